@@ -0,0 +1,12 @@
+// Module with empty entry points; helix-bench copies it into generated module
+// directories to measure bring-up without any module work in the way.
+#include "helix/module.h"
+
+extern "C" {
+
+HELIX_EXPORT int helix_module_init() { return 0; }
+HELIX_EXPORT int helix_module_start() { return 0; }
+HELIX_EXPORT int helix_module_stop() { return 0; }
+HELIX_EXPORT void helix_module_destroy() {}
+
+} // extern "C"
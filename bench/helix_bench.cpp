@@ -0,0 +1,466 @@
+// helix-bench: Google Benchmark suite for the daemon's hot paths.
+//
+//   BM_LogDispatch        helix_log_dispatch() from N producer threads into 0, 1 or N sinks
+//   BM_IpcQuery           one-shot list/info requests against an IpcServer from N clients
+//   BM_ResolveGraph       DependencyResolver::resolve_dependencies() on 10 to 10k modules
+//   BM_ResolveChurn       remove_module() + add_module() + resolving that module, 10 to 10k modules
+//   BM_ManifestParse      ManifestParser::parse_from_string() throughput
+//   BM_ExtractPackage     extract_tar_gz() of a .helx-sized package
+//   BM_ColdStart          HelixDaemon::initialize() restoring K generated modules to Running
+//
+// Write results as JSON to track them across releases:
+//   helix-bench --benchmark_out=helix-bench.json --benchmark_out_format=json
+// The context block of that file records the Helix version. The log benchmark runs the
+// synchronous dispatch path unless HELIX_LOG_ASYNC=1 is exported.
+#include "helix/archive.h"
+#include "helix/daemon.h"
+#include "helix/dependency_resolver.h"
+#include "helix/log.h"
+#include "helix/manifest.h"
+#include "ipc_server.h"
+#include "response_cache.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+extern "C" void helix_log_dispatch(const char* module_name, int level, const char* message);
+extern "C" void helix_log_register_sink_v2(HelixLogSinkV2Fn sink, void* user);
+extern "C" void helix_log_unregister_sink_v2(HelixLogSinkV2Fn sink, void* user);
+
+using namespace helix;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char* kManifest = R"({
+  "name": "metrics-exporter",
+  "version": "2.4.1",
+  "description": "Exports module metrics over HTTP",
+  "author": "Helix Contributors",
+  "license": "MIT",
+  "binary_path": "libmetrics-exporter.so",
+  "entry_points": {"init": "metrics_init", "start": "metrics_start", "stop": "metrics_stop", "destroy": "metrics_destroy"},
+  "timeouts": {"init": 2000, "start": 5000, "stop": 5000},
+  "dependencies": [
+    {"name": "ConsoleLogger", "version": ">=1.0.0", "optional": false},
+    {"name": "http-core", "version": "~2.1.0", "optional": false},
+    {"name": "tls-provider", "version": ">=3.0.0", "optional": true}
+  ],
+  "tags": ["metrics", "http", "prometheus", "observability"],
+  "config": {"listen": "0.0.0.0:9102", "interval_ms": "1000", "path": "/metrics"},
+  "minimum_core_version": "1.0.0",
+  "minimum_api_version": "1.0.0"
+})";
+
+// The daemon reports every step on stdout/stderr; keep that out of the benchmark report
+class QuietConsole {
+public:
+    QuietConsole() : out_(std::cout.rdbuf(&null_)), err_(std::cerr.rdbuf(&null_)) {}
+    ~QuietConsole() {
+        std::cout.rdbuf(out_);
+        std::cerr.rdbuf(err_);
+    }
+
+private:
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    };
+    NullBuffer null_;
+    std::streambuf* out_;
+    std::streambuf* err_;
+};
+
+fs::path make_temp_dir(const char* tag) {
+    std::string pattern = (fs::temp_directory_path() / (std::string("helix-bench-") + tag + "-XXXXXX")).string();
+    if (!::mkdtemp(pattern.data())) return {};
+    return pattern;
+}
+
+std::string module_name(size_t i) { return "bench-module-" + std::to_string(i); }
+
+// Module i depends on up to three earlier modules, so the graph is a DAG with layers
+std::vector<size_t> dependencies_of(size_t i) {
+    std::vector<size_t> deps;
+    uint64_t x = i * 0x9E3779B97F4A7C15ull + 1;
+    for (int k = 0; k < 3 && i > 0; ++k) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        size_t dep = static_cast<size_t>(x % i);
+        if (std::find(deps.begin(), deps.end(), dep) == deps.end()) deps.push_back(dep);
+    }
+    return deps;
+}
+
+std::string manifest_json(size_t i, bool with_dependencies) {
+    std::string out = "{\n  \"name\": \"" + module_name(i) + "\",\n  \"version\": \"1." + std::to_string(i % 10) +
+                      ".0\",\n  \"binary_path\": \"lib" + module_name(i) + ".so\",\n  \"dependencies\": [";
+    if (with_dependencies) {
+        bool first = true;
+        for (size_t dep : dependencies_of(i)) {
+            out += first ? "\n" : ",\n";
+            out += "    {\"name\": \"" + module_name(dep) + "\", \"version\": \">=1.0.0 <2.0.0\", \"optional\": false}";
+            first = false;
+        }
+    }
+    out += "]\n}\n";
+    return out;
+}
+
+/**
+ * @brief Fill dir with count installed copies of the dummy module
+ *
+ * Every module gets its own copy of the library (dlopen() would hand back the
+ * same handle for one file) and the marker that makes the scan pick it up.
+ */
+bool generate_modules(const fs::path& dir, size_t count, bool with_dependencies) {
+    std::error_code ec;
+    for (size_t i = 0; i < count; ++i) {
+        const fs::path module_dir = dir / module_name(i);
+        fs::create_directories(module_dir, ec);
+        std::ofstream(module_dir / "manifest.json") << manifest_json(i, with_dependencies);
+        std::ofstream(module_dir / ".helx_installed");
+        fs::copy_file(HELIX_BENCH_DUMMY_MODULE, module_dir / ("lib" + module_name(i) + ".so"),
+                      fs::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::fprintf(stderr, "helix-bench: cannot copy %s: %s\n", HELIX_BENCH_DUMMY_MODULE, ec.message().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---- helix_log_dispatch ---------------------------------------------------
+
+void count_records(const HelixLogRecord*, size_t count, void* user) {
+    static_cast<std::atomic<uint64_t>*>(user)->fetch_add(count, std::memory_order_relaxed);
+}
+
+std::vector<std::unique_ptr<std::atomic<uint64_t>>> g_sink_counters;
+
+void log_sinks_setup(const benchmark::State& state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        g_sink_counters.push_back(std::make_unique<std::atomic<uint64_t>>(0));
+        helix_log_register_sink_v2(&count_records, g_sink_counters.back().get());
+    }
+}
+
+void log_sinks_teardown(const benchmark::State&) {
+    for (auto& counter : g_sink_counters) helix_log_unregister_sink_v2(&count_records, counter.get());
+    g_sink_counters.clear();
+}
+
+// Arg: number of sinks. Without sinks records go to the bounded pre-sink queue.
+void BM_LogDispatch(benchmark::State& state) {
+    const std::string module = "bench-producer-" + std::to_string(state.thread_index());
+    for (auto _ : state) {
+        helix_log_dispatch(module.c_str(), HELIX_LOG_INFO, "request handled in 42us");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogDispatch)
+    ->ArgName("sinks")
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(4)
+    ->Setup(log_sinks_setup)
+    ->Teardown(log_sinks_teardown)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+// ---- IPC list/info ----------------------------------------------------------
+
+constexpr size_t kIpcModules = 200;
+
+struct IpcFixture {
+    fs::path dir;
+    std::unique_ptr<HelixDaemon> daemon;
+    std::unique_ptr<ResponseCache> replies;
+    std::unique_ptr<IpcServer> server;
+    std::thread thread;
+};
+IpcFixture g_ipc;
+
+void ipc_setup(const benchmark::State&) {
+    g_ipc.dir = make_temp_dir("ipc");
+    generate_modules(g_ipc.dir / "modules", kIpcModules, false);
+    g_ipc.daemon = std::make_unique<HelixDaemon>();
+    {
+        QuietConsole quiet;
+        g_ipc.daemon->initialize((g_ipc.dir / "modules").string());
+    }
+    g_ipc.replies = std::make_unique<ResponseCache>(*g_ipc.daemon);
+    g_ipc.server = std::make_unique<IpcServer>((g_ipc.dir / "helix.sock").string());
+    g_ipc.server->set_read_only_classifier([](const std::string&) { return true; });
+    g_ipc.thread = std::thread([] {
+        g_ipc.server->serve([](const std::string& line) -> IpcServer::Payload {
+            if (line == "list") return g_ipc.replies->list(false);
+            if (line.rfind("info ", 0) == 0) {
+                if (auto reply = g_ipc.replies->info(line.substr(5), false)) return reply;
+            }
+            return std::make_shared<const std::string>("ERR not installed");
+        });
+    });
+    // serve() creates the socket on its own thread
+    for (int i = 0; i < 200 && ::access(g_ipc.server->socket_path().c_str(), F_OK) != 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+void ipc_teardown(const benchmark::State&) {
+    g_ipc.server->stop();
+    g_ipc.thread.join();
+    g_ipc.server.reset();
+    g_ipc.replies.reset();
+    {
+        QuietConsole quiet;
+        g_ipc.daemon->shutdown();
+    }
+    g_ipc.daemon.reset();
+    std::error_code ec;
+    fs::remove_all(g_ipc.dir, ec);
+}
+
+// One command on a fresh connection, as helixctl sends it; returns the reply size
+size_t ipc_request(const std::string& socket_path, const std::string& command) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path.c_str());
+    size_t received = 0;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        const std::string line = command + "\n";
+        if (::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size())) {
+            char buf[16384];
+            ssize_t n;
+            while ((n = ::read(fd, buf, sizeof(buf))) > 0) received += static_cast<size_t>(n);
+        }
+    }
+    ::close(fd);
+    return received;
+}
+
+// Arg 0: list, 1: info. Reports requests per second and per-client p50/p99 latency.
+void BM_IpcQuery(benchmark::State& state) {
+    const std::string socket_path = g_ipc.server->socket_path();
+    const bool info = state.range(0) == 1;
+    std::vector<double> latencies;
+    size_t bytes = 0;
+    size_t n = static_cast<size_t>(state.thread_index());
+    for (auto _ : state) {
+        const std::string command = info ? "info " + module_name(n++ % kIpcModules) : std::string("list");
+        const auto begin = std::chrono::steady_clock::now();
+        const size_t received = ipc_request(socket_path, command);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+        if (received == 0) {
+            state.SkipWithError("no reply from the IPC server");
+            break;
+        }
+        bytes += received;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        state.counters["p50_us"] = benchmark::Counter(latencies[latencies.size() / 2], benchmark::Counter::kAvgThreads);
+        state.counters["p99_us"] =
+            benchmark::Counter(latencies[latencies.size() * 99 / 100], benchmark::Counter::kAvgThreads);
+    }
+}
+BENCHMARK(BM_IpcQuery)
+    ->ArgName("info")
+    ->Arg(0)
+    ->Arg(1)
+    ->Setup(ipc_setup)
+    ->Teardown(ipc_teardown)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+// ---- DependencyResolver -----------------------------------------------------
+
+void BM_ResolveGraph(benchmark::State& state) {
+    const size_t modules = static_cast<size_t>(state.range(0));
+    DependencyResolver resolver;
+    for (size_t i = 0; i < modules; ++i) {
+        ModuleManifest manifest;
+        manifest.name = module_name(i);
+        manifest.version = "1." + std::to_string(i % 10) + ".0";
+        for (size_t dep : dependencies_of(i)) manifest.dependencies.push_back({module_name(dep), ">=1.0.0 <2.0.0", false});
+        resolver.add_module(manifest);
+    }
+    for (auto _ : state) {
+        ResolutionResult result = resolver.resolve_dependencies();
+        if (!result.success || result.load_order.size() != modules) {
+            state.SkipWithError("resolution failed");
+            break;
+        }
+        benchmark::DoNotOptimize(result.load_layers.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ResolveGraph)->ArgName("modules")->RangeMultiplier(10)->Range(10, 10000)->Complexity(benchmark::oN);
+
+// Replaces one of the first ten modules (small dependency closures) and resolves it per
+// iteration. Rows are updated in place, so the cost should stay flat as the graph grows.
+void BM_ResolveChurn(benchmark::State& state) {
+    const size_t modules = static_cast<size_t>(state.range(0));
+    DependencyResolver resolver;
+    std::vector<ModuleManifest> manifests(modules);
+    for (size_t i = 0; i < modules; ++i) {
+        manifests[i].name = module_name(i);
+        manifests[i].version = "1." + std::to_string(i % 10) + ".0";
+        for (size_t dep : dependencies_of(i)) manifests[i].dependencies.push_back({module_name(dep), ">=1.0.0 <2.0.0", false});
+        resolver.add_module(manifests[i]);
+    }
+    size_t next = 0;
+    for (auto _ : state) {
+        const ModuleManifest& manifest = manifests[next++ % std::min<size_t>(modules, 10)];
+        resolver.remove_module(manifest.name);
+        resolver.add_module(manifest);
+        ResolutionResult result = resolver.resolve_dependencies({manifest.name});
+        if (!result.success) {
+            state.SkipWithError("resolution failed");
+            break;
+        }
+        benchmark::DoNotOptimize(result.load_order.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_ResolveChurn)->ArgName("modules")->RangeMultiplier(10)->Range(10, 10000)->Complexity();
+
+// ---- ManifestParser ---------------------------------------------------------
+
+void BM_ManifestParse(benchmark::State& state) {
+    const std::string text = kManifest;
+    ManifestParser parser;
+    for (auto _ : state) {
+        ModuleManifest manifest;
+        if (!parser.parse_from_string(text, manifest)) {
+            state.SkipWithError("manifest did not parse");
+            break;
+        }
+        benchmark::DoNotOptimize(manifest.dependencies.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ManifestParse);
+
+// ---- Package extraction -----------------------------------------------------
+
+// Arg: payload bytes next to manifest.json and the module library
+void BM_ExtractPackage(benchmark::State& state) {
+    const fs::path dir = make_temp_dir("extract");
+    const fs::path payload = dir / "payload.bin";
+    {
+        // Incompressible, like the stripped binaries packages mostly carry
+        std::ofstream out(payload, std::ios::binary);
+        uint64_t x = 88172645463325252ull;
+        for (int64_t i = 0; i < state.range(0); i += 8) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            out.write(reinterpret_cast<const char*>(&x), 8);
+        }
+    }
+    std::ofstream(dir / "manifest.json") << manifest_json(0, false);
+    const std::string archive = (dir / "bench.helx").string();
+    std::string error;
+    if (!write_tar_gz(archive,
+                      {{"manifest.json", (dir / "manifest.json").string()},
+                       {"lib" + module_name(0) + ".so", HELIX_BENCH_DUMMY_MODULE},
+                       {"data/payload.bin", payload.string()}},
+                      error)) {
+        state.SkipWithError(("cannot write package: " + error).c_str());
+    }
+    const fs::path dest = dir / "out";
+    std::error_code ec;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove_all(dest, ec);
+        fs::create_directories(dest, ec);
+        state.ResumeTiming();
+        if (!extract_tar_gz(archive, dest.string(), error)) {
+            state.SkipWithError(("extraction failed: " + error).c_str());
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(fs::file_size(archive, ec)));
+    state.SetLabel(archive_support_available() ? "zlib" : "tar program");
+    fs::remove_all(dir, ec);
+}
+BENCHMARK(BM_ExtractPackage)->ArgName("payload")->Arg(64 << 10)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond);
+
+// ---- Cold start -------------------------------------------------------------
+
+// Arg: modules brought up. Each iteration is a fresh daemon that parses every manifest
+// (the index is removed) and restores all modules to Running from the saved states.
+void BM_ColdStart(benchmark::State& state) {
+    const size_t modules = static_cast<size_t>(state.range(0));
+    const fs::path dir = make_temp_dir("coldstart");
+    if (!generate_modules(dir, modules, true)) {
+        state.SkipWithError("cannot generate modules");
+        return;
+    }
+    {
+        std::ofstream legacy(dir / ".helix_state.json");
+        legacy << "{\n  \"modules\": {\n";
+        for (size_t i = 0; i < modules; ++i) {
+            legacy << "    \"" << module_name(i) << "\": { \"state\": \"Running\" }" << (i + 1 < modules ? ",\n" : "\n");
+        }
+        legacy << "  }\n}\n";
+    }
+    std::error_code ec;
+    size_t running = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove(dir / ".helx_index", ec);
+        auto daemon = std::make_unique<HelixDaemon>();
+        state.ResumeTiming();
+        {
+            QuietConsole quiet;
+            daemon->initialize(dir.string());
+            state.PauseTiming();
+            running = daemon->list_modules_by_state(ModuleState::RUNNING).size();
+            daemon->shutdown();
+            daemon.reset();
+            state.ResumeTiming();
+        }
+        if (running != modules) {
+            state.SkipWithError(("only " + std::to_string(running) + " modules reached Running").c_str());
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    fs::remove_all(dir, ec);
+}
+BENCHMARK(BM_ColdStart)->ArgName("modules")->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::AddCustomContext("helix_version", HELIX_CORE_VERSION);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,317 @@
+// Manifest / state-file / version parsing benchmark.
+//
+// Compares the JsonScanner-based parsers against the regex code they replaced
+// (kept here verbatim as the "legacy" reference) and, when available, against
+// nlohmann_json. Usage: parse_bench [iterations]
+#include "helix/json_scanner.h"
+#include "helix/manifest.h"
+#include "helix/dependency_resolver.h"
+#include "helix/semver.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef HELIX_BENCH_HAVE_NLOHMANN
+#include <nlohmann/json.hpp>
+#endif
+
+using namespace helix;
+
+namespace {
+
+const char* kManifest = R"({
+  "name": "metrics-exporter",
+  "version": "2.4.1-rc.1",
+  "description": "Exports module metrics over HTTP",
+  "author": "Helix Contributors",
+  "license": "MIT",
+  "binary_path": "libmetrics-exporter.so",
+  "entry_points": {
+    "init": "metrics_init",
+    "start": "metrics_start",
+    "stop": "metrics_stop",
+    "destroy": "metrics_destroy"
+  },
+  "timeouts": {"init": 2000, "start": 5000, "stop": 5000},
+  "dependencies": [
+    {"name": "ConsoleLogger", "version": ">=1.0.0", "optional": false},
+    {"name": "http-core", "version": "~2.1.0", "optional": false},
+    {"name": "tls-provider", "version": ">=3.0.0", "optional": true}
+  ],
+  "tags": ["metrics", "http", "prometheus", "observability"],
+  "config": {
+    "listen": "0.0.0.0:9102",
+    "interval_ms": "1000",
+    "path": "/metrics"
+  },
+  "minimum_core_version": "1.0.0",
+  "minimum_api_version": "1.0.0",
+  "homepage": "https://example.invalid/metrics-exporter",
+  "repository": "https://example.invalid/metrics-exporter.git"
+})";
+
+std::string make_state_file(size_t modules) {
+    std::string out = "{\n  \"modules\": {\n";
+    for (size_t i = 0; i < modules; ++i) {
+        out += "    \"module-" + std::to_string(i) + "\": { \"state\": \"" + (i % 3 ? "Running" : "Installed") + "\" }";
+        out += i + 1 < modules ? ",\n" : "\n";
+    }
+    out += "  }\n}";
+    return out;
+}
+
+// ---- legacy reference implementations (regex based, as before the scanner) ----
+
+bool legacy_regex_parse(const std::string& json_content, ModuleManifest& manifest) {
+    std::unordered_map<std::string, std::string> fields;
+    {
+        int obj_depth = 0;
+        size_t i = 0;
+        while (i < json_content.size() && json_content[i] != '{') ++i;
+        if (i < json_content.size()) ++obj_depth, ++i;
+        auto read_string = [&](size_t& idx) -> std::string {
+            std::string out;
+            ++idx;
+            bool esc = false;
+            for (; idx < json_content.size(); ++idx) {
+                char c = json_content[idx];
+                if (esc) { out.push_back(c); esc = false; continue; }
+                if (c == '\\') { esc = true; continue; }
+                if (c == '"') { ++idx; break; }
+                out.push_back(c);
+            }
+            return out;
+        };
+        auto skip_ws = [&](size_t& idx){ while (idx < json_content.size() && (json_content[idx]==' '||json_content[idx]=='\n'||json_content[idx]=='\r'||json_content[idx]=='\t')) ++idx; };
+        for (; i < json_content.size() && obj_depth > 0; ++i) {
+            char c = json_content[i];
+            if (c == '"') {
+                size_t key_pos = i;
+                std::string key = read_string(i);
+                size_t j = i; skip_ws(j);
+                if (j < json_content.size() && json_content[j] == ':') {
+                    ++j; skip_ws(j);
+                    if (j < json_content.size() && json_content[j] == '"' && obj_depth == 1) {
+                        fields[key] = read_string(j);
+                        i = j - 1;
+                        continue;
+                    }
+                }
+                i = key_pos;
+            } else if (c == '{') {
+                ++obj_depth;
+            } else if (c == '}') {
+                --obj_depth;
+            }
+        }
+    }
+    manifest.name = fields["name"];
+    manifest.version = fields["version"];
+    manifest.binary_path = fields["binary_path"];
+    manifest.description = fields["description"];
+    manifest.author = fields["author"];
+    manifest.license = fields["license"];
+
+    std::smatch m;
+    if (std::regex_search(json_content, m, std::regex("\"dependencies\"\\s*:\\s*\\[([\\s\\S]*?)\\]"))) {
+        const std::string deps = m[1].str();
+        std::regex dep_regex("\\{[^}]*\"name\"\\s*:\\s*\"([^\"]+)\"[^}]*\"version\"\\s*:\\s*\"([^\"]*)\"[^}]*\"optional\"\\s*:\\s*(true|false)[^}]*\\}");
+        for (std::sregex_iterator it(deps.begin(), deps.end(), dep_regex), end; it != end; ++it) {
+            manifest.dependencies.push_back({(*it)[1].str(), (*it)[2].str(), (*it)[3].str() == "true"});
+        }
+    }
+    if (std::regex_search(json_content, m, std::regex("\"tags\"\\s*:\\s*\\[([\\s\\S]*?)\\]"))) {
+        const std::string tags = m[1].str();
+        std::regex string_regex("\"([^\"]*)\"");
+        for (std::sregex_iterator it(tags.begin(), tags.end(), string_regex), end; it != end; ++it) {
+            manifest.tags.push_back((*it)[1].str());
+        }
+    }
+    if (std::regex_search(json_content, m, std::regex("\"config\"\\s*:\\s*\\{([\\s\\S]*?)\\}"))) {
+        const std::string config = m[1].str();
+        std::regex config_regex("\"([^\"]+)\"\\s*:\\s*\"([^\"]*)\"");
+        for (std::sregex_iterator it(config.begin(), config.end(), config_regex), end; it != end; ++it) {
+            manifest.config[(*it)[1].str()] = (*it)[2].str();
+        }
+    }
+    if (std::regex_search(json_content, m, std::regex("\"entry_points\"\\s*:\\s*\\{([\\s\\S]*?)\\}"))) {
+        const std::string ep = m[1].str();
+        std::regex ep_field_regex("\"([^\"]+)\"\\s*:\\s*\"([^\"]*)\"");
+        for (std::sregex_iterator it(ep.begin(), ep.end(), ep_field_regex), end; it != end; ++it) {
+            if ((*it)[1].str() == "init") manifest.entry_points.init = (*it)[2].str();
+        }
+    }
+    // Validation as done by the old validate_manifest(): one regex per check
+    std::regex version_regex("^\\d+\\.\\d+\\.\\d+([+-][a-zA-Z0-9\\.-]*)?$");
+    std::regex name_regex("^[a-zA-Z][a-zA-Z0-9_-]*$");
+    std::regex req_regex(R"(^(>=|<=|>|<|~|==)?\s*\d+\.\d+\.\d+([+-][A-Za-z0-9\.-]+)?$)");
+    bool ok = std::regex_match(manifest.name, name_regex) && std::regex_match(manifest.version, version_regex);
+    for (const auto& dep : manifest.dependencies) {
+        ok = ok && std::regex_match(dep.name, name_regex) && std::regex_match(dep.version, req_regex);
+    }
+    return ok;
+}
+
+size_t legacy_state_parse(const std::string& content, std::unordered_map<std::string, std::string>& out) {
+    size_t brace_start = content.find('{', content.find("\"modules\""));
+    size_t i = brace_start;
+    int depth = 0;
+    bool in_string = false;
+    for (; i < content.size(); ++i) {
+        char c = content[i];
+        if (c == '"' && !(i > 0 && content[i - 1] == '\\')) in_string = !in_string;
+        if (in_string) continue;
+        if (c == '{') ++depth;
+        else if (c == '}' && --depth == 0) break;
+    }
+    const std::string block = content.substr(brace_start + 1, i - brace_start - 1);
+    std::regex entry_regex(R"regex("([^"]+)"\s*:\s*\{[^}]*"state"\s*:\s*"([^"]+)"[^}]*\})regex");
+    for (std::sregex_iterator it(block.begin(), block.end(), entry_regex), end; it != end; ++it) {
+        out[(*it)[1].str()] = (*it)[2].str();
+    }
+    return out.size();
+}
+
+bool legacy_version_satisfies(const std::string& available, const std::string& requirement) {
+    std::smatch m;
+    if (!std::regex_match(requirement, m, std::regex(R"(^(>=|<=|>|<|~|==)?\s*(\d+\.\d+\.\d+.*)$)"))) return false;
+    const std::string op = m[1].str(), version = m[2].str();
+    std::regex core(R"(^(\d+)\.(\d+)\.(\d+))");
+    std::smatch a, b;
+    if (!std::regex_match(available, a, core) || !std::regex_match(version, b, core)) return op.empty() || op == "==";
+    int cmp = 0;
+    for (int k = 1; k <= 3 && cmp == 0; ++k) {
+        int x = std::stoi(a[k].str()), y = std::stoi(b[k].str());
+        cmp = x == y ? 0 : (x > y ? 1 : -1);
+    }
+    return op == ">=" ? cmp >= 0 : op == ">" ? cmp > 0 : op == "<=" ? cmp <= 0 : op == "<" ? cmp < 0 : cmp == 0;
+}
+
+// ---- new paths ----
+
+size_t scanner_state_parse(const std::string& content, std::unordered_map<std::string, std::string>& out) {
+    // Same walk as HelixDaemon::load_saved_module_states
+    JsonScanner in(content);
+    std::string_view key, field;
+    std::string state;
+    if (in.enter_object()) {
+        while (in.next_member(key)) {
+            if (key != "modules") { in.skip_value(); continue; }
+            in.enter_object();
+            while (in.next_member(key)) {
+                std::string name(key);
+                in.enter_object();
+                while (in.next_member(field)) {
+                    if (field == "state") in.read_string(state);
+                    else in.skip_value();
+                }
+                out[name] = state;
+            }
+        }
+    }
+    return out.size();
+}
+
+#ifdef HELIX_BENCH_HAVE_NLOHMANN
+bool nlohmann_parse(const std::string& text, ModuleManifest& manifest) {
+    auto j = nlohmann::json::parse(text);
+    manifest.name = j.at("name").get<std::string>();
+    manifest.version = j.at("version").get<std::string>();
+    manifest.binary_path = j.at("binary_path").get<std::string>();
+    manifest.description = j.value("description", "");
+    manifest.author = j.value("author", "");
+    manifest.license = j.value("license", "");
+    for (const auto& d : j["dependencies"]) {
+        manifest.dependencies.push_back({d.value("name", ""), d.value("version", ""), d.value("optional", false)});
+    }
+    for (const auto& t : j["tags"]) manifest.tags.push_back(t.get<std::string>());
+    for (auto it = j["config"].begin(); it != j["config"].end(); ++it) manifest.config[it.key()] = it.value().get<std::string>();
+    const auto& ep = j["entry_points"];
+    manifest.entry_points.init = ep.value("init", manifest.entry_points.init);
+    return true;
+}
+#endif
+
+void run(const char* label, size_t iterations, const std::function<bool()>& body) {
+    double best = 1e300;
+    for (int round = 0; round < 3; ++round) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            if (!body()) {
+                std::cerr << label << ": iteration failed" << std::endl;
+                std::exit(1);
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        best = std::min(best, ns / static_cast<double>(iterations));
+    }
+    std::printf("  %-40s %12.0f ns/op\n", label, best);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const std::string manifest_text = kManifest;
+    const std::string state_text = make_state_file(200);
+    ManifestParser parser;
+
+    std::printf("manifest.json (%zu bytes), %zu iterations, best of 3\n", manifest_text.size(), iterations);
+    run("JsonScanner (ManifestParser)", iterations, [&] {
+        ModuleManifest m;
+        return parser.parse_from_string(manifest_text, m) && m.dependencies.size() == 3;
+    });
+    run("legacy regex parser", iterations, [&] {
+        ModuleManifest m;
+        return legacy_regex_parse(manifest_text, m) && m.dependencies.size() == 3;
+    });
+#ifdef HELIX_BENCH_HAVE_NLOHMANN
+    run("nlohmann::json", iterations, [&] {
+        ModuleManifest m;
+        return nlohmann_parse(manifest_text, m) && m.dependencies.size() == 3;
+    });
+#else
+    std::printf("  %-40s %15s\n", "nlohmann::json", "(not found)");
+#endif
+
+    std::printf(".helix_state.json (200 modules, %zu bytes)\n", state_text.size());
+    run("JsonScanner", iterations, [&] {
+        std::unordered_map<std::string, std::string> out;
+        return scanner_state_parse(state_text, out) == 200;
+    });
+    run("legacy sregex_iterator", iterations, [&] {
+        std::unordered_map<std::string, std::string> out;
+        return legacy_state_parse(state_text, out) == 200;
+    });
+
+    std::printf("version_satisfies(\"2.4.1\", \">=2.1.0\")\n");
+    run("SemVer/VersionRange", iterations * 10, [] {
+        return DependencyResolver::version_satisfies("2.4.1", ">=2.1.0");
+    });
+    run("legacy regex", iterations * 10, [] { return legacy_version_satisfies("2.4.1", ">=2.1.0"); });
+    SemVer parsed_version;
+    VersionRange parsed_range;
+    SemVer::parse("2.4.1", parsed_version);
+    VersionRange::parse(">=2.1.0 <3.0.0", parsed_range);
+    run("pre-parsed satisfied_by", iterations * 10, [&] { return parsed_range.satisfied_by(parsed_version); });
+
+    // 500 modules, each depending on up to three earlier ones through a range
+    DependencyResolver resolver;
+    for (int i = 0; i < 500; ++i) {
+        ModuleManifest m;
+        m.name = "m" + std::to_string(i);
+        m.version = "1." + std::to_string(i % 7) + ".0";
+        for (int d = 1; d <= 3 && i - d * 5 >= 0; ++d) {
+            m.dependencies.push_back({"m" + std::to_string(i - d * 5), ">=1.0.0 <2.0.0", false});
+        }
+        resolver.add_module(m);
+    }
+    std::printf("resolve_dependencies (500 modules, ~1500 ranged edges)\n");
+    run("DependencyResolver", iterations / 10, [&] { return resolver.resolve_dependencies({"m499"}).success; });
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef HELIX_ARCHIVE_H
+#define HELIX_ARCHIVE_H
+
+#include <string>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief One file to store in an archive
+ */
+struct ArchiveMember {
+    std::string name;        ///< Path inside the archive (relative, '/'-separated)
+    std::string source_path; ///< File on disk whose contents and mode are stored
+};
+
+/**
+ * @brief Whether the in-process tar.gz reader/writer is available (built with zlib)
+ *
+ * When false, extract_tar_gz() and write_tar_gz() fail and callers fall back to
+ * the external `tar` program.
+ */
+bool archive_support_available();
+
+/**
+ * @brief Stream-extract a gzip-compressed tar archive (.helx) into a directory
+ *
+ * Decompresses and writes each member in one pass, without intermediate files.
+ * Only regular files and directories are accepted; absolute paths, ".." components,
+ * links and device nodes make the whole extraction fail. GNU long names and pax
+ * "path" records are understood.
+ * @param archive_path Path to the .tar.gz / .helx file
+ * @param dest_dir Directory to extract into (created if missing)
+ * @param error Failure reason when false is returned
+ * @return true if every member was extracted
+ */
+bool extract_tar_gz(const std::string& archive_path, const std::string& dest_dir, std::string& error);
+
+/**
+ * @brief Write files into a new gzip-compressed ustar archive
+ *
+ * The archive is written to a temporary sibling and renamed into place, so readers
+ * never observe a partial file.
+ * @param archive_path Output path
+ * @param members Files to store, in order
+ * @param error Failure reason when false is returned
+ * @return true on success
+ */
+bool write_tar_gz(const std::string& archive_path, const std::vector<ArchiveMember>& members, std::string& error);
+
+} // namespace helix
+
+#endif // HELIX_ARCHIVE_H
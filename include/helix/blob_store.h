@@ -0,0 +1,59 @@
+#ifndef HELIX_BLOB_STORE_H
+#define HELIX_BLOB_STORE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace helix {
+
+/**
+ * @brief Content-addressed file store shared by installed modules
+ *
+ * Blobs live at `<root>/<xx>/<sha256>-<mode>` and installed files are hard links to
+ * them, so identical payloads (the same `.so` shipped by several packages or kept
+ * for several versions) occupy disk and page cache once. Because links share an
+ * inode, installed files must never be modified in place.
+ */
+class BlobStore {
+public:
+    explicit BlobStore(std::string root) : root_(std::move(root)) {}
+
+    /**
+     * @brief SHA-256 of a file's contents as lowercase hex
+     * @return true on success; error holds the reason otherwise
+     */
+    static bool hash_file(const std::string& path, std::string& hex, std::string& error);
+
+    /// SHA-256 of an in-memory buffer as lowercase hex
+    static std::string hash_bytes(const void* data, size_t size);
+
+    /**
+     * @brief Deduplicate a regular file against the store
+     *
+     * If a blob with the same contents and mode exists, the file is replaced by a
+     * hard link (or a reflink when hard-linking fails) to it; otherwise the file
+     * itself is linked into the store and becomes the blob. When neither link
+     * works the file is left as a private copy and true is still returned.
+     * @param path File to deduplicate (must be on the store's filesystem to share)
+     * @param shared Set to true if the file now shares storage with the blob
+     * @param error Failure reason when false is returned
+     * @return false only if the file could not be read or hashed
+     */
+    bool ingest(const std::string& path, bool& shared, std::string& error);
+
+    /**
+     * @brief Delete blobs no installed file links to any more
+     * @return Number of blobs removed
+     */
+    size_t collect_garbage();
+
+    const std::string& root() const { return root_; }
+
+private:
+    std::string root_;
+};
+
+} // namespace helix
+
+#endif // HELIX_BLOB_STORE_H
@@ -0,0 +1,137 @@
+#ifndef HELIX_BUS_H
+#define HELIX_BUS_H
+
+/**
+ * @file bus.h
+ * @brief Message bus between modules
+ *
+ * A topic is a named ring of fixed-size slots. Publishers either copy a
+ * message in (helix_bus_publish) or borrow a slot, fill it in place and commit
+ * it (helix_bus_loan / helix_bus_commit). Every subscriber sees every message
+ * published after it subscribed, in order, and reads it in place: poll returns
+ * views into the ring that stay valid until the subscriber's next poll.
+ *
+ * Publishing never blocks. When a subscriber falls a full ring behind, new
+ * messages are dropped and counted in the topic's drop counter (`helixctl
+ * topics`). Commit loans promptly: subscribers cannot read past an open loan.
+ *
+ * @code
+ * static HelixBusTopic* ticks = nullptr;
+ * HELIX_MODULE_INIT() {
+ *     ticks = helix_bus_topic("ticks", sizeof(Tick), 4096);
+ *     return ticks ? 0 : -1;
+ * }
+ * ...
+ * if (void* slot = helix_bus_loan(ticks, sizeof(Tick))) {
+ *     new (slot) Tick{...};
+ *     helix_bus_commit(ticks, slot, sizeof(Tick));
+ * }
+ *
+ * // consumer thread
+ * HelixBusMessage batch[64];
+ * while (running) {
+ *     size_t n = helix_bus_poll(sub, batch, 64);
+ *     if (n == 0) { helix_bus_wait(sub, 100); continue; }
+ *     for (size_t i = 0; i < n; ++i) handle(static_cast<const Tick*>(batch[i].data));
+ * }
+ * @endcode
+ *
+ * Subscriptions made from a module's init or start are dropped automatically
+ * when the module is unloaded; others must be closed with helix_bus_unsubscribe.
+ *
+ * Modules with "isolation": "process" use the same API: their host maps the
+ * daemon's rings, so messages cross the process boundary through shared memory.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __unix__
+#include <dlfcn.h>
+#endif
+
+struct HelixBusTopic;
+struct HelixBusSubscriber;
+
+// One message returned by helix_bus_poll; data points into the topic's ring
+struct HelixBusMessage {
+    const void* data;
+    uint32_t size;
+};
+
+#define HELIX_BUS_API_VERSION 1u
+
+// Function table exported by helixd as helix_bus_api(); members are only ever appended
+struct HelixBusApi {
+    uint32_t version;
+    HelixBusTopic* (*topic)(const char* name, uint32_t slot_size, uint32_t capacity);
+    void* (*loan)(HelixBusTopic* topic, uint32_t size);
+    void (*commit)(HelixBusTopic* topic, void* loan, uint32_t size);
+    int (*publish)(HelixBusTopic* topic, const void* data, uint32_t size);
+    HelixBusSubscriber* (*subscribe)(HelixBusTopic* topic);
+    void (*unsubscribe)(HelixBusSubscriber* subscriber);
+    size_t (*poll)(HelixBusSubscriber* subscriber, HelixBusMessage* out, size_t max);
+    int (*wait)(HelixBusSubscriber* subscriber, uint32_t timeout_ms);
+};
+
+using HelixBusApiFn = const HelixBusApi* (*)();
+
+// The daemon's bus, or nullptr when running outside helixd
+inline const HelixBusApi* helix_bus() {
+#ifdef __unix__
+    static const HelixBusApi* api = nullptr;
+    if (!api) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_bus_api");
+        if (sym) api = reinterpret_cast<HelixBusApiFn>(sym)();
+    }
+    return api;
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ * Open a topic, creating it on first use. slot_size is the largest message in
+ * bytes and capacity the number of slots (rounded up to a power of two); 0 picks
+ * the defaults. Opening an existing topic succeeds if its slots are large enough.
+ */
+inline HelixBusTopic* helix_bus_topic(const char* name, uint32_t slot_size, uint32_t capacity) {
+    const HelixBusApi* bus = helix_bus();
+    return bus ? bus->topic(name, slot_size, capacity) : nullptr;
+}
+
+// Borrow a slot for a message of up to size bytes; nullptr (and a counted drop) if the ring is full
+inline void* helix_bus_loan(HelixBusTopic* topic, uint32_t size) {
+    return helix_bus()->loan(topic, size);
+}
+
+// Publish a loaned slot with the final size (at most the loaned size); 0 cancels the loan
+inline void helix_bus_commit(HelixBusTopic* topic, void* loan, uint32_t size) {
+    helix_bus()->commit(topic, loan, size);
+}
+
+// Copy a message into the topic; 0 on success, -1 if it was dropped
+inline int helix_bus_publish(HelixBusTopic* topic, const void* data, uint32_t size) {
+    return helix_bus()->publish(topic, data, size);
+}
+
+// Receive messages published from now on; nullptr when the topic has no free subscriber slot
+inline HelixBusSubscriber* helix_bus_subscribe(HelixBusTopic* topic) {
+    return helix_bus()->subscribe(topic);
+}
+
+inline void helix_bus_unsubscribe(HelixBusSubscriber* subscriber) {
+    helix_bus()->unsubscribe(subscriber);
+}
+
+// Release the previous batch and return up to max new messages, oldest first
+inline size_t helix_bus_poll(HelixBusSubscriber* subscriber, HelixBusMessage* out, size_t max) {
+    return helix_bus()->poll(subscriber, out, max);
+}
+
+// Block until a message is ready or timeout_ms passes; 1 if one is ready
+inline int helix_bus_wait(HelixBusSubscriber* subscriber, uint32_t timeout_ms) {
+    return helix_bus()->wait(subscriber, timeout_ms);
+}
+
+#endif // HELIX_BUS_H
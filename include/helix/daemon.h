@@ -4,9 +4,14 @@
 #include "helix/module_loader.h"
 #include "helix/dependency_resolver.h"
 #include "helix/manifest.h"
+#include "helix/module_index.h"
+#include "helix/state_journal.h"
+#include <functional>
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
 
 namespace helix {
 
@@ -33,6 +38,25 @@ struct DaemonModuleInfo {
     ModuleManifest manifest;
     ModuleState state;
     std::string error_message; ///< Last error message if any
+    std::string package_digest; ///< SHA-256 of the .helx it was installed from (empty if unknown)
+};
+
+/**
+ * @brief One lifecycle operation of a batch
+ */
+struct BatchOperation {
+    std::string action; ///< install, enable, start, stop, disable or uninstall
+    std::string target; ///< Package path for install, module name otherwise
+};
+
+/**
+ * @brief Outcome of one batch operation
+ */
+struct BatchResult {
+    std::string action;
+    std::string target;
+    bool success;
+    std::string error; ///< Failure reason when success is false
 };
 
 /**
@@ -65,6 +89,22 @@ public:
      */
     bool install_module(const std::string& package_path);
 
+    /**
+     * @brief Replace an installed module with a newer package without a stop/start gap
+     *
+     * An active module (initialized, running or stopped) is upgraded in memory: the
+     * new build is loaded next to the old one, initialized, handed the old state
+     * through its optional helix_module_handoff() export and started if the old one
+     * was running. Exports and service tables then switch to it in one step, and only
+     * after that is the old instance stopped and destroyed. Any failure before the
+     * switch leaves the old version serving. Refused when a dependent's version
+     * range does not accept the new version, or when the new version needs modules
+     * that are not running.
+     * @param package_path Path to the .helx package of the new version
+     * @return true if the module now runs (or is installed as) the new version
+     */
+    bool upgrade_module(const std::string& package_path);
+
     /**
      * @brief Uninstall a module
      * @param module_name Name of the module to uninstall
@@ -79,6 +119,16 @@ public:
      */
     bool enable_module(const std::string& module_name);
 
+    /**
+     * @brief Map a module and its dependencies without initializing them
+     *
+     * Installed modules in the dependency closure are loaded (dlopen and entry
+     * point lookup) and move to ModuleState::LOADED; a later enable only runs init.
+     * @param module_name Name of the module to prepare
+     * @return true if the module and its dependencies are loaded or further along
+     */
+    bool prepare_module(const std::string& module_name);
+
     /**
      * @brief Disable a module (stop and unload it)
      * @param module_name Name of the module to disable
@@ -100,6 +150,19 @@ public:
      */
     bool stop_module(const std::string& module_name);
 
+    /**
+     * @brief Apply several lifecycle operations in one dependency-ordered pass
+     *
+     * Operations are grouped by action and run as stop, disable, uninstall, install,
+     * enable, start. Within enable/start, dependencies come before their dependents;
+     * within stop/disable/uninstall the order is reversed. A module whose dependency
+     * failed to enable or start in this batch is skipped.
+     * Operations whose target is already in the requested state succeed without action.
+     * @param ops Operations to apply; unknown actions are reported as failures
+     * @return One result per operation, in execution order
+     */
+    std::vector<BatchResult> run_batch(const std::vector<BatchOperation>& ops);
+
     /**
      * @brief Get information about a module
      * @param module_name Name of the module
@@ -151,18 +214,103 @@ public:
      */
     const std::string& last_error() const { return last_error_; }
 
+    /**
+     * @brief Counter bumped on every registry or module state change
+     *
+     * Callers caching derived data (e.g. serialized IPC replies) compare it to detect staleness.
+     */
+    uint64_t registry_generation() const { return registry_generation_; }
+
+    /**
+     * @brief Set how many threads may load, initialize and start modules concurrently
+     *
+     * Used when restoring saved states and when enabling a module pulls in dependencies.
+     * Defaults to the number of CPUs, capped at 8; 1 brings modules up one at a time.
+     * @param workers Worker thread count (0 is treated as 1)
+     */
+    void set_bringup_workers(size_t workers) { bringup_workers_ = workers ? workers : 1; }
+
+    /**
+     * @brief Set the limit for init/start/stop calls of modules whose manifest has no "timeouts"
+     *
+     * A module whose call overruns moves to ModuleState::ERROR and the call returns
+     * failure; the entry point keeps running on its own thread. Defaults to 30 s.
+     * @param timeout_ms Milliseconds; 0 disables the limit
+     */
+    void set_lifecycle_timeout_ms(unsigned timeout_ms);
+
+    /**
+     * @brief Warm module binaries ahead of use
+     *
+     * When enabled, binaries are read into the page cache (readahead) after install and
+     * on each directory scan, and the pages of a module's segments are faulted in right
+     * after it is loaded, so the first calls into it do not take page faults.
+     */
+    void set_preload(bool preload);
+
+    /**
+     * @brief Resolve all of a module's symbols at load time (RTLD_NOW) instead of lazily
+     */
+    void set_bind_now(bool bind_now);
+
+    /**
+     * @brief Program that runs "isolation": "process" modules (default: $HELIX_MODULE_HOST or helix-modhost)
+     */
+    void set_module_host(const std::string& program);
+
+    /// Called with module name, previous state, new state and error message on every change
+    using StateObserver = std::function<void(const std::string&, ModuleState, ModuleState, const std::string&)>;
+
+    /**
+     * @brief Observe module state changes
+     *
+     * Installing reports Unknown -> Installed, uninstalling reports a change to
+     * Unknown. The observer runs on the thread making the change, with daemon
+     * state locked, so it must not call back into the daemon.
+     */
+    void set_state_observer(StateObserver observer) { state_observer_ = std::move(observer); }
+
+    /// Runs the call it is given; see set_module_call_wrapper()
+    using ModuleCallWrapper = std::function<void(const std::function<void()>&)>;
+
+    /**
+     * @brief Wrap the module code enable, prepare, start, stop and disable run
+     *
+     * Loading a binary and every lifecycle entry point called by those operations
+     * goes through wrapper, which helixd uses to release its state lock meanwhile
+     * so queries are not held up by a slow module. The registry is not touched
+     * inside the wrapped call. Without a wrapper the calls run directly.
+     */
+    void set_module_call_wrapper(ModuleCallWrapper wrapper) { module_call_wrapper_ = std::move(wrapper); }
+
 private:
     std::string modules_directory_;
     std::unique_ptr<ModuleLoader> module_loader_;
+    StateObserver state_observer_;
+    ModuleCallWrapper module_call_wrapper_;
     std::unique_ptr<DependencyResolver> dependency_resolver_;
+    ModuleIndex module_index_;          ///< Scan cache, persisted as <modules-dir>/.helx_index
+    StateJournal state_journal_;        ///< Module state transitions, replayed on startup
+    bool module_index_loaded_ = false;
     std::unordered_map<std::string, DaemonModuleInfo> module_registry_;
     bool initialized_;
     std::string last_error_;
+    uint64_t registry_generation_ = 0;
+    size_t bringup_workers_;
+    bool preload_ = false;
 
     void set_last_error(const std::string& err) { last_error_ = err; }
 
+    /// Run module code through the module call wrapper
+    bool call_module(const std::function<bool()>& call);
+
     /**
      * @brief Scan modules directory and populate registry
+     *
+     * Manifests whose file identity (inode, size, mtime, ctime) matches the
+     * persisted index are taken from it instead of being re-parsed; registered
+     * modules that did not change keep their state. Installed-but-idle modules
+     * whose directory disappeared are dropped from the registry.
      * @return true if scanning succeeded, false otherwise
      */
     bool scan_modules_directory();
@@ -175,13 +323,53 @@ private:
      */
     bool load_module_manifest(const std::string& module_path, ModuleManifest& manifest);
 
+    /// A .helx extracted into a staging directory, checked but not yet installed
+    struct StagedPackage {
+        std::string directory;
+        std::string digest;
+        ModuleManifest manifest;
+    };
+
+    /// Check that package_path is a .helx and compute its SHA-256
+    bool hash_package(const std::string& package_path, std::string& package_digest);
+
+    /**
+     * @brief Extract a package into a staging directory and check its requirements
+     *
+     * The staged files are deduplicated against the blob store. On failure the
+     * staging directory is removed and the last error is set.
+     * @param operation "Install" or "Upgrade", for messages
+     */
+    bool stage_package(const std::string& package_path, const std::string& package_digest,
+                       const std::string& operation, StagedPackage& staged);
+
+    /// Rename a staged package into place; the installed directory, or empty on failure
+    std::string place_package(const StagedPackage& staged);
+
     /**
-     * @brief Extract a .helx package to the modules directory
-     * @param package_path Path to the .helx package
+     * @brief Move an extracted .helx package into the modules directory
+     *
+     * The staged tree must live inside the modules directory; it is renamed into
+     * place (atomically exchanged with an existing install), never copied.
+     * @param package_path Staging directory holding the extracted package
      * @param module_name Name of the module being installed
-     * @return Path to extracted module directory, empty string on failure
+     * @param package_digest SHA-256 of the .helx, recorded in the install marker
+     * @return Path to the installed module directory, empty string on failure
+     */
+    std::string extract_package(const std::string& package_path, const std::string& module_name,
+                                const std::string& package_digest);
+
+    /**
+     * @brief Replace files of a staged tree with hard links into the blob store
+     * @param staged_dir Staging directory inside the modules directory
      */
-    std::string extract_package(const std::string& package_path, const std::string& module_name);
+    void deduplicate_staged_tree(const std::string& staged_dir);
+
+    /**
+     * @brief Read the package digest recorded in a module's install marker
+     * @return The digest, or an empty string if none was recorded
+     */
+    static std::string read_package_digest(const std::string& module_path);
 
     /**
      * @brief Remove module files from filesystem
@@ -199,6 +387,13 @@ private:
     void update_module_state(const std::string& module_name, ModuleState new_state, 
                            const std::string& error_message = "");
 
+    /**
+     * @brief Move a module whose last lifecycle call overran its timeout, or whose host process died, to ERROR
+     * @param operation Name used in the error message ("Start", ...)
+     * @return true if the module is hung or lost (state and last error were set)
+     */
+    bool mark_if_hung(const std::string& module_name, const std::string& operation);
+
     /**
      * @brief Resolve and load module dependencies
      * @param module_name Name of the module
@@ -206,24 +401,51 @@ private:
      */
     bool resolve_and_load_dependencies(const std::string& module_name);
 
+    /**
+     * @brief Enable (and where needed start) modules on a bounded worker pool
+     *
+     * A module is loaded, initialized and started only once all of its dependencies
+     * are RUNNING; modules with no edges between them come up concurrently. Modules
+     * that other modules in the set depend on are always started. A module whose
+     * dependency failed is skipped. Per-module timings are printed to stdout.
+     * @param layers Topological layers (ResolutionResult::load_layers) to bring up
+     * @param to_start Modules to leave RUNNING; the others stop at INITIALIZED
+     * @return true if every module reached its target state; otherwise last_error()
+     *         names the first module that failed
+     */
+    bool parallel_bring_up(const std::vector<std::vector<std::string>>& layers,
+                           const std::unordered_set<std::string>& to_start);
+
     // --- State persistence helpers ---
     /**
-     * @brief Return the path to the daemon state file
+     * @brief Return the path to the JSON state file written by earlier releases
      */
     std::string state_file_path() const;
 
     /**
-     * @brief Save current module states to disk for restoration on next start
+     * @brief Commit the state journal as a snapshot and close it
+     *
+     * Called at the start of shutdown, so the transitions made while taking modules
+     * down are not recorded and the next start restores the pre-shutdown states.
      * @return true on success, false on failure
      */
-    bool save_module_states() const;
+    bool save_module_states();
 
     /**
-     * @brief Load saved module states from disk
+     * @brief Open the state journal and replay the saved module states
+     *
+     * A modules directory without a journal but with a legacy `.helix_state.json`
+     * is migrated: the JSON states are imported into a snapshot and the file removed.
      * @param out_states Map of module name -> saved state
-     * @return true if loaded successfully (or file not present), false on parse/read errors
+     * @return true if loaded successfully (or nothing saved), false if the journal cannot be opened
+     */
+    bool load_saved_module_states(std::unordered_map<std::string, ModuleState>& out_states);
+
+    /**
+     * @brief Parse the legacy JSON state file
+     * @return true if loaded successfully or the file is not present
      */
-    bool load_saved_module_states(std::unordered_map<std::string, ModuleState>& out_states) const;
+    bool load_legacy_state_file(std::unordered_map<std::string, ModuleState>& out_states) const;
 
     /**
      * @brief Apply previously saved states by enabling/starting modules as needed
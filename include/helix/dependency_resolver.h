@@ -2,9 +2,11 @@
 #define HELIX_DEPENDENCY_RESOLVER_H
 
 #include "helix/manifest.h"
+#include "helix/semver.h"
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
 #include <string>
 
 namespace helix {
@@ -14,8 +16,10 @@ namespace helix {
  */
 struct ResolutionResult {
     std::vector<std::string> load_order;    ///< Modules in load order (dependencies first)
+    std::vector<std::vector<std::string>> load_layers; ///< load_order split into layers; a layer only depends on earlier ones
     std::vector<std::string> missing_deps;  ///< Dependencies that couldn't be resolved
     std::vector<std::string> circular_deps; ///< Modules involved in circular dependencies
+    std::vector<std::string> version_conflicts; ///< "module -> dependency: requires R, found V" for present but unsatisfying dependencies
     bool success;                           ///< Whether resolution was successful
 };
 
@@ -23,7 +27,15 @@ struct ResolutionResult {
  * @brief Dependency resolver for Helix modules
  * 
  * Builds dependency graphs from module manifests and determines the correct
- * load order. Detects circular dependencies and missing dependencies.
+ * load order. Detects circular dependencies, missing dependencies and
+ * dependencies whose version does not satisfy the declared range. Versions and
+ * ranges are parsed once in add_module(); range checks during resolution are
+ * integer comparisons whose results are memoized per (range, version) pair.
+ *
+ * Module names are interned to dense ids. add_module()/remove_module() update
+ * the adjacency lists and CSR rows of the touched nodes only, and resolution
+ * walks the CSR rows in a single iterative DFS that yields the load order,
+ * cycles, missing dependencies and version conflicts together.
  */
 class DependencyResolver {
 public:
@@ -89,90 +101,97 @@ public:
      */
     std::vector<std::string> get_dependents(const std::string& module_name) const;
 
+    /**
+     * @brief Check whether module needs dependency, directly or through other modules
+     *
+     * Only present modules and active edges count (an optional dependency that is
+     * not installed leads nowhere).
+     */
+    bool depends_on(const std::string& module_name, const std::string& dependency) const;
+
     /**
      * @brief Check if version requirement is satisfied
      * @param available_version Version that's available
-     * @param required_version Version requirement (e.g., ">=1.0.0")
-     * @return true if requirement is satisfied, false otherwise
+     * @param required_version Version range (e.g., ">=1.0.0", ">=1.2.0 <2.0.0"); see VersionRange
+     * @return true if requirement is satisfied, false otherwise (including unparsable input)
      */
     static bool version_satisfies(const std::string& available_version, 
                                   const std::string& required_version);
 
 private:
-    std::unordered_map<std::string, ModuleManifest> modules_;
-    std::unordered_map<std::string, std::unordered_set<std::string>> dependency_graph_;
-    std::unordered_map<std::string, std::unordered_set<std::string>> reverse_graph_;
-
-    /**
-     * @brief Build the dependency graph from loaded modules
-     */
-    void build_dependency_graph();
-
-    /**
-     * @brief Perform topological sort on the dependency graph
-     * @param target_modules Modules to include in sort
-     * @param load_order Output load order
-     * @return true if successful (no cycles), false if cycles detected
-     */
-    bool topological_sort(const std::vector<std::string>& target_modules,
-                         std::vector<std::string>& load_order);
-
-    /**
-     * @brief Detect circular dependencies in the graph
-     * @param target_modules Modules to check
-     * @return Vector of modules involved in cycles
-     */
-    std::vector<std::string> detect_circular_dependencies(const std::vector<std::string>& target_modules);
-
-    /**
-     * @brief Find missing dependencies
-     * @param target_modules Modules to check
-     * @return Vector of missing dependency names
-     */
-    std::vector<std::string> find_missing_dependencies(const std::vector<std::string>& target_modules);
-
-    /**
-     * @brief Recursive helper for cycle detection (DFS)
-     * @param node Current node being visited
-     * @param visited Set of visited nodes
-     * @param rec_stack Set of nodes in current recursion stack
-     * @param cycle_nodes Output set of nodes in cycles
-     * @return true if cycle detected, false otherwise
-     */
-    bool detect_cycle_dfs(const std::string& node,
-                         std::unordered_set<std::string>& visited,
-                         std::unordered_set<std::string>& rec_stack,
-                         std::unordered_set<std::string>& cycle_nodes);
-
-    /**
-     * @brief Parse version requirement string
-     * @param requirement Version requirement (e.g., ">=1.0.0", "1.2.3", "~1.0")
-     * @param operator_out Output operator (>=, ==, ~, etc.)
-     * @param version_out Output version string
-     * @return true if parsing succeeded, false otherwise
-     */
-    static bool parse_version_requirement(const std::string& requirement,
-                                        std::string& operator_out,
-                                        std::string& version_out);
-
-    /**
-     * @brief Compare two semantic versions
-     * @param version1 First version
-     * @param version2 Second version
-     * @return -1 if version1 < version2, 0 if equal, 1 if version1 > version2
-     */
-    static int compare_versions(const std::string& version1, const std::string& version2);
-
-    /**
-     * @brief Parse a semantic version string into components
-     * @param version Version string
-     * @param major Output major version
-     * @param minor Output minor version
-     * @param patch Output patch version
-     * @return true if parsing succeeded, false otherwise
-     */
-    static bool parse_version_components(const std::string& version,
-                                       int& major, int& minor, int& patch);
+    using ModuleId = uint32_t;
+    static constexpr uint32_t kInvalidId = UINT32_MAX;
+
+    /// A declared dependency edge; the target may be a name that is not (yet) present
+    struct Edge {
+        ModuleId target;
+        uint32_t range;    ///< Interned VersionRange id, kInvalidId if unparsable
+        bool optional;
+    };
+
+    /**
+     * @brief One interned module name
+     *
+     * Names referenced only as dependencies get a node with present == false, so
+     * adding the module later links it to its dependents without touching them.
+     */
+    struct Node {
+        std::string name;
+        bool present = false;
+        ModuleManifest manifest;
+        uint32_t version = kInvalidId;      ///< Interned SemVer id
+        std::vector<Edge> deps;             ///< Declared dependencies, in manifest order
+        std::vector<ModuleId> dependents;   ///< Present modules that declare this one
+    };
+
+    std::unordered_map<std::string, ModuleId> ids_;
+    std::deque<Node> nodes_;                ///< Indexed by ModuleId; deque keeps manifest pointers stable
+
+    /// A node's slice of csr_edges_; slots past length are slack for later growth
+    struct Row {
+        uint32_t start = 0;
+        uint32_t length = 0;
+        uint32_t capacity = 0;
+    };
+
+    // CSR copy of every node's deps, updated row by row on add/remove
+    std::vector<Row> csr_rows_;             ///< Indexed by ModuleId
+    std::vector<Edge> csr_edges_;
+    size_t csr_abandoned_ = 0;              ///< Slots of rows that moved to the end
+
+    // Per-resolution DFS scratch, valid where stamp_[id] == epoch_
+    std::vector<uint32_t> stamp_;
+    std::vector<uint8_t> on_stack_;
+    std::vector<uint32_t> layer_;
+    uint32_t epoch_ = 0;
+
+    std::vector<SemVer> versions_;
+    std::unordered_map<std::string, uint32_t> version_ids_;
+    std::vector<VersionRange> ranges_;
+    std::unordered_map<std::string, uint32_t> range_ids_;
+    std::unordered_map<uint64_t, bool> satisfies_cache_; ///< (range id << 32 | version id) -> result
+
+    /// Id of name, creating a not-present node if it is new
+    ModuleId intern_module(const std::string& name);
+
+    /// Present node for name, or nullptr
+    const Node* find_present(const std::string& name) const;
+
+    /// An edge counts unless it is optional and its target is absent
+    bool edge_active(const Edge& edge) const { return nodes_[edge.target].present || !edge.optional; }
+
+    /// Store deps as id's CSR row: in place if it fits, else moved to the end with slack
+    void write_row(ModuleId id, const std::vector<Edge>& deps);
+
+    /// Repack every row contiguously once abandoned slots outweigh live ones
+    void compact_rows();
+
+    /// Intern a version or range by its text; kInvalidId if it does not parse
+    uint32_t intern_version(const std::string& text);
+    uint32_t intern_range(const std::string& text);
+
+    /// Memoized ranges_[range].satisfied_by(versions_[version])
+    bool range_satisfied(uint32_t range, uint32_t version);
 };
 
 } // namespace helix
@@ -0,0 +1,66 @@
+#ifndef HELIX_EXPORT_TABLE_H
+#define HELIX_EXPORT_TABLE_H
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief Process-wide table of the symbols modules publish through their manifest's "exports"
+ *
+ * Modules are loaded with RTLD_LOCAL, so this table is the only way their symbols
+ * reach other modules. Each name has exactly one provider; a second module trying
+ * to publish a taken name fails to load instead of silently interposing. Modules
+ * query the table through helix_export_lookup() (see helix/exports.h).
+ */
+class ExportTable {
+public:
+    static ExportTable& instance();
+
+    /**
+     * @brief Publish all of a module's exports, or none of them
+     * @param module Providing module
+     * @param symbols Name/address pairs
+     * @param error Receives the conflicting name and its current provider on failure
+     * @return false if any name is already provided by another module
+     */
+    bool publish(const std::string& module, const std::vector<std::pair<std::string, void*>>& symbols,
+                 std::string& error);
+
+    /**
+     * @brief Swap a module's exports for a new set in one step (used by upgrades)
+     *
+     * Names the new set drops are withdrawn; lookups never see a mix of old and new.
+     * @param old_resolved If set, receives whether lookup() handed out any address of the
+     *        replaced set; such addresses keep pointing into the instance they came from
+     * @return false, leaving the old set in place, if a name belongs to another module
+     */
+    bool replace(const std::string& module, const std::vector<std::pair<std::string, void*>>& symbols,
+                 std::string& error, bool* old_resolved = nullptr);
+
+    /// Remove every symbol published by module
+    void withdraw(const std::string& module);
+
+    /// Address of an exported symbol, or nullptr
+    void* lookup(const char* name) const;
+
+private:
+    struct Entry {
+        Entry(const std::string& module, void* address) : module(module), address(address) {}
+        std::string module;
+        void* address;
+        mutable std::atomic<bool> resolved{false}; ///< Set by the first lookup() of this name
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, Entry> symbols_;
+};
+
+} // namespace helix
+
+#endif // HELIX_EXPORT_TABLE_H
@@ -0,0 +1,72 @@
+#ifndef HELIX_EXPORTS_H
+#define HELIX_EXPORTS_H
+
+/**
+ * @file exports.h
+ * @brief Lookup of symbols published by other modules
+ *
+ * Modules are loaded with RTLD_LOCAL, so a symbol one module defines is not
+ * visible to the others through the dynamic linker. A provider lists the
+ * symbols it shares in its manifest:
+ *
+ * @code
+ * "exports": ["metrics_counter_add"]
+ * @endcode
+ *
+ * and marks them HELIX_EXPORT so hidden-visibility builds keep them:
+ *
+ * @code
+ * extern "C" HELIX_EXPORT void metrics_counter_add(const char* name, long delta);
+ * @endcode
+ *
+ * and a consumer (which should list the provider in "dependencies") resolves
+ * them once, typically in init:
+ *
+ * @code
+ * using CounterAddFn = void (*)(const char*, long);
+ * static CounterAddFn counter_add = helix_find_export<CounterAddFn>("metrics_counter_add");
+ * @endcode
+ *
+ * Returned addresses stay valid while the provider is loaded. Upgrading the
+ * provider publishes the new build's addresses to later lookups but cannot
+ * redirect one already resolved: it keeps reaching the replaced instance, which
+ * the daemon keeps mapped, stopped and destroyed, until the provider is
+ * unloaded. A consumer that must follow upgrades resolves again before each
+ * use, or uses a service (helix/service.h), whose slot switches for it.
+ */
+
+#ifdef __unix__
+#include <dlfcn.h>
+#endif
+
+// Keeps a symbol in the module's dynamic symbol table when it is built with
+// -fvisibility=hidden (helxcompiler --profile); use it on everything in "exports"
+#if defined(__GNUC__)
+#define HELIX_EXPORT __attribute__((visibility("default")))
+#else
+#define HELIX_EXPORT
+#endif
+
+using HelixExportLookupFn = void* (*)(const char*);
+
+// Address of a symbol another module exported, or nullptr (unknown name, or no daemon)
+inline void* helix_find_export(const char* name) {
+#ifdef __unix__
+    static HelixExportLookupFn lookup_fn = nullptr;
+    if (!lookup_fn) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_export_lookup");
+        if (sym) lookup_fn = reinterpret_cast<HelixExportLookupFn>(sym);
+    }
+    return lookup_fn ? lookup_fn(name) : nullptr;
+#else
+    (void)name; return nullptr;
+#endif
+}
+
+// Typed form: helix_find_export<FnPtr>("name") or helix_find_export<Data*>("name")
+template <typename T>
+inline T helix_find_export(const char* name) {
+    return reinterpret_cast<T>(helix_find_export(name));
+}
+
+#endif // HELIX_EXPORTS_H
@@ -0,0 +1,130 @@
+#ifndef HELIX_HOST_CHANNEL_H
+#define HELIX_HOST_CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace helix {
+
+/**
+ * @brief Message channel between helixd and a module host process
+ *
+ * Two single-consumer rings of fixed 512-byte slots live in one memfd mapping
+ * shared by both processes, one ring per direction, each with an eventfd to wake
+ * its reader. Sending copies the message into the next slot and publishes it with
+ * a release store; the eventfd is written only when the reader has announced that
+ * it is about to block. A reader spins briefly before blocking (on machines with
+ * more than one CPU), so a request and its reply cross in a few microseconds when
+ * both sides are busy and cost two eventfd writes when they are not.
+ *
+ * Requests the daemon answers with a file descriptor (the memfd of a message bus
+ * topic) go over a separate SOCK_SEQPACKET socket pair instead, since only a
+ * socket can carry descriptors: request() on the host side, next_request() and
+ * answer() on the daemon side. They are rare and not latency-sensitive.
+ *
+ * Senders within one process are serialized by a local mutex.
+ * Payloads longer than kMaxPayload are truncated.
+ */
+class HostChannel {
+public:
+    static constexpr size_t kSlotSize = 512;
+    static constexpr size_t kSlots = 128;
+    static constexpr size_t kMaxPayload = kSlotSize - 24;
+
+    /// File descriptor numbers the channel has in a host process
+    static constexpr int kHostMemoryFd = 3;
+    static constexpr int kHostInboxFd = 4;  ///< Wakes the host
+    static constexpr int kHostOutboxFd = 5; ///< Wakes the daemon
+    static constexpr int kHostRequestFd = 6; ///< Host end of the request socket
+
+    enum Type : uint16_t {
+        kReady = 1, ///< host -> daemon: module opened (value 0) or not (value -1, payload = error)
+        kCall,      ///< daemon -> host: run entry point `op`
+        kReply,     ///< host -> daemon: entry point `op` returned `value`
+        kLog,       ///< host -> daemon: log record, op = level, payload = "module\0message"
+        kExit,      ///< daemon -> host: exit now
+        kOpenTopic, ///< host -> daemon request: payload = topic name, value = slot_size << 32 | capacity
+        kTopic,     ///< daemon -> host answer: value 0 with the topic's memfd attached, or -1 (payload = error)
+    };
+
+    struct Message {
+        uint16_t type = 0;
+        uint16_t op = 0;
+        uint64_t id = 0;
+        int64_t value = 0;
+        std::string payload;
+    };
+
+    HostChannel() = default;
+    ~HostChannel();
+    HostChannel(const HostChannel&) = delete;
+    HostChannel& operator=(const HostChannel&) = delete;
+
+    /// Create the shared memory and eventfds (daemon side)
+    bool create(std::string& error);
+
+    /// Map a channel passed down by create() (host side, kHost*Fd descriptors)
+    bool attach(int memory_fd, int inbox_fd, int outbox_fd, int request_fd, std::string& error);
+
+    int memory_fd() const { return memory_fd_; }
+    int host_inbox_fd() const { return efd_[0]; }
+    int host_outbox_fd() const { return efd_[1]; }
+    int host_request_fd() const { return request_fd_[1]; }
+
+    /// Close the daemon's copy of the host's request socket once the host has its own
+    void close_host_request_fd();
+
+    /**
+     * @brief Queue a message for the other side
+     * @param timeout_ms How long to wait for a free slot; 0 fails at once, -1 waits forever
+     */
+    bool send(const Message& message, int timeout_ms = -1);
+
+    /// Next message from the other side; false if none arrived within timeout_ms (-1: forever)
+    bool receive(Message& out, int timeout_ms);
+
+    /// Messages dropped by send() with a zero timeout because the ring was full
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Send a request over the request socket and wait for its answer (host side)
+     * @param fd Receives the descriptor attached to the answer, or -1
+     * @return false if the daemon has gone
+     */
+    bool request(const Message& request, Message& answer, int& fd);
+
+    /// Wait for the host's next request (daemon side); false once the host has gone or shutdown_requests() ran
+    bool next_request(Message& out);
+
+    /// Answer the request next_request() returned, attaching fd unless it is -1 (the caller keeps it)
+    bool answer(const Message& message, int fd);
+
+    /// Make a blocked next_request() return false
+    void shutdown_requests();
+
+private:
+    struct Ring;
+    struct Shared;
+
+    bool map(std::string& error);
+    Ring& outbox() const;
+    Ring& inbox() const;
+    bool try_pop(Message& out);
+
+    bool host_ = false;
+    int memory_fd_ = -1;
+    int efd_[2] = {-1, -1}; ///< [0] wakes the host, [1] wakes the daemon
+    int request_fd_[2] = {-1, -1}; ///< [0] this side's end of the request socket, [1] the host's (daemon only)
+    Shared* shared_ = nullptr;
+    std::mutex send_mutex_;
+    std::mutex request_mutex_;
+    std::atomic<uint64_t> dropped_{0};
+    bool spin_ = false;
+};
+
+} // namespace helix
+
+#endif // HELIX_HOST_CHANNEL_H
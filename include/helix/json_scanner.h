@@ -0,0 +1,132 @@
+#ifndef HELIX_JSON_SCANNER_H
+#define HELIX_JSON_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace helix {
+
+/**
+ * @brief Single-pass pull scanner over an in-memory JSON document
+ *
+ * Walks the text once without building a tree: callers step through objects and
+ * arrays, read the scalars they need and skip_value() the rest. Strings without
+ * escapes are returned as views into the input, so well-formed manifests are read
+ * without per-value allocations. Errors are sticky; after the first one every call
+ * returns false and error() describes it. Skipped containers are only checked for
+ * balanced brackets and terminated strings, and a trailing comma before a closing
+ * bracket is accepted (older helxcompiler releases wrote one).
+ *
+ * @code
+ * JsonScanner in(text);
+ * std::string_view key;
+ * if (in.enter_object()) {
+ *     while (in.next_member(key)) {
+ *         if (key == "name") in.read_string(name);
+ *         else in.skip_value();
+ *     }
+ * }
+ * @endcode
+ */
+class JsonScanner {
+public:
+    enum class Type { Object, Array, String, Number, Bool, Null, Invalid };
+
+    explicit JsonScanner(std::string_view text) : text_(text) {}
+
+    /// Type of the next value (after whitespace), without consuming it
+    Type peek();
+
+    /// Consume '{'; then call next_member() until it returns false
+    bool enter_object();
+
+    /**
+     * @brief Advance to the next member of the current object
+     * @param key Receives the member name (views the input or an internal buffer,
+     *            valid until the next call)
+     * @return false at the closing '}' (which is consumed) or on error
+     */
+    bool next_member(std::string_view& key);
+
+    /// Consume '['; then call next_element() until it returns false
+    bool enter_array();
+
+    /// Advance to the next array element; false at the closing ']' (consumed) or on error
+    bool next_element();
+
+    /**
+     * @brief Read a string value
+     * @param out Views the input when the string has no escapes, otherwise scratch
+     * @param scratch Receives the decoded text of escaped strings
+     */
+    bool read_string(std::string_view& out, std::string& scratch);
+    bool read_string(std::string& out);
+
+    bool read_bool(bool& out);
+
+    /// Read a non-negative integer that fits in 64 bits
+    bool read_unsigned(uint64_t& out);
+
+    /// Read a number literal as its raw text
+    bool read_number(std::string_view& raw);
+
+    /**
+     * @brief Skip one value of any type
+     * @param raw If given, receives the value's source text
+     */
+    bool skip_value(std::string_view* raw = nullptr);
+
+    /// True once only whitespace remains
+    bool at_end();
+
+    bool failed() const { return !error_.empty(); }
+    const std::string& error() const { return error_; }
+    size_t offset() const { return pos_; }
+
+private:
+    bool fail(const std::string& what);
+    void skip_ws();
+    bool expect(char c);
+    bool scan_string(std::string_view& out, std::string& scratch);
+    bool scan_number(std::string_view& raw);
+    bool scan_literal(std::string_view word);
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    bool first_ = false;     ///< Next member/element is the first of its container
+    std::string key_buf_;    ///< Decoded key when it contained escapes
+    std::string error_;
+};
+
+/**
+ * @brief Numeric core and suffix of a semantic version, viewing the scanned text
+ */
+struct SemverView {
+    uint64_t major = 0;
+    uint64_t minor = 0;
+    uint64_t patch = 0;
+    std::string_view suffix; ///< Pre-release/build part including its leading '-' or '+'; may be empty
+};
+
+/**
+ * @brief Scan "MAJOR.MINOR.PATCH" at the start of text, plus an optional suffix
+ *        ('-' or '+' followed by letters, digits, '.' and '-')
+ * @param rest If given, receives whatever follows the version
+ * @return false if text does not start with three dot-separated decimal numbers
+ */
+bool scan_semver(std::string_view text, SemverView& out, std::string_view* rest = nullptr);
+
+/**
+ * @brief Split a requirement such as ">= 1.2.0" into its operator and version text
+ *
+ * Recognized operators are ">=", "<=", ">", "<", "~" and "=="; whitespace after the
+ * operator is dropped. A requirement without an operator yields an empty op.
+ * @return false if nothing follows the operator
+ */
+bool split_version_requirement(std::string_view requirement, std::string_view& op, std::string_view& version);
+
+} // namespace helix
+
+#endif // HELIX_JSON_SCANNER_H
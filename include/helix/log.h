@@ -3,6 +3,10 @@
 
 #include <string>
 #include <cstdint>
+#include <cstddef>
+#include <cstdarg>
+#include <cstdio>
+#include <atomic>
 
 #ifdef __unix__
 #include <dlfcn.h>
@@ -21,8 +25,26 @@ using HelixLogEmitFn = void (*)(const char*, int, const char*);
 using HelixLogDispatchFn = void (*)(const char*, int, const char*);
 using HelixLogRegisterSinkFn = void (*)(HelixLogEmitFn);
 using HelixLogUnregisterSinkFn = void (*)(HelixLogEmitFn);
+using HelixLogDispatchNFn = void (*)(const char*, int, const char*, size_t);
+
+// Structured record passed to v2 sinks. Pointers are only valid for the duration of the sink call.
+struct HelixLogRecord {
+    uint64_t    timestamp_ns; // CLOCK_MONOTONIC time the record was produced
+    uint64_t    thread_id;    // kernel thread id (gettid) of the producer
+    uint32_t    module_id;    // interned module id, stable for the life of the process
+    int32_t     level;        // HelixLogLevel
+    const char* module;       // interned module name (lives as long as the process)
+    const char* message;      // NUL-terminated message text
+    size_t      message_len;  // length of message, excluding the terminator
+};
+
+// v2 sinks receive records in batches; 'user' is the pointer given at registration.
+using HelixLogSinkV2Fn = void (*)(const HelixLogRecord* records, size_t count, void* user);
+using HelixLogRegisterSinkV2Fn = void (*)(HelixLogSinkV2Fn, void*);
+using HelixLogUnregisterSinkV2Fn = void (*)(HelixLogSinkV2Fn, void*);
 
 // Stats structure shared with the registry. Optional: will be zeroed if not supported.
+// Part of the module ABI: its layout is frozen. New counters go in HelixLogStatsV2.
 struct HelixLogStats {
     uint64_t dispatched;        // total messages dispatched to sinks (post-filter)
     uint64_t dropped;           // total dropped for any reason
@@ -30,26 +52,93 @@ struct HelixLogStats {
     uint64_t dropped_filtered;  // dropped due to level filter
     uint64_t queued;            // current pre-sink queue size
     uint64_t queue_capacity;    // configured capacity for pre-sink queue
-    uint64_t sinks;             // number of registered sinks
+    uint64_t sinks;             // number of registered sinks (v1 and v2)
     int      min_level;         // current minimum level filter
 };
 
+// Extended stats. The caller sets struct_size to sizeof(HelixLogStatsV2) as it was compiled;
+// the registry fills only the fields that fit, so fields may only ever be appended.
+struct HelixLogStatsV2 {
+    uint32_t struct_size;       // bytes available to the registry, including this field
+    int32_t  min_level;         // current minimum level filter
+    uint64_t dispatched;        // total messages dispatched to sinks (post-filter)
+    uint64_t dropped;           // total dropped for any reason
+    uint64_t dropped_overflow;  // dropped due to bounded pre-sink queue overflow
+    uint64_t dropped_filtered;  // dropped due to level filter
+    uint64_t queued;            // current pre-sink queue size
+    uint64_t queue_capacity;    // configured capacity for pre-sink queue
+    uint64_t sinks;             // number of registered sinks (v1 and v2)
+    uint64_t ring_capacity;     // async ring capacity in records (0 when async mode is off)
+    uint64_t ring_high_water;   // highest async ring depth observed
+    uint64_t ring_dropped_overflow; // dropped because the async ring was full
+};
+
 using HelixLogGetStatsFn = void (*)(HelixLogStats*);
+using HelixLogGetStatsV2Fn = void (*)(HelixLogStatsV2*);
 using HelixLogSetMinLevelFn = void (*)(int);
 using HelixLogGetMinLevelFn = int (*)();
+using HelixLogMinLevelRefFn = const void* (*)(); // returns the registry's std::atomic<int> level
+#endif
+
+// Compile-time floor for the HELIX_LOGF_* macros. Statements below it compile to nothing.
+// Define before including this header, e.g. -DHELIX_LOG_COMPILED_MIN_LEVEL=1 to strip DEBUG.
+#ifndef HELIX_LOG_COMPILED_MIN_LEVEL
+#define HELIX_LOG_COMPILED_MIN_LEVEL 0
 #endif
 
-// Modules call this helper. It attempts to route to a logging module's
-// helix_log_emit exported symbol via a central dispatcher. The central
-// registry manages pre-sink buffering, filtering, and stats. No printing here.
-inline void helix_log(const char* module_name, const char* message, HelixLogLevel level = HELIX_LOG_INFO) {
 #ifdef __unix__
+inline HelixLogDispatchFn helix_log_dispatch_fn() {
     static HelixLogDispatchFn dispatch_fn = nullptr;
     if (!dispatch_fn) {
         void* sym = dlsym(RTLD_DEFAULT, "helix_log_dispatch");
         if (sym) dispatch_fn = reinterpret_cast<HelixLogDispatchFn>(sym);
     }
-    if (dispatch_fn) {
+    return dispatch_fn;
+}
+
+// Length-aware dispatch: saves the registry a strlen when the caller already knows it.
+inline HelixLogDispatchNFn helix_log_dispatch_n_fn() {
+    static std::atomic<HelixLogDispatchNFn> dispatch_n_fn{nullptr};
+    HelixLogDispatchNFn fn = dispatch_n_fn.load(std::memory_order_relaxed);
+    if (!fn) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_log_dispatch_n");
+        if (sym) dispatch_n_fn.store(fn = reinterpret_cast<HelixLogDispatchNFn>(sym), std::memory_order_relaxed);
+    }
+    return fn;
+}
+
+// Cached pointer to the registry's live minimum level; reading it is a relaxed load.
+inline const std::atomic<int>* helix_log_level_ref() {
+    static std::atomic<const std::atomic<int>*> level_ref{nullptr};
+    const std::atomic<int>* ref = level_ref.load(std::memory_order_relaxed);
+    if (!ref) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_log_min_level_ref");
+        if (sym) {
+            ref = static_cast<const std::atomic<int>*>(reinterpret_cast<HelixLogMinLevelRefFn>(sym)());
+            level_ref.store(ref, std::memory_order_relaxed);
+        }
+    }
+    return ref;
+}
+#endif
+
+// True if a message at 'level' would pass the registry's runtime filter.
+// Without a registry this returns false, matching helix_log() being a no-op.
+inline bool helix_log_enabled(HelixLogLevel level) {
+#ifdef __unix__
+    const std::atomic<int>* ref = helix_log_level_ref();
+    return ref && static_cast<int>(level) >= ref->load(std::memory_order_relaxed);
+#else
+    (void)level; return false;
+#endif
+}
+
+// Modules call this helper. It attempts to route to a logging module's
+// helix_log_emit exported symbol via a central dispatcher. The central
+// registry manages pre-sink buffering, filtering, and stats. No printing here.
+inline void helix_log(const char* module_name, const char* message, HelixLogLevel level = HELIX_LOG_INFO) {
+#ifdef __unix__
+    if (HelixLogDispatchFn dispatch_fn = helix_log_dispatch_fn()) {
         dispatch_fn(module_name ? module_name : "(unknown)", static_cast<int>(level), message ? message : "");
     }
 #else
@@ -57,6 +146,52 @@ inline void helix_log(const char* module_name, const char* message, HelixLogLeve
 #endif
 }
 
+// printf-style variant used by the HELIX_LOGF_* macros. Formats into a stack buffer
+// and only allocates for messages longer than 512 bytes.
+#if defined(__GNUC__)
+__attribute__((format(printf, 3, 4)))
+#endif
+inline void helix_logf(const char* module_name, HelixLogLevel level, const char* fmt, ...) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = std::vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (static_cast<size_t>(n) < sizeof(buf)) {
+#ifdef __unix__
+        if (HelixLogDispatchNFn dispatch_n = helix_log_dispatch_n_fn()) {
+            dispatch_n(module_name ? module_name : "(unknown)", static_cast<int>(level), buf, static_cast<size_t>(n));
+            return;
+        }
+#endif
+        helix_log(module_name, buf, level);
+        return;
+    }
+    std::string big(static_cast<size_t>(n) + 1, '\0');
+    va_start(ap, fmt);
+    std::vsnprintf(&big[0], big.size(), fmt, ap);
+    va_end(ap);
+    big.resize(static_cast<size_t>(n));
+    helix_log(module_name, big.c_str(), level);
+}
+
+// Lazily formatted logging. Arguments are not evaluated and nothing is formatted unless
+// the level passes both HELIX_LOG_COMPILED_MIN_LEVEL and the cached runtime level:
+//   HELIX_LOGF_DEBUG("MyModule", "queue depth %zu", q.size());
+// Messages skipped here never reach the registry, so they are not counted in
+// HelixLogStats::dropped_filtered.
+#define HELIX_LOGF(level, module_name, ...) \
+    do { \
+        if (static_cast<int>(level) >= HELIX_LOG_COMPILED_MIN_LEVEL && helix_log_enabled(level)) \
+            helix_logf((module_name), (level), __VA_ARGS__); \
+    } while (0)
+
+#define HELIX_LOGF_DEBUG(module_name, ...) HELIX_LOGF(HELIX_LOG_DEBUG, module_name, __VA_ARGS__)
+#define HELIX_LOGF_INFO(module_name, ...)  HELIX_LOGF(HELIX_LOG_INFO, module_name, __VA_ARGS__)
+#define HELIX_LOGF_WARN(module_name, ...)  HELIX_LOGF(HELIX_LOG_WARN, module_name, __VA_ARGS__)
+#define HELIX_LOGF_ERROR(module_name, ...) HELIX_LOGF(HELIX_LOG_ERROR, module_name, __VA_ARGS__)
+
 // Helper accessors for logger modules to discover the registration functions.
 // A logger module can do:
 //   auto reg = helix_log_get_register(); if (reg) reg(my_sink);
@@ -78,6 +213,26 @@ inline HelixLogUnregisterSinkFn helix_log_get_unregister() {
 #endif
 }
 
+// v2 sink registration: batches of HelixLogRecord instead of (module, level, message) triples.
+//   auto reg = helix_log_get_register_v2(); if (reg) reg(&my_batch_sink, my_state);
+inline HelixLogRegisterSinkV2Fn helix_log_get_register_v2() {
+#ifdef __unix__
+    void* sym = dlsym(RTLD_DEFAULT, "helix_log_register_sink_v2");
+    return sym ? reinterpret_cast<HelixLogRegisterSinkV2Fn>(sym) : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+inline HelixLogUnregisterSinkV2Fn helix_log_get_unregister_v2() {
+#ifdef __unix__
+    void* sym = dlsym(RTLD_DEFAULT, "helix_log_unregister_sink_v2");
+    return sym ? reinterpret_cast<HelixLogUnregisterSinkV2Fn>(sym) : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
 // Optional: query central logging stats; returns false if unsupported.
 inline bool helix_log_get_stats(struct HelixLogStats* out) {
 #ifdef __unix__
@@ -92,6 +247,22 @@ inline bool helix_log_get_stats(struct HelixLogStats* out) {
 #endif
 }
 
+// Optional: query extended stats (async ring counters); returns false if unsupported.
+// Sets out->struct_size itself; fields the registry does not know are left zeroed.
+inline bool helix_log_get_stats_v2(struct HelixLogStatsV2* out) {
+#ifdef __unix__
+    if (!out) return false;
+    *out = HelixLogStatsV2{};
+    out->struct_size = static_cast<uint32_t>(sizeof(HelixLogStatsV2));
+    void* sym = dlsym(RTLD_DEFAULT, "helix_log_stats_get_v2");
+    if (!sym) return false;
+    reinterpret_cast<HelixLogGetStatsV2Fn>(sym)(out);
+    return true;
+#else
+    (void)out; return false;
+#endif
+}
+
 inline void helix_log_set_min_level(HelixLogLevel level) {
 #ifdef __unix__
     void* sym = dlsym(RTLD_DEFAULT, "helix_log_min_level_set");
@@ -17,6 +17,33 @@ struct EntryPoints {
     std::string destroy = "helix_module_destroy"; ///< Destroy entry point symbol
 };
 
+/**
+ * @brief Per-module limits for lifecycle calls, in milliseconds
+ *
+ * 0 leaves the daemon-wide default in effect.
+ */
+struct LifecycleTimeouts {
+    unsigned init_ms = 0;  ///< Limit for the init entry point
+    unsigned start_ms = 0; ///< Limit for the start entry point
+    unsigned stop_ms = 0;  ///< Limit for the stop entry point
+};
+
+/**
+ * @brief How a module's symbols are exposed to the rest of the process
+ *
+ * Local modules are loaded with RTLD_LOCAL: nothing they define joins the
+ * global symbol scope, and only the names listed in exports are published in
+ * the daemon's export table (see helix/exports.h). Global restores RTLD_GLOBAL
+ * for modules whose dependents link against their symbols directly. Process
+ * runs the module in its own helix-modhost process (see ModuleHost); it cannot
+ * export symbols.
+ */
+struct ModuleLinkage {
+    bool global = false;              ///< "isolation": "global" (default "local")
+    bool process = false;             ///< "isolation": "process"
+    std::vector<std::string> exports; ///< "exports": symbols other modules may look up
+};
+
 /**
  * @brief Represents a module dependency
  */
@@ -55,15 +82,23 @@ struct ModuleManifest {
 
     // Entry points
     EntryPoints entry_points; ///< Optional custom entry points; defaults provided
+
+    // Lifecycle limits
+    LifecycleTimeouts timeouts; ///< Optional "timeouts" object: {"init": ms, "start": ms, "stop": ms}
+
+    // Symbol visibility
+    ModuleLinkage linkage; ///< Optional "isolation" ("local"/"global"/"process") and "exports" array
+
+    // Build
+    std::string build_profile; ///< helxcompiler --profile the binary was built with (empty: none)
 };
 
 /**
  * @brief Parser for Helix module manifest files
  * 
- * Handles parsing .helx module metadata in JSON format and validation.
- * Implementation uses nlohmann_json when available (preferred),
- * and falls back to a simplified parser otherwise.
- * of module dependencies and configuration.
+ * Handles parsing .helx module metadata in JSON format and validation
+ * of module dependencies and configuration. Parsing is a single pass of
+ * the shared JsonScanner (see json_scanner.h) over the file contents.
  */
 class ManifestParser {
 public:
@@ -102,7 +137,7 @@ public:
 
     /**
      * @brief Check if a dependency version requirement is valid
-     * @param requirement Version requirement string (e.g., ">=1.0.0", "1.2.3", "~1.4")
+     * @param requirement Version requirement string (e.g., ">=1.0.0", "1.2.3", ">=1.2.0 <2.0.0")
      * @return true if valid requirement format, false otherwise
      */
     static bool is_valid_version_requirement(const std::string& requirement);
@@ -137,30 +172,6 @@ public:
 private:
     std::string last_error_;
 
-    /**
-     * @brief Parse dependencies from JSON
-     * @param deps_json JSON array of dependencies
-     * @param dependencies Output vector of dependencies
-     * @return true if parsing succeeded, false otherwise
-     */
-    bool parse_dependencies(const std::string& deps_json, std::vector<Dependency>& dependencies);
-
-    /**
-     * @brief Parse configuration from JSON
-     * @param config_json JSON object of configuration
-     * @param config Output map of configuration
-     * @return true if parsing succeeded, false otherwise
-     */
-    bool parse_config(const std::string& config_json, std::unordered_map<std::string, std::string>& config);
-
-    /**
-     * @brief Parse string array from JSON
-     * @param array_json JSON array of strings
-     * @param output Output vector of strings
-     * @return true if parsing succeeded, false otherwise
-     */
-    bool parse_string_array(const std::string& array_json, std::vector<std::string>& output);
-
     /**
      * @brief Set error message
      * @param error Error message to set
@@ -0,0 +1,137 @@
+#ifndef HELIX_MEMORY_H
+#define HELIX_MEMORY_H
+
+/**
+ * @file memory.h
+ * @brief Arenas and fixed-size object pools owned by a module
+ *
+ * helixd provides two allocators whose memory belongs to the module instance
+ * that created them, and is released in one step when that instance is unloaded
+ * (after its library is closed), whether or not the module freed it:
+ *
+ * - An arena hands out memory by bumping a pointer through large blocks. Single
+ *   objects cannot be freed; helix_arena_reset() drops everything at once. Every
+ *   module has a default arena (helix_module_arena()), and can create more.
+ * - A pool hands out objects of one size. Each thread keeps a small cache of free
+ *   objects per pool, so an alloc/free pair on a warm thread takes no lock.
+ *
+ * Arenas and pools are charged to the instance whose lifecycle call, or whose
+ * helix_thread_create() thread, creates them; create them in `init` or later, not
+ * from static constructors. Both are thread-safe. Memory can be used from any
+ * thread, but must not be touched once the module's `destroy` has returned.
+ *
+ * @code
+ * static HelixPool* requests;
+ * HELIX_MODULE_INIT() {
+ *     requests = helix_pool_create(sizeof(Request), alignof(Request));
+ *     return requests ? 0 : -1;
+ * }
+ * // Request* r = static_cast<Request*>(helix_pool_alloc(requests)); ... helix_pool_free(requests, r);
+ * @endcode
+ *
+ * Outside helixd (no allocator exported) every function returns nullptr or does
+ * nothing.
+ */
+
+#include <cstddef>
+
+#ifdef __unix__
+#include <dlfcn.h>
+#endif
+
+struct HelixArena;
+struct HelixPool;
+
+#ifdef __unix__
+
+/// Entry points helixd exports for this header, resolved once per module
+struct HelixMemoryApi {
+    HelixArena* (*arena_create)(size_t block_size);
+    HelixArena* (*module_arena)();
+    void* (*arena_alloc)(HelixArena* arena, size_t size, size_t align);
+    void (*arena_reset)(HelixArena* arena);
+    void (*arena_destroy)(HelixArena* arena);
+    HelixPool* (*pool_create)(size_t object_size, size_t align);
+    void* (*pool_alloc)(HelixPool* pool);
+    void (*pool_free)(HelixPool* pool, void* object);
+    void (*pool_destroy)(HelixPool* pool);
+};
+
+using HelixMemoryApiFn = const HelixMemoryApi* (*)();
+
+inline const HelixMemoryApi* helix_memory_api() {
+    static const HelixMemoryApi* api = []() -> const HelixMemoryApi* {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_memory_api_get");
+        return sym ? reinterpret_cast<HelixMemoryApiFn>(sym)() : nullptr;
+    }();
+    return api;
+}
+
+/**
+ * @brief Create an arena that grabs memory in blocks of block_size bytes (0: 64 KiB)
+ */
+inline HelixArena* helix_arena_create(size_t block_size = 0) {
+    const HelixMemoryApi* api = helix_memory_api();
+    return api ? api->arena_create(block_size) : nullptr;
+}
+
+/// The calling module's default arena, created on first use
+inline HelixArena* helix_module_arena() {
+    const HelixMemoryApi* api = helix_memory_api();
+    return api ? api->module_arena() : nullptr;
+}
+
+/**
+ * @brief size bytes aligned to align (a power of two, 0: alignof(std::max_align_t))
+ * @return nullptr if out of memory
+ */
+inline void* helix_arena_alloc(HelixArena* arena, size_t size, size_t align = 0) {
+    const HelixMemoryApi* api = helix_memory_api();
+    return api && arena ? api->arena_alloc(arena, size, align) : nullptr;
+}
+
+/// Make all of the arena's memory available again; keeps its first block
+inline void helix_arena_reset(HelixArena* arena) {
+    if (const HelixMemoryApi* api = helix_memory_api()) {
+        if (arena) api->arena_reset(arena);
+    }
+}
+
+/// Free the arena and all its memory now instead of at unload
+inline void helix_arena_destroy(HelixArena* arena) {
+    if (const HelixMemoryApi* api = helix_memory_api()) {
+        if (arena) api->arena_destroy(arena);
+    }
+}
+
+/**
+ * @brief Create a pool of objects of object_size bytes aligned to align (0: alignof(std::max_align_t))
+ */
+inline HelixPool* helix_pool_create(size_t object_size, size_t align = 0) {
+    const HelixMemoryApi* api = helix_memory_api();
+    return api ? api->pool_create(object_size, align) : nullptr;
+}
+
+/// One uninitialized object; nullptr if out of memory
+inline void* helix_pool_alloc(HelixPool* pool) {
+    const HelixMemoryApi* api = helix_memory_api();
+    return api && pool ? api->pool_alloc(pool) : nullptr;
+}
+
+/// Return an object to the pool it came from
+inline void helix_pool_free(HelixPool* pool, void* object) {
+    if (const HelixMemoryApi* api = helix_memory_api()) {
+        if (pool && object) api->pool_free(pool, object);
+    }
+}
+
+/// Free the pool and every object in it now instead of at unload
+inline void helix_pool_destroy(HelixPool* pool) {
+    if (const HelixMemoryApi* api = helix_memory_api()) {
+        if (pool) api->pool_destroy(pool);
+    }
+}
+
+#endif // __unix__
+
+#endif // HELIX_MEMORY_H
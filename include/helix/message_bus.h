@@ -0,0 +1,92 @@
+#ifndef HELIX_MESSAGE_BUS_H
+#define HELIX_MESSAGE_BUS_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+struct HelixBusTopic;
+
+namespace helix {
+
+/**
+ * @brief Daemon-side registry of message bus topics (see helix/bus.h for the module API)
+ *
+ * Each topic is a broadcast ring in its own memfd. Producers claim slots with a
+ * CAS on the ring head and never block; every subscriber owns a cursor, and the
+ * slowest cursor bounds how far producers may run ahead, so a full ring drops the
+ * new message instead of overwriting unread ones. Slow paths (subscribing,
+ * recomputing the bound) take a process-shared mutex in the ring. Topics live
+ * until the daemon exits.
+ *
+ * helix-modhost processes map the same rings: their bus opens topics through a
+ * TopicSource, which asks helixd for the memfd (share()), so modules in and out
+ * of process exchange messages without copies or calls through the daemon.
+ */
+class MessageBus {
+public:
+    static constexpr uint32_t kDefaultSlotSize = 256;
+    static constexpr uint32_t kDefaultCapacity = 1024;
+    static constexpr uint32_t kMaxSubscribers = 32;
+
+    struct TopicStats {
+        std::string name;
+        uint32_t slot_size = 0;
+        uint32_t capacity = 0;
+        uint64_t depth = 0;       ///< Messages the slowest subscriber has not released yet
+        uint64_t published = 0;
+        uint64_t dropped = 0;     ///< Loans refused because the ring was full or the message too large
+        uint32_t subscribers = 0;
+    };
+
+    static MessageBus& instance();
+
+    MessageBus();
+    ~MessageBus();
+
+    /**
+     * @brief Open or create a topic
+     * @return nullptr with error set if the topic exists with smaller slots, or
+     *         the ring cannot be allocated
+     */
+    HelixBusTopic* topic(const std::string& name, uint32_t slot_size, uint32_t capacity, std::string& error);
+
+    /// Opens or creates a topic, returning a memfd the caller takes ownership of, or -1 with error set
+    using TopicSource = std::function<int(const std::string& name, uint32_t slot_size, uint32_t capacity,
+                                          std::string& error)>;
+
+    /**
+     * @brief Open or create a topic for another process
+     * @return The topic's memfd, owned by the bus (pass it on, do not close it), or -1 with error set
+     */
+    int share(const std::string& name, uint32_t slot_size, uint32_t capacity, std::string& error);
+
+    /// Map topics obtained from source instead of creating them (a module host, whose daemon owns the topics)
+    void set_topic_source(TopicSource source);
+
+    /// Close every subscription opened from a lifecycle call of one module instance (ModuleInfo::instance)
+    void release_instance(uint64_t instance);
+
+    /// Cancel the open loans and close the subscriptions of a process that has exited (a module host)
+    void release_process(pid_t pid);
+
+    /// Counters of every topic, sorted by name
+    std::vector<TopicStats> stats() const;
+
+private:
+    /// Map a topic from source_; caller holds mutex_
+    HelixBusTopic* attach(const std::string& name, uint32_t slot_size, uint32_t capacity, std::string& error);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<HelixBusTopic>> topics_;
+    TopicSource source_;
+};
+
+} // namespace helix
+
+#endif // HELIX_MESSAGE_BUS_H
@@ -0,0 +1,172 @@
+#ifndef HELIX_METRICS_H
+#define HELIX_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace helix {
+
+/// Metric labels in the order they are rendered, e.g. {{"phase", "init"}}
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief Log-linear latency histogram with per-thread shards
+ *
+ * Values are nanoseconds. Each power of two is split into 16 buckets, so a
+ * recorded value is reported within 6.25% of its true value (HdrHistogram with
+ * about two significant digits); values from 2^38 ns (~4.6 min) up share the top
+ * bucket, while the exact maximum is kept separately.
+ *
+ * record() writes only to the calling thread's shard, with relaxed loads and
+ * stores and no read-modify-write, so concurrent recorders never contend.
+ * snapshot() sums the shards. A shard outlives its thread and is handed to the
+ * next thread that records, so short-lived threads do not grow memory.
+ */
+class Histogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kMaxExponent = 38;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets * (kMaxExponent - kSubBucketBits + 2);
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+        std::vector<uint64_t> buckets; ///< kBuckets counts
+
+        /// Value at quantile q (0..1): the upper edge of its bucket, capped at max_ns
+        uint64_t quantile(double q) const;
+        /// Number of values <= limit_ns; exact when limit_ns + 1 is a bucket edge
+        uint64_t count_at_most(uint64_t limit_ns) const;
+    };
+
+    Histogram(std::string name, MetricLabels labels);
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(uint64_t ns);
+    void record(std::chrono::steady_clock::duration elapsed) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(static_cast<uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    Snapshot snapshot() const;
+
+    const std::string& name() const { return name_; }
+    const MetricLabels& labels() const { return labels_; }
+
+    static size_t bucket_of(uint64_t ns);
+    /// Smallest value that falls into the bucket after b
+    static uint64_t bucket_end(size_t b);
+
+private:
+    struct Shard {
+        std::atomic<uint64_t> counts[kBuckets];
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+        Shard() { for (auto& c : counts) c.store(0, std::memory_order_relaxed); }
+    };
+    friend struct ThreadShards;
+
+    Shard* shard_for_this_thread();
+    void release(Shard* shard);
+
+    const std::string name_;
+    const MetricLabels labels_;
+    const size_t id_; ///< Slot in the per-thread shard table
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<Shard*> free_;
+};
+
+/**
+ * @brief Records the time from construction to destruction into a histogram
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Process-wide registry of latency histograms and gauges
+ *
+ * Histograms are created on first use and never destroyed, so callers look one
+ * up once and keep the reference. Gauges hold one value per label set (the last
+ * duration of a module's init, for example) and are meant for rare updates.
+ *
+ * @code
+ * static Histogram& resolve = Metrics::instance().histogram("helix_dependency_resolve_seconds");
+ * ScopedTimer timer(resolve);
+ * @endcode
+ */
+class Metrics {
+public:
+    static Metrics& instance();
+
+    /**
+     * @brief Histogram for name and labels, created on first call
+     * @param help Description for the metric family; the first non-empty one is kept
+     */
+    Histogram& histogram(const std::string& name, const MetricLabels& labels = {}, const std::string& help = "");
+
+    /// Set a gauge, creating it on first call
+    void set_gauge(const std::string& name, const MetricLabels& labels, double value, const std::string& help = "");
+
+    /// Drop every gauge of name whose labels include label=value (e.g. a removed module)
+    void remove_gauges(const std::string& name, const std::string& label, const std::string& value);
+
+    /// One line per metric: "name{labels} count=... mean_ms=... p50_ms=... p90_ms=... p99_ms=... max_ms=..."
+    std::string render_text() const;
+
+    /// One JSON object per metric and line
+    std::string render_json() const;
+
+    /// Prometheus text exposition format (version 0.0.4)
+    std::string render_prometheus() const;
+
+    /// Snapshots render_deltas() measures from, keyed by series
+    using Baseline = std::map<std::string, Histogram::Snapshot>;
+
+    /**
+     * @brief Histograms that recorded values since baseline, in render_text() and render_json() form
+     *
+     * Count, mean and quantiles cover only the values recorded since baseline;
+     * max_ms is left out because it cannot be split by interval. Histograms with
+     * no new values produce no line. baseline is updated to the current snapshots.
+     */
+    void render_deltas(Baseline& baseline, std::string& text, std::string& json) const;
+
+private:
+    Metrics() = default;
+
+    struct Gauge {
+        std::string name;
+        MetricLabels labels;
+        double value = 0;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms_; ///< Keyed by name{labels}
+    std::map<std::string, Gauge> gauges_;
+    std::map<std::string, std::string> help_;
+};
+
+} // namespace helix
+
+#endif // HELIX_METRICS_H
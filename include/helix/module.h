@@ -9,9 +9,14 @@
  * It simplifies the process of defining module metadata and entry points.
  */
 
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include "helix/log.h"
+#include "helix/bus.h"
+#include "helix/exports.h"
+#include "helix/memory.h"
+#include "helix/resources.h"
 
 namespace helix {
 
@@ -38,10 +43,10 @@ struct ModuleContext {
  */
 #define HELIX_MODULE_DECLARE(name, version, description, author) \
     extern "C" { \
-        const char* helix_module_get_name() { return name; } \
-        const char* helix_module_get_version() { return version; } \
-        const char* helix_module_get_description() { return description; } \
-        const char* helix_module_get_author() { return author; } \
+        HELIX_EXPORT const char* helix_module_get_name() { return name; } \
+        HELIX_EXPORT const char* helix_module_get_version() { return version; } \
+        HELIX_EXPORT const char* helix_module_get_description() { return description; } \
+        HELIX_EXPORT const char* helix_module_get_author() { return author; } \
     }
 
 /**
@@ -54,7 +59,7 @@ struct ModuleContext {
  */
 #define HELIX_MODULE_DEPENDS(...) \
     extern "C" { \
-        const char* helix_module_get_dependencies() { \
+        HELIX_EXPORT const char* helix_module_get_dependencies() { \
             return "[" #__VA_ARGS__ "]"; \
         } \
     }
@@ -72,13 +77,13 @@ struct ModuleContext {
  * }
  */
 #define HELIX_MODULE_INIT() \
-    extern "C" int helix_module_init()
+    extern "C" HELIX_EXPORT int helix_module_init()
 
 /**
  * @brief Define module initialization with a custom symbol name
  */
 #define HELIX_MODULE_INIT_AS(sym) \
-    extern "C" int sym()
+    extern "C" HELIX_EXPORT int sym()
 
 /**
  * @brief Define module start function
@@ -87,13 +92,13 @@ struct ModuleContext {
  * This is called when the module should begin its main operation.
  */
 #define HELIX_MODULE_START() \
-    extern "C" int helix_module_start()
+    extern "C" HELIX_EXPORT int helix_module_start()
 
 /**
  * @brief Define module start with a custom symbol name
  */
 #define HELIX_MODULE_START_AS(sym) \
-    extern "C" int sym()
+    extern "C" HELIX_EXPORT int sym()
 
 /**
  * @brief Define module stop function
@@ -102,13 +107,13 @@ struct ModuleContext {
  * This is called when the module should stop its main operation.
  */
 #define HELIX_MODULE_STOP() \
-    extern "C" int helix_module_stop()
+    extern "C" HELIX_EXPORT int helix_module_stop()
 
 /**
  * @brief Define module stop with a custom symbol name
  */
 #define HELIX_MODULE_STOP_AS(sym) \
-    extern "C" int sym()
+    extern "C" HELIX_EXPORT int sym()
 
 /**
  * @brief Define module cleanup function
@@ -117,13 +122,44 @@ struct ModuleContext {
  * This is called once when the module is being unloaded.
  */
 #define HELIX_MODULE_DESTROY() \
-    extern "C" void helix_module_destroy()
+    extern "C" HELIX_EXPORT void helix_module_destroy()
 
 /**
  * @brief Define module cleanup with a custom symbol name
  */
 #define HELIX_MODULE_DESTROY_AS(sym) \
-    extern "C" void sym()
+    extern "C" HELIX_EXPORT void sym()
+
+/**
+ * @brief State transfer context for `helixctl upgrade`
+ *
+ * When a running module is upgraded, the new build is loaded beside the old one
+ * and initialized; then its optional `helix_module_handoff` export is called
+ * with this context while the old instance is still running. Return 0 to go
+ * on with the upgrade (start the new instance, switch services, stop the old
+ * one), non-zero to abort it and keep the old instance.
+ *
+ * Example:
+ * HELIX_MODULE_HANDOFF() {
+ *     using ExportFn = const Counters* (*)();
+ *     auto old_state = reinterpret_cast<ExportFn>(from->find_previous(from, "my_counters"));
+ *     if (old_state) counters = *old_state();
+ *     return 0;
+ * }
+ */
+#define HELIX_HANDOFF_VERSION 1u
+
+struct HelixHandoff {
+    uint32_t version;               ///< HELIX_HANDOFF_VERSION
+    const char* module_name;
+    const char* previous_version;   ///< Manifest version of the running instance
+    void* previous_handle;          ///< dlopen handle of the running instance
+    /// Address of a symbol in the running instance (dlsym on previous_handle)
+    void* (*find_previous)(const HelixHandoff* self, const char* symbol);
+};
+
+#define HELIX_MODULE_HANDOFF() \
+    extern "C" HELIX_EXPORT int helix_module_handoff(const HelixHandoff* from)
 
 /**
  * Short, ergonomic aliases for declaring entry points.
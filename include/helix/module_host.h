@@ -0,0 +1,104 @@
+#ifndef HELIX_MODULE_HOST_H
+#define HELIX_MODULE_HOST_H
+
+#include "helix/host_channel.h"
+#include "helix/manifest.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <sys/types.h>
+
+namespace helix {
+
+/**
+ * @brief A module running in its own helix-modhost process ("isolation": "process")
+ *
+ * spawn() forks and executes the host program, which opens the module and then
+ * runs its entry points on request over a HostChannel. A reader thread collects
+ * replies and forwards the module's log records to the daemon's log registry. A
+ * second thread answers the host's descriptor requests: it hands out the memfd
+ * of each message bus topic the module opens, so the module publishes into and
+ * polls the same rings as in-process modules. A crash or hang is confined to the
+ * host process: calls made after it dies, and calls waiting when it dies, return
+ * kHostLost, and the loans and subscriptions it left in topics are released.
+ *
+ * Services and exports do not cross the process boundary: a service table or an
+ * exported symbol is a native address with a signature only the modules know, so
+ * there is nothing the daemon could forward. helix-modhost makes them fail with
+ * a message saying so.
+ */
+class ModuleHost {
+public:
+    enum Op : uint16_t {
+        kInit = 1,
+        kStart,
+        kStop,
+        kDestroy,
+        kPing, ///< No-op; measures a round trip
+    };
+
+    /// Result of call() when the host process is gone
+    static constexpr int kHostLost = -128;
+
+    /**
+     * @brief Start a host process for a module and wait until it has opened it
+     * @return nullptr with error set if the program cannot run or the module does not load
+     */
+    static std::shared_ptr<ModuleHost> spawn(const std::string& program, const std::string& module_path,
+                                             const std::string& module_name, const EntryPoints& entry_points,
+                                             bool bind_now, std::string& error);
+
+    /// $HELIX_MODULE_HOST, else helix-modhost next to the running executable, else "helix-modhost" on PATH
+    static std::string default_program();
+
+    ~ModuleHost();
+    ModuleHost(const ModuleHost&) = delete;
+    ModuleHost& operator=(const ModuleHost&) = delete;
+
+    /// Run one entry point in the host and return its result (void entry points return 0)
+    int call(Op op);
+
+    /// Ask the host to exit, killing it after grace_ms; returns once it has been reaped
+    void terminate(unsigned grace_ms = 1000);
+
+    /// SIGKILL the host (a lifecycle call overran its timeout)
+    void kill();
+
+    pid_t pid() const { return pid_; }
+    bool alive() const;
+
+    /// How the host ended ("exited with code 1", "killed by signal 11"); empty while alive
+    std::string exit_reason() const;
+
+private:
+    explicit ModuleHost(std::string name) : name_(std::move(name)) {}
+
+    void reader_loop();
+    void serve_requests();
+    void handle(HostChannel::Message& message);
+    void mark_gone(int status);
+
+    const std::string name_;
+    HostChannel channel_;
+    pid_t pid_ = -1;
+    std::thread reader_;
+    std::thread server_; ///< serve_requests()
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool ready_ = false;
+    std::string ready_error_;
+    bool gone_ = false;
+    std::string exit_reason_;
+    bool exit_requested_ = false; ///< terminate() asked the host to go; its exit is expected
+    uint64_t next_call_ = 1;
+    std::unordered_map<uint64_t, int> replies_;
+};
+
+} // namespace helix
+
+#endif // HELIX_MODULE_HOST_H
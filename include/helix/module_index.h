@@ -0,0 +1,71 @@
+#ifndef HELIX_MODULE_INDEX_H
+#define HELIX_MODULE_INDEX_H
+
+#include "helix/manifest.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace helix {
+
+/**
+ * @brief Cached scan result for one installed module directory
+ *
+ * The file identity fields describe the directory's manifest.json at the time it
+ * was parsed; the entry is only reused while all of them still match.
+ */
+struct ModuleIndexEntry {
+    std::string directory;      ///< Directory name inside the modules directory
+    uint64_t device = 0;        ///< st_dev of manifest.json
+    uint64_t inode = 0;         ///< st_ino of manifest.json
+    uint64_t size = 0;          ///< st_size of manifest.json
+    int64_t mtime_ns = 0;       ///< st_mtim of manifest.json
+    int64_t ctime_ns = 0;       ///< st_ctim of manifest.json
+    std::string package_digest; ///< Digest recorded in the install marker
+    ModuleManifest manifest;    ///< Parsed manifest
+};
+
+/**
+ * @brief Compact binary index of the modules directory
+ *
+ * Persisted as `<modules-dir>/.helx_index` so startup can skip re-parsing
+ * manifests that have not changed since the previous scan. A missing, truncated
+ * or foreign-format file simply loads as an empty index.
+ */
+class ModuleIndex {
+public:
+    /**
+     * @brief Replace the contents with the index stored at path
+     * @return true if a valid index was read; false leaves the index empty
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Write the index to path (via a temporary file and rename)
+     * @return true on success
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Fill the identity fields of entry from a manifest file
+     * @return false if the file cannot be stat'ed
+     */
+    static bool stat_manifest(const std::string& manifest_path, ModuleIndexEntry& entry);
+
+    /**
+     * @brief Entry for directory if its stored identity equals probe's
+     * @return nullptr when absent or stale
+     */
+    const ModuleIndexEntry* find_current(const ModuleIndexEntry& probe) const;
+
+    void put(ModuleIndexEntry entry) { entries_[entry.directory] = std::move(entry); }
+    size_t size() const { return entries_.size(); }
+    const std::unordered_map<std::string, ModuleIndexEntry>& entries() const { return entries_; }
+
+private:
+    std::unordered_map<std::string, ModuleIndexEntry> entries_;
+};
+
+} // namespace helix
+
+#endif // HELIX_MODULE_INDEX_H
@@ -4,21 +4,33 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <functional>
+#include <utility>
+#include <vector>
 #include "helix/manifest.h"
 
+struct HelixAllocStats;
+
 namespace helix {
 
 /**
  * @brief Standard module entry points that all Helix modules must implement
+ *
+ * Plain pointers to the module's functions; all null for a module that runs in
+ * its own host process, whose calls go through ModuleInfo::host instead.
  */
 struct ModuleInterface {
-    std::function<int()> init;      ///< Initialize module resources
-    std::function<int()> start;     ///< Start module operation
-    std::function<int()> stop;      ///< Stop module operation
-    std::function<void()> destroy;  ///< Cleanup module resources
+    int (*init)() = nullptr;      ///< Initialize module resources
+    int (*start)() = nullptr;     ///< Start module operation
+    int (*stop)() = nullptr;      ///< Stop module operation
+    void (*destroy)() = nullptr;  ///< Cleanup module resources
 };
 
+struct PendingCall;
+class ModuleHost;
+
 /**
  * @brief Information about a loaded module
  */
@@ -26,17 +38,32 @@ struct ModuleInfo {
     std::string name;
     std::string version;
     std::string path;
-    void* handle;               ///< dlopen handle
+    void* handle;               ///< dlopen handle; null for a module hosted in its own process
+    std::shared_ptr<ModuleHost> host; ///< Host process of an "isolation": "process" module
     ModuleInterface interface;  ///< Function pointers to module entry points
     bool initialized;
     bool running;
+    LifecycleTimeouts timeouts; ///< Per-call limits (0 = loader default)
+    std::shared_ptr<PendingCall> overrun; ///< Lifecycle call that exceeded its timeout and may still run
+    uint64_t instance = 0;      ///< Distinguishes successive loads of the same module
+    uint32_t account = 0;       ///< ResourceAccounting id its code runs under
+    const HelixAllocStats* alloc_stats = nullptr; ///< Exported by HELIX_MODULE_TRACK_ALLOCATIONS(), or null
+    std::vector<std::pair<std::string, void*>> exports; ///< Symbols published in the ExportTable
+    /// helix_find_export() handed out one of its addresses; kept mapped until unload once retired
+    bool exports_resolved = false;
+    /// Instances replaced by upgrade_module(); see close_retired() for when they are unmapped
+    std::vector<std::unique_ptr<ModuleInfo>> retired;
 };
 
 /**
  * @brief Core module loader for the Helix framework
  * 
  * Handles dynamic loading of compiled modules (.so files) using dlopen(),
- * resolves standard entry points, and manages module lifecycle.
+ * resolves standard entry points, and manages module lifecycle. Modules are
+ * loaded RTLD_LOCAL by default so they do not grow the global symbol scope;
+ * symbols meant for other modules go through the ExportTable.
+ * Calls for different modules may run concurrently; calls for the same module
+ * must be serialized by the caller.
  */
 class ModuleLoader {
 public:
@@ -61,6 +88,92 @@ public:
     bool load_module(const std::string& module_path, const std::string& module_name,
                      const EntryPoints& entry_points);
 
+    /**
+     * @brief Load a module with custom entry points and lifecycle call limits
+     * @param timeouts Limits for init/start/stop; zero fields use the loader default
+     * @return true on success
+     */
+    bool load_module(const std::string& module_path, const std::string& module_name,
+                     const EntryPoints& entry_points, const LifecycleTimeouts& timeouts);
+
+    /**
+     * @brief Load a module with custom entry points, lifecycle limits and symbol linkage
+     *
+     * Modules are loaded RTLD_LOCAL unless linkage.global is set. linkage.exports
+     * are resolved in the module and published in the ExportTable; a missing or
+     * already-exported name fails the load.
+     * @param linkage Symbol visibility and exports (other overloads use the defaults)
+     * @return true on success
+     */
+    bool load_module(const std::string& module_path, const std::string& module_name,
+                     const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                     const ModuleLinkage& linkage);
+
+    /**
+     * @brief Replace a loaded, initialized module with a new build, without a stop/start gap
+     *
+     * The new build is loaded beside the running instance under its own handle
+     * and initialized. Then its optional helix_module_handoff export is called
+     * (see HelixHandoff in helix/module.h), and it is started if the old
+     * instance was running. Only then are the module's exports and services
+     * switched over and the old instance stopped and destroyed. Consumers' service
+     * pointers are rewritten in place. A failure before the switch discards the
+     * new instance and leaves the old one untouched. The old instance's code
+     * stays mapped while anything may still call it (see close_retired()), so
+     * calls that raced the switch still land in mapped code.
+     * @param module_path New .so; may be a staging path (the instance keeps no reference to it)
+     * @param previous_version Passed to the handoff hook
+     * @param error Failure reason
+     * @return true once the new instance is current
+     */
+    bool upgrade_module(const std::string& module_name, const std::string& module_path,
+                        const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                        const ModuleLinkage& linkage, const std::string& previous_version, std::string& error);
+
+    /**
+     * @brief Set the limit applied to init/start/stop calls without a per-module timeout
+     * @param timeout_ms Milliseconds; 0 calls entry points inline without a limit
+     */
+    void set_default_timeout_ms(unsigned timeout_ms) { default_timeout_ms_ = timeout_ms; }
+
+    /**
+     * @brief Bind every symbol when a module is loaded (RTLD_NOW) instead of on first call
+     *
+     * Moves PLT resolution off the first init/start and calls into the module;
+     * a module with unresolvable symbols then fails to load instead of failing later.
+     */
+    void set_bind_now(bool bind_now) { bind_now_ = bind_now; }
+
+    /**
+     * @brief Fault in the pages of each module's mapped segments right after dlopen()
+     */
+    void set_prefault(bool prefault) { prefault_ = prefault; }
+
+    /**
+     * @brief Program that hosts "isolation": "process" modules (default: ModuleHost::default_program())
+     */
+    void set_host_program(const std::string& program);
+
+    /**
+     * @brief Start reading a file into the page cache (readahead, else posix_fadvise WILLNEED)
+     * @return false if the file could not be opened
+     */
+    static bool readahead_file(const std::string& path);
+
+    /**
+     * @brief Check whether a lifecycle call of the module overran its timeout and is still running
+     *
+     * While true the module cannot be started, stopped or unloaded. A failed
+     * initialize/start/stop call with this true means the call timed out.
+     */
+    bool is_module_hung(const std::string& module_name) const;
+
+    /**
+     * @brief How the host process of an "isolation": "process" module ended
+     * @return Empty while the host runs, or for modules loaded in-process
+     */
+    std::string host_exit_reason(const std::string& module_name) const;
+
     /**
      * @brief Unload a previously loaded module
      * @param module_name Name of the module to unload
@@ -117,7 +230,60 @@ public:
     std::vector<std::string> get_loaded_modules() const;
 
 private:
+    // Guards the map only; entry points run unlocked so distinct modules can be
+    // loaded, initialized and started from different threads at the same time.
+    mutable std::mutex mutex_;
     std::unordered_map<std::string, std::unique_ptr<ModuleInfo>> loaded_modules_;
+    std::atomic<unsigned> default_timeout_ms_{0};
+    std::atomic<bool> bind_now_{false};
+    std::atomic<bool> prefault_{false};
+    std::string host_program_;
+
+    /**
+     * @brief madvise(WILLNEED) and touch every page of the PT_LOAD segments of a loaded library
+     * @param handle dlopen handle
+     */
+    static void prefault_segments(void* handle);
+
+    /**
+     * @brief Run an entry point, giving up after timeout_ms on a helper thread
+     * @param rc Entry point result when it returned in time
+     * @return false if the call overran; the module is then marked hung
+     */
+    bool call_entry_point(ModuleInfo& module, const std::function<int()>& fn,
+                          unsigned timeout_ms, const char* what, int& rc);
+
+    /**
+     * @brief dlopen() a module and resolve its entry points and exports
+     * @return nullptr with error set on failure
+     */
+    std::unique_ptr<ModuleInfo> open_module(const std::string& open_path, const std::string& module_name,
+                                            const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                                            const ModuleLinkage& linkage, std::string& error);
+
+    /// Start the host process of an "isolation": "process" module; entry points become calls into it
+    std::unique_ptr<ModuleInfo> spawn_host(const std::string& module_path, const std::string& module_name,
+                                           const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                                           std::string& error);
+
+    /// dlclose() the module's library, or end its host process
+    static bool close_module(ModuleInfo& module);
+
+    /**
+     * @brief dlclose() retired instances nothing can still call into
+     *
+     * An instance with a timed-out call still running is always kept. Until the
+     * module is unloading, so is one whose exports were resolved (the addresses
+     * cannot be redirected) and, while the module's services have consumers, every
+     * one (retired service tables point into it).
+     */
+    static void close_retired(ModuleInfo& module, bool unloading = false);
+
+    /**
+     * @brief Look up a loaded module under the map lock
+     * @return Stable pointer to the entry, nullptr if not loaded
+     */
+    ModuleInfo* find_module(const std::string& module_name) const;
 
     /**
      * @brief Resolve standard entry points from a loaded module
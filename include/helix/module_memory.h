@@ -0,0 +1,75 @@
+#ifndef HELIX_MODULE_MEMORY_H
+#define HELIX_MODULE_MEMORY_H
+
+#include "helix/memory.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief Daemon side of helix/memory.h: arenas and object pools owned by module instances
+ *
+ * Every arena and pool belongs to the module instance current on the creating
+ * thread (ServiceRegistry::current_instance(); 0 when none, which is never
+ * released in bulk). release() frees everything an instance still owns;
+ * ModuleLoader calls it once the instance's library has been closed. Reserved
+ * bytes are reported to ResourceAccounting as the module's arena_bytes.
+ *
+ * Pools keep a per-thread cache of free objects for up to kCachedPools pools.
+ * A cache is refilled from, or spilled to, the pool's shared free list
+ * kCacheBatch objects at a time. Caches of a pool that has been freed are
+ * dropped without touching its memory.
+ */
+class ModuleMemory {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+    static constexpr size_t kCacheSize = 32;
+    static constexpr size_t kCacheBatch = 16;
+    static constexpr size_t kCachedPools = 8;
+
+    static ModuleMemory& instance();
+
+    HelixArena* create_arena(size_t block_size);
+    /// Default arena of the calling thread's instance
+    HelixArena* module_arena();
+    static void* arena_alloc(HelixArena* arena, size_t size, size_t align);
+    static void arena_reset(HelixArena* arena);
+    void destroy_arena(HelixArena* arena);
+
+    HelixPool* create_pool(size_t object_size, size_t align);
+    static void* pool_alloc(HelixPool* pool);
+    static void pool_free(HelixPool* pool, void* object);
+    void destroy_pool(HelixPool* pool);
+
+    /// Free every arena and pool the instance still owns; returns the bytes released
+    size_t release(uint64_t instance);
+
+    /// Bytes reserved by the instance's arenas and pools
+    size_t reserved(uint64_t instance) const;
+
+    /// Function table returned by the exported helix_memory_api_get()
+    static const HelixMemoryApi* api();
+
+private:
+    ModuleMemory() = default;
+
+    struct Owner {
+        uint32_t account = 0;
+        HelixArena* default_arena = nullptr;
+        std::vector<HelixArena*> arenas;
+        std::vector<HelixPool*> pools;
+    };
+
+    Owner& owner_locked(uint64_t instance);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Owner> owners_;
+};
+
+} // namespace helix
+
+#endif // HELIX_MODULE_MEMORY_H
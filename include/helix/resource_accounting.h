@@ -0,0 +1,144 @@
+#ifndef HELIX_RESOURCE_ACCOUNTING_H
+#define HELIX_RESOURCE_ACCOUNTING_H
+
+#include "helix/resources.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+
+namespace helix {
+
+/**
+ * @brief Charges CPU time, threads, file descriptors and heap use to modules
+ *
+ * A thread is attributed to a module while a Scope for that module is alive on
+ * it: ModuleLoader opens one around every lifecycle call, and threads started
+ * through helix_thread_create() (spawn_thread()) carry their creator's scope for
+ * their whole life. CPU time is the thread CPU clock consumed inside lifecycle
+ * calls plus that of the module's threads, live and exited.
+ *
+ * Descriptors are attributed when they are created (fd_opened()) and released by
+ * fd_closed(); helixd feeds both from wrappers around the libc calls that create
+ * and close descriptors, which skip the bookkeeping for descriptors the daemon
+ * itself creates. A descriptor number a module reuses without a close being seen
+ * is moved to it. Only descriptors below kMaxTrackedFds are tracked.
+ *
+ * Heap use comes from the HelixAllocStats a module exports when it opts in with
+ * HELIX_MODULE_TRACK_ALLOCATIONS(), and from the arenas and pools ModuleMemory
+ * reports through add_arena_bytes().
+ *
+ * A module hosted in its own process (set_host_process()) is charged that whole
+ * process instead: its CPU time, threads, descriptors and RSS are read from /proc.
+ */
+class ResourceAccounting {
+public:
+    static constexpr uint32_t kMaxModules = 4096;
+    static constexpr int kMaxTrackedFds = 65536;
+
+    struct Usage {
+        uint32_t threads = 0;          ///< Live threads started with helix_thread_create()
+        uint64_t threads_started = 0;
+        uint64_t cpu_ns = 0;
+        int64_t fds = 0;
+        bool allocations_tracked = false;
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes_allocated = 0;
+        uint64_t bytes_freed = 0;
+        uint64_t arena_bytes = 0;      ///< Reserved by the module's helix/memory.h arenas and pools
+        int host_pid = 0;              ///< Host process of an "isolation": "process" module, else 0
+        uint64_t rss_bytes = 0;        ///< Resident size of the host process
+
+        /// bytes_allocated - bytes_freed, or 0 when more was freed than counted as allocated
+        uint64_t live_bytes() const { return bytes_allocated > bytes_freed ? bytes_allocated - bytes_freed : 0; }
+    };
+
+    struct ProcessUsage {
+        uint64_t rss_bytes = 0;
+        uint64_t cpu_ns = 0;
+        uint32_t threads = 0;
+        uint32_t fds = 0;
+    };
+
+    /// Attributes the calling thread to a module for its lifetime (id 0 = nobody)
+    class Scope {
+    public:
+        explicit Scope(uint32_t id);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        uint32_t previous_;
+    };
+
+    static ResourceAccounting& instance();
+
+    /// Stable id of module (1-based), assigned on first use; 0 once kMaxModules names exist
+    uint32_t id_of(const std::string& module);
+
+    /// Module the calling thread is attributed to, or 0
+    static uint32_t current();
+
+    /// CPU time used by the calling thread so far
+    static uint64_t thread_cpu_ns();
+
+    void add_cpu(uint32_t id, uint64_t ns);
+
+    /// pthread_create() for a thread attributed to the calling thread's module
+    int spawn_thread(pthread_t* thread, const pthread_attr_t* attr, void* (*start)(void*), void* arg);
+
+    /// A descriptor was created by the calling thread
+    void fd_opened(int fd);
+
+    /// A descriptor is about to be closed
+    void fd_closed(int fd);
+
+    /// Bytes reserved (positive) or released (negative) by a module's arenas and pools
+    void add_arena_bytes(uint32_t id, int64_t bytes);
+
+    /// Heap counters of a loaded module; nullptr before its library is unmapped
+    void set_alloc_stats(const std::string& module, const HelixAllocStats* stats);
+
+    /// The module runs in process pid (0: no longer)
+    void set_host_process(const std::string& module, int pid);
+
+    Usage usage(const std::string& module) const;
+
+    /// Whole-process RSS, CPU time, thread and descriptor counts from /proc (pid 0: this process)
+    static ProcessUsage process_usage(int pid = 0);
+
+private:
+    ResourceAccounting() = default;
+
+    struct Slot {
+        std::string name;
+        std::atomic<int64_t> fds{0};
+        std::atomic<uint64_t> cpu_ns{0};        ///< Lifecycle calls and exited threads
+        std::atomic<uint64_t> threads_started{0};
+        std::atomic<const HelixAllocStats*> alloc{nullptr};
+        std::atomic<int> host_pid{0};
+        std::atomic<int64_t> arena_bytes{0};
+        mutable std::mutex mutex;
+        std::vector<clockid_t> live;            ///< CPU clocks of live module threads
+    };
+    friend struct AttributedThread;
+
+    Slot* slot(uint32_t id) const { return id && id < kMaxModules ? slots_[id].load(std::memory_order_acquire) : nullptr; }
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    std::deque<Slot> storage_;
+    std::atomic<Slot*> slots_[kMaxModules] = {};
+    std::atomic<uint16_t> fd_owner_[kMaxTrackedFds] = {};
+};
+
+} // namespace helix
+
+#endif // HELIX_RESOURCE_ACCOUNTING_H
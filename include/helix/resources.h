@@ -0,0 +1,138 @@
+#ifndef HELIX_RESOURCES_H
+#define HELIX_RESOURCES_H
+
+/**
+ * @file resources.h
+ * @brief Per-module resource accounting for module code
+ *
+ * helixd charges CPU time, threads and file descriptors to the module whose code
+ * is running: its lifecycle calls, and threads started with helix_thread_create(),
+ * which carry the attribution of the thread that started them. Threads started
+ * with std::thread or pthread_create() directly are not attributed.
+ *
+ * @code
+ * static pthread_t worker;
+ * HELIX_MODULE_START() { return helix_thread_create(&worker, nullptr, worker_main, nullptr); }
+ * @endcode
+ *
+ * Heap use is counted only for modules that opt in with
+ * HELIX_MODULE_TRACK_ALLOCATIONS() in one source file. It replaces operator new
+ * and delete inside the module (hidden visibility, so other modules and the
+ * daemon are unaffected) with versions that count bytes with malloc_usable_size().
+ * Memory the module gets from malloc() directly or from other libraries is not
+ * counted. `helixctl info <module>` and `helixctl top` show the numbers.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#ifdef __unix__
+#include <dlfcn.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <stdlib.h>
+#endif
+
+#define HELIX_ALLOC_STATS_VERSION 1u
+
+/// Allocation counters a module exports with HELIX_MODULE_TRACK_ALLOCATIONS(); updated with relaxed atomics
+struct HelixAllocStats {
+    uint32_t version; ///< HELIX_ALLOC_STATS_VERSION
+    uint32_t reserved;
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes_allocated;
+    uint64_t bytes_freed;
+};
+
+#ifdef __unix__
+
+using HelixThreadCreateFn = int (*)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+
+/**
+ * @brief pthread_create() whose thread is accounted to the calling module
+ *
+ * Falls back to plain pthread_create() outside helixd.
+ */
+inline int helix_thread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*start)(void*), void* arg) {
+    static HelixThreadCreateFn spawn = nullptr;
+    if (!spawn) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_thread_spawn");
+        spawn = sym ? reinterpret_cast<HelixThreadCreateFn>(sym) : &pthread_create;
+    }
+    return spawn(thread, attr, start, arg);
+}
+
+inline void* helix_tracked_alloc(HelixAllocStats* stats, std::size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (p) {
+        __atomic_fetch_add(&stats->allocations, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&stats->bytes_allocated, malloc_usable_size(p), __ATOMIC_RELAXED);
+    }
+    return p;
+}
+
+inline void helix_tracked_free(HelixAllocStats* stats, void* p) {
+    if (!p) return;
+    __atomic_fetch_add(&stats->frees, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->bytes_freed, malloc_usable_size(p), __ATOMIC_RELAXED);
+    std::free(p);
+}
+
+inline void* helix_tracked_new(HelixAllocStats* stats, std::size_t size) {
+    for (;;) {
+        if (void* p = helix_tracked_alloc(stats, size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+#if defined(__LP64__)
+
+/*
+ * <new> declares the global operators with default visibility, which a visibility
+ * attribute cannot override, so the replacements are hidden in the object file
+ * instead. Hidden, the module's own calls bind to them while the daemon and other
+ * modules keep the global operators. The mangled names assume a 64-bit size_t.
+ */
+#define HELIX_ALLOC_HIDE_OPERATORS_ \
+    __asm__(".hidden _Znwm\n\t.hidden _Znam\n\t.hidden _ZnwmRKSt9nothrow_t\n\t.hidden _ZnamRKSt9nothrow_t\n\t" \
+            ".hidden _ZdlPv\n\t.hidden _ZdaPv\n\t.hidden _ZdlPvm\n\t.hidden _ZdaPvm");
+
+/**
+ * @brief Count this module's operator new/delete allocations; use in exactly one source file
+ */
+#define HELIX_MODULE_TRACK_ALLOCATIONS() \
+    static HelixAllocStats helix_alloc_counters_ = {HELIX_ALLOC_STATS_VERSION, 0, 0, 0, 0, 0}; \
+    extern "C" __attribute__((visibility("default"))) const HelixAllocStats* helix_module_alloc_stats() { \
+        return &helix_alloc_counters_; \
+    } \
+    HELIX_ALLOC_HIDE_OPERATORS_ \
+    void* operator new(std::size_t size) { return helix_tracked_new(&helix_alloc_counters_, size); } \
+    void* operator new[](std::size_t size) { return helix_tracked_new(&helix_alloc_counters_, size); } \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept { \
+        return helix_tracked_alloc(&helix_alloc_counters_, size); \
+    } \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { \
+        return helix_tracked_alloc(&helix_alloc_counters_, size); \
+    } \
+    void operator delete(void* p) noexcept { helix_tracked_free(&helix_alloc_counters_, p); } \
+    void operator delete[](void* p) noexcept { helix_tracked_free(&helix_alloc_counters_, p); } \
+    void operator delete(void* p, std::size_t) noexcept { helix_tracked_free(&helix_alloc_counters_, p); } \
+    void operator delete[](void* p, std::size_t) noexcept { helix_tracked_free(&helix_alloc_counters_, p); }
+
+#else
+
+#define HELIX_MODULE_TRACK_ALLOCATIONS()
+
+#endif // __LP64__
+
+#else
+
+#define HELIX_MODULE_TRACK_ALLOCATIONS()
+
+#endif
+
+#endif // HELIX_RESOURCES_H
@@ -0,0 +1,85 @@
+#ifndef HELIX_SEMVER_H
+#define HELIX_SEMVER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief Parsed semantic version
+ *
+ * Compares with integer operations only: the numeric core first, then the
+ * pre-release identifiers by SemVer precedence (a pre-release sorts before its
+ * release; numeric identifiers compare numerically and before alphanumeric ones).
+ * Build metadata ("+...") is accepted and ignored.
+ */
+struct SemVer {
+    uint64_t major = 0;
+    uint64_t minor = 0;
+    uint64_t patch = 0;
+    std::string prerelease; ///< Without the leading '-'; empty for a release
+
+    /**
+     * @brief Parse "MAJOR.MINOR.PATCH" with an optional -prerelease or +build suffix
+     * @return false unless the whole text is a version
+     */
+    static bool parse(std::string_view text, SemVer& out);
+
+    /// -1, 0 or 1 as this version sorts before, equal to or after other
+    int compare(const SemVer& other) const;
+
+    std::string to_string() const;
+
+    bool operator==(const SemVer& other) const { return compare(other) == 0; }
+    bool operator!=(const SemVer& other) const { return compare(other) != 0; }
+    bool operator<(const SemVer& other) const { return compare(other) < 0; }
+};
+
+/**
+ * @brief Parsed version requirement
+ *
+ * A range is one or more comparator sets separated by "||"; a version satisfies
+ * the range when it satisfies every comparator of any set. Comparators are
+ * separated by whitespace and use the operators ">=", ">", "<=", "<", "==" and
+ * "~" ("~1.2.3" accepts 1.2.x from 1.2.3 on); a bare version means "==".
+ * An empty range accepts every version.
+ *
+ * @code
+ * VersionRange range;
+ * SemVer v;
+ * if (VersionRange::parse(">=1.2.0 <2.0.0", range) && SemVer::parse("1.4.2", v)) {
+ *     range.satisfied_by(v); // true
+ * }
+ * @endcode
+ */
+class VersionRange {
+public:
+    enum class Op { Eq, Gt, Ge, Lt, Le, Tilde };
+
+    struct Comparator {
+        Op op = Op::Eq;
+        SemVer version;
+    };
+
+    /// @return false if requirement is not a valid range (out is left empty)
+    static bool parse(std::string_view requirement, VersionRange& out);
+
+    bool satisfied_by(const SemVer& version) const;
+
+    /// True for the empty range, which accepts every version
+    bool any() const { return sets_.empty(); }
+
+    const std::vector<std::vector<Comparator>>& sets() const { return sets_; }
+
+private:
+    static bool matches(const Comparator& c, const SemVer& version);
+
+    std::vector<std::vector<Comparator>> sets_;
+};
+
+} // namespace helix
+
+#endif // HELIX_SEMVER_H
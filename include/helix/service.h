@@ -0,0 +1,112 @@
+#ifndef HELIX_SERVICE_H
+#define HELIX_SERVICE_H
+
+/**
+ * @file service.h
+ * @brief Typed services shared between modules
+ *
+ * A provider fills a function table and registers it under a name in init:
+ *
+ * @code
+ * struct MetricsV1 {
+ *     void (*counter_add)(const char* name, long delta);
+ *     long (*counter_get)(const char* name);
+ * };
+ * static const MetricsV1 metrics = {counter_add, counter_get};
+ *
+ * HELIX_MODULE_INIT() { return helix_register_service("metrics", HELIX_SERVICE_VERSION(1, 0), &metrics); }
+ * @endcode
+ *
+ * A consumer lists the provider in its manifest's "dependencies" and resolves
+ * the service once, also from init or start; after that every call is an
+ * acquire load of the current table plus a plain indirect call:
+ *
+ * @code
+ * static HelixService<MetricsV1> metrics;
+ * HELIX_MODULE_INIT() {
+ *     metrics = helix_resolve_service<MetricsV1>("metrics", HELIX_SERVICE_VERSION(1, 0));
+ *     return metrics ? 0 : -1;
+ * }
+ * ... metrics->counter_add("requests", 1);
+ * @endcode
+ *
+ * Tables only grow: a minor version appends members, a major version is a new
+ * incompatible table. The daemon copies the table at registration, so it should
+ * hold only function pointers and constants. A resolved service stays valid
+ * until the consumer is unloaded: the daemon refuses to disable a provider while
+ * its services are in use, and `upgrade` publishes the new table atomically, so
+ * each call goes entirely through the old table or entirely through the new one.
+ * Do not keep the pointer get() returns beyond the call it is used for.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __unix__
+#include <dlfcn.h>
+#endif
+
+#define HELIX_SERVICE_VERSION(major, minor) ((static_cast<uint32_t>(major) << 16) | static_cast<uint32_t>(minor))
+
+using HelixServiceRegisterFn = int (*)(const char*, uint32_t, const void*, size_t);
+using HelixServiceResolveFn = const void* (*)(const char*, uint32_t, size_t);
+
+// Register a table of size bytes; 0 on success, -1 on conflict or without a daemon
+inline int helix_service_register_raw(const char* name, uint32_t version, const void* vtable, size_t size) {
+#ifdef __unix__
+    static HelixServiceRegisterFn register_fn = nullptr;
+    if (!register_fn) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_service_register");
+        if (sym) register_fn = reinterpret_cast<HelixServiceRegisterFn>(sym);
+    }
+    return register_fn ? register_fn(name, version, vtable, size) : -1;
+#else
+    (void)name; (void)version; (void)vtable; (void)size; return -1;
+#endif
+}
+
+// Slot of the provider's table if it is compatible with version and at least size bytes,
+// else nullptr. The slot is a std::atomic<const void*>; see HelixService.
+inline const void* helix_service_resolve_raw(const char* name, uint32_t version, size_t size) {
+#ifdef __unix__
+    static HelixServiceResolveFn resolve_fn = nullptr;
+    if (!resolve_fn) {
+        void* sym = dlsym(RTLD_DEFAULT, "helix_service_resolve");
+        if (sym) resolve_fn = reinterpret_cast<HelixServiceResolveFn>(sym);
+    }
+    return resolve_fn ? resolve_fn(name, version, size) : nullptr;
+#else
+    (void)name; (void)version; (void)size; return nullptr;
+#endif
+}
+
+template <typename VTable>
+inline int helix_register_service(const char* name, uint32_t version, const VTable* vtable) {
+    return helix_service_register_raw(name, version, vtable, sizeof(VTable));
+}
+
+// A resolved service. Each access loads the table the provider currently publishes.
+template <typename VTable>
+class HelixService {
+public:
+    HelixService() = default;
+    explicit HelixService(const void* slot) : slot_(static_cast<const std::atomic<const void*>*>(slot)) {}
+
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    const VTable* get() const {
+        return slot_ ? static_cast<const VTable*>(slot_->load(std::memory_order_acquire)) : nullptr;
+    }
+    const VTable* operator->() const { return get(); }
+
+private:
+    const std::atomic<const void*>* slot_ = nullptr;
+};
+
+template <typename VTable>
+inline HelixService<VTable> helix_resolve_service(const char* name, uint32_t version) {
+    return HelixService<VTable>(helix_service_resolve_raw(name, version, sizeof(VTable)));
+}
+
+#endif // HELIX_SERVICE_H
@@ -0,0 +1,172 @@
+#ifndef HELIX_SERVICE_REGISTRY_H
+#define HELIX_SERVICE_REGISTRY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief Process-wide registry of the typed services modules provide to each other
+ *
+ * A service is a named, versioned function table owned by the module that
+ * registered it. Consumers resolve it once and then call through the returned
+ * slot directly; the registry is not involved in the calls themselves.
+ * Registrations and lookups are attributed to the module whose lifecycle entry
+ * point is running on the calling thread (see CallerScope), and a consumer may
+ * only use a service whose provider it depends on, so the provider is always
+ * initialized first. Modules use the C ABI in helix/service.h.
+ *
+ * Versions are (major << 16 | minor): a lookup succeeds when the majors match,
+ * the provider's minor is at least the requested one and the provider's table
+ * is at least as large as the consumer's.
+ *
+ * The registry keeps its own immutable copy of each table and hands consumers a
+ * slot holding an atomic pointer to the current copy. Upgrading a provider
+ * (begin_replacement/commit_replacement) publishes a new copy with one release
+ * store, so a consumer loading the slot sees either the whole old table or the
+ * whole new one, and switches without resolving again. Replaced copies are
+ * retired, not freed, until the service itself is dropped, because a consumer
+ * may still be in a call through one.
+ */
+class ServiceRegistry {
+public:
+    /// Answers whether consumer (transitively) depends on provider
+    using DependencyCheck = std::function<bool(const std::string& consumer, const std::string& provider)>;
+
+    /// Marks the calling thread as running a lifecycle call of module for its lifetime
+    class CallerScope {
+    public:
+        /// @param instance Identifies one load of the module (ModuleInfo::instance), 0 if unknown
+        explicit CallerScope(const std::string& module, uint64_t instance = 0);
+        ~CallerScope();
+        CallerScope(const CallerScope&) = delete;
+        CallerScope& operator=(const CallerScope&) = delete;
+
+    private:
+        const std::string* previous_;
+        uint64_t previous_instance_;
+    };
+
+    struct ServiceInfo {
+        std::string name;
+        std::string provider;
+        uint32_t version = 0;
+        size_t size = 0;
+        std::vector<std::string> consumers;
+    };
+
+    static ServiceRegistry& instance();
+
+    /// Module whose lifecycle call the calling thread is running, or nullptr
+    static const std::string* current_caller();
+
+    /// Instance of the module whose lifecycle call the calling thread is running, or 0
+    static uint64_t current_instance();
+
+    /// Install the dependency check; without one every lookup is allowed
+    void set_dependency_check(DependencyCheck check);
+
+    /// Make helix_service_register() and helix_service_resolve() fail with reason (used by module hosts)
+    void set_unavailable(const std::string& reason);
+
+    /// Why services cannot be used in this process, or empty
+    std::string unavailable_reason() const;
+
+    /**
+     * @brief Register a service provided by module
+     * @param vtable Function table; copied, so it only has to be valid during the call
+     * @param size sizeof the provider's table
+     * @return false if the name is taken by another module (error says by whom)
+     */
+    bool register_service(const std::string& module, const std::string& name, uint32_t version,
+                          const void* vtable, size_t size, std::string& error);
+
+    /// Where a service's current table is published; stable while the service is registered
+    using Slot = std::atomic<const void*>;
+
+    /**
+     * @brief Resolve a service for consumer and record the use
+     * @param size sizeof the consumer's view of the table
+     * @return The slot of the provider's table, or nullptr with error set
+     */
+    const Slot* resolve(const std::string& consumer, const std::string& name, uint32_t version, size_t size,
+                        std::string& error);
+
+    /**
+     * @brief Start staging the services of a new instance of module
+     *
+     * Until commit_replacement() or abort_replacement(), registrations made from
+     * lifecycle calls of that instance are staged; the running instance's
+     * services stay in effect.
+     */
+    void begin_replacement(const std::string& module, uint64_t instance);
+
+    /**
+     * @brief Make the staged services current
+     *
+     * Every service of module that has consumers must be registered again with
+     * the same major version, at least the highest minor and table size any
+     * consumer asked for. Services not registered again are dropped.
+     * @return false (nothing changed) if the new instance would break a consumer
+     */
+    bool commit_replacement(const std::string& module, std::string& error);
+
+    /// Discard the staged services of module
+    void abort_replacement(const std::string& module);
+
+    /// Drop module's services and its recorded uses of other modules' services
+    void withdraw(const std::string& module);
+
+    /// Modules, other than provider itself, using a service provider registered
+    std::vector<std::string> consumers_of(const std::string& provider) const;
+
+    std::vector<ServiceInfo> list() const;
+
+private:
+    /// Registry-owned copy of a table; consumers point into it
+    struct Table {
+        std::unique_ptr<unsigned char[]> bytes;
+        size_t size;
+    };
+
+    struct Entry {
+        std::string provider;
+        uint32_t version;
+        size_t size;
+        std::unique_ptr<Slot> slot; ///< Points at tables.back()
+        std::vector<Table> tables;  ///< back() is current; earlier copies are retired by upgrades
+        std::vector<std::string> consumers;
+        uint32_t max_minor = 0;     ///< Highest minor version a consumer asked for
+        size_t max_size = 0;        ///< Largest table a consumer asked for
+    };
+
+    struct Registration {
+        uint32_t version;
+        std::vector<unsigned char> bytes;
+    };
+
+    struct Staged {
+        uint64_t instance;
+        std::unordered_map<std::string, Registration> services;
+    };
+
+    static Table copy_table(const void* vtable, size_t size);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> services_;
+    std::unordered_map<std::string, Staged> staged_; ///< By module being replaced
+    DependencyCheck depends_;
+    std::string unavailable_;
+};
+
+} // namespace helix
+
+#endif // HELIX_SERVICE_REGISTRY_H
@@ -0,0 +1,123 @@
+#ifndef HELIX_STATE_JOURNAL_H
+#define HELIX_STATE_JOURNAL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace helix {
+
+/**
+ * @brief Crash-safe, append-only log of module state transitions
+ *
+ * Every transition is one fixed-size 64-byte record (CRC-32, sequence number,
+ * state code, module name) appended to `<dir>/.helix_state.journal`. A background
+ * thread writes whatever has queued up since its last pass in a single write()
+ * followed by one fdatasync(), so a burst of transitions costs one sync. Once the
+ * journal holds more than a threshold of records it is compacted: the current
+ * states are written to `<dir>/.helix_state.snapshot` (temporary file, fsync,
+ * rename) and the journal is truncated.
+ *
+ * Opening replays the snapshot and then the journal records newer than it, so
+ * replay costs O(modules + changes since the last compaction). A torn or corrupt
+ * tail (failed CRC) ends replay and is cut off before new records are appended.
+ *
+ * State codes are opaque to the journal; code 0 removes the module. Module names
+ * longer than kMaxNameLength do not fit a record and force a compaction instead.
+ */
+class StateJournal {
+public:
+    static constexpr size_t kRecordSize = 64;
+    static constexpr size_t kMaxNameLength = 46;
+    static constexpr size_t kDefaultCompactThreshold = 4096;
+
+    struct Stats {
+        uint64_t records = 0;     ///< Records appended since open
+        uint64_t syncs = 0;       ///< fdatasync() calls (one per group commit)
+        uint64_t compactions = 0; ///< Snapshots written
+        uint64_t replayed = 0;    ///< Journal records applied by open()
+    };
+
+    StateJournal() = default;
+    ~StateJournal();
+
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    /**
+     * @brief Replay the snapshot and journal in directory and start appending
+     * @param states Receives the recovered module states
+     * @return false if the files exist but cannot be opened; a missing journal is
+     *         not an error and yields no states
+     */
+    bool open(const std::string& directory, std::unordered_map<std::string, uint8_t>& states,
+              std::string& error);
+
+    /// True between a successful open() and close()
+    bool is_open() const { return fd_ >= 0; }
+
+    /**
+     * @brief Seed the journal with states from another source (legacy state file)
+     *        and write them out as a snapshot
+     */
+    bool import(const std::unordered_map<std::string, uint8_t>& states);
+
+    /// Queue a transition; it is durable after the next group commit. No-op when closed.
+    void record(const std::string& module, uint8_t state);
+
+    /// Block until every record queued so far is on disk
+    bool flush();
+
+    /// Write a snapshot of the current states and truncate the journal
+    bool compact();
+
+    /// Flush, compact and stop the writer thread; later records are ignored
+    bool close();
+
+    /// Compact after this many journal records (default kDefaultCompactThreshold)
+    void set_compact_threshold(size_t records) { compact_threshold_ = records ? records : 1; }
+
+    Stats stats() const;
+
+    std::string journal_path() const { return directory_ + "/.helix_state.journal"; }
+    std::string snapshot_path() const { return directory_ + "/.helix_state.snapshot"; }
+
+private:
+    struct Pending {
+        std::string module;
+        uint8_t state;
+    };
+
+    void writer_loop();
+    bool commit(std::vector<Pending>& batch, std::unique_lock<std::mutex>& lock);
+    bool write_snapshot(std::unique_lock<std::mutex>& lock);
+    bool load_snapshot(uint64_t& seq, std::unordered_map<std::string, uint8_t>& states, std::string& error);
+
+    std::string directory_;
+    int fd_ = -1;
+    size_t compact_threshold_ = kDefaultCompactThreshold;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::thread writer_;
+    bool stop_ = false;
+    std::vector<Pending> queue_;
+    uint64_t next_seq_ = 1;      ///< Sequence number of the next record
+    uint64_t queued_ = 0;        ///< Records handed to record()
+    uint64_t committed_ = 0;     ///< Records durable in journal or snapshot
+    size_t journal_records_ = 0; ///< Records in the journal file
+    bool needs_compaction_ = false;
+    bool failed_ = false;        ///< A write failed; flush() reports it
+    std::unordered_map<std::string, uint8_t> states_; ///< States as of the last queued record
+    Stats stats_;
+};
+
+} // namespace helix
+
+#endif // HELIX_STATE_JOURNAL_H
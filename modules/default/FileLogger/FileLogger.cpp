@@ -0,0 +1,490 @@
+/*
+ Helix – File Logger Module
+ Purpose:
+    - High-throughput file logging sink for the Helix module management platform.
+    - Keeps up with bursty producers where the per-line flushing console path cannot.
+
+ Details:
+    - Formatting happens on the calling thread; lines are appended to large page-aligned
+      buffers under a short lock. A writer thread hands filled buffers to writev(), so
+      producers never wait on disk I/O.
+    - Timestamp format: YYYY-MM-DD HH:MM:SS.mmm (local time), same as ConsoleLogger.
+      The date/time prefix is formatted once per second per thread and reused.
+    - Rotation by size and/or age is performed by the writer thread between writes:
+      <path> -> <path>.1 -> ... -> <path>.<keep>.
+    - The file is opened with O_NOFOLLOW and must be a regular file owned by the daemon's
+      user, so a link or file planted in a shared directory is not written through.
+    - If the writer falls behind and all buffers are full, lines are dropped and counted;
+      a note with the count is written once space frees up.
+    - Registration: prefers the batch (v2) sink API, falls back to helix_log_get_register.
+    - The writer is started with helix_thread_create() and operator new/delete are counted
+      (HELIX_MODULE_TRACK_ALLOCATIONS), so `helixctl top` charges its CPU, file and heap
+      use to this module. The page-aligned buffers come from posix_memalign and are not
+      part of the heap count.
+    - Entry points: filelogger_init/start/stop/destroy
+         Ensure manifest.json entry_points map to these symbols.
+    - License: MIT (see repository root LICENSE).
+
+ Configuration (environment of helixd):
+    - HELIX_FILELOG_PATH        log file path (default: $HELIX_STATE_DIR/logs/helix.log, where helixd
+                                sets HELIX_STATE_DIR to its modules directory)
+    - HELIX_FILELOG_MAX_BYTES   rotate when the file would exceed this size; 0 disables (default: 64 MiB)
+    - HELIX_FILELOG_ROTATE_SECS rotate when the file is older than this; 0 disables (default: 0)
+    - HELIX_FILELOG_KEEP        rotated files to keep (default: 5)
+    - HELIX_FILELOG_FLUSH_MS    maximum time a line waits in memory (default: 200)
+
+ Notes:
+    - io_uring is not used: writev of a handful of 256 KiB buffers per wakeup already
+      amortizes the syscall cost, and it keeps the module dependency-free.
+*/
+
+#include "helix/module.h"
+#include "helix/log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+HELIX_MODULE_TRACK_ALLOCATIONS()
+
+namespace {
+
+constexpr size_t kBufferSize = 256 * 1024;
+constexpr size_t kMaxBuffers = 16;      // at most 4 MiB waiting for the writer
+constexpr size_t kMaxLine = 1024;       // longer messages are truncated
+constexpr size_t kLocalChunk = 16 * 1024;
+
+struct Config {
+    std::string path;
+    uint64_t max_bytes = 64ull * 1024 * 1024;
+    uint64_t rotate_secs = 0;
+    int keep = 5;
+    int flush_ms = 200;
+};
+
+struct Buffer {
+    char* data;
+    size_t used;
+};
+
+Config g_cfg;
+
+// Producer/writer hand-off; everything below is guarded by g_buf_mtx.
+std::mutex g_buf_mtx;
+std::condition_variable g_buf_cv;
+Buffer* g_active = nullptr;
+std::vector<Buffer*> g_full;
+std::vector<Buffer*> g_free;
+size_t g_allocated = 0;
+uint64_t g_dropped_lines = 0;
+bool g_stop = false;
+
+// Owned by the writer thread once started.
+int g_fd = -1;
+uint64_t g_file_bytes = 0;
+time_t g_opened_at = 0;
+
+pthread_t g_writer;
+bool g_writer_running = false;
+std::atomic<bool> g_registered{false};
+bool g_registered_v2 = false;
+
+inline const char* level_to_str(int level) noexcept {
+    switch (level) {
+        case 0: return "DEBUG";
+        case 1: return "INFO";
+        case 2: return "WARN";
+        case 3: return "ERROR";
+        default: return "INFO";
+    }
+}
+
+uint64_t env_u64(const char* name, uint64_t def) {
+    const char* v = std::getenv(name);
+    if (!v || !*v) return def;
+    char* end = nullptr;
+    unsigned long long n = std::strtoull(v, &end, 10);
+    return (end && *end == '\0') ? static_cast<uint64_t>(n) : def;
+}
+
+void load_config() {
+    if (const char* p = std::getenv("HELIX_FILELOG_PATH"); p && *p) {
+        g_cfg.path = p;
+    } else {
+        // Next to the daemon's own state rather than in a world-writable directory
+        const char* state = std::getenv("HELIX_STATE_DIR");
+        const std::string dir = std::string(state && *state ? state : ".") + "/logs";
+        if (::mkdir(dir.c_str(), 0750) != 0 && errno != EEXIST) {
+            std::cerr << "FileLogger: cannot create " << dir << ": " << std::strerror(errno) << std::endl;
+        }
+        g_cfg.path = dir + "/helix.log";
+    }
+    g_cfg.max_bytes = env_u64("HELIX_FILELOG_MAX_BYTES", g_cfg.max_bytes);
+    g_cfg.rotate_secs = env_u64("HELIX_FILELOG_ROTATE_SECS", g_cfg.rotate_secs);
+    g_cfg.keep = static_cast<int>(env_u64("HELIX_FILELOG_KEEP", static_cast<uint64_t>(g_cfg.keep)));
+    g_cfg.flush_ms = static_cast<int>(env_u64("HELIX_FILELOG_FLUSH_MS", static_cast<uint64_t>(g_cfg.flush_ms)));
+    if (g_cfg.flush_ms <= 0) g_cfg.flush_ms = 1;
+}
+
+// --- Formatting ---
+
+// "YYYY-MM-DD HH:MM:SS." for the current second; rebuilt only when the second changes.
+struct TimestampCache {
+    int64_t second = INT64_MIN;
+    char prefix[32];
+    size_t len = 0;
+};
+thread_local TimestampCache t_ts;
+
+int64_t realtime_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+int64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000ll + ts.tv_nsec;
+}
+
+const TimestampCache& timestamp_prefix(int64_t second) {
+    if (t_ts.second != second) {
+        std::time_t t = static_cast<std::time_t>(second);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        int n = std::snprintf(t_ts.prefix, sizeof(t_ts.prefix), "%04d-%02d-%02d %02d:%02d:%02d.",
+                              tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                              tm.tm_hour, tm.tm_min, tm.tm_sec);
+        t_ts.len = n > 0 ? static_cast<size_t>(n) : 0;
+        t_ts.second = second;
+    }
+    return t_ts;
+}
+
+inline char* put(char* out, const char* s, size_t n) {
+    std::memcpy(out, s, n);
+    return out + n;
+}
+
+// Formats one line into 'out' (at least kMaxLine bytes) and returns its length.
+size_t format_line(char* out, int64_t wall_ns, const char* module, int level,
+                   const char* msg, size_t msg_len) {
+    const int64_t second = wall_ns / 1000000000ll;
+    const int ms = static_cast<int>((wall_ns / 1000000ll) % 1000);
+    const TimestampCache& ts = timestamp_prefix(second);
+    const char* lvl = level_to_str(level);
+    const size_t mod_len = std::strlen(module);
+    const size_t lvl_len = std::strlen(lvl);
+
+    char* p = out;
+    *p++ = '[';
+    p = put(p, ts.prefix, ts.len);
+    *p++ = static_cast<char>('0' + ms / 100);
+    *p++ = static_cast<char>('0' + (ms / 10) % 10);
+    *p++ = static_cast<char>('0' + ms % 10);
+    p = put(p, "] [", 3);
+    p = put(p, module, std::min(mod_len, size_t{128}));
+    p = put(p, "] [", 3);
+    p = put(p, lvl, lvl_len);
+    p = put(p, "] ", 2);
+    const size_t room = kMaxLine - 1 - static_cast<size_t>(p - out);
+    p = put(p, msg, std::min(msg_len, room));
+    *p++ = '\n';
+    return static_cast<size_t>(p - out);
+}
+
+// --- Buffer management ---
+
+Buffer* allocate_buffer_locked() {
+    if (!g_free.empty()) {
+        Buffer* b = g_free.back();
+        g_free.pop_back();
+        b->used = 0;
+        return b;
+    }
+    if (g_allocated >= kMaxBuffers) return nullptr;
+    void* mem = nullptr;
+    if (posix_memalign(&mem, 4096, kBufferSize) != 0) return nullptr;
+    ++g_allocated;
+    return new Buffer{static_cast<char*>(mem), 0};
+}
+
+// Copies formatted lines into the active buffer. 'lines' counts the lines in 'data' so
+// drops can be reported accurately.
+void append(const char* data, size_t len, size_t lines) {
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(g_buf_mtx);
+        if (!g_active || g_active->used + len > kBufferSize) {
+            if (g_active && g_active->used > 0) {
+                g_full.push_back(g_active);
+                g_active = nullptr;
+                wake = true;
+            }
+            if (!g_active) g_active = allocate_buffer_locked();
+            if (!g_active) {
+                g_dropped_lines += lines;
+                if (wake) g_buf_cv.notify_one();
+                return;
+            }
+        }
+        std::memcpy(g_active->data + g_active->used, data, len);
+        g_active->used += len;
+    }
+    if (wake) g_buf_cv.notify_one();
+}
+
+// --- Sinks ---
+
+void filelogger_sink_batch(const HelixLogRecord* recs, size_t count, void*) {
+    // Records carry CLOCK_MONOTONIC timestamps; map them to wall time once per batch.
+    const int64_t offset = realtime_ns() - monotonic_ns();
+    char chunk[kLocalChunk];
+    size_t used = 0;
+    size_t lines = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (used + kMaxLine > sizeof(chunk)) {
+            append(chunk, used, lines);
+            used = 0;
+            lines = 0;
+        }
+        const HelixLogRecord& r = recs[i];
+        used += format_line(chunk + used, static_cast<int64_t>(r.timestamp_ns) + offset,
+                            r.module ? r.module : "(unknown)", r.level,
+                            r.message ? r.message : "", r.message ? r.message_len : 0);
+        ++lines;
+    }
+    if (used > 0) append(chunk, used, lines);
+}
+
+void filelogger_sink(const char* module_name, int level, const char* message) {
+    char line[kMaxLine];
+    const char* msg = message ? message : "";
+    size_t n = format_line(line, realtime_ns(), module_name ? module_name : "(unknown)", level,
+                           msg, std::strlen(msg));
+    append(line, n, 1);
+}
+
+// --- Writer thread ---
+
+// Refuses symlinks, and existing files that are not regular or belong to another user
+bool open_log_file() {
+    g_fd = ::open(g_cfg.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | O_NOFOLLOW, 0640);
+    if (g_fd < 0) return false;
+    struct stat st{};
+    if (fstat(g_fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != ::geteuid()) {
+        ::close(g_fd);
+        g_fd = -1;
+        errno = EPERM;
+        return false;
+    }
+    g_file_bytes = static_cast<uint64_t>(st.st_size);
+    g_opened_at = std::time(nullptr);
+    return true;
+}
+
+void rotate_log_file() {
+    ::close(g_fd);
+    g_fd = -1;
+    if (g_cfg.keep <= 0) {
+        ::unlink(g_cfg.path.c_str());
+    } else {
+        for (int i = g_cfg.keep - 1; i >= 1; --i) {
+            std::string from = g_cfg.path + "." + std::to_string(i);
+            std::string to = g_cfg.path + "." + std::to_string(i + 1);
+            ::rename(from.c_str(), to.c_str());
+        }
+        ::rename(g_cfg.path.c_str(), (g_cfg.path + ".1").c_str());
+    }
+    if (!open_log_file()) {
+        std::cerr << "FileLogger: failed to reopen " << g_cfg.path << ": " << std::strerror(errno) << std::endl;
+    }
+}
+
+bool rotation_due(uint64_t pending) {
+    if (g_file_bytes == 0) return false;
+    if (g_cfg.max_bytes > 0 && g_file_bytes + pending > g_cfg.max_bytes) return true;
+    if (g_cfg.rotate_secs > 0 &&
+        static_cast<uint64_t>(std::time(nullptr) - g_opened_at) >= g_cfg.rotate_secs) return true;
+    return false;
+}
+
+// Writes every iovec fully, resuming after partial writes and EINTR.
+void write_all(struct iovec* iov, int count) {
+    while (count > 0 && g_fd >= 0) {
+        ssize_t n = ::writev(g_fd, iov, std::min(count, IOV_MAX));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "FileLogger: write failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        g_file_bytes += static_cast<uint64_t>(n);
+        size_t left = static_cast<size_t>(n);
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+            iov->iov_len -= left;
+        }
+    }
+}
+
+void* writer_main(void*) {
+    std::vector<Buffer*> batch;
+    std::vector<struct iovec> iov;
+    bool stopping = false;
+    while (!stopping) {
+        uint64_t dropped = 0;
+        {
+            std::unique_lock<std::mutex> lock(g_buf_mtx);
+            g_buf_cv.wait_for(lock, std::chrono::milliseconds(g_cfg.flush_ms),
+                              [] { return g_stop || !g_full.empty(); });
+            // Flush the partially filled buffer too, so lines never wait longer than flush_ms.
+            if (g_active && g_active->used > 0) {
+                g_full.push_back(g_active);
+                g_active = nullptr;
+            }
+            batch.swap(g_full);
+            dropped = g_dropped_lines;
+            g_dropped_lines = 0;
+            stopping = g_stop;
+        }
+
+        uint64_t pending = 0;
+        iov.clear();
+        for (Buffer* b : batch) {
+            iov.push_back({b->data, b->used});
+            pending += b->used;
+        }
+        char note[96];
+        if (dropped > 0) {
+            int n = std::snprintf(note, sizeof(note), "[FileLogger] dropped %llu lines: writer fell behind\n",
+                                  static_cast<unsigned long long>(dropped));
+            if (n > 0) {
+                iov.push_back({note, static_cast<size_t>(n)});
+                pending += static_cast<uint64_t>(n);
+            }
+        }
+        if (!iov.empty()) {
+            if (rotation_due(pending)) rotate_log_file();
+            write_all(iov.data(), static_cast<int>(iov.size()));
+        }
+
+        if (!batch.empty()) {
+            std::lock_guard<std::mutex> lock(g_buf_mtx);
+            for (Buffer* b : batch) {
+                b->used = 0;
+                g_free.push_back(b);
+            }
+        }
+        batch.clear();
+    }
+    return nullptr;
+}
+
+void release_buffers() {
+    std::lock_guard<std::mutex> lock(g_buf_mtx);
+    if (g_active) g_free.push_back(g_active);
+    g_active = nullptr;
+    for (Buffer* b : g_full) g_free.push_back(b);
+    g_full.clear();
+    for (Buffer* b : g_free) {
+        std::free(b->data);
+        delete b;
+    }
+    g_free.clear();
+    g_allocated = 0;
+}
+
+} // namespace
+
+extern "C" {
+
+int filelogger_init() {
+    load_config();
+    helix_log("FileLogger", "Logger module initialized", HELIX_LOG_INFO);
+    return 0;
+}
+
+int filelogger_start() {
+    if (g_registered.load(std::memory_order_acquire)) return 0;
+    if (!open_log_file()) {
+        std::cerr << "FileLogger: cannot open " << g_cfg.path << ": " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_buf_mtx);
+        g_stop = false;
+    }
+    if (int rc = helix_thread_create(&g_writer, nullptr, &writer_main, nullptr)) {
+        std::cerr << "FileLogger: failed to start writer thread: " << std::strerror(rc) << std::endl;
+        ::close(g_fd);
+        g_fd = -1;
+        return -1;
+    }
+    g_writer_running = true;
+    if (auto reg_v2 = helix_log_get_register_v2()) {
+        reg_v2(&filelogger_sink_batch, nullptr);
+        g_registered_v2 = true;
+        g_registered.store(true, std::memory_order_release);
+    } else if (auto reg = helix_log_get_register()) {
+        reg(&filelogger_sink);
+        g_registered_v2 = false;
+        g_registered.store(true, std::memory_order_release);
+    }
+    helix_log("FileLogger", ("Logger sink registered, writing to " + g_cfg.path).c_str(), HELIX_LOG_INFO);
+    return 0;
+}
+
+int filelogger_stop() {
+    if (g_registered.load(std::memory_order_acquire)) {
+        // Unregistering waits for in-flight sink calls, so no line is appended after this.
+        if (g_registered_v2) {
+            if (auto unreg = helix_log_get_unregister_v2()) unreg(&filelogger_sink_batch, nullptr);
+        } else if (auto unreg = helix_log_get_unregister()) {
+            unreg(&filelogger_sink);
+        }
+        g_registered.store(false, std::memory_order_release);
+    }
+    if (g_writer_running) {
+        {
+            std::lock_guard<std::mutex> lock(g_buf_mtx);
+            g_stop = true;
+        }
+        g_buf_cv.notify_one();
+        pthread_join(g_writer, nullptr);
+        g_writer_running = false;
+    }
+    if (g_fd >= 0) {
+        ::close(g_fd);
+        g_fd = -1;
+    }
+    release_buffers();
+    helix_log("FileLogger", "Logger sink unregistered", HELIX_LOG_INFO);
+    return 0;
+}
+
+void filelogger_destroy() {
+    helix_log("FileLogger", "Logger module destroyed", HELIX_LOG_DEBUG);
+}
+
+}
@@ -0,0 +1,431 @@
+#include "helix/archive.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <utility>
+#include <vector>
+#ifdef HELIX_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace helix {
+
+#ifdef HELIX_HAVE_ZLIB
+
+namespace {
+
+constexpr size_t kBlock = 512;
+constexpr size_t kChunk = 64 * 1024;
+constexpr unsigned kGzBuffer = 256 * 1024;
+
+// ustar header field offsets/lengths
+constexpr size_t kNameOff = 0, kNameLen = 100;
+constexpr size_t kModeOff = 100, kModeLen = 8;
+constexpr size_t kUidOff = 108, kGidOff = 116, kIdLen = 8;
+constexpr size_t kSizeOff = 124, kSizeLen = 12;
+constexpr size_t kMtimeOff = 136, kMtimeLen = 12;
+constexpr size_t kChksumOff = 148, kChksumLen = 8;
+constexpr size_t kTypeOff = 156;
+constexpr size_t kMagicOff = 257;
+constexpr size_t kPrefixOff = 345, kPrefixLen = 155;
+
+struct GzCloser {
+    void operator()(gzFile f) const { if (f) gzclose(f); }
+};
+using GzHandle = std::unique_ptr<gzFile_s, GzCloser>;
+
+std::string field(const unsigned char* hdr, size_t off, size_t len) {
+    size_t n = 0;
+    while (n < len && hdr[off + n] != '\0') ++n;
+    return std::string(reinterpret_cast<const char*>(hdr + off), n);
+}
+
+// Numeric fields are octal text, or base-256 when the high bit of the first byte is set
+bool parse_number(const unsigned char* hdr, size_t off, size_t len, uint64_t& out) {
+    out = 0;
+    if (hdr[off] & 0x80) {
+        for (size_t i = 1; i < len; ++i) out = (out << 8) | hdr[off + i];
+        return true;
+    }
+    size_t i = 0;
+    while (i < len && (hdr[off + i] == ' ' || hdr[off + i] == '\0')) ++i;
+    for (; i < len && hdr[off + i] >= '0' && hdr[off + i] <= '7'; ++i) out = (out << 3) | (hdr[off + i] - '0');
+    return true;
+}
+
+bool checksum_ok(const unsigned char* hdr) {
+    uint64_t stored = 0;
+    parse_number(hdr, kChksumOff, kChksumLen, stored);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kBlock; ++i) {
+        sum += (i >= kChksumOff && i < kChksumOff + kChksumLen) ? ' ' : hdr[i];
+    }
+    return sum == stored;
+}
+
+// Reject anything that could escape dest_dir
+bool safe_relative_path(const std::string& path) {
+    if (path.empty() || path[0] == '/') return false;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (path.compare(start, end - start, "..") == 0 && end - start == 2) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+std::string normalize_member(std::string name) {
+    while (name.rfind("./", 0) == 0) name.erase(0, 2);
+    while (!name.empty() && name.back() == '/') name.pop_back();
+    return name;
+}
+
+bool read_exact(gzFile gz, void* buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        int n = gzread(gz, static_cast<char*>(buf) + got, static_cast<unsigned>(len - got));
+        if (n <= 0) return false;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool skip_bytes(gzFile gz, uint64_t len) {
+    char buf[kBlock * 16];
+    while (len > 0) {
+        size_t step = len < sizeof(buf) ? static_cast<size_t>(len) : sizeof(buf);
+        if (!read_exact(gz, buf, step)) return false;
+        len -= step;
+    }
+    return true;
+}
+
+uint64_t padded(uint64_t size) { return (size + kBlock - 1) / kBlock * kBlock; }
+
+std::string gz_error(gzFile gz) {
+    int errnum = 0;
+    const char* msg = gzerror(gz, &errnum);
+    if (errnum == Z_ERRNO) return std::strerror(errno);
+    return msg && *msg ? msg : "unexpected end of archive";
+}
+
+// Minimal pax extended header: "<len> key=value\n" records; only "path" matters here
+std::string pax_path(const std::string& data) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t sp = data.find(' ', pos);
+        if (sp == std::string::npos) break;
+        size_t len = std::strtoul(data.c_str() + pos, nullptr, 10);
+        if (len == 0 || pos + len > data.size()) break;
+        std::string record = data.substr(sp + 1, pos + len - sp - 2); // drop trailing '\n'
+        if (record.rfind("path=", 0) == 0) return record.substr(5);
+        pos += len;
+    }
+    return std::string();
+}
+
+void put_octal(unsigned char* hdr, size_t off, size_t len, uint64_t value) {
+    // len-1 digits, NUL-terminated
+    std::snprintf(reinterpret_cast<char*>(hdr + off), len, "%0*llo", static_cast<int>(len - 1),
+                  static_cast<unsigned long long>(value));
+}
+
+} // namespace
+
+bool archive_support_available() { return true; }
+
+bool extract_tar_gz(const std::string& archive_path, const std::string& dest_dir, std::string& error) {
+    GzHandle gz(gzopen(archive_path.c_str(), "rb"));
+    if (!gz) {
+        error = "cannot open " + archive_path + ": " + std::strerror(errno);
+        return false;
+    }
+    gzbuffer(gz.get(), kGzBuffer);
+
+    std::error_code ec;
+    std::filesystem::create_directories(dest_dir, ec);
+    if (ec) {
+        error = "cannot create " + dest_dir + ": " + ec.message();
+        return false;
+    }
+
+    std::unique_ptr<char[]> chunk(new char[kChunk]);
+    unsigned char hdr[kBlock];
+    std::string long_name; // from a preceding GNU 'L' or pax 'x' header
+    size_t members = 0;
+    // Directory modes are applied last so read-only directories can still receive their files
+    std::vector<std::pair<std::string, mode_t>> dir_modes;
+
+    for (;;) {
+        if (!read_exact(gz.get(), hdr, kBlock)) {
+            // Archives truncated right after the last member (no end blocks) are still complete
+            if (gzeof(gz.get()) && long_name.empty()) break;
+            error = "read header: " + gz_error(gz.get());
+            return false;
+        }
+        if (members == 0 && gzdirect(gz.get())) { // zlib passes non-gzip input through unchanged
+            error = "not a gzip-compressed archive";
+            return false;
+        }
+        bool zero = true;
+        for (size_t i = 0; i < kBlock && zero; ++i) zero = hdr[i] == 0;
+        if (zero) break; // end-of-archive marker
+
+        if (!checksum_ok(hdr)) {
+            error = "corrupt tar header (checksum mismatch)";
+            return false;
+        }
+        uint64_t size = 0, mode = 0;
+        parse_number(hdr, kSizeOff, kSizeLen, size);
+        parse_number(hdr, kModeOff, kModeLen, mode);
+        const char type = static_cast<char>(hdr[kTypeOff]);
+
+        if (type == 'L' || type == 'x') {
+            if (size > 64 * 1024) {
+                error = "oversized extended header";
+                return false;
+            }
+            std::string data(static_cast<size_t>(size), '\0');
+            if (!read_exact(gz.get(), &data[0], data.size()) || !skip_bytes(gz.get(), padded(size) - size)) {
+                error = "read extended header: " + gz_error(gz.get());
+                return false;
+            }
+            if (type == 'L') {
+                long_name = std::string(data.c_str());
+            } else {
+                std::string p = pax_path(data);
+                if (!p.empty()) long_name = p;
+            }
+            continue;
+        }
+        if (type == 'g') { // pax global header: nothing we use
+            if (!skip_bytes(gz.get(), padded(size))) {
+                error = "read global header: " + gz_error(gz.get());
+                return false;
+            }
+            continue;
+        }
+
+        std::string name = long_name;
+        long_name.clear();
+        if (name.empty()) {
+            name = field(hdr, kNameOff, kNameLen);
+            const std::string prefix = field(hdr, kPrefixOff, kPrefixLen);
+            if (std::memcmp(hdr + kMagicOff, "ustar", 5) == 0 && !prefix.empty()) name = prefix + "/" + name;
+        }
+        name = normalize_member(name);
+        if (name.empty() || name == ".") { // the archive root itself
+            if (!skip_bytes(gz.get(), padded(size))) {
+                error = "read member: " + gz_error(gz.get());
+                return false;
+            }
+            continue;
+        }
+        if (!safe_relative_path(name)) {
+            error = "refusing unsafe member path: " + name;
+            return false;
+        }
+        const std::string out_path = dest_dir + "/" + name;
+
+        if (type == '5') {
+            std::filesystem::create_directories(out_path, ec);
+            if (ec) {
+                error = "mkdir " + out_path + ": " + ec.message();
+                return false;
+            }
+            if (mode & 07777) dir_modes.emplace_back(out_path, static_cast<mode_t>(mode & 07777));
+            ++members;
+            continue;
+        }
+        if (type != '0' && type != '\0' && type != '7') {
+            error = "unsupported member type '" + std::string(1, type) + "' for " + name;
+            return false;
+        }
+
+        const auto parent = std::filesystem::path(out_path).parent_path();
+        std::filesystem::create_directories(parent, ec);
+        const mode_t perm = static_cast<mode_t>(mode & 0777) ? static_cast<mode_t>(mode & 0777) : 0644;
+        int fd = ::open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, perm);
+        if (fd < 0) {
+            error = "create " + out_path + ": " + std::strerror(errno);
+            return false;
+        }
+        uint64_t left = size;
+        bool ok = true;
+        while (left > 0 && ok) {
+            size_t step = left < kChunk ? static_cast<size_t>(left) : kChunk;
+            if (!read_exact(gz.get(), chunk.get(), step)) {
+                error = "read " + name + ": " + gz_error(gz.get());
+                ok = false;
+                break;
+            }
+            size_t off = 0;
+            while (off < step) {
+                ssize_t w = ::write(fd, chunk.get() + off, step - off);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    error = "write " + out_path + ": " + std::strerror(errno);
+                    ok = false;
+                    break;
+                }
+                off += static_cast<size_t>(w);
+            }
+            left -= step;
+        }
+        if (ok && ::fchmod(fd, perm) != 0) { // O_CREAT honours the umask; archives carry exact bits
+            error = "chmod " + out_path + ": " + std::strerror(errno);
+            ok = false;
+        }
+        ::close(fd);
+        if (!ok) return false;
+        if (!skip_bytes(gz.get(), padded(size) - size)) {
+            error = "read padding: " + gz_error(gz.get());
+            return false;
+        }
+        ++members;
+    }
+
+    if (members == 0) {
+        error = "archive is empty";
+        return false;
+    }
+    for (auto it = dir_modes.rbegin(); it != dir_modes.rend(); ++it) {
+        if (::chmod(it->first.c_str(), it->second & 0777) != 0) {
+            error = "chmod " + it->first + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_tar_gz(const std::string& archive_path, const std::vector<ArchiveMember>& members, std::string& error) {
+    const std::string tmp_path = archive_path + ".tmp";
+    GzHandle gz(gzopen(tmp_path.c_str(), "wb6"));
+    if (!gz) {
+        error = "cannot create " + tmp_path + ": " + std::strerror(errno);
+        return false;
+    }
+    gzbuffer(gz.get(), kGzBuffer);
+
+    auto fail = [&](const std::string& msg) {
+        error = msg;
+        gz.reset();
+        ::unlink(tmp_path.c_str());
+        return false;
+    };
+
+    std::unique_ptr<char[]> chunk(new char[kChunk]);
+    for (const auto& m : members) {
+        std::string name = normalize_member(m.name);
+        if (!safe_relative_path(name)) return fail("invalid member name: " + m.name);
+
+        int fd = ::open(m.source_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail("open " + m.source_path + ": " + std::strerror(errno));
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return fail("not a regular file: " + m.source_path);
+        }
+
+        unsigned char hdr[kBlock];
+        std::memset(hdr, 0, sizeof(hdr));
+        std::string prefix;
+        if (name.size() > kNameLen) {
+            // Split at a '/' so that both halves fit the ustar name/prefix fields
+            size_t cut = name.rfind('/', kPrefixLen);
+            if (cut == std::string::npos || name.size() - cut - 1 > kNameLen) {
+                ::close(fd);
+                return fail("member name too long for ustar: " + name);
+            }
+            prefix = name.substr(0, cut);
+            name = name.substr(cut + 1);
+        }
+        std::memcpy(hdr + kNameOff, name.data(), name.size());
+        std::memcpy(hdr + kPrefixOff, prefix.data(), prefix.size());
+        put_octal(hdr, kModeOff, kModeLen, st.st_mode & 0777);
+        put_octal(hdr, kUidOff, kIdLen, 0);
+        put_octal(hdr, kGidOff, kIdLen, 0);
+        put_octal(hdr, kSizeOff, kSizeLen, static_cast<uint64_t>(st.st_size));
+        put_octal(hdr, kMtimeOff, kMtimeLen, static_cast<uint64_t>(st.st_mtime));
+        hdr[kTypeOff] = '0';
+        std::memcpy(hdr + kMagicOff, "ustar\0" "00", 8);
+        std::memset(hdr + kChksumOff, ' ', kChksumLen);
+        unsigned sum = 0;
+        for (size_t i = 0; i < kBlock; ++i) sum += hdr[i];
+        std::snprintf(reinterpret_cast<char*>(hdr + kChksumOff), kChksumLen, "%06o", sum);
+        hdr[kChksumOff + 7] = ' ';
+
+        if (gzwrite(gz.get(), hdr, kBlock) != static_cast<int>(kBlock)) {
+            ::close(fd);
+            return fail("write header: " + gz_error(gz.get()));
+        }
+        uint64_t written = 0;
+        for (;;) {
+            ssize_t n = ::read(fd, chunk.get(), kChunk);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) {
+                ::close(fd);
+                return fail("read " + m.source_path + ": " + std::strerror(errno));
+            }
+            if (n == 0) break;
+            if (gzwrite(gz.get(), chunk.get(), static_cast<unsigned>(n)) != n) {
+                ::close(fd);
+                return fail("write " + name + ": " + gz_error(gz.get()));
+            }
+            written += static_cast<uint64_t>(n);
+        }
+        ::close(fd);
+        if (written != static_cast<uint64_t>(st.st_size)) return fail("file changed while archiving: " + m.source_path);
+        const size_t pad = static_cast<size_t>(padded(written) - written);
+        if (pad) {
+            std::memset(hdr, 0, pad);
+            if (gzwrite(gz.get(), hdr, static_cast<unsigned>(pad)) != static_cast<int>(pad)) {
+                return fail("write padding: " + gz_error(gz.get()));
+            }
+        }
+    }
+
+    // Two zero blocks end the archive
+    unsigned char end[kBlock * 2];
+    std::memset(end, 0, sizeof(end));
+    if (gzwrite(gz.get(), end, sizeof(end)) != static_cast<int>(sizeof(end))) {
+        return fail("write trailer: " + gz_error(gz.get()));
+    }
+    if (gzclose(gz.release()) != Z_OK) {
+        ::unlink(tmp_path.c_str());
+        error = "finish " + tmp_path + ": compression failed";
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), archive_path.c_str()) != 0) {
+        error = "rename to " + archive_path + ": " + std::strerror(errno);
+        ::unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+#else // !HELIX_HAVE_ZLIB
+
+bool archive_support_available() { return false; }
+
+bool extract_tar_gz(const std::string&, const std::string&, std::string& error) {
+    error = "built without zlib";
+    return false;
+}
+
+bool write_tar_gz(const std::string&, const std::vector<ArchiveMember>&, std::string& error) {
+    error = "built without zlib";
+    return false;
+}
+
+#endif // HELIX_HAVE_ZLIB
+
+} // namespace helix
@@ -0,0 +1,220 @@
+#include "helix/blob_store.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace helix {
+
+namespace {
+
+// SHA-256 (FIPS 180-4); small and dependency-free, used to name blobs and cache entries
+class Sha256 {
+public:
+    void update(const unsigned char* data, size_t len) {
+        total_ += len;
+        if (used_) {
+            size_t take = std::min(len, sizeof(buf_) - used_);
+            std::memcpy(buf_ + used_, data, take);
+            used_ += take;
+            data += take;
+            len -= take;
+            if (used_ < sizeof(buf_)) return;
+            block(buf_);
+            used_ = 0;
+        }
+        for (; len >= 64; data += 64, len -= 64) block(data);
+        std::memcpy(buf_, data, len);
+        used_ = len;
+    }
+
+    std::string hex() {
+        const uint64_t bits = total_ * 8;
+        static const unsigned char pad[64] = {0x80};
+        const size_t pad_len = used_ < 56 ? 56 - used_ : 120 - used_;
+        update(pad, pad_len);
+        unsigned char len_be[8];
+        for (int i = 0; i < 8; ++i) len_be[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        update(len_be, 8);
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        out.reserve(64);
+        for (uint32_t w : h_) {
+            for (int i = 28; i >= 0; i -= 4) out.push_back(digits[(w >> i) & 0xf]);
+        }
+        return out;
+    }
+
+private:
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void block(const unsigned char* p) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(p[4 * i]) << 24) | (uint32_t(p[4 * i + 1]) << 16) | (uint32_t(p[4 * i + 2]) << 8) | p[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        h_[0] += a; h_[1] += b; h_[2] += c; h_[3] += d;
+        h_[4] += e; h_[5] += f; h_[6] += g; h_[7] += h;
+    }
+
+    uint32_t h_[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    unsigned char buf_[64];
+    size_t used_ = 0;
+    uint64_t total_ = 0;
+};
+
+// Share blob's storage under dst via a copy-on-write clone (btrfs, xfs, ...)
+bool reflink(const std::string& blob, const std::string& dst) {
+#if defined(__linux__) && defined(FICLONE)
+    int src = ::open(blob.c_str(), O_RDONLY | O_CLOEXEC);
+    if (src < 0) return false;
+    struct stat st{};
+    ::fstat(src, &st);
+    int out = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0) {
+        ::close(src);
+        return false;
+    }
+    bool ok = ::ioctl(out, FICLONE, src) == 0 && ::fchmod(out, st.st_mode & 0777) == 0;
+    ::close(out);
+    ::close(src);
+    if (!ok) ::unlink(dst.c_str());
+    return ok;
+#else
+    (void)blob;
+    (void)dst;
+    return false;
+#endif
+}
+
+} // namespace
+
+bool BlobStore::hash_file(const std::string& path, std::string& hex, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    (void)::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    Sha256 sha;
+    unsigned char buf[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            error = "read " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        if (n == 0) break;
+        sha.update(buf, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    hex = sha.hex();
+    return true;
+}
+
+std::string BlobStore::hash_bytes(const void* data, size_t size) {
+    Sha256 sha;
+    sha.update(static_cast<const unsigned char*>(data), size);
+    return sha.hex();
+}
+
+bool BlobStore::ingest(const std::string& path, bool& shared, std::string& error) {
+    shared = false;
+    struct stat st{};
+    if (::lstat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        error = "not a regular file: " + path;
+        return false;
+    }
+    std::string hex;
+    if (!hash_file(path, hex, error)) return false;
+
+    char mode[8];
+    std::snprintf(mode, sizeof(mode), "%03o", static_cast<unsigned>(st.st_mode & 0777));
+    const std::string dir = root_ + "/" + hex.substr(0, 2);
+    const std::string blob = dir + "/" + hex + "-" + mode;
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) return true; // no store; keep the private copy
+
+    struct stat bst{};
+    if (::stat(blob.c_str(), &bst) == 0) {
+        if (bst.st_dev == st.st_dev && bst.st_ino == st.st_ino) {
+            shared = true; // already linked
+            return true;
+        }
+        // Known contents: swap the fresh copy for a link to the existing blob
+        const std::string tmp = path + ".blob-link";
+        ::unlink(tmp.c_str());
+        if (::link(blob.c_str(), tmp.c_str()) == 0 || reflink(blob, tmp)) {
+            if (::rename(tmp.c_str(), path.c_str()) == 0) {
+                shared = true;
+                return true;
+            }
+            ::unlink(tmp.c_str());
+        }
+        return true;
+    }
+
+    // New contents: the file itself becomes the blob (link then rename, so the blob appears atomically)
+    const std::string tmp = blob + ".tmp" + std::to_string(static_cast<long>(::getpid()));
+    ::unlink(tmp.c_str());
+    if (::link(path.c_str(), tmp.c_str()) != 0) return true;
+    if (::rename(tmp.c_str(), blob.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        return true;
+    }
+    shared = true;
+    return true;
+}
+
+size_t BlobStore::collect_garbage() {
+    size_t removed = 0;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root_, ec)) return 0;
+    for (const auto& bucket : std::filesystem::directory_iterator(root_, ec)) {
+        if (!bucket.is_directory(ec)) continue;
+        for (const auto& entry : std::filesystem::directory_iterator(bucket.path(), ec)) {
+            struct stat st{};
+            if (::lstat(entry.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+            // A link count of 1 means only the store still refers to the inode
+            if (st.st_nlink <= 1 && ::unlink(entry.path().c_str()) == 0) ++removed;
+        }
+        std::filesystem::remove(bucket.path(), ec); // only succeeds once the bucket is empty
+    }
+    return removed;
+}
+
+} // namespace helix
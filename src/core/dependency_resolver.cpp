@@ -1,75 +1,252 @@
 #include "helix/dependency_resolver.h"
+#include "helix/metrics.h"
 #include <algorithm>
-#include <queue>
 #include <iostream>
-#include <regex>
-#include <sstream>
+#include <unordered_set>
 
 namespace helix {
 
 DependencyResolver::DependencyResolver() {
 }
 
+DependencyResolver::ModuleId DependencyResolver::intern_module(const std::string& name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    const ModuleId id = static_cast<ModuleId>(nodes_.size());
+    nodes_.emplace_back();
+    nodes_.back().name = name;
+    ids_.emplace(name, id);
+    csr_rows_.push_back(Row{static_cast<uint32_t>(csr_edges_.size()), 0, 0});
+    return id;
+}
+
+const DependencyResolver::Node* DependencyResolver::find_present(const std::string& name) const {
+    auto it = ids_.find(name);
+    if (it == ids_.end() || !nodes_[it->second].present) return nullptr;
+    return &nodes_[it->second];
+}
+
 bool DependencyResolver::add_module(const ModuleManifest& manifest) {
     // Check if module already exists
-    if (modules_.find(manifest.name) != modules_.end()) {
+    if (find_present(manifest.name)) {
         std::cerr << "Module '" << manifest.name << "' already exists in resolver" << std::endl;
         return false;
     }
 
-    // Add the module
-    modules_[manifest.name] = manifest;
-    
-    // Rebuild dependency graph
-    build_dependency_graph();
-    
+    // Add the module, parsing its version and dependency ranges once
+    const ModuleId id = intern_module(manifest.name);
+    std::vector<Edge> deps;
+    deps.reserve(manifest.dependencies.size());
+    for (const auto& dep : manifest.dependencies) {
+        const ModuleId target = intern_module(dep.name);
+        deps.push_back({target, intern_range(dep.version), dep.optional});
+        auto& dependents = nodes_[target].dependents;
+        if (std::find(dependents.begin(), dependents.end(), id) == dependents.end()) {
+            dependents.push_back(id);
+        }
+    }
+
+    // intern_module() may have grown nodes_, but deque references stay valid
+    Node& node = nodes_[id];
+    node.present = true;
+    node.manifest = manifest;
+    node.version = intern_version(manifest.version);
+    node.deps = std::move(deps);
+    write_row(id, node.deps);
     return true;
 }
 
 void DependencyResolver::remove_module(const std::string& module_name) {
-    auto it = modules_.find(module_name);
-    if (it != modules_.end()) {
-        modules_.erase(it);
-        build_dependency_graph();
+    auto it = ids_.find(module_name);
+    if (it == ids_.end() || !nodes_[it->second].present) return;
+
+    // Unlink from the dependencies' reverse lists; the node stays as a placeholder
+    // because its dependents still declare it
+    const ModuleId id = it->second;
+    Node& node = nodes_[id];
+    for (const auto& edge : node.deps) {
+        auto& dependents = nodes_[edge.target].dependents;
+        dependents.erase(std::remove(dependents.begin(), dependents.end(), id), dependents.end());
     }
+    node.present = false;
+    node.manifest = ModuleManifest();
+    node.version = kInvalidId;
+    node.deps.clear();
+    csr_rows_[id].length = 0; // keeps its slots for a re-add
 }
 
 void DependencyResolver::clear() {
-    modules_.clear();
-    dependency_graph_.clear();
-    reverse_graph_.clear();
+    ids_.clear();
+    nodes_.clear();
+    csr_rows_.clear();
+    csr_edges_.clear();
+    csr_abandoned_ = 0;
+    stamp_.clear();
+    on_stack_.clear();
+    layer_.clear();
+    epoch_ = 0;
+    versions_.clear();
+    version_ids_.clear();
+    ranges_.clear();
+    range_ids_.clear();
+    satisfies_cache_.clear();
+}
+
+// Row updates are O(deps): a row that outgrows its slots moves to the end of
+// csr_edges_ with 50% slack, and the slots it leaves are reclaimed by an
+// occasional compaction, so a change never repacks the whole graph by itself.
+void DependencyResolver::write_row(ModuleId id, const std::vector<Edge>& deps) {
+    Row& row = csr_rows_[id];
+    const uint32_t length = static_cast<uint32_t>(deps.size());
+    if (length > row.capacity) {
+        csr_abandoned_ += row.capacity;
+        row.start = static_cast<uint32_t>(csr_edges_.size());
+        row.capacity = length + std::max<uint32_t>(2, length / 2);
+        csr_edges_.resize(csr_edges_.size() + row.capacity);
+    }
+    std::copy(deps.begin(), deps.end(), csr_edges_.begin() + row.start);
+    row.length = length;
+    // Compact once a third of the slots are abandoned; amortized O(1) per written edge
+    if (csr_abandoned_ > 256 && csr_abandoned_ * 3 > csr_edges_.size()) compact_rows();
+}
+
+void DependencyResolver::compact_rows() {
+    std::vector<Edge> packed;
+    packed.reserve(csr_edges_.size() - csr_abandoned_);
+    for (Row& row : csr_rows_) {
+        const uint32_t start = static_cast<uint32_t>(packed.size());
+        packed.insert(packed.end(), csr_edges_.begin() + row.start, csr_edges_.begin() + row.start + row.capacity);
+        row.start = start;
+    }
+    csr_edges_.swap(packed);
+    csr_abandoned_ = 0;
 }
 
 ResolutionResult DependencyResolver::resolve_dependencies(const std::vector<std::string>& target_modules) {
+    static Histogram& latency = Metrics::instance().histogram("helix_dependency_resolve_seconds", {},
+                                                              "Time to resolve a dependency set into load order");
+    ScopedTimer timer(latency);
     ResolutionResult result;
     result.success = false;
 
+    const size_t n = nodes_.size();
+    if (stamp_.size() < n) {
+        stamp_.resize(n, 0);
+        on_stack_.resize(n, 0);
+        layer_.resize(n, 0);
+    }
+    if (++epoch_ == 0) { // wrapped: old stamps could alias the new epoch
+        std::fill(stamp_.begin(), stamp_.end(), 0);
+        epoch_ = 1;
+    }
+
     // If no target modules specified, resolve all modules
-    std::vector<std::string> targets = target_modules;
-    if (targets.empty()) {
-        for (const auto& [name, manifest] : modules_) {
-            targets.push_back(name);
+    std::vector<ModuleId> roots;
+    std::unordered_set<std::string> missing;
+    if (target_modules.empty()) {
+        for (ModuleId id = 0; id < n; ++id) {
+            if (nodes_[id].present) roots.push_back(id);
+        }
+    } else {
+        for (const auto& name : target_modules) {
+            auto it = ids_.find(name);
+            if (it == ids_.end() || !nodes_[it->second].present) {
+                missing.insert(name);
+            } else {
+                roots.push_back(it->second);
+            }
+        }
+    }
+
+    // One iterative DFS over the packed graph. Post-order gives dependencies
+    // first; a node's layer is one more than its deepest dependency's.
+    struct Frame {
+        ModuleId id;
+        uint32_t next_edge;
+    };
+    std::vector<Frame> stack;
+    std::vector<ModuleId> post_order;
+    std::unordered_set<ModuleId> cycle_nodes;
+    uint32_t max_layer = 0;
+
+    auto visit = [&](ModuleId id) {
+        stamp_[id] = epoch_;
+        on_stack_[id] = 1;
+        layer_[id] = 0;
+        stack.push_back({id, csr_rows_[id].start});
+    };
+
+    for (ModuleId root : roots) {
+        if (stamp_[root] == epoch_) continue;
+        visit(root);
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            const ModuleId current = top.id;
+            const Row& row = csr_rows_[current];
+            if (top.next_edge == row.start + row.length) {
+                // All dependencies done
+                on_stack_[current] = 0;
+                post_order.push_back(current);
+                max_layer = std::max(max_layer, layer_[current]);
+                stack.pop_back();
+                if (!stack.empty()) {
+                    uint32_t& parent_layer = layer_[stack.back().id];
+                    parent_layer = std::max(parent_layer, layer_[current] + 1);
+                }
+                continue;
+            }
+
+            const Edge& edge = csr_edges_[top.next_edge++];
+            const Node& dep = nodes_[edge.target];
+            if (!dep.present) {
+                if (!edge.optional) missing.insert(dep.name);
+                continue;
+            }
+            if (!range_satisfied(edge.range, dep.version)) {
+                const Node& node = nodes_[current];
+                const size_t index = top.next_edge - 1 - row.start;
+                result.version_conflicts.push_back(node.name + " -> " + dep.name + ": requires " +
+                                                   node.manifest.dependencies[index].version +
+                                                   ", found " + dep.manifest.version);
+            }
+            if (stamp_[edge.target] != epoch_) {
+                visit(edge.target); // invalidates top
+            } else if (on_stack_[edge.target]) {
+                // Back edge: everything on the stack from the dependency up is in the cycle
+                for (auto f = stack.rbegin(); f != stack.rend(); ++f) {
+                    cycle_nodes.insert(f->id);
+                    if (f->id == edge.target) break;
+                }
+            } else {
+                layer_[current] = std::max(layer_[current], layer_[edge.target] + 1);
+            }
         }
     }
 
-    // Find missing dependencies
-    result.missing_deps = find_missing_dependencies(targets);
+    result.missing_deps.assign(missing.begin(), missing.end());
+    for (ModuleId id : cycle_nodes) result.circular_deps.push_back(nodes_[id].name);
+
     if (!result.missing_deps.empty()) {
         std::cerr << "Missing dependencies found" << std::endl;
-        return result;
     }
-
-    // Detect circular dependencies
-    result.circular_deps = detect_circular_dependencies(targets);
+    if (!result.version_conflicts.empty()) {
+        std::cerr << "Dependency version conflicts found" << std::endl;
+    }
     if (!result.circular_deps.empty()) {
         std::cerr << "Circular dependencies detected" << std::endl;
+    }
+    if (!result.missing_deps.empty() || !result.version_conflicts.empty() || !result.circular_deps.empty()) {
         return result;
     }
 
-    // Perform topological sort to get load order
-    if (!topological_sort(targets, result.load_order)) {
-        std::cerr << "Failed to determine load order" << std::endl;
-        return result;
+    // Group by layer; load_order is the layers concatenated
+    result.load_layers.resize(post_order.empty() ? 0 : max_layer + 1);
+    for (ModuleId id : post_order) {
+        result.load_layers[layer_[id]].push_back(nodes_[id].name);
+    }
+    result.load_order.reserve(post_order.size());
+    for (const auto& layer : result.load_layers) {
+        result.load_order.insert(result.load_order.end(), layer.begin(), layer.end());
     }
 
     result.success = true;
@@ -77,297 +254,134 @@ ResolutionResult DependencyResolver::resolve_dependencies(const std::vector<std:
 }
 
 bool DependencyResolver::has_module(const std::string& module_name) const {
-    return modules_.find(module_name) != modules_.end();
+    return find_present(module_name) != nullptr;
 }
 
 const ModuleManifest* DependencyResolver::get_module_manifest(const std::string& module_name) const {
-    auto it = modules_.find(module_name);
-    return (it != modules_.end()) ? &it->second : nullptr;
+    const Node* node = find_present(module_name);
+    return node ? &node->manifest : nullptr;
 }
 
 std::vector<std::string> DependencyResolver::get_all_modules() const {
     std::vector<std::string> module_names;
-    module_names.reserve(modules_.size());
+    module_names.reserve(nodes_.size());
     
-    for (const auto& [name, manifest] : modules_) {
-        module_names.push_back(name);
+    for (const auto& node : nodes_) {
+        if (node.present) module_names.push_back(node.name);
     }
     
     return module_names;
 }
 
 std::vector<std::string> DependencyResolver::get_dependencies(const std::string& module_name) const {
-    auto it = dependency_graph_.find(module_name);
-    if (it == dependency_graph_.end()) {
+    const Node* node = find_present(module_name);
+    if (!node) {
         return {};
     }
-    
-    return std::vector<std::string>(it->second.begin(), it->second.end());
-}
-
-std::vector<std::string> DependencyResolver::get_dependents(const std::string& module_name) const {
-    auto it = reverse_graph_.find(module_name);
-    if (it == reverse_graph_.end()) {
-        return {};
-    }
-    
-    return std::vector<std::string>(it->second.begin(), it->second.end());
-}
-
-bool DependencyResolver::version_satisfies(const std::string& available_version, 
-                                          const std::string& required_version) {
-    if (required_version.empty()) {
-        return true; // No version requirement
-    }
-
-    std::string op, version;
-    if (!parse_version_requirement(required_version, op, version)) {
-        return false; // Invalid requirement format
-    }
-
-    int cmp = compare_versions(available_version, version);
-
-    if (op == "==" || op.empty()) {
-        return cmp == 0;
-    } else if (op == ">=") {
-        return cmp >= 0;
-    } else if (op == ">") {
-        return cmp > 0;
-    } else if (op == "<=") {
-        return cmp <= 0;
-    } else if (op == "<") {
-        return cmp < 0;
-    } else if (op == "~") {
-        // Tilde version: compatible within same minor version
-        int avail_major, avail_minor, avail_patch;
-        int req_major, req_minor, req_patch;
-        
-        if (!parse_version_components(available_version, avail_major, avail_minor, avail_patch) ||
-            !parse_version_components(version, req_major, req_minor, req_patch)) {
-            return false;
-        }
-        
-        return (avail_major == req_major && avail_minor == req_minor && avail_patch >= req_patch);
-    }
-
-    return false;
-}
 
-void DependencyResolver::build_dependency_graph() {
-    dependency_graph_.clear();
-    reverse_graph_.clear();
-
-    // Build forward and reverse dependency graphs
-    for (const auto& [module_name, manifest] : modules_) {
-        dependency_graph_[module_name] = {};
-        
-        for (const auto& dep : manifest.dependencies) {
-            // Skip optional dependencies that aren't available
-            if (dep.optional && modules_.find(dep.name) == modules_.end()) {
-                continue;
-            }
-            
-            // Add to forward graph
-            dependency_graph_[module_name].insert(dep.name);
-            
-            // Add to reverse graph
-            reverse_graph_[dep.name].insert(module_name);
+    std::vector<std::string> deps;
+    for (const auto& edge : node->deps) {
+        const std::string& name = nodes_[edge.target].name;
+        if (edge_active(edge) && std::find(deps.begin(), deps.end(), name) == deps.end()) {
+            deps.push_back(name);
         }
     }
+    return deps;
 }
 
-bool DependencyResolver::topological_sort(const std::vector<std::string>& target_modules,
-                                         std::vector<std::string>& load_order) {
-    load_order.clear();
-
-    // Build subset graph for target modules and their dependencies
-    std::unordered_set<std::string> all_needed;
-    std::queue<std::string> to_process;
-    
-    // Add target modules to processing queue
-    for (const auto& module : target_modules) {
-        if (modules_.find(module) != modules_.end()) {
-            to_process.push(module);
-            all_needed.insert(module);
-        }
-    }
-    
-    // Recursively add dependencies
-    while (!to_process.empty()) {
-        std::string current = to_process.front();
-        to_process.pop();
-        
-        auto deps_it = dependency_graph_.find(current);
-        if (deps_it != dependency_graph_.end()) {
-            for (const auto& dep : deps_it->second) {
-                if (all_needed.find(dep) == all_needed.end()) {
-                    all_needed.insert(dep);
-                    to_process.push(dep);
-                }
-            }
-        }
-    }
-
-    // Calculate in-degrees as the number of dependencies each module has within the subset.
-    // With edges represented as module -> dependency in dependency_graph_,
-    // the correct dependency-first order is achieved by:
-    //  - in_degree[module] = number of deps in subset
-    //  - when removing a node U (a dependency), decrement in_degree of its dependents
-    //    using reverse_graph_[U].
-    std::unordered_map<std::string, int> in_degree;
-    for (const auto& module : all_needed) {
-        int deg = 0;
-        auto deps_it = dependency_graph_.find(module);
-        if (deps_it != dependency_graph_.end()) {
-            for (const auto& dep : deps_it->second) {
-                if (all_needed.find(dep) != all_needed.end()) {
-                    ++deg;
-                }
-            }
-        }
-        in_degree[module] = deg;
-    }
-
-    // Kahn's algorithm for topological sort
-    std::queue<std::string> zero_in_degree;
-    for (const auto& [module, degree] : in_degree) {
-        if (degree == 0) {
-            zero_in_degree.push(module);
-        }
+std::vector<std::string> DependencyResolver::get_dependents(const std::string& module_name) const {
+    auto it = ids_.find(module_name);
+    if (it == ids_.end()) {
+        return {};
     }
 
-    while (!zero_in_degree.empty()) {
-        std::string current = zero_in_degree.front();
-        zero_in_degree.pop();
-        load_order.push_back(current);
-
-        // Decrement in-degree of dependents of 'current'
-        auto rev_it = reverse_graph_.find(current);
-        if (rev_it != reverse_graph_.end()) {
-            for (const auto& dependent : rev_it->second) {
-                if (all_needed.find(dependent) != all_needed.end()) {
-                    --in_degree[dependent];
-                    if (in_degree[dependent] == 0) {
-                        zero_in_degree.push(dependent);
-                    }
-                }
+    std::vector<std::string> dependents;
+    for (ModuleId dependent : nodes_[it->second].dependents) {
+        for (const auto& edge : nodes_[dependent].deps) {
+            if (edge.target == it->second && edge_active(edge)) {
+                dependents.push_back(nodes_[dependent].name);
+                break;
             }
         }
     }
-
-    // Check if all modules were processed (no cycles)
-    return load_order.size() == all_needed.size();
+    return dependents;
 }
 
-std::vector<std::string> DependencyResolver::detect_circular_dependencies(const std::vector<std::string>& target_modules) {
-    std::unordered_set<std::string> visited;
-    std::unordered_set<std::string> rec_stack;
-    std::unordered_set<std::string> cycle_nodes;
-
-    for (const auto& module : target_modules) {
-        if (visited.find(module) == visited.end()) {
-            detect_cycle_dfs(module, visited, rec_stack, cycle_nodes);
-        }
+bool DependencyResolver::depends_on(const std::string& module_name, const std::string& dependency) const {
+    auto from = ids_.find(module_name);
+    auto to = ids_.find(dependency);
+    if (from == ids_.end() || to == ids_.end() || from->second == to->second) {
+        return false;
     }
 
-    return std::vector<std::string>(cycle_nodes.begin(), cycle_nodes.end());
-}
-
-std::vector<std::string> DependencyResolver::find_missing_dependencies(const std::vector<std::string>& target_modules) {
-    std::unordered_set<std::string> missing;
-
-    for (const auto& module_name : target_modules) {
-        auto it = modules_.find(module_name);
-        if (it == modules_.end()) {
-            missing.insert(module_name);
-            continue;
-        }
-
-        const auto& manifest = it->second;
-        for (const auto& dep : manifest.dependencies) {
-            if (!dep.optional && modules_.find(dep.name) == modules_.end()) {
-                missing.insert(dep.name);
-            }
+    std::vector<uint8_t> seen(nodes_.size(), 0);
+    std::vector<ModuleId> pending{from->second};
+    seen[from->second] = 1;
+    while (!pending.empty()) {
+        const ModuleId id = pending.back();
+        pending.pop_back();
+        for (const auto& edge : nodes_[id].deps) {
+            if (!edge_active(edge) || !nodes_[edge.target].present || seen[edge.target]) continue;
+            if (edge.target == to->second) return true;
+            seen[edge.target] = 1;
+            pending.push_back(edge.target);
         }
     }
-
-    return std::vector<std::string>(missing.begin(), missing.end());
+    return false;
 }
 
-bool DependencyResolver::detect_cycle_dfs(const std::string& node,
-                                         std::unordered_set<std::string>& visited,
-                                         std::unordered_set<std::string>& rec_stack,
-                                         std::unordered_set<std::string>& cycle_nodes) {
-    visited.insert(node);
-    rec_stack.insert(node);
-
-    auto deps_it = dependency_graph_.find(node);
-    if (deps_it != dependency_graph_.end()) {
-        for (const auto& dep : deps_it->second) {
-            if (rec_stack.find(dep) != rec_stack.end()) {
-                // Cycle detected
-                cycle_nodes.insert(node);
-                cycle_nodes.insert(dep);
-                return true;
-            }
-            
-            if (visited.find(dep) == visited.end()) {
-                if (detect_cycle_dfs(dep, visited, rec_stack, cycle_nodes)) {
-                    cycle_nodes.insert(node);
-                    return true;
-                }
-            }
-        }
+bool DependencyResolver::version_satisfies(const std::string& available_version, 
+                                          const std::string& required_version) {
+    if (required_version.empty()) {
+        return true; // No version requirement
     }
 
-    rec_stack.erase(node);
-    return false;
+    SemVer version;
+    VersionRange range;
+    if (!SemVer::parse(available_version, version) || !VersionRange::parse(required_version, range)) {
+        return false; // Invalid version or requirement format
+    }
+    return range.satisfied_by(version);
 }
 
-bool DependencyResolver::parse_version_requirement(const std::string& requirement,
-                                                  std::string& operator_out,
-                                                  std::string& version_out) {
-    std::regex req_regex(R"(^(>=|<=|>|<|~|==)?\s*(\d+\.\d+\.\d+.*)$)");
-    std::smatch match;
-    
-    if (std::regex_match(requirement, match, req_regex)) {
-        operator_out = match[1].str();
-        version_out = match[2].str();
-        return true;
+uint32_t DependencyResolver::intern_version(const std::string& text) {
+    auto it = version_ids_.find(text);
+    if (it != version_ids_.end()) return it->second;
+    SemVer version;
+    uint32_t id = kInvalidId;
+    if (SemVer::parse(text, version)) {
+        id = static_cast<uint32_t>(versions_.size());
+        versions_.push_back(std::move(version));
     }
-    
-    return false;
+    version_ids_.emplace(text, id);
+    return id;
 }
 
-int DependencyResolver::compare_versions(const std::string& version1, const std::string& version2) {
-    int major1, minor1, patch1;
-    int major2, minor2, patch2;
-    
-    if (!parse_version_components(version1, major1, minor1, patch1) ||
-        !parse_version_components(version2, major2, minor2, patch2)) {
-        return 0; // Invalid versions are considered equal
+uint32_t DependencyResolver::intern_range(const std::string& text) {
+    auto it = range_ids_.find(text);
+    if (it != range_ids_.end()) return it->second;
+    VersionRange range;
+    uint32_t id = kInvalidId;
+    if (VersionRange::parse(text, range)) {
+        id = static_cast<uint32_t>(ranges_.size());
+        ranges_.push_back(std::move(range));
     }
-    
-    if (major1 != major2) return (major1 > major2) ? 1 : -1;
-    if (minor1 != minor2) return (minor1 > minor2) ? 1 : -1;
-    if (patch1 != patch2) return (patch1 > patch2) ? 1 : -1;
-    
-    return 0; // Equal
+    range_ids_.emplace(text, id);
+    return id;
 }
 
-bool DependencyResolver::parse_version_components(const std::string& version,
-                                                 int& major, int& minor, int& patch) {
-    std::regex version_regex(R"(^(\d+)\.(\d+)\.(\d+))");
-    std::smatch match;
-    
-    if (std::regex_match(version, match, version_regex)) {
-        major = std::stoi(match[1].str());
-        minor = std::stoi(match[2].str());
-        patch = std::stoi(match[3].str());
-        return true;
-    }
-    
-    return false;
+bool DependencyResolver::range_satisfied(uint32_t range, uint32_t version) {
+    if (range == kInvalidId) return false;
+    if (ranges_[range].any()) return true;
+    if (version == kInvalidId) return false;
+
+    // Interned ranges and versions never change, so cached results never go stale
+    const uint64_t key = (static_cast<uint64_t>(range) << 32) | version;
+    auto it = satisfies_cache_.find(key);
+    if (it != satisfies_cache_.end()) return it->second;
+    const bool ok = ranges_[range].satisfied_by(versions_[version]);
+    satisfies_cache_.emplace(key, ok);
+    return ok;
 }
 
-} // namespace helix
\ No newline at end of file
+} // namespace helix
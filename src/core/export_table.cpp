@@ -0,0 +1,80 @@
+#include "helix/export_table.h"
+#include <mutex>
+
+namespace helix {
+
+ExportTable& ExportTable::instance() {
+    static ExportTable table;
+    return table;
+}
+
+bool ExportTable::publish(const std::string& module, const std::vector<std::pair<std::string, void*>>& symbols,
+                          std::string& error) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [name, address] : symbols) {
+        auto it = symbols_.find(name);
+        if (it != symbols_.end() && it->second.module != module) {
+            error = "symbol '" + name + "' is already exported by '" + it->second.module + "'";
+            return false;
+        }
+    }
+    for (const auto& [name, address] : symbols) {
+        symbols_.erase(name);
+        symbols_.try_emplace(name, module, address);
+    }
+    return true;
+}
+
+bool ExportTable::replace(const std::string& module, const std::vector<std::pair<std::string, void*>>& symbols,
+                          std::string& error, bool* old_resolved) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [name, address] : symbols) {
+        auto it = symbols_.find(name);
+        if (it != symbols_.end() && it->second.module != module) {
+            error = "symbol '" + name + "' is already exported by '" + it->second.module + "'";
+            return false;
+        }
+    }
+    bool resolved = false;
+    for (auto it = symbols_.begin(); it != symbols_.end();) {
+        if (it->second.module == module) {
+            resolved = resolved || it->second.resolved.load(std::memory_order_relaxed);
+            it = symbols_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const auto& [name, address] : symbols) {
+        symbols_.try_emplace(name, module, address);
+    }
+    if (old_resolved) *old_resolved = resolved;
+    return true;
+}
+
+void ExportTable::withdraw(const std::string& module) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (auto it = symbols_.begin(); it != symbols_.end();) {
+        if (it->second.module == module) {
+            it = symbols_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void* ExportTable::lookup(const char* name) const {
+    if (!name) return nullptr;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = symbols_.find(name);
+    if (it == symbols_.end()) return nullptr;
+    // Only the first lookup writes, so later ones share the line read-only
+    if (!it->second.resolved.load(std::memory_order_relaxed)) it->second.resolved.store(true, std::memory_order_relaxed);
+    return it->second.address;
+}
+
+} // namespace helix
+
+// Exported from helixd (--export-dynamic); modules reach it through helix/exports.h
+extern "C" void* helix_export_lookup(const char* name) {
+    return helix::ExportTable::instance().lookup(name);
+}
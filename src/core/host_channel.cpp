@@ -0,0 +1,293 @@
+#include "helix/host_channel.h"
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+constexpr uint32_t kChannelMagic = 0x43484C48; // "HLHC"
+constexpr uint32_t kChannelVersion = 1;
+constexpr auto kSpinFor = std::chrono::microseconds(50);
+
+struct Slot {
+    uint16_t type;
+    uint16_t op;
+    uint32_t length;
+    uint64_t id;
+    int64_t value;
+    char payload[HostChannel::kMaxPayload];
+};
+static_assert(sizeof(Slot) == HostChannel::kSlotSize, "slot layout");
+
+void encode(const HostChannel::Message& message, Slot& slot) {
+    slot.type = message.type;
+    slot.op = message.op;
+    slot.id = message.id;
+    slot.value = message.value;
+    slot.length = static_cast<uint32_t>(std::min(message.payload.size(), HostChannel::kMaxPayload));
+    std::memcpy(slot.payload, message.payload.data(), slot.length);
+}
+
+void decode(const Slot& slot, HostChannel::Message& out) {
+    out.type = slot.type;
+    out.op = slot.op;
+    out.id = slot.id;
+    out.value = slot.value;
+    out.payload.assign(slot.payload, std::min<size_t>(slot.length, HostChannel::kMaxPayload));
+}
+
+// One packet from the request socket, and the descriptor attached to it (closed if fd is null)
+bool receive_packet(int socket, HostChannel::Message& out, int* fd) {
+    if (fd) *fd = -1;
+    Slot slot;
+    iovec iov{&slot, sizeof(slot)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = ::recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        int received;
+        std::memcpy(&received, CMSG_DATA(c), sizeof(received));
+        if (fd) *fd = received;
+        else ::close(received);
+    }
+    if (static_cast<size_t>(n) != sizeof(slot)) {
+        if (fd && *fd >= 0) ::close(*fd);
+        return false;
+    }
+    decode(slot, out);
+    return true;
+}
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+struct HostChannel::Ring {
+    alignas(64) std::atomic<uint64_t> head{0};     ///< Next slot the sender fills
+    alignas(64) std::atomic<uint64_t> tail{0};     ///< Next slot the reader takes
+    alignas(64) std::atomic<uint32_t> waiting{0};  ///< Reader is about to block on its eventfd
+    Slot slots[kSlots];
+};
+
+struct HostChannel::Shared {
+    uint32_t magic = kChannelMagic;
+    uint32_t version = kChannelVersion;
+    Ring rings[2]; ///< [0] daemon -> host, [1] host -> daemon
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "the rings are shared between processes and need address-free atomics");
+
+HostChannel::~HostChannel() {
+    if (shared_) munmap(shared_, sizeof(Shared));
+    for (int fd : {memory_fd_, efd_[0], efd_[1], request_fd_[0], request_fd_[1]}) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool HostChannel::create(std::string& error) {
+    host_ = false;
+    memory_fd_ = memfd_create("helix-module-host", MFD_CLOEXEC);
+    if (memory_fd_ < 0 || ftruncate(memory_fd_, sizeof(Shared)) != 0) {
+        error = std::string("cannot create channel memory: ") + std::strerror(errno);
+        return false;
+    }
+    for (int& fd : efd_) {
+        fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (fd < 0) {
+            error = std::string("cannot create channel eventfd: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, request_fd_) != 0) {
+        error = std::string("cannot create channel socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (!map(error)) return false;
+    new (shared_) Shared();
+    return true;
+}
+
+bool HostChannel::attach(int memory_fd, int inbox_fd, int outbox_fd, int request_fd, std::string& error) {
+    host_ = true;
+    memory_fd_ = memory_fd;
+    efd_[0] = inbox_fd;
+    efd_[1] = outbox_fd;
+    request_fd_[0] = request_fd;
+    if (!map(error)) return false;
+    if (shared_->magic != kChannelMagic || shared_->version != kChannelVersion) {
+        error = "channel memory has an unknown layout";
+        return false;
+    }
+    return true;
+}
+
+bool HostChannel::map(std::string& error) {
+    void* mapping = mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd_, 0);
+    if (mapping == MAP_FAILED) {
+        error = std::string("cannot map channel memory: ") + std::strerror(errno);
+        return false;
+    }
+    shared_ = static_cast<Shared*>(mapping);
+    spin_ = sysconf(_SC_NPROCESSORS_ONLN) > 1; // spinning on one CPU only delays the sender
+    return true;
+}
+
+HostChannel::Ring& HostChannel::outbox() const {
+    return shared_->rings[host_ ? 1 : 0];
+}
+
+HostChannel::Ring& HostChannel::inbox() const {
+    return shared_->rings[host_ ? 0 : 1];
+}
+
+bool HostChannel::send(const Message& message, int timeout_ms) {
+    if (!shared_) return false;
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    Ring& ring = outbox();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (head - ring.tail.load(std::memory_order_acquire) >= kSlots) {
+        if (timeout_ms == 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (timeout_ms > 0 && std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(20)); // the reader is behind; rare
+    }
+
+    encode(message, ring.slots[head % kSlots]);
+    // seq_cst pairs with the reader's store to `waiting`: either it sees the slot or we see it waiting
+    ring.head.store(head + 1, std::memory_order_seq_cst);
+    if (ring.waiting.load(std::memory_order_seq_cst)) {
+        const uint64_t one = 1;
+        (void)!::write(efd_[host_ ? 1 : 0], &one, sizeof(one));
+    }
+    return true;
+}
+
+bool HostChannel::try_pop(Message& out) {
+    Ring& ring = inbox();
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail == ring.head.load(std::memory_order_acquire)) return false;
+    decode(ring.slots[tail % kSlots], out);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool HostChannel::receive(Message& out, int timeout_ms) {
+    if (!shared_) return false;
+    if (try_pop(out)) return true;
+    const auto start = std::chrono::steady_clock::now();
+    if (spin_) {
+        for (unsigned i = 1;; ++i) {
+            cpu_relax();
+            if (try_pop(out)) return true;
+            if ((i & 63) == 0 && std::chrono::steady_clock::now() - start >= kSpinFor) break;
+        }
+    }
+
+    Ring& ring = inbox();
+    const int fd = efd_[host_ ? 0 : 1];
+    const auto deadline = start + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        ring.waiting.store(1, std::memory_order_seq_cst);
+        if (try_pop(out)) {
+            ring.waiting.store(0, std::memory_order_relaxed);
+            return true;
+        }
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            wait_ms = left > 0 ? static_cast<int>(left) : 0;
+        }
+        pollfd pfd{fd, POLLIN, 0};
+        const int rc = ::poll(&pfd, 1, wait_ms);
+        ring.waiting.store(0, std::memory_order_relaxed);
+        if (rc > 0) {
+            uint64_t count;
+            (void)!::read(fd, &count, sizeof(count));
+        }
+        if (try_pop(out)) return true;
+        if (rc == 0 || (rc < 0 && errno != EINTR)) return false;
+        if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) return false;
+    }
+}
+
+void HostChannel::close_host_request_fd() {
+    if (request_fd_[1] >= 0) ::close(request_fd_[1]);
+    request_fd_[1] = -1;
+}
+
+bool HostChannel::request(const Message& request, Message& answer, int& fd) {
+    fd = -1;
+    std::lock_guard<std::mutex> lock(request_mutex_);
+    Slot slot;
+    encode(request, slot);
+    ssize_t n;
+    do {
+        n = ::send(request_fd_[0], &slot, sizeof(slot), MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(sizeof(slot))) return false;
+    return receive_packet(request_fd_[0], answer, &fd);
+}
+
+bool HostChannel::next_request(Message& out) {
+    return receive_packet(request_fd_[0], out, nullptr);
+}
+
+bool HostChannel::answer(const Message& message, int fd) {
+    Slot slot;
+    encode(message, slot);
+    iovec iov{&slot, sizeof(slot)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr* c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(c), &fd, sizeof(fd));
+    }
+    ssize_t n;
+    do {
+        n = ::sendmsg(request_fd_[0], &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == static_cast<ssize_t>(sizeof(slot));
+}
+
+void HostChannel::shutdown_requests() {
+    if (request_fd_[0] >= 0) ::shutdown(request_fd_[0], SHUT_RDWR);
+}
+
+} // namespace helix
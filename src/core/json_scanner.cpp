@@ -0,0 +1,356 @@
+#include "helix/json_scanner.h"
+
+namespace helix {
+
+namespace {
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Decimal digits at the start of s, without overflow; advances s past them
+bool scan_decimal(std::string_view& s, uint64_t& out) {
+    size_t i = 0;
+    out = 0;
+    for (; i < s.size() && is_digit(s[i]); ++i) {
+        const uint64_t d = static_cast<uint64_t>(s[i] - '0');
+        if (out > (UINT64_MAX - d) / 10) return false;
+        out = out * 10 + d;
+    }
+    if (i == 0) return false;
+    s.remove_prefix(i);
+    return true;
+}
+
+} // namespace
+
+bool JsonScanner::fail(const std::string& what) {
+    if (error_.empty()) error_ = what + " at offset " + std::to_string(pos_);
+    return false;
+}
+
+void JsonScanner::skip_ws() {
+    while (pos_ < text_.size()) {
+        const char c = text_[pos_];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+        ++pos_;
+    }
+}
+
+bool JsonScanner::expect(char c) {
+    skip_ws();
+    if (pos_ >= text_.size() || text_[pos_] != c) return fail(std::string("expected '") + c + "'");
+    ++pos_;
+    return true;
+}
+
+JsonScanner::Type JsonScanner::peek() {
+    if (failed()) return Type::Invalid;
+    skip_ws();
+    if (pos_ >= text_.size()) return Type::Invalid;
+    switch (text_[pos_]) {
+        case '{': return Type::Object;
+        case '[': return Type::Array;
+        case '"': return Type::String;
+        case 't': case 'f': return Type::Bool;
+        case 'n': return Type::Null;
+        default: return (text_[pos_] == '-' || is_digit(text_[pos_])) ? Type::Number : Type::Invalid;
+    }
+}
+
+bool JsonScanner::enter_object() {
+    if (failed() || !expect('{')) return false;
+    first_ = true;
+    return true;
+}
+
+bool JsonScanner::enter_array() {
+    if (failed() || !expect('[')) return false;
+    first_ = true;
+    return true;
+}
+
+bool JsonScanner::next_member(std::string_view& key) {
+    if (failed()) return false;
+    skip_ws();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+        ++pos_;
+        first_ = false;
+        return false;
+    }
+    if (!first_) {
+        if (!expect(',')) return false;
+        skip_ws();
+        if (pos_ < text_.size() && text_[pos_] == '}') { // tolerated trailing comma
+            ++pos_;
+            return false;
+        }
+    }
+    first_ = false;
+    skip_ws();
+    if (pos_ >= text_.size() || text_[pos_] != '"') return fail("expected member name");
+    if (!scan_string(key, key_buf_)) return false;
+    return expect(':');
+}
+
+bool JsonScanner::next_element() {
+    if (failed()) return false;
+    skip_ws();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+        ++pos_;
+        first_ = false;
+        return false;
+    }
+    if (!first_) {
+        if (!expect(',')) return false;
+        skip_ws();
+        if (pos_ < text_.size() && text_[pos_] == ']') { // tolerated trailing comma
+            ++pos_;
+            return false;
+        }
+    }
+    first_ = false;
+    return true;
+}
+
+bool JsonScanner::scan_string(std::string_view& out, std::string& scratch) {
+    // pos_ is at the opening quote
+    const size_t start = ++pos_;
+    size_t i = start;
+    while (i < text_.size() && text_[i] != '"' && text_[i] != '\\') ++i;
+    if (i >= text_.size()) return fail("unterminated string");
+    if (text_[i] == '"') {
+        out = text_.substr(start, i - start);
+        pos_ = i + 1;
+        return true;
+    }
+
+    // Escapes present: decode into scratch
+    scratch.assign(text_.data() + start, i - start);
+    while (i < text_.size()) {
+        char c = text_[i++];
+        if (c == '"') {
+            out = scratch;
+            pos_ = i;
+            return true;
+        }
+        if (c != '\\') {
+            scratch.push_back(c);
+            continue;
+        }
+        if (i >= text_.size()) break;
+        c = text_[i++];
+        switch (c) {
+            case '"': case '\\': case '/': scratch.push_back(c); break;
+            case 'b': scratch.push_back('\b'); break;
+            case 'f': scratch.push_back('\f'); break;
+            case 'n': scratch.push_back('\n'); break;
+            case 'r': scratch.push_back('\r'); break;
+            case 't': scratch.push_back('\t'); break;
+            case 'u': {
+                auto read_hex4 = [&](uint32_t& v) {
+                    if (i + 4 > text_.size()) return false;
+                    v = 0;
+                    for (int k = 0; k < 4; ++k) {
+                        int h = hex_value(text_[i + k]);
+                        if (h < 0) return false;
+                        v = (v << 4) | static_cast<uint32_t>(h);
+                    }
+                    i += 4;
+                    return true;
+                };
+                uint32_t cp = 0;
+                if (!read_hex4(cp)) { pos_ = i; return fail("bad \\u escape"); }
+                if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text_.size() && text_[i] == '\\' && text_[i + 1] == 'u') {
+                    i += 2;
+                    uint32_t lo = 0;
+                    if (!read_hex4(lo) || lo < 0xDC00 || lo > 0xDFFF) { pos_ = i; return fail("bad surrogate pair"); }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                append_utf8(scratch, cp);
+                break;
+            }
+            default:
+                pos_ = i;
+                return fail("bad escape");
+        }
+    }
+    pos_ = i;
+    return fail("unterminated string");
+}
+
+bool JsonScanner::scan_number(std::string_view& raw) {
+    const size_t start = pos_;
+    size_t i = pos_;
+    if (i < text_.size() && text_[i] == '-') ++i;
+    const size_t int_start = i;
+    while (i < text_.size() && is_digit(text_[i])) ++i;
+    if (i == int_start) return fail("bad number");
+    if (i < text_.size() && text_[i] == '.') {
+        const size_t frac = ++i;
+        while (i < text_.size() && is_digit(text_[i])) ++i;
+        if (i == frac) return fail("bad number");
+    }
+    if (i < text_.size() && (text_[i] == 'e' || text_[i] == 'E')) {
+        ++i;
+        if (i < text_.size() && (text_[i] == '+' || text_[i] == '-')) ++i;
+        const size_t exp = i;
+        while (i < text_.size() && is_digit(text_[i])) ++i;
+        if (i == exp) return fail("bad number");
+    }
+    raw = text_.substr(start, i - start);
+    pos_ = i;
+    return true;
+}
+
+bool JsonScanner::scan_literal(std::string_view word) {
+    if (text_.substr(pos_, word.size()) != word) return fail("bad literal");
+    pos_ += word.size();
+    return true;
+}
+
+bool JsonScanner::read_string(std::string_view& out, std::string& scratch) {
+    if (peek() != Type::String) return fail("expected string");
+    first_ = false;
+    return scan_string(out, scratch);
+}
+
+bool JsonScanner::read_string(std::string& out) {
+    std::string_view view;
+    if (!read_string(view, out)) return false;
+    if (view.data() != out.data()) out.assign(view.data(), view.size());
+    return true;
+}
+
+bool JsonScanner::read_bool(bool& out) {
+    if (peek() != Type::Bool) return fail("expected true or false");
+    first_ = false;
+    out = text_[pos_] == 't';
+    return scan_literal(out ? "true" : "false");
+}
+
+bool JsonScanner::read_number(std::string_view& raw) {
+    if (peek() != Type::Number) return fail("expected number");
+    first_ = false;
+    return scan_number(raw);
+}
+
+bool JsonScanner::read_unsigned(uint64_t& out) {
+    std::string_view raw;
+    if (!read_number(raw)) return false;
+    if (!scan_decimal(raw, out) || !raw.empty()) return fail("expected unsigned integer");
+    return true;
+}
+
+bool JsonScanner::skip_value(std::string_view* raw) {
+    const Type type = peek();
+    const size_t start = pos_;
+    first_ = false;
+    std::string_view ignored;
+    switch (type) {
+        case Type::String:
+            if (!scan_string(ignored, key_buf_)) return false;
+            break;
+        case Type::Number:
+            if (!scan_number(ignored)) return false;
+            break;
+        case Type::Bool:
+            if (!scan_literal(text_[pos_] == 't' ? "true" : "false")) return false;
+            break;
+        case Type::Null:
+            if (!scan_literal("null")) return false;
+            break;
+        case Type::Object:
+        case Type::Array: {
+            // Balanced-bracket skip; strings are scanned so brackets inside them don't count
+            size_t depth = 0;
+            while (pos_ < text_.size()) {
+                const char c = text_[pos_];
+                if (c == '"') {
+                    if (!scan_string(ignored, key_buf_)) return false;
+                    continue;
+                }
+                ++pos_;
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (--depth == 0) break;
+                }
+            }
+            if (depth != 0) return fail("unterminated container");
+            break;
+        }
+        case Type::Invalid:
+            return fail("expected value");
+    }
+    if (raw) *raw = text_.substr(start, pos_ - start);
+    return true;
+}
+
+bool JsonScanner::at_end() {
+    skip_ws();
+    return pos_ >= text_.size();
+}
+
+bool scan_semver(std::string_view text, SemverView& out, std::string_view* rest) {
+    std::string_view s = text;
+    if (!scan_decimal(s, out.major) || s.empty() || s[0] != '.') return false;
+    s.remove_prefix(1);
+    if (!scan_decimal(s, out.minor) || s.empty() || s[0] != '.') return false;
+    s.remove_prefix(1);
+    if (!scan_decimal(s, out.patch)) return false;
+    out.suffix = std::string_view();
+    if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+        size_t i = 1;
+        while (i < s.size()) {
+            const char c = s[i];
+            const bool ok = is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '-';
+            if (!ok) break;
+            ++i;
+        }
+        out.suffix = s.substr(0, i);
+        s.remove_prefix(i);
+    }
+    if (rest) *rest = s;
+    return true;
+}
+
+bool split_version_requirement(std::string_view requirement, std::string_view& op, std::string_view& version) {
+    size_t n = 0;
+    if (requirement.size() >= 2 && (requirement.compare(0, 2, ">=") == 0 || requirement.compare(0, 2, "<=") == 0 ||
+                                    requirement.compare(0, 2, "==") == 0)) {
+        n = 2;
+    } else if (!requirement.empty() && (requirement[0] == '>' || requirement[0] == '<' || requirement[0] == '~')) {
+        n = 1;
+    }
+    op = requirement.substr(0, n);
+    size_t i = n;
+    while (i < requirement.size() && (requirement[i] == ' ' || requirement[i] == '\t')) ++i;
+    version = requirement.substr(i);
+    return !version.empty();
+}
+
+} // namespace helix
@@ -1,12 +1,11 @@
 #include "helix/manifest.h"
-#include <fstream>
+#include "helix/json_scanner.h"
+#include "helix/semver.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
 #include <sstream>
 #include <iostream>
-#include <regex>
-#ifdef HELIX_USE_NLOHMANN_JSON
-#include <nlohmann/json.hpp>
-using nlohmann::json;
-#endif
 
 namespace helix {
 
@@ -14,179 +13,181 @@ ManifestParser::ManifestParser() : last_error_("") {
 }
 
 bool ManifestParser::parse_from_file(const std::string& file_path, ModuleManifest& manifest) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) {
+    std::FILE* file = std::fopen(file_path.c_str(), "rb");
+    if (!file) {
         set_error("Failed to open manifest file: " + file_path);
         return false;
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();
+    // Manifests are small; read in one go instead of streaming through a stringstream
+    std::string content;
+    char buf[8192];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) content.append(buf, n);
+    std::fclose(file);
 
-    return parse_from_string(buffer.str(), manifest);
+    return parse_from_string(content, manifest);
 }
 
-bool ManifestParser::parse_from_string(const std::string& json_content, ModuleManifest& manifest) {
-#ifdef HELIX_USE_NLOHMANN_JSON
-    last_error_.clear();
-    try {
-        json j = json::parse(json_content);
-        // Required fields
-        if (!j.contains("name") || !j.contains("version") || !j.contains("binary_path")) {
-            set_error("Missing required field(s): name/version/binary_path");
-            return false;
-        }
-        manifest.name = j.at("name").get<std::string>();
-        manifest.version = j.at("version").get<std::string>();
-        manifest.binary_path = j.at("binary_path").get<std::string>();
+namespace {
 
-        // Optional strings
-        if (j.contains("description")) manifest.description = j.at("description").get<std::string>();
-        if (j.contains("author")) manifest.author = j.at("author").get<std::string>();
-        if (j.contains("license")) manifest.license = j.at("license").get<std::string>();
-        if (j.contains("homepage")) manifest.homepage = j.at("homepage").get<std::string>();
-        if (j.contains("repository")) manifest.repository = j.at("repository").get<std::string>();
-        if (j.contains("minimum_core_version")) manifest.minimum_core_version = j.at("minimum_core_version").get<std::string>();
-        if (j.contains("minimum_api_version")) manifest.minimum_api_version = j.at("minimum_api_version").get<std::string>();
+// Member value that must be a string; anything else is a schema error
+bool read_string_field(JsonScanner& in, std::string_view key, std::string& out, std::string& error) {
+    if (in.peek() != JsonScanner::Type::String) {
+        error = "Field '" + std::string(key) + "' must be a string";
+        return false;
+    }
+    return in.read_string(out);
+}
 
-        // Arrays
-        if (j.contains("dependencies") && j["dependencies"].is_array()) {
-            for (const auto& d : j["dependencies"]) {
-                Dependency dep{};
-                if (d.contains("name")) dep.name = d.at("name").get<std::string>();
-                if (d.contains("version")) dep.version = d.at("version").get<std::string>();
-                dep.optional = d.value("optional", false);
-                manifest.dependencies.push_back(dep);
-            }
-        }
-        if (j.contains("tags") && j["tags"].is_array()) {
-            for (const auto& t : j["tags"]) manifest.tags.push_back(t.get<std::string>());
+bool read_dependencies(JsonScanner& in, std::vector<Dependency>& dependencies, std::string& error) {
+    if (!in.enter_array()) return false;
+    std::string_view key;
+    while (in.next_element()) {
+        if (in.peek() != JsonScanner::Type::Object) {
+            error = "Entries of 'dependencies' must be objects";
+            return false;
         }
-
-        // Config object
-        if (j.contains("config") && j["config"].is_object()) {
-            for (auto it = j["config"].begin(); it != j["config"].end(); ++it) {
-                // Coerce primitive values to string for simplicity
-                if (it.value().is_string()) manifest.config[it.key()] = it.value().get<std::string>();
-                else if (it.value().is_number_integer()) manifest.config[it.key()] = std::to_string(it.value().get<long long>());
-                else if (it.value().is_number_float()) manifest.config[it.key()] = std::to_string(it.value().get<double>());
-                else if (it.value().is_boolean()) manifest.config[it.key()] = it.value().get<bool>() ? "true" : "false";
-                else manifest.config[it.key()] = it.value().dump();
-            }
+        in.enter_object();
+        Dependency dep{};
+        dep.optional = false;
+        while (in.next_member(key)) {
+            if (key == "name") { if (!read_string_field(in, key, dep.name, error)) return false; }
+            else if (key == "version") { if (!read_string_field(in, key, dep.version, error)) return false; }
+            else if (key == "optional" && in.peek() == JsonScanner::Type::Bool) in.read_bool(dep.optional);
+            else in.skip_value();
         }
+        dependencies.push_back(std::move(dep));
+    }
+    return !in.failed();
+}
 
-        // Entry points
-        if (j.contains("entry_points") && j["entry_points"].is_object()) {
-            const auto& ep = j["entry_points"];
-            if (ep.contains("init")) manifest.entry_points.init = ep.at("init").get<std::string>();
-            if (ep.contains("start")) manifest.entry_points.start = ep.at("start").get<std::string>();
-            if (ep.contains("stop")) manifest.entry_points.stop = ep.at("stop").get<std::string>();
-            if (ep.contains("destroy")) manifest.entry_points.destroy = ep.at("destroy").get<std::string>();
-        }
-    } catch (const std::exception& e) {
-        set_error(std::string("JSON parsing error: ") + e.what());
-        return false;
+bool read_string_array(JsonScanner& in, std::string_view name, std::vector<std::string>& out, std::string& error) {
+    if (!in.enter_array()) return false;
+    while (in.next_element()) {
+        std::string item;
+        if (!read_string_field(in, name, item, error)) return false;
+        out.push_back(std::move(item));
     }
-    return validate_manifest(manifest);
-#else
-    // Fallback: existing simplified/regex-based parser
-    last_error_.clear();
-    try {
-        // existing code path retained below
-        std::unordered_map<std::string, std::string> fields;
-        {
-            bool in_string = false;
-            int obj_depth = 0;
-            size_t i = 0;
-            while (i < json_content.size() && json_content[i] != '{') ++i;
-            if (i < json_content.size()) ++obj_depth, ++i;
-            auto read_string = [&](size_t& idx) -> std::string {
-                std::string out;
-                ++idx;
-                bool esc = false;
-                for (; idx < json_content.size(); ++idx) {
-                    char c = json_content[idx];
-                    if (esc) { out.push_back(c); esc = false; continue; }
-                    if (c == '\\') { esc = true; continue; }
-                    if (c == '"') { ++idx; break; }
-                    out.push_back(c);
-                }
-                return out;
-            };
-            auto skip_ws = [&](size_t& idx){ while (idx < json_content.size() && (json_content[idx]==' '||json_content[idx]=='\n'||json_content[idx]=='\r'||json_content[idx]=='\t')) ++idx; };
-            for (; i < json_content.size() && obj_depth > 0; ++i) {
-                char c = json_content[i];
-                if (c == '"') {
-                    size_t key_pos = i;
-                    std::string key = read_string(i);
-                    size_t j = i; skip_ws(j);
-                    if (j < json_content.size() && json_content[j] == ':') {
-                        ++j; skip_ws(j);
-                        if (j < json_content.size() && json_content[j] == '"' && obj_depth == 1) {
-                            std::string val = read_string(j);
-                            fields[key] = val;
-                            i = j - 1;
-                            continue;
-                        }
-                    }
-                    i = key_pos;
-                } else if (c == '{') {
-                    ++obj_depth;
-                } else if (c == '}') {
-                    --obj_depth;
-                }
+    return !in.failed();
+}
+
+bool read_config(JsonScanner& in, std::unordered_map<std::string, std::string>& config) {
+    if (!in.enter_object()) return false;
+    std::string_view key;
+    while (in.next_member(key)) {
+        std::string& value = config[std::string(key)];
+        // Coerce primitive values to string for simplicity; nested values keep their JSON text
+        switch (in.peek()) {
+            case JsonScanner::Type::String:
+                in.read_string(value);
+                break;
+            case JsonScanner::Type::Bool: {
+                bool b = false;
+                in.read_bool(b);
+                value = b ? "true" : "false";
+                break;
+            }
+            default: {
+                std::string_view raw;
+                in.skip_value(&raw);
+                value.assign(raw.data(), raw.size());
+                break;
             }
         }
+    }
+    return !in.failed();
+}
 
-        if (fields.find("name") != fields.end()) manifest.name = fields["name"]; else { set_error("Missing required field: name"); return false; }
-        if (fields.find("version") != fields.end()) manifest.version = fields["version"]; else { set_error("Missing required field: version"); return false; }
-        if (fields.find("binary_path") != fields.end()) manifest.binary_path = fields["binary_path"]; else { set_error("Missing required field: binary_path"); return false; }
-
-        manifest.description = fields.count("description") ? fields["description"] : "";
-        manifest.author = fields.count("author") ? fields["author"] : "";
-        manifest.license = fields.count("license") ? fields["license"] : "";
-        manifest.minimum_api_version = fields.count("minimum_api_version") ? fields["minimum_api_version"] : "";
-        manifest.homepage = fields.count("homepage") ? fields["homepage"] : "";
-        manifest.repository = fields.count("repository") ? fields["repository"] : "";
-        manifest.minimum_core_version = fields.count("minimum_core_version") ? fields["minimum_core_version"] : "";
+bool read_entry_points(JsonScanner& in, EntryPoints& ep, std::string& error) {
+    if (!in.enter_object()) return false;
+    std::string_view key;
+    while (in.next_member(key)) {
+        std::string* slot = key == "init" ? &ep.init : key == "start" ? &ep.start
+                          : key == "stop" ? &ep.stop : key == "destroy" ? &ep.destroy : nullptr;
+        if (!slot) in.skip_value();
+        else if (!read_string_field(in, key, *slot, error)) return false;
+    }
+    return !in.failed();
+}
 
-        std::regex deps_regex("\"dependencies\"\\s*:\\s*\\[([\\s\\S]*?)\\]");
-        std::smatch deps_match;
-        if (std::regex_search(json_content, deps_match, deps_regex)) {
-            if (!parse_dependencies(deps_match[1].str(), manifest.dependencies)) return false;
+bool read_timeouts(JsonScanner& in, LifecycleTimeouts& timeouts) {
+    if (!in.enter_object()) return false;
+    std::string_view key;
+    while (in.next_member(key)) {
+        unsigned* slot = key == "init" ? &timeouts.init_ms : key == "start" ? &timeouts.start_ms
+                       : key == "stop" ? &timeouts.stop_ms : nullptr;
+        // Only non-negative integers count; anything else leaves the default in place
+        if (!slot || in.peek() != JsonScanner::Type::Number) {
+            in.skip_value();
+            continue;
         }
-        std::regex tags_regex("\"tags\"\\s*:\\s*\\[([\\s\\S]*?)\\]");
-        std::smatch tags_match;
-        if (std::regex_search(json_content, tags_match, tags_regex)) {
-            if (!parse_string_array(tags_match[1].str(), manifest.tags)) return false;
+        std::string_view raw;
+        if (!in.read_number(raw)) break;
+        uint64_t ms = 0;
+        bool digits = !raw.empty();
+        for (char c : raw) {
+            if (c < '0' || c > '9') { digits = false; break; }
+            if (ms <= UINT32_MAX) ms = ms * 10 + static_cast<uint64_t>(c - '0');
         }
-        std::regex config_regex("\"config\"\\s*:\\s*\\{([\\s\\S]*?)\\}");
-        std::smatch config_match;
-        if (std::regex_search(json_content, config_match, config_regex)) {
-            if (!parse_config(config_match[1].str(), manifest.config)) return false;
-        }
-        std::regex ep_obj_regex("\"entry_points\"\\s*:\\s*\\{([\\s\\S]*?)\\}");
-        std::smatch ep_obj_match;
-        if (std::regex_search(json_content, ep_obj_match, ep_obj_regex)) {
-            const std::string ep_json = ep_obj_match[1].str();
-            std::regex ep_field_regex("\"([^\"]+)\"\\s*:\\s*\"([^\"]*)\"");
-            std::sregex_iterator eiter(ep_json.begin(), ep_json.end(), ep_field_regex), eend;
-            for (; eiter != eend; ++eiter) {
-                const std::string key = (*eiter)[1].str();
-                const std::string val = (*eiter)[2].str();
-                if (key == "init") manifest.entry_points.init = val;
-                else if (key == "start") manifest.entry_points.start = val;
-                else if (key == "stop") manifest.entry_points.stop = val;
-                else if (key == "destroy") manifest.entry_points.destroy = val;
+        if (digits) *slot = static_cast<unsigned>(std::min<uint64_t>(ms, UINT32_MAX));
+    }
+    return !in.failed();
+}
+
+} // namespace
+
+bool ManifestParser::parse_from_string(const std::string& json_content, ModuleManifest& manifest) {
+    // Single pass over the document; unknown members are skipped
+    last_error_.clear();
+    JsonScanner in(json_content);
+    std::string error;
+    bool has_name = false, has_version = false, has_binary = false;
+    bool ok = in.enter_object();
+    std::string_view key;
+    while (ok && in.next_member(key)) {
+        if (key == "name") ok = has_name = read_string_field(in, key, manifest.name, error);
+        else if (key == "version") ok = has_version = read_string_field(in, key, manifest.version, error);
+        else if (key == "binary_path") ok = has_binary = read_string_field(in, key, manifest.binary_path, error);
+        else if (key == "description") ok = read_string_field(in, key, manifest.description, error);
+        else if (key == "author") ok = read_string_field(in, key, manifest.author, error);
+        else if (key == "license") ok = read_string_field(in, key, manifest.license, error);
+        else if (key == "homepage") ok = read_string_field(in, key, manifest.homepage, error);
+        else if (key == "repository") ok = read_string_field(in, key, manifest.repository, error);
+        else if (key == "minimum_core_version") ok = read_string_field(in, key, manifest.minimum_core_version, error);
+        else if (key == "minimum_api_version") ok = read_string_field(in, key, manifest.minimum_api_version, error);
+        else if (key == "dependencies" && in.peek() == JsonScanner::Type::Array) ok = read_dependencies(in, manifest.dependencies, error);
+        else if (key == "tags" && in.peek() == JsonScanner::Type::Array) ok = read_string_array(in, key, manifest.tags, error);
+        else if (key == "config" && in.peek() == JsonScanner::Type::Object) ok = read_config(in, manifest.config);
+        else if (key == "entry_points" && in.peek() == JsonScanner::Type::Object) ok = read_entry_points(in, manifest.entry_points, error);
+        else if (key == "timeouts" && in.peek() == JsonScanner::Type::Object) ok = read_timeouts(in, manifest.timeouts);
+        else if (key == "isolation") {
+            std::string isolation;
+            ok = read_string_field(in, key, isolation, error);
+            if (ok && isolation != "local" && isolation != "global" && isolation != "process") {
+                error = "isolation must be \"local\", \"global\" or \"process\", got \"" + isolation + "\"";
+                ok = false;
             }
+            manifest.linkage.global = isolation == "global";
+            manifest.linkage.process = isolation == "process";
         }
-    } catch (const std::exception& e) {
-        set_error("JSON parsing error: " + std::string(e.what()));
+        else if (key == "build_profile") ok = read_string_field(in, key, manifest.build_profile, error);
+        else if (key == "exports" && in.peek() == JsonScanner::Type::Array) ok = read_string_array(in, key, manifest.linkage.exports, error);
+        else ok = in.skip_value();
+    }
+    if (ok && !in.failed() && !in.at_end()) {
+        error = "trailing characters after the manifest object";
+        ok = false;
+    }
+    if (!ok || in.failed()) {
+        set_error(std::string("JSON parsing error: ") + (error.empty() ? in.error() : error));
+        return false;
+    }
+    if (!has_name || !has_version || !has_binary) {
+        set_error(std::string("Missing required field: ") + (!has_name ? "name" : !has_version ? "version" : "binary_path"));
         return false;
     }
     return validate_manifest(manifest);
-#endif
 }
 
 bool ManifestParser::validate_manifest(const ModuleManifest& manifest) {
@@ -249,21 +250,31 @@ bool ManifestParser::validate_manifest(const ModuleManifest& manifest) {
         set_error("Invalid entry point symbol for destroy: " + manifest.entry_points.destroy);
         return false;
     }
+    for (const auto& symbol : manifest.linkage.exports) {
+        if (!is_valid_symbol_name(symbol)) {
+            set_error("Invalid exported symbol: " + symbol);
+            return false;
+        }
+    }
+    if (manifest.linkage.process && !manifest.linkage.exports.empty()) {
+        set_error("Modules with isolation \"process\" cannot have exports");
+        return false;
+    }
 
     return true;
 }
 
 bool ManifestParser::is_valid_version(const std::string& version) {
-    // Basic semantic version validation (X.Y.Z format)
-    std::regex version_regex("^\\d+\\.\\d+\\.\\d+([+-][a-zA-Z0-9\\.-]*)?$");
-    return std::regex_match(version, version_regex);
+    // Semantic version: X.Y.Z with an optional -prerelease/+build suffix
+    SemVer v;
+    return SemVer::parse(version, v);
 }
 
 bool ManifestParser::is_valid_version_requirement(const std::string& requirement) {
-    // Accept bare versions or operators >=, <=, >, <, ~, == followed by a semver
-    // Allow optional pre-release/build suffix after patch
-    std::regex req_regex(R"(^(>=|<=|>|<|~|==)?\s*\d+\.\d+\.\d+([+-][A-Za-z0-9\.-]+)?$)");
-    return std::regex_match(requirement, req_regex);
+    // One or more comparators (>=, <=, >, <, ~, == or a bare semver), optionally
+    // joined with "||"; see VersionRange
+    VersionRange range;
+    return VersionRange::parse(requirement, range);
 }
 
 bool ManifestParser::is_valid_module_name(const std::string& name) {
@@ -271,16 +282,19 @@ bool ManifestParser::is_valid_module_name(const std::string& name) {
     if (name.empty() || name.length() > 64) {
         return false;
     }
-    
-    std::regex name_regex("^[a-zA-Z][a-zA-Z0-9_-]*$");
-    return std::regex_match(name, name_regex);
+    auto alpha = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+    if (!alpha(name[0])) return false;
+    return std::all_of(name.begin() + 1, name.end(), [&](char c) {
+        return alpha(c) || (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
 }
 
 bool ManifestParser::is_valid_symbol_name(const std::string& symbol) {
     // C identifier: starts with letter or underscore, then letters/digits/underscore, allow namespace-like '::' not allowed for dlsym, so restrict to C-style
     if (symbol.empty() || symbol.size() > 128) return false;
-    std::regex sym_regex("^[A-Za-z_][A-Za-z0-9_]*$");
-    return std::regex_match(symbol, sym_regex);
+    auto word = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; };
+    if (!word(symbol[0])) return false;
+    return std::all_of(symbol.begin() + 1, symbol.end(), [&](char c) { return word(c) || (c >= '0' && c <= '9'); });
 }
 
 std::string ManifestParser::serialize_manifest(const ModuleManifest& manifest) {
@@ -299,6 +313,11 @@ std::string ManifestParser::serialize_manifest(const ModuleManifest& manifest) {
     json << "    \"stop\": \"" << manifest.entry_points.stop << "\",\n";
     json << "    \"destroy\": \"" << manifest.entry_points.destroy << "\"\n";
     json << "  },\n";
+    if (manifest.timeouts.init_ms || manifest.timeouts.start_ms || manifest.timeouts.stop_ms) {
+        json << "  \"timeouts\": {\"init\": " << manifest.timeouts.init_ms
+             << ", \"start\": " << manifest.timeouts.start_ms
+             << ", \"stop\": " << manifest.timeouts.stop_ms << "},\n";
+    }
     
     // Dependencies
     json << "  \"dependencies\": [\n";
@@ -347,60 +366,6 @@ std::string ManifestParser::serialize_manifest(const ModuleManifest& manifest) {
     return json.str();
 }
 
-bool ManifestParser::parse_dependencies(const std::string& deps_json, std::vector<Dependency>& dependencies) {
-    // Simplified dependency parsing
-    if (deps_json.empty()) {
-        return true;
-    }
-
-    // Parse each dependency object (very basic implementation)
-    std::regex dep_regex("\\{[^}]*\"name\"\\s*:\\s*\"([^\"]+)\"[^}]*\"version\"\\s*:\\s*\"([^\"]*)\"[^}]*\"optional\"\\s*:\\s*(true|false)[^}]*\\}");
-    std::sregex_iterator iter(deps_json.begin(), deps_json.end(), dep_regex);
-    std::sregex_iterator end;
-
-    for (; iter != end; ++iter) {
-        Dependency dep;
-        dep.name = (*iter)[1].str();
-        dep.version = (*iter)[2].str();
-        dep.optional = (*iter)[3].str() == "true";
-        dependencies.push_back(dep);
-    }
-
-    return true;
-}
-
-bool ManifestParser::parse_config(const std::string& config_json, std::unordered_map<std::string, std::string>& config) {
-    if (config_json.empty()) {
-        return true;
-    }
-
-    std::regex config_regex("\"([^\"]+)\"\\s*:\\s*\"([^\"]*)\"");
-    std::sregex_iterator iter(config_json.begin(), config_json.end(), config_regex);
-    std::sregex_iterator end;
-
-    for (; iter != end; ++iter) {
-        config[(*iter)[1].str()] = (*iter)[2].str();
-    }
-
-    return true;
-}
-
-bool ManifestParser::parse_string_array(const std::string& array_json, std::vector<std::string>& output) {
-    if (array_json.empty()) {
-        return true;
-    }
-
-    std::regex string_regex("\"([^\"]*)\"");
-    std::sregex_iterator iter(array_json.begin(), array_json.end(), string_regex);
-    std::sregex_iterator end;
-
-    for (; iter != end; ++iter) {
-        output.push_back((*iter)[1].str());
-    }
-
-    return true;
-}
-
 void ManifestParser::set_error(const std::string& error) {
     last_error_ = error;
     std::cerr << "Manifest error: " << error << std::endl;
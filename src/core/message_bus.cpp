@@ -0,0 +1,518 @@
+#include "helix/message_bus.h"
+#include "helix/bus.h"
+#include "helix/service_registry.h"
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <new>
+
+namespace {
+
+constexpr uint32_t kRingMagic = 0x474E5248; // "HRNG"
+constexpr uint32_t kRingVersion = 1;
+constexpr uint32_t kCancelled = 1;
+constexpr uint32_t kMaxSlotSize = 1u << 20;
+constexpr uint32_t kMaxCapacity = 1u << 20;
+constexpr size_t kMaxRingBytes = size_t(256) << 20;
+
+enum : uint32_t { kSubscriberFree = 0, kSubscriberActive = 1 };
+
+// Slot header; the payload follows it in the same stride
+struct alignas(64) Slot {
+    std::atomic<uint64_t> ready; ///< seq + 1 once the message for seq is committed
+    std::atomic<uint64_t> seq;   ///< Written by the claiming producer, after owner
+    std::atomic<int32_t> owner;  ///< pid of the claiming producer
+    uint32_t size;
+    uint32_t flags;
+};
+
+struct alignas(64) Cursor {
+    std::atomic<uint64_t> position; ///< Next seq this subscriber reads; everything before it is released
+    std::atomic<uint32_t> state;
+    std::atomic<int32_t> owner;     ///< pid of the subscribing process
+};
+
+// Start of a topic's memfd; only atomics, offsets and a process-shared mutex, so the
+// daemon and module hosts map the same ring
+struct RingControl {
+    uint32_t magic; ///< The geometry is fixed at creation; a host checks it when it maps the topic
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t capacity;
+    uint32_t stride;
+    pthread_mutex_t lock; ///< Robust; subscribe/unsubscribe and bound recomputation
+    alignas(64) std::atomic<uint64_t> head;  ///< Next seq to claim
+    alignas(64) std::atomic<uint64_t> bound; ///< Producers may claim seqs below bound + capacity
+    alignas(64) std::atomic<uint64_t> cancelled; ///< Loans committed with size 0; published = head - cancelled
+    std::atomic<uint64_t> dropped;
+    alignas(64) std::atomic<uint32_t> signal; ///< Futex word, bumped by commits that find a waiter
+    std::atomic<uint32_t> waiters;
+    Cursor cursors[helix::MessageBus::kMaxSubscribers];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "rings are shared between processes and need address-free atomics");
+
+// Holds a ring's mutex. Everything it guards is atomic, so a holder that died
+// (a crashed module host) leaves consistent state and the lock is just taken over.
+class RingLock {
+public:
+    explicit RingLock(RingControl* control) : mutex_(&control->lock) {
+        if (pthread_mutex_lock(mutex_) == EOWNERDEAD) pthread_mutex_consistent(mutex_);
+    }
+    ~RingLock() { pthread_mutex_unlock(mutex_); }
+    RingLock(const RingLock&) = delete;
+    RingLock& operator=(const RingLock&) = delete;
+
+private:
+    pthread_mutex_t* mutex_;
+};
+
+size_t control_size() {
+    return (sizeof(RingControl) + 63) & ~size_t(63);
+}
+
+long futex(std::atomic<uint32_t>* word, int op, uint32_t value, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+uint32_t round_up_pow2(uint32_t v) {
+    uint32_t p = 2;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+struct HelixBusSubscriber {
+    HelixBusTopic* topic = nullptr;
+    uint32_t index = 0;
+    uint64_t pending = 0;  ///< End of the batch handed out by the last poll
+    uint64_t owner = 0;    ///< Module instance whose lifecycle call subscribed; 0 if unknown
+};
+
+struct HelixBusTopic {
+    std::string name;
+    uint32_t slot_size = 0;
+    uint32_t capacity = 0;
+    uint32_t stride = 0;
+    int memory_fd = -1;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    RingControl* control = nullptr;
+    unsigned char* slots = nullptr;
+    int32_t process = 0; ///< getpid() of the process this view of the ring belongs to
+
+    HelixBusSubscriber subscribers[helix::MessageBus::kMaxSubscribers]; ///< Only those this process opened
+
+    ~HelixBusTopic() {
+        if (mapping) munmap(mapping, mapping_size);
+        if (memory_fd >= 0) ::close(memory_fd);
+    }
+
+    bool map(std::string& error) {
+        void* addr = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, memory_fd, 0);
+        if (addr == MAP_FAILED) {
+            error = "cannot map topic '" + name + "': " + std::strerror(errno);
+            return false;
+        }
+        mapping = addr;
+        control = static_cast<RingControl*>(addr);
+        slots = static_cast<unsigned char*>(addr) + control_size();
+        process = static_cast<int32_t>(getpid());
+        return true;
+    }
+
+    Slot* slot(uint64_t seq) const {
+        return reinterpret_cast<Slot*>(slots + static_cast<size_t>(seq & (capacity - 1)) * stride);
+    }
+
+    static unsigned char* payload(Slot* s) { return reinterpret_cast<unsigned char*>(s) + sizeof(Slot); }
+
+    // Lowest active cursor, or the head when nobody subscribes; caller holds the RingLock
+    void refresh_bound() {
+        uint64_t low = control->head.load(std::memory_order_acquire);
+        for (auto& cursor : control->cursors) {
+            if (cursor.state.load(std::memory_order_acquire) != kSubscriberActive) continue;
+            low = std::min(low, cursor.position.load(std::memory_order_acquire));
+        }
+        control->bound.store(low, std::memory_order_release);
+    }
+
+    void* loan(uint32_t size) {
+        if (size > slot_size) {
+            control->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        uint64_t seq = control->head.load(std::memory_order_relaxed);
+        bool refreshed = false;
+        while (true) {
+            // The slot's previous lap must be committed...
+            Slot* s = slot(seq);
+            const uint64_t previous = seq >= capacity ? seq - capacity + 1 : 0;
+            if (s->ready.load(std::memory_order_acquire) != previous) {
+                const uint64_t head = control->head.load(std::memory_order_relaxed);
+                if (head != seq) { // another producer took seq meanwhile
+                    seq = head;
+                    continue;
+                }
+                control->dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            // ...and every subscriber past it
+            if (seq >= control->bound.load(std::memory_order_acquire) + capacity) {
+                if (refreshed) {
+                    control->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                {
+                    RingLock lock(control);
+                    refresh_bound();
+                }
+                refreshed = true;
+                seq = control->head.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (control->head.compare_exchange_weak(seq, seq + 1, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed)) {
+                s->owner.store(process, std::memory_order_relaxed);
+                s->seq.store(seq, std::memory_order_release);
+                s->size = size;
+                s->flags = 0;
+                return payload(s);
+            }
+        }
+    }
+
+    void commit(void* loaned, uint32_t size) {
+        const size_t offset = static_cast<unsigned char*>(loaned) - slots - sizeof(Slot);
+        Slot* s = reinterpret_cast<Slot*>(slots + offset);
+        if (size == 0) {
+            s->flags = kCancelled;
+            control->cancelled.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            s->size = std::min(size, s->size);
+        }
+        s->ready.store(s->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        wake();
+    }
+
+    void wake() {
+        // Pairs with the waiter's increment of waiters: either it sees this message, or we see it waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (control->waiters.load(std::memory_order_relaxed) != 0) {
+            control->signal.fetch_add(1, std::memory_order_release);
+            futex(&control->signal, FUTEX_WAKE, INT_MAX, nullptr);
+        }
+    }
+
+    HelixBusSubscriber* subscribe() {
+        RingLock lock(control);
+        for (uint32_t i = 0; i < helix::MessageBus::kMaxSubscribers; ++i) {
+            Cursor& cursor = control->cursors[i];
+            if (cursor.state.load(std::memory_order_relaxed) != kSubscriberFree) continue;
+            const uint64_t head = control->head.load(std::memory_order_acquire);
+            cursor.position.store(head, std::memory_order_relaxed);
+            cursor.owner.store(process, std::memory_order_relaxed);
+            cursor.state.store(kSubscriberActive, std::memory_order_release);
+            HelixBusSubscriber& sub = subscribers[i];
+            sub.topic = this;
+            sub.index = i;
+            sub.pending = head;
+            sub.owner = helix::ServiceRegistry::current_instance();
+            return &sub;
+        }
+        return nullptr;
+    }
+
+    void unsubscribe(HelixBusSubscriber* sub) {
+        RingLock lock(control);
+        control->cursors[sub->index].state.store(kSubscriberFree, std::memory_order_release);
+        sub->owner = 0;
+        refresh_bound();
+    }
+
+    // Undo what a process that has exited left behind: loans it never committed
+    // (cancelled, so subscribers can read past them) and its subscriptions
+    void release_process(int32_t pid) {
+        const uint64_t head = control->head.load(std::memory_order_acquire);
+        bool cancelled = false;
+        for (uint64_t seq = head > capacity ? head - capacity : 0; seq < head; ++seq) {
+            Slot* s = slot(seq);
+            if (s->ready.load(std::memory_order_acquire) == seq + 1) continue;
+            // owner is stored before seq, so a matching seq means owner is this lap's producer
+            if (s->seq.load(std::memory_order_acquire) != seq || s->owner.load(std::memory_order_relaxed) != pid) {
+                continue;
+            }
+            s->flags = kCancelled;
+            control->cancelled.fetch_add(1, std::memory_order_relaxed);
+            s->ready.store(seq + 1, std::memory_order_release);
+            cancelled = true;
+        }
+        if (cancelled) wake();
+
+        RingLock lock(control);
+        for (auto& cursor : control->cursors) {
+            if (cursor.state.load(std::memory_order_acquire) == kSubscriberActive &&
+                cursor.owner.load(std::memory_order_relaxed) == pid) {
+                cursor.state.store(kSubscriberFree, std::memory_order_release);
+            }
+        }
+        refresh_bound();
+    }
+
+    size_t poll(HelixBusSubscriber* sub, HelixBusMessage* out, size_t max) {
+        uint64_t pos = sub->pending;
+        control->cursors[sub->index].position.store(pos, std::memory_order_release);
+        size_t n = 0;
+        while (n < max) {
+            Slot* s = slot(pos);
+            if (s->ready.load(std::memory_order_acquire) != pos + 1) break;
+            if (!(s->flags & kCancelled)) out[n++] = HelixBusMessage{payload(s), s->size};
+            ++pos;
+        }
+        sub->pending = pos;
+        return n;
+    }
+
+    bool ready(const HelixBusSubscriber* sub) const {
+        return slot(sub->pending)->ready.load(std::memory_order_acquire) == sub->pending + 1;
+    }
+
+    int wait(HelixBusSubscriber* sub, uint32_t timeout_ms) {
+        if (ready(sub)) return 1;
+        control->waiters.fetch_add(1, std::memory_order_seq_cst);
+        const uint32_t seen = control->signal.load(std::memory_order_seq_cst);
+        if (!ready(sub)) {
+            timespec timeout{static_cast<time_t>(timeout_ms / 1000), static_cast<long>(timeout_ms % 1000) * 1000000L};
+            futex(&control->signal, FUTEX_WAIT, seen, &timeout);
+        }
+        control->waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return ready(sub) ? 1 : 0;
+    }
+};
+
+namespace helix {
+
+MessageBus& MessageBus::instance() {
+    static MessageBus bus;
+    return bus;
+}
+
+MessageBus::MessageBus() = default;
+
+MessageBus::~MessageBus() = default;
+
+HelixBusTopic* MessageBus::topic(const std::string& name, uint32_t slot_size, uint32_t capacity,
+                                 std::string& error) {
+    if (name.empty()) {
+        error = "topic name is empty";
+        return nullptr;
+    }
+    if (slot_size == 0) slot_size = kDefaultSlotSize;
+    if (capacity == 0) capacity = kDefaultCapacity;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = topics_.find(name);
+    if (it != topics_.end()) {
+        if (it->second->slot_size < slot_size) {
+            error = "topic '" + name + "' has " + std::to_string(it->second->slot_size) + "-byte slots, " +
+                    std::to_string(slot_size) + " requested";
+            return nullptr;
+        }
+        return it->second.get();
+    }
+    if (source_) return attach(name, slot_size, capacity, error);
+
+    if (slot_size > kMaxSlotSize || capacity > kMaxCapacity) {
+        error = "topic '" + name + "' exceeds the slot size or capacity limit";
+        return nullptr;
+    }
+    auto topic = std::make_unique<HelixBusTopic>();
+    topic->name = name;
+    topic->slot_size = slot_size;
+    topic->capacity = round_up_pow2(capacity);
+    topic->stride = static_cast<uint32_t>((sizeof(Slot) + slot_size + 63) & ~size_t(63));
+    topic->mapping_size = control_size() + static_cast<size_t>(topic->stride) * topic->capacity;
+    if (topic->mapping_size > kMaxRingBytes) {
+        error = "topic '" + name + "' would need more than " + std::to_string(kMaxRingBytes >> 20) + " MiB";
+        return nullptr;
+    }
+    // A memfd, so module hosts can map the ring too (see share()). Created through syscall():
+    // the topic outlives the module whose call created it, so fd accounting must not charge it.
+    topic->memory_fd = static_cast<int>(syscall(SYS_memfd_create, ("helix-bus:" + name).c_str(), MFD_CLOEXEC));
+    if (topic->memory_fd < 0 || ftruncate(topic->memory_fd, static_cast<off_t>(topic->mapping_size)) != 0) {
+        error = "cannot create topic '" + name + "': " + std::strerror(errno);
+        return nullptr;
+    }
+    if (!topic->map(error)) return nullptr;
+    RingControl* control = new (topic->mapping) RingControl();
+    control->magic = kRingMagic;
+    control->version = kRingVersion;
+    control->slot_size = topic->slot_size;
+    control->capacity = topic->capacity;
+    control->stride = topic->stride;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&control->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    for (uint32_t i = 0; i < topic->capacity; ++i) {
+        new (topic->slots + static_cast<size_t>(i) * topic->stride) Slot();
+    }
+
+    HelixBusTopic* out = topic.get();
+    topics_.emplace(name, std::move(topic));
+    return out;
+}
+
+HelixBusTopic* MessageBus::attach(const std::string& name, uint32_t slot_size, uint32_t capacity,
+                                  std::string& error) {
+    auto topic = std::make_unique<HelixBusTopic>();
+    topic->name = name;
+    topic->memory_fd = source_(name, slot_size, capacity, error);
+    if (topic->memory_fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(topic->memory_fd, &st) != 0 || static_cast<size_t>(st.st_size) < control_size()) {
+        error = "topic '" + name + "' has no ring";
+        return nullptr;
+    }
+    topic->mapping_size = static_cast<size_t>(st.st_size);
+    if (!topic->map(error)) return nullptr;
+    const RingControl& control = *topic->control;
+    topic->slot_size = control.slot_size;
+    topic->capacity = control.capacity;
+    topic->stride = control.stride;
+    if (control.magic != kRingMagic || control.version != kRingVersion || topic->capacity == 0 ||
+        (topic->capacity & (topic->capacity - 1)) != 0 || topic->stride < sizeof(Slot) + topic->slot_size ||
+        control_size() + static_cast<size_t>(topic->stride) * topic->capacity > topic->mapping_size) {
+        error = "topic '" + name + "' has an unknown ring layout";
+        return nullptr;
+    }
+    if (topic->slot_size < slot_size) {
+        error = "topic '" + name + "' has " + std::to_string(topic->slot_size) + "-byte slots, " +
+                std::to_string(slot_size) + " requested";
+        return nullptr;
+    }
+
+    HelixBusTopic* out = topic.get();
+    topics_.emplace(name, std::move(topic));
+    return out;
+}
+
+int MessageBus::share(const std::string& name, uint32_t slot_size, uint32_t capacity, std::string& error) {
+    HelixBusTopic* shared = topic(name, slot_size, capacity, error);
+    return shared ? shared->memory_fd : -1;
+}
+
+void MessageBus::set_topic_source(TopicSource source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    source_ = std::move(source);
+}
+
+void MessageBus::release_process(pid_t pid) {
+    if (pid <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, topic] : topics_) topic->release_process(static_cast<int32_t>(pid));
+}
+
+void MessageBus::release_instance(uint64_t instance) {
+    if (instance == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [name, topic] : topics_) {
+        for (auto& sub : topic->subscribers) {
+            if (sub.owner == instance &&
+                topic->control->cursors[sub.index].state.load(std::memory_order_acquire) == kSubscriberActive) {
+                topic->unsubscribe(&sub);
+            }
+        }
+    }
+}
+
+std::vector<MessageBus::TopicStats> MessageBus::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TopicStats> out;
+    out.reserve(topics_.size());
+    for (const auto& [name, topic] : topics_) {
+        const RingControl& control = *topic->control;
+        TopicStats s;
+        s.name = name;
+        s.slot_size = topic->slot_size;
+        s.capacity = topic->capacity;
+        const uint64_t head = control.head.load(std::memory_order_acquire);
+        s.published = head - control.cancelled.load(std::memory_order_relaxed);
+        s.dropped = control.dropped.load(std::memory_order_relaxed);
+        uint64_t low = head;
+        for (const auto& cursor : control.cursors) {
+            if (cursor.state.load(std::memory_order_acquire) != kSubscriberActive) continue;
+            ++s.subscribers;
+            low = std::min(low, cursor.position.load(std::memory_order_acquire));
+        }
+        s.depth = head - low;
+        out.push_back(std::move(s));
+    }
+    std::sort(out.begin(), out.end(), [](const TopicStats& a, const TopicStats& b) { return a.name < b.name; });
+    return out;
+}
+
+} // namespace helix
+
+// C ABI behind helix/bus.h; exported from helixd (--export-dynamic) as one function table
+
+namespace {
+
+HelixBusTopic* bus_topic(const char* name, uint32_t slot_size, uint32_t capacity) {
+    std::string error;
+    HelixBusTopic* topic = helix::MessageBus::instance().topic(name ? name : "", slot_size, capacity, error);
+    if (!topic) std::cerr << "Message bus: " << error << std::endl;
+    return topic;
+}
+
+void* bus_loan(HelixBusTopic* topic, uint32_t size) { return topic ? topic->loan(size) : nullptr; }
+
+void bus_commit(HelixBusTopic* topic, void* loan, uint32_t size) {
+    if (topic && loan) topic->commit(loan, size);
+}
+
+int bus_publish(HelixBusTopic* topic, const void* data, uint32_t size) {
+    void* slot = bus_loan(topic, size);
+    if (!slot) return -1;
+    if (size) std::memcpy(slot, data, size);
+    // A zero-length message is still a message; commit(0) would cancel it
+    topic->commit(slot, size ? size : UINT32_MAX);
+    return 0;
+}
+
+HelixBusSubscriber* bus_subscribe(HelixBusTopic* topic) { return topic ? topic->subscribe() : nullptr; }
+
+void bus_unsubscribe(HelixBusSubscriber* sub) {
+    if (sub) sub->topic->unsubscribe(sub);
+}
+
+size_t bus_poll(HelixBusSubscriber* sub, HelixBusMessage* out, size_t max) {
+    return sub ? sub->topic->poll(sub, out, max) : 0;
+}
+
+int bus_wait(HelixBusSubscriber* sub, uint32_t timeout_ms) { return sub ? sub->topic->wait(sub, timeout_ms) : 0; }
+
+const HelixBusApi kBusApi = {
+    HELIX_BUS_API_VERSION, bus_topic, bus_loan, bus_commit, bus_publish,
+    bus_subscribe, bus_unsubscribe, bus_poll, bus_wait,
+};
+
+} // namespace
+
+extern "C" const HelixBusApi* helix_bus_api() {
+    return &kBusApi;
+}
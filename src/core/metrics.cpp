@@ -0,0 +1,341 @@
+#include "helix/metrics.h"
+#include <cstdio>
+
+namespace helix {
+
+namespace {
+
+std::atomic<size_t> next_histogram_id{0};
+
+std::string series_key(const std::string& name, const MetricLabels& labels) {
+    std::string key = name;
+    key.push_back('{');
+    for (const auto& [k, v] : labels) {
+        key += k;
+        key.push_back('=');
+        key += v;
+        key.push_back(',');
+    }
+    key.push_back('}');
+    return key;
+}
+
+// Prometheus label syntax; also readable in the text view
+std::string render_labels(const MetricLabels& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) return "";
+    std::string out = "{";
+    for (const auto& [k, v] : labels) {
+        if (out.size() > 1) out.push_back(',');
+        out += k + "=\"";
+        for (char c : v) {
+            if (c == '\\' || c == '"') out.push_back('\\');
+            if (c == '\n') out += "\\n";
+            else out.push_back(c);
+        }
+        out.push_back('"');
+    }
+    if (!extra.empty()) {
+        if (out.size() > 1) out.push_back(',');
+        out += extra;
+    }
+    out.push_back('}');
+    return out;
+}
+
+void append_json_string(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+std::string format_number(const char* format, double value) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), format, value);
+    return buf;
+}
+
+std::string ms(uint64_t ns) { return format_number("%.3f", static_cast<double>(ns) / 1e6); }
+std::string seconds(double s) { return format_number("%.9g", s); }
+
+} // namespace
+
+// Per-thread table of shards, indexed by histogram id; returns shards when the thread exits
+struct ThreadShards {
+    std::vector<Histogram::Shard*> shards;
+    std::vector<Histogram*> owners;
+
+    ~ThreadShards() {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            if (shards[i]) owners[i]->release(shards[i]);
+        }
+    }
+};
+
+namespace {
+thread_local ThreadShards t_shards;
+} // namespace
+
+Histogram::Histogram(std::string name, MetricLabels labels)
+    : name_(std::move(name)), labels_(std::move(labels)), id_(next_histogram_id.fetch_add(1)) {}
+
+size_t Histogram::bucket_of(uint64_t ns) {
+    if (ns < kSubBuckets) return static_cast<size_t>(ns);
+    const unsigned e = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+    if (e > kMaxExponent) return kBuckets - 1;
+    const size_t m = static_cast<size_t>(ns >> (e - kSubBucketBits)) & (kSubBuckets - 1);
+    return (e - kSubBucketBits + 1) * kSubBuckets + m;
+}
+
+uint64_t Histogram::bucket_end(size_t b) {
+    if (b < kSubBuckets) return b + 1;
+    const unsigned e = static_cast<unsigned>(b / kSubBuckets) + kSubBucketBits - 1;
+    const uint64_t m = b % kSubBuckets;
+    return (kSubBuckets + m + 1) << (e - kSubBucketBits);
+}
+
+Histogram::Shard* Histogram::shard_for_this_thread() {
+    ThreadShards& table = t_shards;
+    if (id_ < table.shards.size() && table.shards[id_]) return table.shards[id_];
+    Shard* shard = nullptr; // reuse one left behind by an exited thread (its counts carry over)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            shard = free_.back();
+            free_.pop_back();
+        } else {
+            shards_.push_back(std::make_unique<Shard>());
+            shard = shards_.back().get();
+        }
+    }
+    if (table.shards.size() <= id_) {
+        table.shards.resize(id_ + 1, nullptr);
+        table.owners.resize(id_ + 1, nullptr);
+    }
+    table.shards[id_] = shard;
+    table.owners[id_] = this;
+    return shard;
+}
+
+void Histogram::release(Shard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(shard);
+}
+
+void Histogram::record(uint64_t ns) {
+    // Only this thread writes the shard, so plain load/store pairs are enough
+    Shard* shard = shard_for_this_thread();
+    auto& count = shard->counts[bucket_of(ns)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    shard->sum.store(shard->sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > shard->max.load(std::memory_order_relaxed)) shard->max.store(ns, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot out;
+    out.buckets.assign(kBuckets, 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& shard : shards_) {
+        for (size_t b = 0; b < kBuckets; ++b) {
+            const uint64_t n = shard->counts[b].load(std::memory_order_relaxed);
+            out.buckets[b] += n;
+            out.count += n;
+        }
+        out.sum_ns += shard->sum.load(std::memory_order_relaxed);
+        const uint64_t max = shard->max.load(std::memory_order_relaxed);
+        if (max > out.max_ns) out.max_ns = max;
+    }
+    return out;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            const uint64_t edge = bucket_end(b) - 1;
+            return edge < max_ns ? edge : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+uint64_t Histogram::Snapshot::count_at_most(uint64_t limit_ns) const {
+    uint64_t n = 0;
+    for (size_t b = 0; b < buckets.size() && bucket_end(b) <= limit_ns + 1; ++b) n += buckets[b];
+    return n;
+}
+
+Metrics& Metrics::instance() {
+    // Never destroyed: threads may still record while static destructors run
+    static Metrics* metrics = new Metrics();
+    return *metrics;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const MetricLabels& labels, const std::string& help) {
+    const std::string key = series_key(name, labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!help.empty()) help_.emplace(name, help);
+    auto it = histograms_.find(key);
+    if (it == histograms_.end()) it = histograms_.emplace(key, std::make_unique<Histogram>(name, labels)).first;
+    return *it->second;
+}
+
+void Metrics::set_gauge(const std::string& name, const MetricLabels& labels, double value, const std::string& help) {
+    const std::string key = series_key(name, labels);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!help.empty()) help_.emplace(name, help);
+    Gauge& gauge = gauges_[key];
+    if (gauge.name.empty()) {
+        gauge.name = name;
+        gauge.labels = labels;
+    }
+    gauge.value = value;
+}
+
+void Metrics::remove_gauges(const std::string& name, const std::string& label, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = gauges_.begin(); it != gauges_.end();) {
+        bool match = it->second.name == name;
+        if (match) {
+            match = false;
+            for (const auto& [k, v] : it->second.labels) match = match || (k == label && v == value);
+        }
+        it = match ? gauges_.erase(it) : std::next(it);
+    }
+}
+
+std::string Metrics::render_text() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    for (const auto& [key, h] : histograms_) {
+        const Histogram::Snapshot s = h->snapshot();
+        out += h->name() + render_labels(h->labels()) + " count=" + std::to_string(s.count) +
+               " mean_ms=" + ms(s.count ? s.sum_ns / s.count : 0) + " p50_ms=" + ms(s.quantile(0.5)) +
+               " p90_ms=" + ms(s.quantile(0.9)) + " p99_ms=" + ms(s.quantile(0.99)) + " max_ms=" + ms(s.max_ns) + "\n";
+    }
+    for (const auto& [key, g] : gauges_) {
+        out += g.name + render_labels(g.labels) + " value=" + format_number("%.6g", g.value) + "\n";
+    }
+    return out;
+}
+
+std::string Metrics::render_json() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    auto open = [&](const std::string& name, const MetricLabels& labels, const char* type) {
+        out += "{\"name\":";
+        append_json_string(out, name);
+        out += ",\"type\":\"";
+        out += type;
+        out += "\",\"labels\":{";
+        for (size_t i = 0; i < labels.size(); ++i) {
+            if (i) out.push_back(',');
+            append_json_string(out, labels[i].first);
+            out.push_back(':');
+            append_json_string(out, labels[i].second);
+        }
+        out.push_back('}');
+    };
+    for (const auto& [key, h] : histograms_) {
+        const Histogram::Snapshot s = h->snapshot();
+        open(h->name(), h->labels(), "histogram");
+        out += ",\"count\":" + std::to_string(s.count) + ",\"sum_ms\":" + ms(s.sum_ns) +
+               ",\"p50_ms\":" + ms(s.quantile(0.5)) + ",\"p90_ms\":" + ms(s.quantile(0.9)) +
+               ",\"p99_ms\":" + ms(s.quantile(0.99)) + ",\"max_ms\":" + ms(s.max_ns) + "}\n";
+    }
+    for (const auto& [key, g] : gauges_) {
+        open(g.name, g.labels, "gauge");
+        out += ",\"value\":" + format_number("%.9g", g.value) + "}\n";
+    }
+    return out;
+}
+
+void Metrics::render_deltas(Baseline& baseline, std::string& text, std::string& json) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, h] : histograms_) {
+        Histogram::Snapshot now = h->snapshot();
+        Histogram::Snapshot& last = baseline[key];
+        if (now.count == last.count) continue;
+        Histogram::Snapshot d;
+        d.count = now.count - last.count;
+        d.sum_ns = now.sum_ns - last.sum_ns;
+        d.max_ns = now.max_ns; // only caps the quantiles
+        d.buckets = now.buckets;
+        for (size_t b = 0; b < last.buckets.size() && b < d.buckets.size(); ++b) d.buckets[b] -= last.buckets[b];
+        const std::string p50 = ms(d.quantile(0.5)), p90 = ms(d.quantile(0.9)), p99 = ms(d.quantile(0.99));
+        text += h->name() + render_labels(h->labels()) + " count=" + std::to_string(d.count) +
+                " mean_ms=" + ms(d.sum_ns / d.count) + " p50_ms=" + p50 + " p90_ms=" + p90 + " p99_ms=" + p99 + "\n";
+        json += "{\"name\":";
+        append_json_string(json, h->name());
+        json += ",\"type\":\"histogram\",\"labels\":{";
+        for (size_t i = 0; i < h->labels().size(); ++i) {
+            if (i) json.push_back(',');
+            append_json_string(json, h->labels()[i].first);
+            json.push_back(':');
+            append_json_string(json, h->labels()[i].second);
+        }
+        json += "},\"count\":" + std::to_string(d.count) + ",\"sum_ms\":" + ms(d.sum_ns) + ",\"p50_ms\":" + p50 +
+                ",\"p90_ms\":" + p90 + ",\"p99_ms\":" + p99 + "}\n";
+        last = std::move(now);
+    }
+}
+
+std::string Metrics::render_prometheus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    auto family = [&](const std::string& name, const char* type) {
+        auto help = help_.find(name);
+        if (help != help_.end()) out += "# HELP " + name + " " + help->second + "\n";
+        out += "# TYPE " + name + " " + type + "\n";
+    };
+
+    // Buckets are exact at powers of two; publish every second one from ~1 us to ~69 s
+    std::string last_family;
+    for (const auto& [key, h] : histograms_) {
+        if (h->name() != last_family) {
+            family(h->name(), "histogram");
+            last_family = h->name();
+        }
+        const Histogram::Snapshot s = h->snapshot();
+        for (unsigned e = 10; e <= 36; e += 2) {
+            const uint64_t edge = uint64_t{1} << e;
+            out += h->name() + "_bucket" +
+                   render_labels(h->labels(), "le=\"" + seconds(static_cast<double>(edge) / 1e9) + "\"") + " " +
+                   std::to_string(s.count_at_most(edge - 1)) + "\n";
+        }
+        out += h->name() + "_bucket" + render_labels(h->labels(), "le=\"+Inf\"") + " " + std::to_string(s.count) + "\n";
+        out += h->name() + "_sum" + render_labels(h->labels()) + " " + seconds(static_cast<double>(s.sum_ns) / 1e9) + "\n";
+        out += h->name() + "_count" + render_labels(h->labels()) + " " + std::to_string(s.count) + "\n";
+    }
+    last_family.clear();
+    for (const auto& [key, g] : gauges_) {
+        if (g.name != last_family) {
+            family(g.name, "gauge");
+            last_family = g.name;
+        }
+        out += g.name + render_labels(g.labels) + " " + format_number("%.9g", g.value) + "\n";
+    }
+    return out;
+}
+
+} // namespace helix
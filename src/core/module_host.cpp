@@ -0,0 +1,288 @@
+#include "helix/module_host.h"
+#include "helix/log.h"
+#include "helix/message_bus.h"
+#include "helix/resource_accounting.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+constexpr auto kStartTimeout = std::chrono::seconds(30);
+
+std::string describe_status(int status) {
+    if (status < 0) return "was reaped elsewhere";
+    if (WIFEXITED(status)) return "exited with code " + std::to_string(WEXITSTATUS(status));
+    if (WIFSIGNALED(status)) {
+        const int sig = WTERMSIG(status);
+        const char* name = strsignal(sig);
+        return "killed by signal " + std::to_string(sig) + (name ? std::string(" (") + name + ")" : std::string());
+    }
+    return "ended with status " + std::to_string(status);
+}
+
+} // namespace
+
+std::string ModuleHost::default_program() {
+    if (const char* env = std::getenv("HELIX_MODULE_HOST")) {
+        if (*env) return env;
+    }
+    std::vector<char> buf(1024);
+    for (;;) {
+        const ssize_t len = ::readlink("/proc/self/exe", buf.data(), buf.size());
+        if (len < 0) break;
+        if (static_cast<size_t>(len) < buf.size()) {
+            std::string self(buf.data(), static_cast<size_t>(len));
+            const std::string sibling = self.substr(0, self.find_last_of('/') + 1) + "helix-modhost";
+            if (::access(sibling.c_str(), X_OK) == 0) return sibling;
+            break;
+        }
+        buf.resize(buf.size() * 2);
+    }
+    return "helix-modhost";
+}
+
+std::shared_ptr<ModuleHost> ModuleHost::spawn(const std::string& program, const std::string& module_path,
+                                              const std::string& module_name, const EntryPoints& entry_points,
+                                              bool bind_now, std::string& error) {
+    std::shared_ptr<ModuleHost> host(new ModuleHost(module_name));
+    if (!host->channel_.create(error)) {
+        error = "module host for '" + module_name + "': " + error;
+        return nullptr;
+    }
+
+    std::vector<std::string> args = {program, "--module", module_path, "--name", module_name,
+                                     "--entry-points", entry_points.init, entry_points.start, entry_points.stop,
+                                     entry_points.destroy, "--log-level",
+                                     std::to_string(static_cast<int>(helix_log_get_min_level()))};
+    if (bind_now) args.push_back("--bind-now");
+    std::vector<char*> argv;
+    for (auto& arg : args) argv.push_back(&arg[0]);
+    argv.push_back(nullptr);
+
+    // Lift the channel descriptors above the slots they take in the child, so dup2 cannot clobber one
+    const int sources[4] = {host->channel_.memory_fd(), host->channel_.host_inbox_fd(),
+                            host->channel_.host_outbox_fd(), host->channel_.host_request_fd()};
+    int lifted[4] = {-1, -1, -1, -1};
+    for (int i = 0; i < 4; ++i) {
+        lifted[i] = fcntl(sources[i], F_DUPFD_CLOEXEC, 10);
+        if (lifted[i] < 0) {
+            error = std::string("module host for '") + module_name + "': " + std::strerror(errno);
+            for (int fd : lifted) {
+                if (fd >= 0) ::close(fd);
+            }
+            return nullptr;
+        }
+    }
+
+    // Between fork and exec only async-signal-safe calls: the daemon is multi-threaded. dup3 goes
+    // through syscall() because helixd wraps the libc descriptor calls for resource accounting.
+    const pid_t parent = getpid();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) _exit(127);
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, nullptr);
+        if (syscall(SYS_dup3, lifted[0], HostChannel::kHostMemoryFd, 0) < 0 ||
+            syscall(SYS_dup3, lifted[1], HostChannel::kHostInboxFd, 0) < 0 ||
+            syscall(SYS_dup3, lifted[2], HostChannel::kHostOutboxFd, 0) < 0 ||
+            syscall(SYS_dup3, lifted[3], HostChannel::kHostRequestFd, 0) < 0) {
+            _exit(127);
+        }
+#ifdef SYS_close_range
+        syscall(SYS_close_range, HostChannel::kHostRequestFd + 1, ~0U, 0);
+#endif
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    const int fork_errno = errno;
+    for (int fd : lifted) ::close(fd);
+    if (pid < 0) {
+        error = "module host for '" + module_name + "': fork failed: " + std::strerror(fork_errno);
+        return nullptr;
+    }
+    host->channel_.close_host_request_fd(); // so the request server sees the host exit
+    host->pid_ = pid;
+    ResourceAccounting::instance().set_host_process(module_name, pid);
+    host->reader_ = std::thread(&ModuleHost::reader_loop, host.get());
+    host->server_ = std::thread(&ModuleHost::serve_requests, host.get());
+
+    std::unique_lock<std::mutex> lock(host->mutex_);
+    host->cv_.wait_for(lock, kStartTimeout, [&]() { return host->ready_ || host->gone_; });
+    if (host->ready_ && host->ready_error_.empty()) return host;
+    if (host->ready_) error = host->ready_error_;
+    else if (host->gone_) error = "cannot run " + program + ": host " + host->exit_reason_;
+    else error = program + " did not report in time";
+    error = "module host for '" + module_name + "': " + error;
+    lock.unlock();
+    host->terminate(0);
+    return nullptr;
+}
+
+ModuleHost::~ModuleHost() {
+    terminate();
+}
+
+int ModuleHost::call(Op op) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (gone_ || pid_ <= 0) return kHostLost;
+        id = next_call_++;
+    }
+    HostChannel::Message request;
+    request.type = HostChannel::kCall;
+    request.op = op;
+    request.id = id;
+    if (!channel_.send(request, 1000)) return kHostLost; // a full ring means the host stopped reading
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return gone_ || replies_.count(id) != 0; });
+    auto it = replies_.find(id);
+    if (it == replies_.end()) return kHostLost;
+    const int rc = it->second;
+    replies_.erase(it);
+    return rc;
+}
+
+void ModuleHost::terminate(unsigned grace_ms) {
+    if (pid_ <= 0) return;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        exit_requested_ = true;
+        if (!gone_) {
+            lock.unlock();
+            HostChannel::Message request;
+            request.type = HostChannel::kExit;
+            (void)channel_.send(request, 100);
+            lock.lock();
+            if (!cv_.wait_for(lock, std::chrono::milliseconds(grace_ms), [&]() { return gone_; })) {
+                ::kill(pid_, SIGKILL);
+                cv_.wait(lock, [&]() { return gone_; });
+            }
+        }
+    }
+    if (reader_.joinable()) reader_.join();
+    channel_.shutdown_requests();
+    if (server_.joinable()) server_.join();
+}
+
+void ModuleHost::kill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!gone_ && pid_ > 0) ::kill(pid_, SIGKILL); // the reader reaps it; pid_ cannot have been reused yet
+}
+
+bool ModuleHost::alive() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pid_ > 0 && !gone_;
+}
+
+std::string ModuleHost::exit_reason() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return exit_reason_;
+}
+
+void ModuleHost::reader_loop() {
+    HostChannel::Message message;
+    for (;;) {
+        if (channel_.receive(message, 50)) {
+            handle(message);
+            continue;
+        }
+        int status = 0;
+        const pid_t reaped = waitpid(pid_, &status, WNOHANG);
+        if (reaped == pid_ || (reaped < 0 && errno == ECHILD)) {
+            while (channel_.receive(message, 0)) handle(message); // last words
+            mark_gone(reaped == pid_ ? status : -1);
+            return;
+        }
+    }
+}
+
+void ModuleHost::serve_requests() {
+    HostChannel::Message request;
+    while (channel_.next_request(request)) {
+        HostChannel::Message answer;
+        answer.id = request.id;
+        int fd = -1;
+        switch (request.type) {
+            case HostChannel::kOpenTopic: {
+                const auto geometry = static_cast<uint64_t>(request.value);
+                std::string error;
+                answer.type = HostChannel::kTopic;
+                fd = MessageBus::instance().share(request.payload, static_cast<uint32_t>(geometry >> 32),
+                                                  static_cast<uint32_t>(geometry), error);
+                if (fd < 0) {
+                    answer.value = -1;
+                    answer.payload = error;
+                }
+                break;
+            }
+            default:
+                answer.type = request.type;
+                answer.value = -1;
+                answer.payload = "unknown request";
+                break;
+        }
+        if (!channel_.answer(answer, fd)) break;
+    }
+}
+
+void ModuleHost::handle(HostChannel::Message& message) {
+    switch (message.type) {
+        case HostChannel::kReady: {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_ = true;
+            if (message.value != 0) ready_error_ = message.payload.empty() ? "the module failed to load" : message.payload;
+            cv_.notify_all();
+            break;
+        }
+        case HostChannel::kReply: {
+            std::lock_guard<std::mutex> lock(mutex_);
+            replies_[message.id] = static_cast<int>(message.value);
+            cv_.notify_all();
+            break;
+        }
+        case HostChannel::kLog: {
+            // "module\0message"
+            const size_t split = message.payload.find('\0');
+            const std::string module = split == std::string::npos ? name_ : message.payload.substr(0, split);
+            const char* text = split == std::string::npos ? message.payload.c_str() : message.payload.c_str() + split + 1;
+            helix_log(module.empty() ? name_.c_str() : module.c_str(), text, static_cast<HelixLogLevel>(message.op));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void ModuleHost::mark_gone(int status) {
+    const std::string reason = describe_status(status);
+    bool expected;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        gone_ = true;
+        exit_reason_ = reason;
+        expected = exit_requested_;
+    }
+    cv_.notify_all();
+    ResourceAccounting::instance().set_host_process(name_, 0);
+    MessageBus::instance().release_process(pid_);
+    if (!expected) {
+        std::cerr << "Host process " << pid_ << " of module '" << name_ << "' " << reason << std::endl;
+    }
+}
+
+} // namespace helix
@@ -0,0 +1,205 @@
+#include "helix/module_index.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+// "HLXIDX" + format version; bump the version whenever the record layout changes
+const char kMagic[8] = {'H', 'L', 'X', 'I', 'D', 'X', '0', '3'};
+const uint32_t kByteOrderMark = 0x01020304;
+
+class Writer {
+public:
+    void raw(const void* p, size_t n) { out.append(static_cast<const char*>(p), n); }
+    void u8(uint8_t v) { raw(&v, 1); }
+    void u32(uint32_t v) { raw(&v, sizeof(v)); }
+    void u64(uint64_t v) { raw(&v, sizeof(v)); }
+    void str(const std::string& s) {
+        u32(static_cast<uint32_t>(s.size()));
+        raw(s.data(), s.size());
+    }
+    std::string out;
+};
+
+class Reader {
+public:
+    Reader(const std::string& data) : p_(data.data()), end_(data.data() + data.size()) {}
+    bool raw(void* dst, size_t n) {
+        if (static_cast<size_t>(end_ - p_) < n) return fail();
+        std::memcpy(dst, p_, n);
+        p_ += n;
+        return true;
+    }
+    bool u8(uint8_t& v) { return raw(&v, 1); }
+    bool u32(uint32_t& v) { return raw(&v, sizeof(v)); }
+    bool u64(uint64_t& v) { return raw(&v, sizeof(v)); }
+    bool i64(int64_t& v) { return raw(&v, sizeof(v)); }
+    bool str(std::string& s) {
+        uint32_t n = 0;
+        if (!u32(n) || static_cast<size_t>(end_ - p_) < n) return fail();
+        s.assign(p_, n);
+        p_ += n;
+        return true;
+    }
+    bool ok() const { return ok_; }
+
+private:
+    bool fail() { ok_ = false; return false; }
+    const char* p_;
+    const char* end_;
+    bool ok_ = true;
+};
+
+void write_manifest(Writer& w, const ModuleManifest& m) {
+    for (const std::string* s : {&m.name, &m.version, &m.description, &m.author, &m.license, &m.binary_path,
+                                 &m.homepage, &m.repository, &m.minimum_core_version, &m.minimum_api_version,
+                                 &m.entry_points.init, &m.entry_points.start, &m.entry_points.stop,
+                                 &m.entry_points.destroy, &m.build_profile}) {
+        w.str(*s);
+    }
+    w.u32(m.timeouts.init_ms);
+    w.u32(m.timeouts.start_ms);
+    w.u32(m.timeouts.stop_ms);
+    w.u32(static_cast<uint32_t>(m.dependencies.size()));
+    for (const auto& dep : m.dependencies) {
+        w.str(dep.name);
+        w.str(dep.version);
+        w.u8(dep.optional ? 1 : 0);
+    }
+    w.u32(static_cast<uint32_t>(m.config.size()));
+    for (const auto& [key, value] : m.config) {
+        w.str(key);
+        w.str(value);
+    }
+    w.u32(static_cast<uint32_t>(m.tags.size()));
+    for (const auto& tag : m.tags) w.str(tag);
+    w.u8(m.linkage.process ? 2 : m.linkage.global ? 1 : 0);
+    w.u32(static_cast<uint32_t>(m.linkage.exports.size()));
+    for (const auto& symbol : m.linkage.exports) w.str(symbol);
+}
+
+bool read_manifest(Reader& r, ModuleManifest& m) {
+    for (std::string* s : {&m.name, &m.version, &m.description, &m.author, &m.license, &m.binary_path,
+                           &m.homepage, &m.repository, &m.minimum_core_version, &m.minimum_api_version,
+                           &m.entry_points.init, &m.entry_points.start, &m.entry_points.stop,
+                           &m.entry_points.destroy, &m.build_profile}) {
+        if (!r.str(*s)) return false;
+    }
+    uint32_t count = 0;
+    if (!r.u32(m.timeouts.init_ms) || !r.u32(m.timeouts.start_ms) || !r.u32(m.timeouts.stop_ms)) return false;
+    if (!r.u32(count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        Dependency dep;
+        uint8_t optional = 0;
+        if (!r.str(dep.name) || !r.str(dep.version) || !r.u8(optional)) return false;
+        dep.optional = optional != 0;
+        m.dependencies.push_back(std::move(dep));
+    }
+    if (!r.u32(count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string key, value;
+        if (!r.str(key) || !r.str(value)) return false;
+        m.config.emplace(std::move(key), std::move(value));
+    }
+    if (!r.u32(count)) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string tag;
+        if (!r.str(tag)) return false;
+        m.tags.push_back(std::move(tag));
+    }
+    uint8_t isolation = 0; // 0 local, 1 global, 2 process
+    if (!r.u8(isolation) || !r.u32(count)) return false;
+    m.linkage.global = isolation == 1;
+    m.linkage.process = isolation == 2;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string symbol;
+        if (!r.str(symbol)) return false;
+        m.linkage.exports.push_back(std::move(symbol));
+    }
+    return true;
+}
+
+} // namespace
+
+bool ModuleIndex::load(const std::string& path) {
+    entries_.clear();
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::string data;
+    char buf[64 * 1024];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+    std::fclose(f);
+
+    Reader r(data);
+    char magic[sizeof(kMagic)];
+    uint32_t bom = 0, count = 0;
+    if (!r.raw(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !r.u32(bom) || bom != kByteOrderMark || !r.u32(count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        ModuleIndexEntry e;
+        if (!r.str(e.directory) || !r.u64(e.device) || !r.u64(e.inode) || !r.u64(e.size) ||
+            !r.i64(e.mtime_ns) || !r.i64(e.ctime_ns) || !r.str(e.package_digest) || !read_manifest(r, e.manifest)) {
+            entries_.clear();
+            return false;
+        }
+        entries_[e.directory] = std::move(e);
+    }
+    return r.ok();
+}
+
+bool ModuleIndex::save(const std::string& path) const {
+    Writer w;
+    w.raw(kMagic, sizeof(kMagic));
+    w.u32(kByteOrderMark);
+    w.u32(static_cast<uint32_t>(entries_.size()));
+    for (const auto& [dir, e] : entries_) {
+        w.str(e.directory);
+        w.u64(e.device);
+        w.u64(e.inode);
+        w.u64(e.size);
+        w.u64(static_cast<uint64_t>(e.mtime_ns));
+        w.u64(static_cast<uint64_t>(e.ctime_ns));
+        w.str(e.package_digest);
+        write_manifest(w, e.manifest);
+    }
+
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(w.out.data(), 1, w.out.size(), f) == w.out.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) std::remove(tmp.c_str());
+    return ok;
+}
+
+bool ModuleIndex::stat_manifest(const std::string& manifest_path, ModuleIndexEntry& entry) {
+    struct stat st{};
+    if (::stat(manifest_path.c_str(), &st) != 0) return false;
+    entry.device = static_cast<uint64_t>(st.st_dev);
+    entry.inode = static_cast<uint64_t>(st.st_ino);
+    entry.size = static_cast<uint64_t>(st.st_size);
+    entry.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    entry.ctime_ns = static_cast<int64_t>(st.st_ctim.tv_sec) * 1000000000LL + st.st_ctim.tv_nsec;
+    return true;
+}
+
+const ModuleIndexEntry* ModuleIndex::find_current(const ModuleIndexEntry& probe) const {
+    auto it = entries_.find(probe.directory);
+    if (it == entries_.end()) return nullptr;
+    const ModuleIndexEntry& e = it->second;
+    if (e.device != probe.device || e.inode != probe.inode || e.size != probe.size ||
+        e.mtime_ns != probe.mtime_ns || e.ctime_ns != probe.ctime_ns) {
+        return nullptr;
+    }
+    return &e;
+}
+
+} // namespace helix
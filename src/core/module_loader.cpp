@@ -1,22 +1,109 @@
 #include "helix/module_loader.h"
+#include "helix/export_table.h"
+#include "helix/message_bus.h"
+#include "helix/metrics.h"
+#include "helix/module.h"
+#include "helix/module_host.h"
+#include "helix/module_memory.h"
+#include "helix/resource_accounting.h"
+#include "helix/service_registry.h"
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <condition_variable>
 #include <iostream>
+#include <thread>
 #include <vector>
 
 namespace helix {
 
+// Completion slot shared between a caller and the helper thread running an entry point
+struct PendingCall {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+    int rc = 0;
+};
+
+// True while a timed-out call is still executing; forgets the call once it has returned
+static bool overrun_in_flight(ModuleInfo& module) {
+    if (!module.overrun) return false;
+    {
+        std::lock_guard<std::mutex> lock(module.overrun->mutex);
+        if (!module.overrun->done) return true;
+    }
+    module.overrun.reset();
+    return false;
+}
+
+// True once the host process of an "isolation": "process" module has died
+static bool host_lost(const ModuleInfo& module) {
+    return module.host && !module.host->alive();
+}
+
+// Runs one entry point: a direct call into the library, or a request to the module's host process
+static int invoke(ModuleInfo& module, ModuleHost::Op op) {
+    if (module.host) return module.host->call(op);
+    switch (op) {
+        case ModuleHost::kInit: return module.interface.init();
+        case ModuleHost::kStart: return module.interface.start();
+        case ModuleHost::kStop: return module.interface.stop();
+        case ModuleHost::kDestroy: module.interface.destroy(); return 0;
+        default: return -1;
+    }
+}
+
+// Instance ids are unique for the life of the process
+static std::atomic<uint64_t> next_instance{1};
+
+// Lifecycle timings: one histogram per phase across all modules, plus each module's last duration
+static void record_phase(const std::string& module, const char* phase, std::chrono::steady_clock::time_point since) {
+    const auto elapsed = std::chrono::steady_clock::now() - since;
+    Metrics& metrics = Metrics::instance();
+    metrics.histogram("helix_module_lifecycle_seconds", {{"phase", phase}},
+                      "Time spent in module loading and lifecycle calls").record(elapsed);
+    metrics.set_gauge("helix_module_last_lifecycle_seconds", {{"module", module}, {"phase", phase}},
+                      std::chrono::duration<double>(elapsed).count(), "Duration of the module's latest call per phase");
+}
+
+// Runs a module's code attributed to it, charging the calling thread's CPU time
+static int run_accounted(uint32_t account, const std::function<int()>& fn) {
+    ResourceAccounting::Scope scope(account);
+    const uint64_t cpu0 = ResourceAccounting::thread_cpu_ns();
+    const int rc = fn();
+    ResourceAccounting::instance().add_cpu(account, ResourceAccounting::thread_cpu_ns() - cpu0);
+    return rc;
+}
+
 ModuleLoader::ModuleLoader() {
 }
 
 ModuleLoader::~ModuleLoader() {
     // Unload all modules on destruction
     for (auto& [name, module] : loaded_modules_) {
+        if (overrun_in_flight(*module)) {
+            continue; // its code is still executing; leave it mapped
+        }
         if (module->running) {
             stop_module(name);
         }
-        if (module->handle) {
-            dlclose(module->handle);
+        if (module->handle || module->host) {
+            MessageBus::instance().release_instance(module->instance);
+            ServiceRegistry::instance().withdraw(name);
+            ExportTable::instance().withdraw(name);
+            ResourceAccounting::instance().set_alloc_stats(name, nullptr);
+            close_module(*module);
+            ModuleMemory::instance().release(module->instance);
         }
+        close_retired(*module, true);
+        for (auto& instance : module->retired) instance.release();
     }
     loaded_modules_.clear();
 }
@@ -28,89 +115,493 @@ bool ModuleLoader::load_module(const std::string& module_path, const std::string
 
 bool ModuleLoader::load_module(const std::string& module_path, const std::string& module_name,
                                const EntryPoints& entry_points) {
-    if (loaded_modules_.find(module_name) != loaded_modules_.end()) {
+    return load_module(module_path, module_name, entry_points, LifecycleTimeouts());
+}
+
+bool ModuleLoader::load_module(const std::string& module_path, const std::string& module_name,
+                               const EntryPoints& entry_points, const LifecycleTimeouts& timeouts) {
+    return load_module(module_path, module_name, entry_points, timeouts, ModuleLinkage());
+}
+
+bool ModuleLoader::load_module(const std::string& module_path, const std::string& module_name,
+                               const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                               const ModuleLinkage& linkage) {
+    if (find_module(module_name)) {
         std::cerr << "Module '" << module_name << "' is already loaded" << std::endl;
         return false;
     }
 
-    // Load the shared library with RTLD_GLOBAL so symbols are visible to other modules
-    void* handle = dlopen(module_path.c_str(), RTLD_LAZY | RTLD_GLOBAL);
-    if (!handle) {
-        std::cerr << "Failed to load module '" << module_name << "': " << dlerror() << std::endl;
+    std::string error;
+    auto module_info = open_module(module_path, module_name, entry_points, timeouts, linkage, error);
+    if (!module_info) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    ModuleInfo* loaded = module_info.get();
+    const auto symbols = module_info->exports;
+    const HelixAllocStats* alloc_stats = module_info->alloc_stats;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loaded_modules_.count(module_name)) {
+            std::cerr << "Module '" << module_name << "' is already loaded" << std::endl;
+            close_module(*module_info);
+            return false;
+        }
+        loaded_modules_.emplace(module_name, std::move(module_info));
+    }
+
+    if (!symbols.empty() && !ExportTable::instance().publish(module_name, symbols, error)) {
+        std::cerr << "Failed to publish exports of module '" << module_name << "': " << error << std::endl;
+        close_module(*loaded);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            loaded_modules_.erase(module_name);
+        }
         return false;
     }
+    ResourceAccounting::instance().set_alloc_stats(module_name, alloc_stats);
+
+    std::cout << "Successfully loaded module '" << module_name << "' from " << module_path << std::endl;
+    return true;
+}
+
+std::unique_ptr<ModuleInfo> ModuleLoader::open_module(const std::string& open_path, const std::string& module_name,
+                                                      const EntryPoints& entry_points,
+                                                      const LifecycleTimeouts& timeouts,
+                                                      const ModuleLinkage& linkage, std::string& error) {
+    if (linkage.process) {
+        return spawn_host(open_path, module_name, entry_points, timeouts, error);
+    }
+
+    // RTLD_LOCAL keeps the module's symbols out of the global scope (and out of every
+    // later lookup); shared symbols are published explicitly through the ExportTable
+    const int binding = bind_now_ ? RTLD_NOW : RTLD_LAZY;
+    auto t0 = std::chrono::steady_clock::now();
+    void* handle = dlopen(open_path.c_str(), binding | (linkage.global ? RTLD_GLOBAL : RTLD_LOCAL));
+    if (!handle) {
+        error = "Failed to load module '" + module_name + "': " + dlerror();
+        return nullptr;
+    }
+    if (prefault_) {
+        prefault_segments(handle);
+    }
+    record_phase(module_name, "dlopen", t0);
+    t0 = std::chrono::steady_clock::now();
 
     auto module_info = std::make_unique<ModuleInfo>();
     module_info->name = module_name;
-    module_info->path = module_path;
+    module_info->path = open_path;
     module_info->handle = handle;
     module_info->initialized = false;
     module_info->running = false;
+    module_info->timeouts = timeouts;
+    module_info->instance = next_instance.fetch_add(1, std::memory_order_relaxed);
+    module_info->account = ResourceAccounting::instance().id_of(module_name);
 
     if (!resolve_entry_points(handle, module_info->interface, entry_points)) {
-        std::cerr << "Failed to resolve entry points for module '" << module_name << "'" << std::endl;
+        error = "Failed to resolve entry points for module '" + module_name + "'";
         dlclose(handle);
+        return nullptr;
+    }
+
+    for (const auto& name : linkage.exports) {
+        void* address = dlsym(handle, name.c_str());
+        if (!address) {
+            error = "Module '" + module_name + "' does not define exported symbol '" + name + "'";
+            dlclose(handle);
+            return nullptr;
+        }
+        module_info->exports.emplace_back(name, address);
+    }
+    using AllocStatsFn = const HelixAllocStats* (*)();
+    if (auto stats = reinterpret_cast<AllocStatsFn>(dlsym(handle, "helix_module_alloc_stats"))) {
+        module_info->alloc_stats = stats();
+    }
+    record_phase(module_name, "symbols", t0);
+    return module_info;
+}
+
+std::unique_ptr<ModuleInfo> ModuleLoader::spawn_host(const std::string& module_path, const std::string& module_name,
+                                                     const EntryPoints& entry_points,
+                                                     const LifecycleTimeouts& timeouts, std::string& error) {
+    std::string program;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        program = host_program_;
+    }
+    if (program.empty()) program = ModuleHost::default_program();
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto host = ModuleHost::spawn(program, module_path, module_name, entry_points, bind_now_, error);
+    if (!host) return nullptr;
+    record_phase(module_name, "dlopen", t0);
+
+    auto module_info = std::make_unique<ModuleInfo>();
+    module_info->name = module_name;
+    module_info->path = module_path;
+    module_info->handle = nullptr;
+    module_info->host = host;
+    module_info->initialized = false;
+    module_info->running = false;
+    module_info->timeouts = timeouts;
+    module_info->instance = next_instance.fetch_add(1, std::memory_order_relaxed);
+    module_info->account = ResourceAccounting::instance().id_of(module_name);
+    std::cout << "Module '" << module_name << "' runs in host process " << host->pid() << std::endl;
+    return module_info;
+}
+
+bool ModuleLoader::close_module(ModuleInfo& module) {
+    if (module.host) {
+        module.host->terminate();
+        return true;
+    }
+    if (dlclose(module.handle) != 0) {
+        std::cerr << "Failed to unload module '" << module.name << "': " << dlerror() << std::endl;
         return false;
     }
+    return true;
+}
 
-    loaded_modules_[module_name] = std::move(module_info);
-    
-    std::cout << "Successfully loaded module '" << module_name << "' from " << module_path << std::endl;
+void ModuleLoader::set_host_program(const std::string& program) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    host_program_ = program;
+}
+
+std::string ModuleLoader::host_exit_reason(const std::string& module_name) const {
+    ModuleInfo* module = find_module(module_name);
+    return module && module->host ? module->host->exit_reason() : std::string();
+}
+
+void ModuleLoader::close_retired(ModuleInfo& module, bool unloading) {
+    auto& retired = module.retired;
+    // A consumer may be mid-call through a retired table, which the registry keeps
+    // until the service is withdrawn
+    const bool consumed = !unloading && !retired.empty() && !ServiceRegistry::instance().consumers_of(module.name).empty();
+    for (auto it = retired.begin(); it != retired.end();) {
+        if (overrun_in_flight(**it)) {
+            ++it; // still executing a timed-out call
+            continue;
+        }
+        if (consumed || (!unloading && (*it)->exports_resolved)) {
+            ++it;
+            continue;
+        }
+        dlclose((*it)->handle);
+        ModuleMemory::instance().release((*it)->instance);
+        it = retired.erase(it);
+    }
+}
+
+bool ModuleLoader::upgrade_module(const std::string& module_name, const std::string& module_path,
+                                  const EntryPoints& entry_points, const LifecycleTimeouts& timeouts,
+                                  const ModuleLinkage& linkage, const std::string& previous_version,
+                                  std::string& error) {
+    ModuleInfo* current = find_module(module_name);
+    if (!current || !current->initialized) {
+        error = "'" + module_name + "' is not initialized";
+        return false;
+    }
+    if (overrun_in_flight(*current)) {
+        error = "a timed-out lifecycle call of '" + module_name + "' is still running";
+        return false;
+    }
+    if (current->host || linkage.process) {
+        error = "modules with \"isolation\": \"process\" cannot be upgraded in place; restart them instead";
+        return false;
+    }
+    const auto started_at = std::chrono::steady_clock::now();
+
+    // Earlier retired instances that nothing can reach any more
+    close_retired(*current);
+
+    // dlopen() returns the loaded object for a path it has seen, so open the new
+    // build through a private hard link
+    const size_t slash = module_path.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? std::string(".") : module_path.substr(0, slash);
+    const std::string base = slash == std::string::npos ? module_path : module_path.substr(slash + 1);
+    const std::string private_path =
+        dir + "/." + base + ".upgrade-" + std::to_string(next_instance.load(std::memory_order_relaxed));
+    unlink(private_path.c_str());
+    if (link(module_path.c_str(), private_path.c_str()) != 0) {
+        error = "cannot link " + module_path + ": " + std::strerror(errno);
+        return false;
+    }
+    auto fresh = open_module(private_path, module_name, entry_points, timeouts, linkage, error);
+    unlink(private_path.c_str());
+    if (!fresh) {
+        return false;
+    }
+    fresh->path = module_path;
+    if (fresh->handle == current->handle) {
+        // Same file (unchanged binaries share one inode in the store): nothing to swap
+        dlclose(fresh->handle);
+        current->timeouts = timeouts;
+        std::cout << "Module '" << module_name << "' binary is unchanged; kept the running instance" << std::endl;
+        return true;
+    }
+
+    ServiceRegistry& services = ServiceRegistry::instance();
+    services.begin_replacement(module_name, fresh->instance);
+
+    // Undo everything the new instance did; it never became visible
+    auto discard = [&](const std::string& why) {
+        services.abort_replacement(module_name);
+        if (overrun_in_flight(*fresh)) {
+            error = why + " (the new instance stays mapped while its call runs)";
+            current->retired.push_back(std::move(fresh));
+            return false;
+        }
+        if (fresh->initialized) {
+            ServiceRegistry::CallerScope scope(module_name, fresh->instance);
+            invoke(*fresh, ModuleHost::kDestroy);
+        }
+        MessageBus::instance().release_instance(fresh->instance);
+        if (fresh->exports_resolved) {
+            current->retired.push_back(std::move(fresh)); // a lookup saw its exports while they were published
+            error = why;
+            return false;
+        }
+        dlclose(fresh->handle);
+        ModuleMemory::instance().release(fresh->instance);
+        error = why;
+        return false;
+    };
+
+    int rc = 0;
+    const unsigned init_ms = timeouts.init_ms ? timeouts.init_ms : default_timeout_ms_.load();
+    if (!call_entry_point(*fresh, [m = fresh.get()]() { return invoke(*m, ModuleHost::kInit); }, init_ms, "init", rc)) {
+        return discard("new instance init did not return in time");
+    }
+    if (rc != 0) {
+        return discard("new instance init failed with code " + std::to_string(rc));
+    }
+    fresh->initialized = true;
+
+    if (void* hook = dlsym(fresh->handle, "helix_module_handoff")) {
+        // Owned by the call so a timed-out hook never reads a dead frame
+        struct HandoffState {
+            HelixHandoff handoff;
+            std::string name;
+            std::string version;
+        };
+        auto state = std::make_shared<HandoffState>();
+        state->name = module_name;
+        state->version = previous_version;
+        state->handoff.version = HELIX_HANDOFF_VERSION;
+        state->handoff.module_name = state->name.c_str();
+        state->handoff.previous_version = state->version.c_str();
+        state->handoff.previous_handle = current->handle;
+        state->handoff.find_previous = [](const HelixHandoff* self, const char* symbol) -> void* {
+            return self && symbol ? dlsym(self->previous_handle, symbol) : nullptr;
+        };
+        using HandoffFn = int (*)(const HelixHandoff*);
+        auto fn = reinterpret_cast<HandoffFn>(hook);
+        if (!call_entry_point(*fresh, [fn, state]() { return fn(&state->handoff); }, init_ms, "handoff", rc)) {
+            return discard("helix_module_handoff did not return in time");
+        }
+        if (rc != 0) {
+            return discard("helix_module_handoff failed with code " + std::to_string(rc));
+        }
+    }
+
+    const bool was_running = current->running;
+    if (was_running) {
+        const unsigned start_ms = timeouts.start_ms ? timeouts.start_ms : default_timeout_ms_.load();
+        if (!call_entry_point(*fresh, [m = fresh.get()]() { return invoke(*m, ModuleHost::kStart); }, start_ms, "start", rc)) {
+            return discard("new instance start did not return in time");
+        }
+        if (rc != 0) {
+            return discard("new instance start failed with code " + std::to_string(rc));
+        }
+        fresh->running = true;
+    }
+
+    // Switch: exports, then services (rewritten in place for their consumers), then the map entry
+    auto stop_fresh = [&]() {
+        if (!fresh->running) return;
+        int stop_rc = 0;
+        const unsigned stop_ms = timeouts.stop_ms ? timeouts.stop_ms : default_timeout_ms_.load();
+        if (call_entry_point(*fresh, [m = fresh.get()]() { return invoke(*m, ModuleHost::kStop); }, stop_ms, "stop", stop_rc)) fresh->running = false;
+    };
+    std::string switch_error;
+    bool resolved = false;
+    if (!ExportTable::instance().replace(module_name, fresh->exports, switch_error, &resolved)) {
+        stop_fresh();
+        return discard("cannot publish exports: " + switch_error);
+    }
+    current->exports_resolved = current->exports_resolved || resolved;
+    if (!services.commit_replacement(module_name, switch_error)) {
+        ExportTable::instance().replace(module_name, current->exports, error, &fresh->exports_resolved);
+        stop_fresh();
+        return discard(switch_error);
+    }
+
+    std::unique_ptr<ModuleInfo> previous;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& slot = loaded_modules_[module_name];
+        previous = std::move(slot);
+        slot = std::move(fresh);
+        current = slot.get();
+    }
+    ResourceAccounting::instance().set_alloc_stats(module_name, current->alloc_stats);
+
+    // Retire the old instance
+    bool destroyable = true;
+    if (previous->running) {
+        const unsigned stop_ms = previous->timeouts.stop_ms ? previous->timeouts.stop_ms : default_timeout_ms_.load();
+        if (!call_entry_point(*previous, [m = previous.get()]() { return invoke(*m, ModuleHost::kStop); }, stop_ms, "stop", rc)) {
+            destroyable = false; // still inside stop; leave it mapped and never destroy it
+        } else if (rc != 0) {
+            std::cerr << "Previous instance of '" << module_name << "' stop failed with code: " << rc << std::endl;
+        }
+        previous->running = false;
+    }
+    if (destroyable) {
+        ServiceRegistry::CallerScope scope(module_name, previous->instance);
+        const auto t0 = std::chrono::steady_clock::now();
+        run_accounted(previous->account, [&]() { return invoke(*previous, ModuleHost::kDestroy); });
+        record_phase(module_name, "destroy", t0);
+    }
+    MessageBus::instance().release_instance(previous->instance);
+    current->retired.push_back(std::move(previous));
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_at).count();
+    std::cout << "Upgraded module '" << module_name << "' in " << std::fixed << std::setprecision(1) << ms
+              << std::defaultfloat << " ms" << (was_running ? " without stopping it" : "")
+              << std::endl;
     return true;
 }
 
+bool ModuleLoader::readahead_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        if (::readahead(fd, 0, static_cast<size_t>(st.st_size)) != 0) {
+            (void)::posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+        }
+    }
+    ::close(fd);
+    return true;
+}
+
+void ModuleLoader::prefault_segments(void* handle) {
+    struct link_map* map = nullptr;
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || !map) return;
+
+    // dl_iterate_phdr reports the program headers; pick the object at the handle's load base
+    auto visit = [](struct dl_phdr_info* info, size_t, void* data) -> int {
+        const auto* target = static_cast<const struct link_map*>(data);
+        if (info->dlpi_addr != target->l_addr || !info->dlpi_name ||
+            std::strcmp(info->dlpi_name, target->l_name) != 0) {
+            return 0;
+        }
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+            const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+            if (ph.p_type != PT_LOAD || !(ph.p_flags & PF_R) || ph.p_memsz == 0) continue;
+            const uintptr_t begin = (info->dlpi_addr + ph.p_vaddr) & ~(page - 1);
+            const uintptr_t end = info->dlpi_addr + ph.p_vaddr + ph.p_memsz;
+            (void)madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+            // One read per page maps it now instead of on the first call into the module
+            for (uintptr_t p = begin; p < end; p += page) {
+                (void)*reinterpret_cast<const volatile char*>(p);
+            }
+        }
+        return 1;
+    };
+    dl_iterate_phdr(visit, map);
+}
+
 bool ModuleLoader::unload_module(const std::string& module_name) {
-    auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
+    ModuleInfo* module = find_module(module_name);
+    if (!module) {
         std::cerr << "Module '" << module_name << "' is not loaded" << std::endl;
         return false;
     }
 
-    auto& module = it->second;
+    if (overrun_in_flight(*module)) {
+        std::cerr << "Module '" << module_name << "' cannot be unloaded while a timed-out call is still running" << std::endl;
+        return false;
+    }
 
-    if (module->running) {
+    // A dead host process has nothing left to stop or destroy
+    const bool lost = host_lost(*module);
+    if (module->running && !lost) {
         if (!stop_module(module_name)) {
             std::cerr << "Failed to stop module '" << module_name << "' before unloading" << std::endl;
             return false;
         }
     }
 
-    if (module->initialized && module->interface.destroy) {
-        module->interface.destroy();
+    if (module->initialized && !lost) {
+        const auto t0 = std::chrono::steady_clock::now();
+        ServiceRegistry::CallerScope scope(module_name, module->instance);
+        run_accounted(module->account, [&]() { return invoke(*module, ModuleHost::kDestroy); });
+        record_phase(module_name, "destroy", t0);
     }
 
-    if (dlclose(module->handle) != 0) {
-        std::cerr << "Failed to unload module '" << module_name << "': " << dlerror() << std::endl;
+    MessageBus::instance().release_instance(module->instance);
+    ServiceRegistry::instance().withdraw(module_name);
+    ExportTable::instance().withdraw(module_name);
+    ResourceAccounting::instance().set_alloc_stats(module_name, nullptr);
+    if (!close_module(*module)) {
         return false;
     }
+    if (const size_t released = ModuleMemory::instance().release(module->instance)) {
+        std::cout << "Released " << released << " bytes of arena and pool memory of module '" << module_name << "'"
+                  << std::endl;
+    }
+    close_retired(*module, true);
+    if (!module->retired.empty()) {
+        std::cerr << "Module '" << module_name << "' leaves " << module->retired.size()
+                  << " replaced instance(s) mapped while their timed-out calls run" << std::endl;
+        for (auto& instance : module->retired) instance.release(); // deliberately leaked with the mapping
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        loaded_modules_.erase(module_name);
+    }
 
-    loaded_modules_.erase(it);
-    
     std::cout << "Successfully unloaded module '" << module_name << "'" << std::endl;
     return true;
 }
 
 bool ModuleLoader::initialize_module(const std::string& module_name) {
-    auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
+    ModuleInfo* module = find_module(module_name);
+    if (!module) {
         std::cerr << "Module '" << module_name << "' is not loaded" << std::endl;
         return false;
     }
 
-    auto& module = it->second;
+    if (overrun_in_flight(*module)) {
+        std::cerr << "Module '" << module_name << "' still has a timed-out call running" << std::endl;
+        return false;
+    }
     
     if (module->initialized) {
         std::cerr << "Module '" << module_name << "' is already initialized" << std::endl;
         return false;
     }
 
-    if (!module->interface.init) {
+    if (!module->host && !module->interface.init) {
         std::cerr << "Module '" << module_name << "' does not have an init function" << std::endl;
         return false;
     }
 
-    int result = module->interface.init();
+    int result = 0;
+    const unsigned timeout_ms = module->timeouts.init_ms ? module->timeouts.init_ms : default_timeout_ms_.load();
+    if (!call_entry_point(*module, [m = module]() { return invoke(*m, ModuleHost::kInit); }, timeout_ms, "init", result)) {
+        return false;
+    }
     if (result != 0) {
+        if (host_lost(*module)) {
+            std::cerr << "Host process of module '" << module_name << "' " << module->host->exit_reason() << std::endl;
+            return false;
+        }
         std::cerr << "Module '" << module_name << "' init function failed with code: " << result << std::endl;
         return false;
     }
@@ -121,13 +612,16 @@ bool ModuleLoader::initialize_module(const std::string& module_name) {
 }
 
 bool ModuleLoader::start_module(const std::string& module_name) {
-    auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
+    ModuleInfo* module = find_module(module_name);
+    if (!module) {
         std::cerr << "Module '" << module_name << "' is not loaded" << std::endl;
         return false;
     }
 
-    auto& module = it->second;
+    if (overrun_in_flight(*module)) {
+        std::cerr << "Module '" << module_name << "' still has a timed-out call running" << std::endl;
+        return false;
+    }
     
     if (!module->initialized) {
         std::cerr << "Module '" << module_name << "' must be initialized before starting" << std::endl;
@@ -139,13 +633,21 @@ bool ModuleLoader::start_module(const std::string& module_name) {
         return false;
     }
 
-    if (!module->interface.start) {
+    if (!module->host && !module->interface.start) {
         std::cerr << "Module '" << module_name << "' does not have a start function" << std::endl;
         return false;
     }
 
-    int result = module->interface.start();
+    int result = 0;
+    const unsigned timeout_ms = module->timeouts.start_ms ? module->timeouts.start_ms : default_timeout_ms_.load();
+    if (!call_entry_point(*module, [m = module]() { return invoke(*m, ModuleHost::kStart); }, timeout_ms, "start", result)) {
+        return false;
+    }
     if (result != 0) {
+        if (host_lost(*module)) {
+            std::cerr << "Host process of module '" << module_name << "' " << module->host->exit_reason() << std::endl;
+            return false;
+        }
         std::cerr << "Module '" << module_name << "' start function failed with code: " << result << std::endl;
         return false;
     }
@@ -156,27 +658,38 @@ bool ModuleLoader::start_module(const std::string& module_name) {
 }
 
 bool ModuleLoader::stop_module(const std::string& module_name) {
-    auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
+    ModuleInfo* module = find_module(module_name);
+    if (!module) {
         std::cerr << "Module '" << module_name << "' is not loaded" << std::endl;
         return false;
     }
 
-    auto& module = it->second;
+    if (overrun_in_flight(*module)) {
+        std::cerr << "Module '" << module_name << "' still has a timed-out call running" << std::endl;
+        return false;
+    }
     
     if (!module->running) {
         std::cerr << "Module '" << module_name << "' is not running" << std::endl;
         return false;
     }
 
-    if (!module->interface.stop) {
+    if (!module->host && !module->interface.stop) {
         std::cerr << "Module '" << module_name << "' does not have a stop function" << std::endl;
         return false;
     }
 
-    // Call the module's stop function
-    int result = module->interface.stop();
+    int result = 0;
+    const unsigned timeout_ms = module->timeouts.stop_ms ? module->timeouts.stop_ms : default_timeout_ms_.load();
+    if (!call_entry_point(*module, [m = module]() { return invoke(*m, ModuleHost::kStop); }, timeout_ms, "stop", result)) {
+        return false;
+    }
     if (result != 0) {
+        if (host_lost(*module)) {
+            module->running = false; // it stopped with its process
+            std::cerr << "Host process of module '" << module_name << "' " << module->host->exit_reason() << std::endl;
+            return false;
+        }
         std::cerr << "Module '" << module_name << "' stop function failed with code: " << result << std::endl;
         return false;
     }
@@ -187,26 +700,81 @@ bool ModuleLoader::stop_module(const std::string& module_name) {
 }
 
 bool ModuleLoader::is_module_loaded(const std::string& module_name) const {
-    return loaded_modules_.find(module_name) != loaded_modules_.end();
+    return find_module(module_name) != nullptr;
 }
 
 bool ModuleLoader::is_module_running(const std::string& module_name) const {
-    auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
+    const ModuleInfo* module = find_module(module_name);
+    return module && module->running;
+}
+
+const ModuleInfo* ModuleLoader::get_module_info(const std::string& module_name) const {
+    return find_module(module_name);
+}
+
+bool ModuleLoader::is_module_hung(const std::string& module_name) const {
+    ModuleInfo* module = find_module(module_name);
+    return module && overrun_in_flight(*module);
+}
+
+bool ModuleLoader::call_entry_point(ModuleInfo& module, const std::function<int()>& fn,
+                                    unsigned timeout_ms, const char* what, int& rc) {
+    // Services, topics and exports used by the entry point are attributed to this instance
+    const auto t0 = std::chrono::steady_clock::now();
+    if (timeout_ms == 0) {
+        ServiceRegistry::CallerScope scope(module.name, module.instance);
+        rc = run_accounted(module.account, fn);
+        record_phase(module.name, what, t0);
+        return true;
+    }
+
+    auto call = std::make_shared<PendingCall>();
+    std::thread worker([call, fn, name = module.name, instance = module.instance, account = module.account]() {
+        ServiceRegistry::CallerScope scope(name, instance);
+        int result = run_accounted(account, fn);
+        std::lock_guard<std::mutex> lock(call->mutex);
+        call->rc = result;
+        call->done = true;
+        call->cv.notify_all();
+    });
+
+    bool finished;
+    {
+        std::unique_lock<std::mutex> lock(call->mutex);
+        finished = call->cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]() { return call->done; });
+        rc = call->rc;
+    }
+    record_phase(module.name, what, t0);
+    if (finished) {
+        worker.join();
+        return true;
+    }
+
+    if (module.host) {
+        // A hosted module can be interrupted: kill its process and the call returns kHostLost at once
+        module.host->kill();
+        worker.join();
+        std::cerr << "Module '" << module.name << "' " << what << " function did not return within "
+                  << timeout_ms << " ms; killed its host process" << std::endl;
         return false;
     }
-    return it->second->running;
+
+    // The entry point cannot be interrupted; let it finish on its own and keep the module mapped
+    worker.detach();
+    module.overrun = call;
+    std::cerr << "Module '" << module.name << "' " << what << " function did not return within "
+              << timeout_ms << " ms" << std::endl;
+    return false;
 }
 
-const ModuleInfo* ModuleLoader::get_module_info(const std::string& module_name) const {
+ModuleInfo* ModuleLoader::find_module(const std::string& module_name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto it = loaded_modules_.find(module_name);
-    if (it == loaded_modules_.end()) {
-        return nullptr;
-    }
-    return it->second.get();
+    return (it != loaded_modules_.end()) ? it->second.get() : nullptr;
 }
 
 std::vector<std::string> ModuleLoader::get_loaded_modules() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::string> module_names;
     module_names.reserve(loaded_modules_.size());
     
@@ -0,0 +1,422 @@
+#include "helix/module_memory.h"
+#include "helix/resource_accounting.h"
+#include "helix/service_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// Both are opaque to modules; their layout is private to this file
+struct HelixArena {
+    struct Block {
+        Block* next;
+        size_t size;      ///< Payload bytes
+        bool dedicated;   ///< Holds one large allocation
+        alignas(std::max_align_t) char payload[1];
+    };
+
+    uint64_t owner = 0;
+    uint32_t account = 0;
+    size_t block_size = 0;
+    std::mutex mutex;
+    Block* blocks = nullptr; ///< Most recent first
+    Block* current = nullptr; ///< Block the cursor points into
+    char* cursor = nullptr;
+    char* end = nullptr;
+    size_t reserved = 0;
+};
+
+struct HelixPool {
+    uint64_t id = 0;         ///< Never reused, so stale thread caches can be recognized
+    uint64_t owner = 0;
+    uint32_t account = 0;
+    size_t stride = 0;
+    size_t align = 0;
+    size_t per_chunk = 0;
+    std::mutex mutex;
+    void* free_list = nullptr; ///< Intrusive: the first word of a free object links to the next
+    std::vector<void*> chunks;
+    char* carve = nullptr;     ///< Unused tail of the newest chunk
+    char* carve_end = nullptr;
+    size_t reserved = 0;
+};
+
+namespace helix {
+
+namespace {
+
+using Block = HelixArena::Block;
+
+constexpr size_t kBlockHeader = offsetof(Block, payload);
+
+bool power_of_two(size_t n) {
+    return n && (n & (n - 1)) == 0;
+}
+
+char* align_up(char* p, size_t align) {
+    const uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<char*>((v + align - 1) & ~static_cast<uintptr_t>(align - 1));
+}
+
+void charge(uint32_t account, int64_t bytes) {
+    ResourceAccounting::instance().add_arena_bytes(account, bytes);
+}
+
+Block* new_block(size_t payload, bool dedicated) {
+    void* raw = std::malloc(kBlockHeader + payload);
+    if (!raw) return nullptr;
+    Block* block = static_cast<Block*>(raw);
+    block->next = nullptr;
+    block->size = payload;
+    block->dedicated = dedicated;
+    return block;
+}
+
+// Frees every block; returns the bytes released
+size_t free_arena(HelixArena* arena) {
+    size_t released = 0;
+    for (Block* block = arena->blocks; block;) {
+        Block* next = block->next;
+        released += block->size;
+        std::free(block);
+        block = next;
+    }
+    arena->blocks = arena->current = nullptr;
+    arena->cursor = arena->end = nullptr;
+    arena->reserved = 0;
+    return released;
+}
+
+// Pools that still exist, so a thread cache holding objects of a freed pool can tell
+struct PoolRegistry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, HelixPool*> live;
+    uint64_t next_id = 1;
+
+    static PoolRegistry& instance() {
+        // Never destroyed: thread caches are flushed by thread-exit destructors
+        static PoolRegistry* registry = new PoolRegistry();
+        return *registry;
+    }
+};
+
+// Pushes objects onto a pool's shared free list; the caller holds pool->mutex
+void push_locked(HelixPool* pool, void* const* items, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        *static_cast<void**>(items[i]) = pool->free_list;
+        pool->free_list = items[i];
+    }
+}
+
+size_t free_pool(HelixPool* pool) {
+    for (void* chunk : pool->chunks) std::free(chunk);
+    pool->chunks.clear();
+    pool->free_list = nullptr;
+    pool->carve = pool->carve_end = nullptr;
+    const size_t released = pool->reserved;
+    pool->reserved = 0;
+    return released;
+}
+
+struct PoolCache {
+    uint64_t id = 0;
+    uint32_t count = 0;
+    void* items[ModuleMemory::kCacheSize];
+};
+
+// Returns cached objects to their pool if it still exists, else forgets them
+void spill_cache(PoolCache& cache) {
+    if (cache.id && cache.count) {
+        PoolRegistry& registry = PoolRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.live.find(cache.id);
+        if (it != registry.live.end()) {
+            std::lock_guard<std::mutex> pool_lock(it->second->mutex);
+            push_locked(it->second, cache.items, cache.count);
+        }
+    }
+    cache.id = 0;
+    cache.count = 0;
+}
+
+struct ThreadCaches {
+    PoolCache slots[ModuleMemory::kCachedPools];
+
+    ~ThreadCaches() {
+        for (PoolCache& cache : slots) spill_cache(cache);
+    }
+};
+
+thread_local ThreadCaches t_caches;
+
+PoolCache& cache_for(HelixPool* pool) {
+    PoolCache& cache = t_caches.slots[pool->id % ModuleMemory::kCachedPools];
+    if (cache.id != pool->id) {
+        spill_cache(cache);
+        cache.id = pool->id;
+    }
+    return cache;
+}
+
+// Moves up to kCacheBatch free objects into the cache, carving a new chunk if needed
+void refill(HelixPool* pool, PoolCache& cache) {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    while (cache.count < ModuleMemory::kCacheBatch) {
+        if (pool->free_list) {
+            void* object = pool->free_list;
+            pool->free_list = *static_cast<void**>(object);
+            cache.items[cache.count++] = object;
+            continue;
+        }
+        if (pool->carve == pool->carve_end) {
+            const size_t bytes = pool->stride * pool->per_chunk;
+            void* chunk = nullptr;
+            if (posix_memalign(&chunk, std::max(pool->align, sizeof(void*)), bytes) != 0) return;
+            pool->chunks.push_back(chunk);
+            pool->carve = static_cast<char*>(chunk);
+            pool->carve_end = pool->carve + bytes;
+            pool->reserved += bytes;
+            charge(pool->account, static_cast<int64_t>(bytes));
+        }
+        cache.items[cache.count++] = pool->carve;
+        pool->carve += pool->stride;
+    }
+}
+
+} // namespace
+
+ModuleMemory& ModuleMemory::instance() {
+    // Never destroyed: modules may free pool objects from static destructors
+    static ModuleMemory* memory = new ModuleMemory();
+    return *memory;
+}
+
+ModuleMemory::Owner& ModuleMemory::owner_locked(uint64_t instance) {
+    auto [it, inserted] = owners_.try_emplace(instance);
+    if (inserted) it->second.account = ResourceAccounting::current();
+    return it->second;
+}
+
+HelixArena* ModuleMemory::create_arena(size_t block_size) {
+    auto* arena = new (std::nothrow) HelixArena();
+    if (!arena) return nullptr;
+    arena->block_size = block_size ? block_size : kDefaultBlockSize;
+    std::lock_guard<std::mutex> lock(mutex_);
+    arena->owner = ServiceRegistry::current_instance();
+    Owner& owner = owner_locked(arena->owner);
+    arena->account = owner.account;
+    owner.arenas.push_back(arena);
+    return arena;
+}
+
+HelixArena* ModuleMemory::module_arena() {
+    const uint64_t instance = ServiceRegistry::current_instance();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Owner& owner = owner_locked(instance);
+        if (owner.default_arena) return owner.default_arena;
+    }
+    HelixArena* arena = create_arena(0);
+    if (!arena) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    Owner& owner = owner_locked(instance);
+    if (owner.default_arena) {
+        // Another thread of the instance got there first
+        owner.arenas.erase(std::remove(owner.arenas.begin(), owner.arenas.end(), arena), owner.arenas.end());
+        delete arena;
+        return owner.default_arena;
+    }
+    owner.default_arena = arena;
+    return arena;
+}
+
+void* ModuleMemory::arena_alloc(HelixArena* arena, size_t size, size_t align) {
+    if (!align) align = alignof(std::max_align_t);
+    if (!power_of_two(align)) return nullptr;
+    if (!size) size = 1;
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    if (arena->cursor) {
+        char* p = align_up(arena->cursor, align);
+        if (p <= arena->end && static_cast<size_t>(arena->end - p) >= size) {
+            arena->cursor = p + size;
+            return p;
+        }
+    }
+
+    // Large requests get a block of their own so the current block's tail stays usable
+    const bool dedicated = size > arena->block_size / 4;
+    const size_t payload = dedicated ? size + align : std::max(arena->block_size, size + align);
+    Block* block = new_block(payload, dedicated);
+    if (!block) return nullptr;
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->reserved += payload;
+    charge(arena->account, static_cast<int64_t>(payload));
+    char* p = align_up(block->payload, align);
+    if (!dedicated) {
+        arena->current = block;
+        arena->cursor = p + size;
+        arena->end = block->payload + payload;
+    }
+    return p;
+}
+
+void ModuleMemory::arena_reset(HelixArena* arena) {
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    Block* kept = nullptr;
+    size_t released = 0;
+    for (Block* block = arena->blocks; block;) {
+        Block* next = block->next;
+        if (!kept && !block->dedicated) {
+            kept = block;
+            kept->next = nullptr;
+        } else {
+            released += block->size;
+            std::free(block);
+        }
+        block = next;
+    }
+    arena->blocks = arena->current = kept;
+    arena->cursor = kept ? kept->payload : nullptr;
+    arena->end = kept ? kept->payload + kept->size : nullptr;
+    arena->reserved -= released;
+    charge(arena->account, -static_cast<int64_t>(released));
+}
+
+void ModuleMemory::destroy_arena(HelixArena* arena) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = owners_.find(arena->owner);
+        if (it != owners_.end()) {
+            auto& arenas = it->second.arenas;
+            arenas.erase(std::remove(arenas.begin(), arenas.end(), arena), arenas.end());
+            if (it->second.default_arena == arena) it->second.default_arena = nullptr;
+        }
+    }
+    const size_t released = free_arena(arena);
+    charge(arena->account, -static_cast<int64_t>(released));
+    delete arena;
+}
+
+HelixPool* ModuleMemory::create_pool(size_t object_size, size_t align) {
+    if (!align) align = alignof(std::max_align_t);
+    if (!power_of_two(align) || !object_size) return nullptr;
+    auto* pool = new (std::nothrow) HelixPool();
+    if (!pool) return nullptr;
+    const size_t size = std::max(object_size, sizeof(void*));
+    pool->align = align;
+    pool->stride = (size + align - 1) & ~(align - 1);
+    pool->per_chunk = std::max<size_t>(kCacheBatch, kDefaultBlockSize / pool->stride);
+    {
+        PoolRegistry& registry = PoolRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        pool->id = registry.next_id++;
+        registry.live.emplace(pool->id, pool);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool->owner = ServiceRegistry::current_instance();
+    Owner& owner = owner_locked(pool->owner);
+    pool->account = owner.account;
+    owner.pools.push_back(pool);
+    return pool;
+}
+
+void* ModuleMemory::pool_alloc(HelixPool* pool) {
+    PoolCache& cache = cache_for(pool);
+    if (!cache.count) refill(pool, cache);
+    return cache.count ? cache.items[--cache.count] : nullptr;
+}
+
+void ModuleMemory::pool_free(HelixPool* pool, void* object) {
+    PoolCache& cache = cache_for(pool);
+    if (cache.count == kCacheSize) {
+        // Hand the older half back so the next frees and allocs stay local
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        push_locked(pool, cache.items, kCacheBatch);
+        std::copy(cache.items + kCacheBatch, cache.items + kCacheSize, cache.items);
+        cache.count -= kCacheBatch;
+    }
+    cache.items[cache.count++] = object;
+}
+
+void ModuleMemory::destroy_pool(HelixPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = owners_.find(pool->owner);
+        if (it != owners_.end()) {
+            auto& pools = it->second.pools;
+            pools.erase(std::remove(pools.begin(), pools.end(), pool), pools.end());
+        }
+    }
+    {
+        PoolRegistry& registry = PoolRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.erase(pool->id);
+    }
+    const size_t released = free_pool(pool);
+    charge(pool->account, -static_cast<int64_t>(released));
+    delete pool;
+}
+
+size_t ModuleMemory::release(uint64_t instance) {
+    Owner owner;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = owners_.find(instance);
+        if (it == owners_.end()) return 0;
+        owner = std::move(it->second);
+        owners_.erase(it);
+    }
+    size_t released = 0;
+    for (HelixArena* arena : owner.arenas) {
+        released += free_arena(arena);
+        delete arena;
+    }
+    {
+        PoolRegistry& registry = PoolRegistry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (HelixPool* pool : owner.pools) registry.live.erase(pool->id);
+    }
+    for (HelixPool* pool : owner.pools) {
+        released += free_pool(pool);
+        delete pool;
+    }
+    charge(owner.account, -static_cast<int64_t>(released));
+    return released;
+}
+
+size_t ModuleMemory::reserved(uint64_t instance) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = owners_.find(instance);
+    if (it == owners_.end()) return 0;
+    size_t total = 0;
+    for (HelixArena* arena : it->second.arenas) {
+        std::lock_guard<std::mutex> arena_lock(arena->mutex);
+        total += arena->reserved;
+    }
+    for (HelixPool* pool : it->second.pools) {
+        std::lock_guard<std::mutex> pool_lock(pool->mutex);
+        total += pool->reserved;
+    }
+    return total;
+}
+
+const HelixMemoryApi* ModuleMemory::api() {
+    static const HelixMemoryApi table = {
+        [](size_t block_size) { return instance().create_arena(block_size); },
+        []() { return instance().module_arena(); },
+        &ModuleMemory::arena_alloc,
+        &ModuleMemory::arena_reset,
+        [](HelixArena* arena) { instance().destroy_arena(arena); },
+        [](size_t object_size, size_t align) { return instance().create_pool(object_size, align); },
+        &ModuleMemory::pool_alloc,
+        &ModuleMemory::pool_free,
+        [](HelixPool* pool) { instance().destroy_pool(pool); },
+    };
+    return &table;
+}
+
+} // namespace helix
+
+extern "C" const HelixMemoryApi* helix_memory_api_get() {
+    return helix::ModuleMemory::api();
+}
@@ -0,0 +1,231 @@
+#include "helix/resource_accounting.h"
+#include "helix/service_registry.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+thread_local uint32_t t_account = 0;
+
+uint64_t clock_ns(clockid_t clock) {
+    timespec ts{};
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+// Start routine and attribution of a thread started by spawn_thread()
+struct AttributedThread {
+    ResourceAccounting::Slot* slot;
+    uint32_t id;
+    std::string caller; ///< Creator's ServiceRegistry caller, empty if none
+    uint64_t instance;
+    void* (*start)(void*);
+    void* arg;
+
+    // Charges the thread's CPU time to the module however it ends (return, pthread_exit, cancel)
+    struct Registration {
+        ResourceAccounting::Slot* slot;
+        clockid_t clock;
+        bool registered;
+
+        ~Registration() {
+            if (!registered) return;
+            const uint64_t used = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            slot->cpu_ns.fetch_add(used, std::memory_order_relaxed);
+            auto it = std::find(slot->live.begin(), slot->live.end(), clock);
+            if (it != slot->live.end()) slot->live.erase(it);
+        }
+    };
+
+    static void* run(void* raw) {
+        std::unique_ptr<AttributedThread> self(static_cast<AttributedThread*>(raw));
+        Registration registration{self->slot, clockid_t{}, false};
+        if (pthread_getcpuclockid(pthread_self(), &registration.clock) == 0) {
+            std::lock_guard<std::mutex> lock(self->slot->mutex);
+            self->slot->live.push_back(registration.clock);
+            registration.registered = true;
+        }
+        ResourceAccounting::Scope account(self->id);
+        std::unique_ptr<ServiceRegistry::CallerScope> caller;
+        if (!self->caller.empty()) caller = std::make_unique<ServiceRegistry::CallerScope>(self->caller, self->instance);
+        void* (*start)(void*) = self->start;
+        void* arg = self->arg;
+        return start(arg);
+    }
+};
+
+ResourceAccounting::Scope::Scope(uint32_t id) : previous_(t_account) {
+    t_account = id;
+}
+
+ResourceAccounting::Scope::~Scope() {
+    t_account = previous_;
+}
+
+ResourceAccounting& ResourceAccounting::instance() {
+    // Never destroyed: descriptors are still opened and closed while static destructors run
+    static ResourceAccounting* accounting = new ResourceAccounting();
+    return *accounting;
+}
+
+uint32_t ResourceAccounting::id_of(const std::string& module) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(module);
+    if (it != ids_.end()) return it->second;
+    if (storage_.size() + 1 >= kMaxModules) return 0;
+    storage_.emplace_back();
+    Slot* slot = &storage_.back();
+    slot->name = module;
+    const uint32_t id = static_cast<uint32_t>(storage_.size());
+    slots_[id].store(slot, std::memory_order_release);
+    ids_.emplace(module, id);
+    return id;
+}
+
+uint32_t ResourceAccounting::current() {
+    return t_account;
+}
+
+uint64_t ResourceAccounting::thread_cpu_ns() {
+    return clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+void ResourceAccounting::add_cpu(uint32_t id, uint64_t ns) {
+    if (Slot* s = slot(id)) s->cpu_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+int ResourceAccounting::spawn_thread(pthread_t* thread, const pthread_attr_t* attr, void* (*start)(void*), void* arg) {
+    Slot* s = slot(current());
+    if (!s) return pthread_create(thread, attr, start, arg);
+    const std::string* caller = ServiceRegistry::current_caller();
+    auto* attributed = new AttributedThread{s, current(), caller ? *caller : std::string(),
+                                            ServiceRegistry::current_instance(), start, arg};
+    const int rc = pthread_create(thread, attr, &AttributedThread::run, attributed);
+    if (rc != 0) {
+        delete attributed;
+        return rc;
+    }
+    s->threads_started.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+}
+
+void ResourceAccounting::fd_opened(int fd) {
+    if (fd < 0 || fd >= kMaxTrackedFds) return;
+    const uint32_t id = current();
+    // Most descriptors belong to the daemon; skip the atomic exchange when nothing changes
+    if (id == 0 && fd_owner_[fd].load(std::memory_order_relaxed) == 0) return;
+    const uint16_t previous = fd_owner_[fd].exchange(static_cast<uint16_t>(id), std::memory_order_relaxed);
+    if (previous == id) return;
+    if (Slot* s = slot(previous)) s->fds.fetch_sub(1, std::memory_order_relaxed);
+    if (Slot* s = slot(id)) s->fds.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ResourceAccounting::fd_closed(int fd) {
+    if (fd < 0 || fd >= kMaxTrackedFds) return;
+    if (fd_owner_[fd].load(std::memory_order_relaxed) == 0) return;
+    const uint16_t previous = fd_owner_[fd].exchange(0, std::memory_order_relaxed);
+    if (Slot* s = slot(previous)) s->fds.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ResourceAccounting::add_arena_bytes(uint32_t id, int64_t bytes) {
+    if (Slot* s = slot(id)) s->arena_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ResourceAccounting::set_alloc_stats(const std::string& module, const HelixAllocStats* stats) {
+    if (stats && stats->version != HELIX_ALLOC_STATS_VERSION) stats = nullptr;
+    if (Slot* s = slot(id_of(module))) s->alloc.store(stats, std::memory_order_release);
+}
+
+void ResourceAccounting::set_host_process(const std::string& module, int pid) {
+    if (Slot* s = slot(id_of(module))) s->host_pid.store(pid, std::memory_order_release);
+}
+
+ResourceAccounting::Usage ResourceAccounting::usage(const std::string& module) const {
+    Usage out;
+    Slot* s = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ids_.find(module);
+        if (it != ids_.end()) s = slot(it->second);
+    }
+    if (!s) return out;
+    if (const int pid = s->host_pid.load(std::memory_order_acquire)) {
+        const ProcessUsage host = process_usage(pid);
+        out.host_pid = pid;
+        out.cpu_ns = host.cpu_ns;
+        out.threads = host.threads;
+        out.fds = host.fds;
+        out.rss_bytes = host.rss_bytes;
+        return out;
+    }
+    out.threads_started = s->threads_started.load(std::memory_order_relaxed);
+    const int64_t fds = s->fds.load(std::memory_order_relaxed);
+    out.fds = fds > 0 ? fds : 0;
+    const int64_t arena = s->arena_bytes.load(std::memory_order_relaxed);
+    out.arena_bytes = arena > 0 ? static_cast<uint64_t>(arena) : 0;
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        out.cpu_ns = s->cpu_ns.load(std::memory_order_relaxed);
+        out.threads = static_cast<uint32_t>(s->live.size());
+        for (clockid_t clock : s->live) out.cpu_ns += clock_ns(clock);
+    }
+    if (const HelixAllocStats* a = s->alloc.load(std::memory_order_acquire)) {
+        out.allocations_tracked = true;
+        out.allocations = __atomic_load_n(&a->allocations, __ATOMIC_RELAXED);
+        out.frees = __atomic_load_n(&a->frees, __ATOMIC_RELAXED);
+        out.bytes_allocated = __atomic_load_n(&a->bytes_allocated, __ATOMIC_RELAXED);
+        out.bytes_freed = __atomic_load_n(&a->bytes_freed, __ATOMIC_RELAXED);
+    }
+    return out;
+}
+
+ResourceAccounting::ProcessUsage ResourceAccounting::process_usage(int pid) {
+    ProcessUsage out;
+    const std::string proc = pid ? "/proc/" + std::to_string(pid) : std::string("/proc/self");
+    clockid_t cpu_clock = CLOCK_PROCESS_CPUTIME_ID;
+    if (!pid || clock_getcpuclockid(pid, &cpu_clock) == 0) out.cpu_ns = clock_ns(cpu_clock);
+
+    if (FILE* statm = std::fopen((proc + "/statm").c_str(), "r")) {
+        unsigned long size = 0, resident = 0;
+        if (std::fscanf(statm, "%lu %lu", &size, &resident) == 2) {
+            out.rss_bytes = static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        }
+        std::fclose(statm);
+    }
+
+    if (FILE* status = std::fopen((proc + "/status").c_str(), "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), status)) {
+            if (std::strncmp(line, "Threads:", 8) == 0) {
+                out.threads = static_cast<uint32_t>(std::strtoul(line + 8, nullptr, 10));
+                break;
+            }
+        }
+        std::fclose(status);
+    }
+
+    if (DIR* dir = opendir((proc + "/fd").c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') ++out.fds;
+        }
+        closedir(dir);
+        if (!pid && out.fds) --out.fds; // the directory stream's own descriptor
+    }
+    return out;
+}
+
+} // namespace helix
+
+extern "C" int helix_thread_spawn(pthread_t* thread, const pthread_attr_t* attr, void* (*start)(void*), void* arg) {
+    return helix::ResourceAccounting::instance().spawn_thread(thread, attr, start, arg);
+}
@@ -0,0 +1,152 @@
+#include "helix/semver.h"
+#include "helix/json_scanner.h"
+
+namespace helix {
+
+namespace {
+
+bool is_space(char c) { return c == ' ' || c == '\t'; }
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+    while (!s.empty() && is_space(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+bool all_digits(std::string_view s) {
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+
+template <typename T>
+int three_way(const T& a, const T& b) {
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+// SemVer 2.0 precedence of two dot-separated pre-release strings
+int compare_prerelease(std::string_view a, std::string_view b) {
+    // A release sorts after any of its pre-releases
+    if (a.empty() || b.empty()) return a.empty() == b.empty() ? 0 : (a.empty() ? 1 : -1);
+
+    while (true) {
+        const size_t da = a.find('.'), db = b.find('.');
+        const std::string_view ia = a.substr(0, da), ib = b.substr(0, db);
+        const bool na = all_digits(ia), nb = all_digits(ib);
+        int cmp;
+        if (na && nb) {
+            // Numeric identifiers: longer (without leading zeros) is larger, else compare digits
+            cmp = ia.size() != ib.size() ? three_way(ia.size(), ib.size()) : three_way(ia, ib);
+        } else if (na != nb) {
+            cmp = na ? -1 : 1;
+        } else {
+            cmp = three_way(ia, ib);
+        }
+        if (cmp != 0) return cmp;
+        if (da == std::string_view::npos || db == std::string_view::npos) {
+            return three_way(da == std::string_view::npos ? 0 : 1, db == std::string_view::npos ? 0 : 1);
+        }
+        a.remove_prefix(da + 1);
+        b.remove_prefix(db + 1);
+    }
+}
+
+} // namespace
+
+bool SemVer::parse(std::string_view text, SemVer& out) {
+    SemverView view;
+    std::string_view rest;
+    if (!scan_semver(text, view, &rest) || !rest.empty() || view.suffix.size() == 1) return false;
+    out.major = view.major;
+    out.minor = view.minor;
+    out.patch = view.patch;
+    out.prerelease.clear();
+    if (!view.suffix.empty() && view.suffix[0] == '-') out.prerelease.assign(view.suffix.substr(1));
+    return true;
+}
+
+int SemVer::compare(const SemVer& other) const {
+    if (major != other.major) return three_way(major, other.major);
+    if (minor != other.minor) return three_way(minor, other.minor);
+    if (patch != other.patch) return three_way(patch, other.patch);
+    if (prerelease.empty() && other.prerelease.empty()) return 0;
+    return compare_prerelease(prerelease, other.prerelease);
+}
+
+std::string SemVer::to_string() const {
+    std::string s = std::to_string(major) + "." + std::to_string(minor) + "." + std::to_string(patch);
+    if (!prerelease.empty()) s += "-" + prerelease;
+    return s;
+}
+
+bool VersionRange::parse(std::string_view requirement, VersionRange& out) {
+    out.sets_.clear();
+    std::string_view text = trim(requirement);
+    if (text.empty()) return true;
+
+    std::vector<std::vector<Comparator>> sets;
+    while (true) {
+        const size_t bar = text.find("||");
+        std::string_view part = trim(text.substr(0, bar));
+        if (part.empty()) return false;
+
+        std::vector<Comparator> set;
+        while (!part.empty()) {
+            std::string_view op, version;
+            if (!split_version_requirement(part, op, version)) return false;
+
+            // The version runs up to the next whitespace
+            size_t end = 0;
+            while (end < version.size() && !is_space(version[end])) ++end;
+            Comparator c;
+            if (!SemVer::parse(version.substr(0, end), c.version)) return false;
+            if (op.empty() || op == "==") c.op = Op::Eq;
+            else if (op == ">=") c.op = Op::Ge;
+            else if (op == ">") c.op = Op::Gt;
+            else if (op == "<=") c.op = Op::Le;
+            else if (op == "<") c.op = Op::Lt;
+            else c.op = Op::Tilde;
+            set.push_back(std::move(c));
+            part = trim(version.substr(end));
+        }
+        sets.push_back(std::move(set));
+
+        if (bar == std::string_view::npos) break;
+        text = text.substr(bar + 2);
+    }
+    out.sets_ = std::move(sets);
+    return true;
+}
+
+bool VersionRange::matches(const Comparator& c, const SemVer& version) {
+    const int cmp = version.compare(c.version);
+    switch (c.op) {
+        case Op::Eq: return cmp == 0;
+        case Op::Gt: return cmp > 0;
+        case Op::Ge: return cmp >= 0;
+        case Op::Lt: return cmp < 0;
+        case Op::Le: return cmp <= 0;
+        case Op::Tilde:
+            // Compatible within the same minor version
+            return version.major == c.version.major && version.minor == c.version.minor && cmp >= 0;
+    }
+    return false;
+}
+
+bool VersionRange::satisfied_by(const SemVer& version) const {
+    if (sets_.empty()) return true;
+    for (const auto& set : sets_) {
+        bool ok = true;
+        for (const auto& c : set) {
+            if (!matches(c, version)) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) return true;
+    }
+    return false;
+}
+
+} // namespace helix
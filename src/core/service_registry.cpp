@@ -0,0 +1,295 @@
+#include "helix/service_registry.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace helix {
+
+namespace {
+
+thread_local const std::string* t_caller = nullptr;
+thread_local uint64_t t_instance = 0;
+
+std::string version_string(uint32_t version) {
+    return std::to_string(version >> 16) + "." + std::to_string(version & 0xFFFF);
+}
+
+} // namespace
+
+ServiceRegistry::CallerScope::CallerScope(const std::string& module, uint64_t instance)
+    : previous_(t_caller), previous_instance_(t_instance) {
+    t_caller = &module;
+    t_instance = instance;
+}
+
+ServiceRegistry::CallerScope::~CallerScope() {
+    t_caller = previous_;
+    t_instance = previous_instance_;
+}
+
+ServiceRegistry& ServiceRegistry::instance() {
+    static ServiceRegistry registry;
+    return registry;
+}
+
+const std::string* ServiceRegistry::current_caller() {
+    return t_caller;
+}
+
+uint64_t ServiceRegistry::current_instance() {
+    return t_instance;
+}
+
+ServiceRegistry::Table ServiceRegistry::copy_table(const void* vtable, size_t size) {
+    Table table{std::make_unique<unsigned char[]>(size), size};
+    std::memcpy(table.bytes.get(), vtable, size);
+    return table;
+}
+
+void ServiceRegistry::set_dependency_check(DependencyCheck check) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    depends_ = std::move(check);
+}
+
+bool ServiceRegistry::register_service(const std::string& module, const std::string& name, uint32_t version,
+                                       const void* vtable, size_t size, std::string& error) {
+    if (name.empty() || !vtable || size == 0) {
+        error = "a service needs a name and a non-empty table";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = services_.find(name);
+    if (it != services_.end() && it->second.provider != module) {
+        error = "service '" + name + "' is already provided by '" + it->second.provider + "'";
+        return false;
+    }
+
+    // A replacement instance registers into its staging area until the upgrade commits
+    auto staged = staged_.find(module);
+    if (staged != staged_.end() && staged->second.instance == t_instance) {
+        const auto* bytes = static_cast<const unsigned char*>(vtable);
+        staged->second.services[name] = Registration{version, std::vector<unsigned char>(bytes, bytes + size)};
+        return true;
+    }
+
+    if (it != services_.end() && !it->second.consumers.empty()) {
+        error = "service '" + name + "' is in use and cannot be replaced";
+        return false;
+    }
+    Entry entry;
+    entry.provider = module;
+    entry.version = version;
+    entry.size = size;
+    entry.tables.push_back(copy_table(vtable, size));
+    entry.slot = std::make_unique<Slot>(entry.tables.back().bytes.get());
+    services_[name] = std::move(entry);
+    return true;
+}
+
+const ServiceRegistry::Slot* ServiceRegistry::resolve(const std::string& consumer, const std::string& name,
+                                                      uint32_t version, size_t size, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = services_.find(name);
+    if (it == services_.end()) {
+        error = "service '" + name + "' is not registered";
+        return nullptr;
+    }
+    Entry& entry = it->second;
+    if ((entry.version >> 16) != (version >> 16) || (entry.version & 0xFFFF) < (version & 0xFFFF)) {
+        error = "service '" + name + "' is version " + version_string(entry.version) + ", requested " +
+                version_string(version);
+        return nullptr;
+    }
+    if (entry.size < size) {
+        error = "service '" + name + "' table is " + std::to_string(entry.size) + " bytes, consumer expects " +
+                std::to_string(size);
+        return nullptr;
+    }
+    if (entry.provider != consumer) {
+        if (depends_ && !depends_(consumer, entry.provider)) {
+            error = "service '" + name + "' is provided by '" + entry.provider + "', which '" + consumer +
+                    "' does not list in its dependencies";
+            return nullptr;
+        }
+        if (std::find(entry.consumers.begin(), entry.consumers.end(), consumer) == entry.consumers.end()) {
+            entry.consumers.push_back(consumer);
+        }
+        entry.max_minor = std::max(entry.max_minor, version & 0xFFFF);
+        entry.max_size = std::max(entry.max_size, size);
+    }
+    return entry.slot.get();
+}
+
+void ServiceRegistry::begin_replacement(const std::string& module, uint64_t instance) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    staged_[module] = Staged{instance, {}};
+}
+
+bool ServiceRegistry::commit_replacement(const std::string& module, std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto staged_it = staged_.find(module);
+    if (staged_it == staged_.end()) {
+        error = "no replacement of '" + module + "' in progress";
+        return false;
+    }
+    auto& staged = staged_it->second.services;
+
+    // Check everything first so a refused upgrade leaves the running tables untouched
+    for (const auto& [name, entry] : services_) {
+        if (entry.provider != module || entry.consumers.empty()) continue;
+        auto next = staged.find(name);
+        if (next == staged.end()) {
+            error = "the new version does not register service '" + name + "', which is in use";
+            return false;
+        }
+        const uint32_t major = next->second.version >> 16, minor = next->second.version & 0xFFFF;
+        if (major != (entry.version >> 16) || minor < entry.max_minor) {
+            error = "service '" + name + "' version " + version_string(next->second.version) +
+                    " is incompatible with its consumers (" + std::to_string(entry.version >> 16) + "." +
+                    std::to_string(entry.max_minor) + " in use)";
+            return false;
+        }
+        if (next->second.bytes.size() < entry.max_size) {
+            error = "service '" + name + "' table shrank below the " + std::to_string(entry.max_size) +
+                    " bytes its consumers use";
+            return false;
+        }
+    }
+
+    for (const auto& [name, registration] : staged) {
+        auto taken = services_.find(name);
+        if (taken != services_.end() && taken->second.provider != module) {
+            error = "service '" + name + "' is already provided by '" + taken->second.provider + "'";
+            return false;
+        }
+    }
+
+    for (auto it = services_.begin(); it != services_.end();) {
+        Entry& entry = it->second;
+        if (entry.provider != module) {
+            ++it;
+            continue;
+        }
+        auto next = staged.find(it->first);
+        if (next == staged.end()) {
+            it = services_.erase(it); // unused, and not offered by the new version
+            continue;
+        }
+        // Consumers load the slot once per call, so they see one whole table or the other
+        const auto& bytes = next->second.bytes;
+        entry.tables.push_back(copy_table(bytes.data(), bytes.size()));
+        entry.slot->store(entry.tables.back().bytes.get(), std::memory_order_release);
+        entry.version = next->second.version;
+        entry.size = bytes.size();
+        staged.erase(next);
+        ++it;
+    }
+    for (auto& [name, registration] : staged) {
+        Entry entry;
+        entry.provider = module;
+        entry.version = registration.version;
+        entry.size = registration.bytes.size();
+        entry.tables.push_back(copy_table(registration.bytes.data(), registration.bytes.size()));
+        entry.slot = std::make_unique<Slot>(entry.tables.back().bytes.get());
+        services_[name] = std::move(entry);
+    }
+    staged_.erase(staged_it);
+    return true;
+}
+
+void ServiceRegistry::abort_replacement(const std::string& module) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    staged_.erase(module);
+}
+
+void ServiceRegistry::withdraw(const std::string& module) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = services_.begin(); it != services_.end();) {
+        if (it->second.provider == module) {
+            it = services_.erase(it);
+            continue;
+        }
+        auto& consumers = it->second.consumers;
+        consumers.erase(std::remove(consumers.begin(), consumers.end(), module), consumers.end());
+        ++it;
+    }
+}
+
+void ServiceRegistry::set_unavailable(const std::string& reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unavailable_ = reason;
+}
+
+std::string ServiceRegistry::unavailable_reason() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return unavailable_;
+}
+
+std::vector<std::string> ServiceRegistry::consumers_of(const std::string& provider) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    for (const auto& [name, entry] : services_) {
+        if (entry.provider != provider) continue;
+        for (const auto& consumer : entry.consumers) {
+            if (std::find(out.begin(), out.end(), consumer) == out.end()) out.push_back(consumer);
+        }
+    }
+    return out;
+}
+
+std::vector<ServiceRegistry::ServiceInfo> ServiceRegistry::list() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ServiceInfo> out;
+    out.reserve(services_.size());
+    for (const auto& [name, entry] : services_) {
+        out.push_back(ServiceInfo{name, entry.provider, entry.version, entry.size, entry.consumers});
+    }
+    std::sort(out.begin(), out.end(), [](const ServiceInfo& a, const ServiceInfo& b) { return a.name < b.name; });
+    return out;
+}
+
+} // namespace helix
+
+// Exported from helixd (--export-dynamic); modules reach these through helix/service.h
+
+extern "C" int helix_service_register(const char* name, uint32_t version, const void* vtable, size_t size) {
+    const std::string unavailable = helix::ServiceRegistry::instance().unavailable_reason();
+    if (!unavailable.empty()) {
+        std::cerr << "Service '" << (name ? name : "") << "' cannot be registered: " << unavailable << std::endl;
+        return -1;
+    }
+    const std::string* caller = helix::ServiceRegistry::current_caller();
+    if (!caller) {
+        std::cerr << "Service '" << (name ? name : "") << "' must be registered from a module's init or start"
+                  << std::endl;
+        return -1;
+    }
+    std::string error;
+    if (!helix::ServiceRegistry::instance().register_service(*caller, name ? name : "", version, vtable, size,
+                                                             error)) {
+        std::cerr << "Module '" << *caller << "' failed to register service: " << error << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// Returns the service's slot (a std::atomic<const void*>) as const void* to keep a C signature
+extern "C" const void* helix_service_resolve(const char* name, uint32_t version, size_t size) {
+    const std::string unavailable = helix::ServiceRegistry::instance().unavailable_reason();
+    if (!unavailable.empty()) {
+        std::cerr << "Service '" << (name ? name : "") << "' cannot be resolved: " << unavailable << std::endl;
+        return nullptr;
+    }
+    const std::string* caller = helix::ServiceRegistry::current_caller();
+    if (!caller) {
+        std::cerr << "Service '" << (name ? name : "") << "' must be resolved from a module's init or start"
+                  << std::endl;
+        return nullptr;
+    }
+    std::string error;
+    const auto* slot = helix::ServiceRegistry::instance().resolve(*caller, name ? name : "", version, size, error);
+    if (!slot) {
+        std::cerr << "Module '" << *caller << "' cannot use service: " << error << std::endl;
+    }
+    return slot;
+}
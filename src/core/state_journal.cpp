@@ -0,0 +1,384 @@
+#include "helix/state_journal.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+// "HLXSNP" + format version; bump the version whenever the snapshot layout changes
+const char kSnapshotMagic[8] = {'H', 'L', 'X', 'S', 'N', 'P', '0', '1'};
+const uint32_t kByteOrderMark = 0x01020304;
+// Tag of every journal record ("HJR1" in memory on little-endian hosts)
+const uint32_t kRecordMagic = 0x31524A48;
+
+// Journal record layout; kRecordSize bytes, host byte order (the magic doubles as a byte order check)
+const size_t kCrcOffset = 0;    // u32 CRC-32 of bytes [4, 64)
+const size_t kMagicOffset = 4;  // u32 kRecordMagic
+const size_t kSeqOffset = 8;    // u64 sequence number, strictly increasing
+const size_t kStateOffset = 16; // u8 state code (0 = removed)
+const size_t kLengthOffset = 17; // u8 name length
+const size_t kNameOffset = 18;  // name, zero padded to the end of the record
+
+static_assert(kNameOffset + StateJournal::kMaxNameLength == StateJournal::kRecordSize,
+              "journal record layout does not add up");
+
+uint32_t crc32(const void* data, size_t size) {
+    static const auto table = []() {
+        struct { uint32_t v[256]; } t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t.v[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) crc = table.v[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void encode_record(char* out, uint64_t seq, uint8_t state, const std::string& module) {
+    std::memset(out, 0, StateJournal::kRecordSize);
+    std::memcpy(out + kMagicOffset, &kRecordMagic, sizeof(kRecordMagic));
+    std::memcpy(out + kSeqOffset, &seq, sizeof(seq));
+    out[kStateOffset] = static_cast<char>(state);
+    out[kLengthOffset] = static_cast<char>(module.size());
+    std::memcpy(out + kNameOffset, module.data(), module.size());
+    const uint32_t crc = crc32(out + kMagicOffset, StateJournal::kRecordSize - kMagicOffset);
+    std::memcpy(out + kCrcOffset, &crc, sizeof(crc));
+}
+
+bool decode_record(const char* in, uint64_t& seq, uint8_t& state, std::string& module) {
+    uint32_t crc = 0, magic = 0;
+    std::memcpy(&crc, in + kCrcOffset, sizeof(crc));
+    std::memcpy(&magic, in + kMagicOffset, sizeof(magic));
+    if (magic != kRecordMagic) return false;
+    if (crc != crc32(in + kMagicOffset, StateJournal::kRecordSize - kMagicOffset)) return false;
+    const size_t length = static_cast<unsigned char>(in[kLengthOffset]);
+    if (length == 0 || length > StateJournal::kMaxNameLength) return false;
+    std::memcpy(&seq, in + kSeqOffset, sizeof(seq));
+    state = static_cast<uint8_t>(in[kStateOffset]);
+    module.assign(in + kNameOffset, length);
+    return true;
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char buf[8192];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    std::fclose(f);
+    return true;
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void sync_directory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    (void)::fsync(fd);
+    ::close(fd);
+}
+
+} // namespace
+
+StateJournal::~StateJournal() {
+    (void)close();
+}
+
+bool StateJournal::load_snapshot(uint64_t& seq, std::unordered_map<std::string, uint8_t>& states,
+                                 std::string& error) {
+    seq = 0;
+    std::string data;
+    if (!read_file(snapshot_path(), data)) return true; // no snapshot yet
+
+    // magic, byte order mark, seq, count, { u8 state, u16 length, name }..., u32 CRC-32 of all before it
+    const size_t header = sizeof(kSnapshotMagic) + 4 + 8 + 4;
+    uint32_t bom = 0, count = 0, crc = 0;
+    if (data.size() < header + 4 || std::memcmp(data.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        error = "not a state snapshot";
+        return false;
+    }
+    std::memcpy(&bom, data.data() + 8, 4);
+    std::memcpy(&seq, data.data() + 12, 8);
+    std::memcpy(&count, data.data() + 20, 4);
+    std::memcpy(&crc, data.data() + data.size() - 4, 4);
+    if (bom != kByteOrderMark || crc != crc32(data.data(), data.size() - 4)) {
+        error = "state snapshot is corrupt";
+        seq = 0;
+        return false;
+    }
+    size_t pos = header;
+    const size_t end = data.size() - 4;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (end - pos < 3) break;
+        const uint8_t state = static_cast<uint8_t>(data[pos]);
+        uint16_t length = 0;
+        std::memcpy(&length, data.data() + pos + 1, 2);
+        pos += 3;
+        if (end - pos < length) break;
+        states[data.substr(pos, length)] = state;
+        pos += length;
+    }
+    return true;
+}
+
+bool StateJournal::open(const std::string& directory, std::unordered_map<std::string, uint8_t>& states,
+                        std::string& error) {
+    if (is_open()) {
+        error = "state journal is already open";
+        return false;
+    }
+    directory_ = directory;
+    states.clear();
+
+    uint64_t snapshot_seq = 0;
+    std::string snapshot_error;
+    if (!load_snapshot(snapshot_seq, states, snapshot_error)) {
+        // Renames make a damaged snapshot unlikely; keep whatever the journal still has
+        std::cerr << "Ignoring state snapshot '" << snapshot_path() << "': " << snapshot_error << std::endl;
+        states.clear();
+    }
+
+    const std::string path = journal_path();
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "cannot open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+
+    std::string data;
+    (void)read_file(path, data);
+    uint64_t last_seq = snapshot_seq;
+    size_t valid = 0;
+    size_t records = 0;
+    std::string module;
+    for (size_t pos = 0; pos + kRecordSize <= data.size(); pos += kRecordSize) {
+        uint64_t seq = 0;
+        uint8_t state = 0;
+        if (!decode_record(data.data() + pos, seq, state, module)) break;
+        valid = pos + kRecordSize;
+        ++records;
+        // Records already folded into the snapshot (compaction stopped before the truncate)
+        if (seq <= last_seq) continue;
+        last_seq = seq;
+        if (state == 0) states.erase(module);
+        else states[module] = state;
+        ++stats_.replayed;
+    }
+    if (valid < data.size()) {
+        std::cerr << "State journal '" << path << "': dropping " << (data.size() - valid)
+                  << " trailing bytes (torn or corrupt record)" << std::endl;
+        if (::ftruncate(fd, static_cast<off_t>(valid)) != 0) {
+            error = "cannot truncate '" + path + "': " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    next_seq_ = last_seq + 1;
+    journal_records_ = records;
+    queued_ = committed_ = 0;
+    stop_ = failed_ = false;
+    needs_compaction_ = journal_records_ > compact_threshold_;
+    states_ = states;
+    queue_.clear();
+    writer_ = std::thread([this]() { writer_loop(); });
+    return true;
+}
+
+bool StateJournal::import(const std::unordered_map<std::string, uint8_t>& states) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!is_open()) return false;
+        for (const auto& [module, state] : states) {
+            if (state == 0) continue;
+            states_[module] = state;
+        }
+        ++queued_;
+    }
+    return compact();
+}
+
+void StateJournal::record(const std::string& module, uint8_t state) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_open() || stop_ || module.empty()) return;
+    if (state == 0) states_.erase(module);
+    else states_[module] = state;
+    ++queued_;
+    ++stats_.records;
+    if (module.size() > kMaxNameLength || failed_) {
+        // Only the snapshot can hold this name (or recover from a failed write)
+        needs_compaction_ = true;
+    } else {
+        queue_.push_back({module, state});
+    }
+    work_cv_.notify_one();
+}
+
+bool StateJournal::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_open()) return false;
+    const uint64_t target = queued_;
+    done_cv_.wait(lock, [&]() { return committed_ >= target || !writer_.joinable(); });
+    return !failed_;
+}
+
+bool StateJournal::compact() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!is_open()) return false;
+    needs_compaction_ = true;
+    const uint64_t target = queued_;
+    work_cv_.notify_one();
+    done_cv_.wait(lock, [&]() { return (!needs_compaction_ && committed_ >= target) || !writer_.joinable(); });
+    return !failed_;
+}
+
+bool StateJournal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!is_open()) return true;
+    }
+    const bool ok = compact();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        work_cv_.notify_one();
+    }
+    if (writer_.joinable()) writer_.join();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ::close(fd_);
+    fd_ = -1;
+    queue_.clear();
+    done_cv_.notify_all();
+    return ok;
+}
+
+StateJournal::Stats StateJournal::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void StateJournal::writer_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<Pending> batch;
+    for (;;) {
+        work_cv_.wait(lock, [&]() { return stop_ || needs_compaction_ || !queue_.empty(); });
+        if (needs_compaction_ || journal_records_ + queue_.size() > compact_threshold_) {
+            if (!write_snapshot(lock)) failed_ = true;
+            needs_compaction_ = false;
+            done_cv_.notify_all();
+            continue;
+        }
+        if (!queue_.empty()) {
+            batch.clear();
+            batch.swap(queue_);
+            (void)commit(batch, lock);
+            done_cv_.notify_all();
+            continue;
+        }
+        if (stop_) return;
+    }
+}
+
+bool StateJournal::commit(std::vector<Pending>& batch, std::unique_lock<std::mutex>& lock) {
+    // Everything queued before this point goes out in one write and one fdatasync
+    const uint64_t upto = queued_;
+    const uint64_t first_seq = next_seq_;
+    next_seq_ += batch.size();
+    lock.unlock();
+
+    std::string buffer(batch.size() * kRecordSize, '\0');
+    for (size_t i = 0; i < batch.size(); ++i) {
+        encode_record(&buffer[i * kRecordSize], first_seq + i, batch[i].state, batch[i].module);
+    }
+    bool ok = write_all(fd_, buffer.data(), buffer.size()) && ::fdatasync(fd_) == 0;
+    const int saved_errno = errno;
+
+    lock.lock();
+    journal_records_ += batch.size();
+    committed_ = upto;
+    ++stats_.syncs;
+    if (!ok) {
+        std::cerr << "State journal '" << journal_path() << "': write failed: " << std::strerror(saved_errno)
+                  << std::endl;
+        failed_ = true;
+    }
+    return ok;
+}
+
+bool StateJournal::write_snapshot(std::unique_lock<std::mutex>& lock) {
+    // Copy the states so record() is not blocked on the disk; the snapshot covers every queued record
+    const uint64_t seq = next_seq_ - 1;
+    const uint64_t upto = queued_;
+    const std::unordered_map<std::string, uint8_t> states = states_;
+    queue_.clear();
+    lock.unlock();
+
+    std::string out(kSnapshotMagic, sizeof(kSnapshotMagic));
+    const uint32_t count = static_cast<uint32_t>(states.size());
+    out.append(reinterpret_cast<const char*>(&kByteOrderMark), 4);
+    out.append(reinterpret_cast<const char*>(&seq), 8);
+    out.append(reinterpret_cast<const char*>(&count), 4);
+    for (const auto& [module, state] : states) {
+        const uint16_t length = static_cast<uint16_t>(module.size());
+        out.push_back(static_cast<char>(state));
+        out.append(reinterpret_cast<const char*>(&length), 2);
+        out.append(module.data(), length);
+    }
+    const uint32_t crc = crc32(out.data(), out.size());
+    out.append(reinterpret_cast<const char*>(&crc), 4);
+
+    const std::string path = snapshot_path();
+    const std::string tmp = path + ".tmp";
+    bool ok = false;
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        ok = write_all(fd, out.data(), out.size()) && ::fsync(fd) == 0;
+        ok = (::close(fd) == 0) && ok;
+        if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+        if (!ok) std::remove(tmp.c_str());
+    }
+    if (ok) {
+        sync_directory(directory_);
+        // Records up to seq now live in the snapshot; a crash before this truncate only leaves
+        // records that replay skips
+        ok = ::ftruncate(fd_, 0) == 0 && ::fdatasync(fd_) == 0;
+    }
+    if (!ok) {
+        std::cerr << "State journal: cannot write snapshot '" << path << "': " << std::strerror(errno) << std::endl;
+    }
+
+    lock.lock();
+    if (ok) {
+        journal_records_ = 0;
+        failed_ = false;
+        ++stats_.compactions;
+        ++stats_.syncs;
+    }
+    committed_ = upto;
+    return ok;
+}
+
+} // namespace helix
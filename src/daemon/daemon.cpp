@@ -1,14 +1,26 @@
 #include "helix/daemon.h"
 #include "helix/version.h"
+#include "helix/archive.h"
+#include "helix/blob_store.h"
+#include "helix/json_scanner.h"
+#include "helix/metrics.h"
+#include "helix/service_registry.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <chrono>
-#include <regex>
 #include <algorithm>
+#include <cstdlib>
 #include <set>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <thread>
 #ifdef __unix__
+#include <fcntl.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -39,7 +51,13 @@ HelixDaemon::HelixDaemon()
     : modules_directory_(""), 
       module_loader_(std::make_unique<ModuleLoader>()),
       dependency_resolver_(std::make_unique<DependencyResolver>()),
-      initialized_(false) {
+      initialized_(false),
+      bringup_workers_(std::max(1u, std::min(8u, std::thread::hardware_concurrency()))) {
+    module_loader_->set_default_timeout_ms(30000);
+}
+
+void HelixDaemon::set_lifecycle_timeout_ms(unsigned timeout_ms) {
+    module_loader_->set_default_timeout_ms(timeout_ms);
 }
 
 HelixDaemon::~HelixDaemon() {
@@ -48,6 +66,19 @@ HelixDaemon::~HelixDaemon() {
     }
 }
 
+void HelixDaemon::set_preload(bool preload) {
+    preload_ = preload;
+    module_loader_->set_prefault(preload);
+}
+
+void HelixDaemon::set_bind_now(bool bind_now) {
+    module_loader_->set_bind_now(bind_now);
+}
+
+void HelixDaemon::set_module_host(const std::string& program) {
+    module_loader_->set_host_program(program);
+}
+
 bool HelixDaemon::initialize(const std::string& modules_directory) {
     if (initialized_) {
         std::cerr << "Daemon is already initialized" << std::endl;
@@ -64,12 +95,23 @@ bool HelixDaemon::initialize(const std::string& modules_directory) {
         return false;
     }
 
+    // Tells modules (e.g. FileLogger) where the daemon keeps its state; set before any module thread runs
+    std::error_code ec;
+    const auto state_dir = std::filesystem::absolute(modules_directory_, ec);
+    ::setenv("HELIX_STATE_DIR", (ec ? modules_directory_ : state_dir.string()).c_str(), 1);
+
     // Scan for existing modules
     if (!scan_modules_directory()) {
         std::cerr << "Failed to scan modules directory" << std::endl;
         return false;
     }
 
+    // A module may only use services of modules its manifest depends on
+    ServiceRegistry::instance().set_dependency_check(
+        [this](const std::string& consumer, const std::string& provider) {
+            return dependency_resolver_->depends_on(consumer, provider);
+        });
+
     initialized_ = true;
 
     // Attempt to restore previously saved module states (best-effort)
@@ -77,13 +119,14 @@ bool HelixDaemon::initialize(const std::string& modules_directory) {
         std::unordered_map<std::string, ModuleState> saved;
         if (load_saved_module_states(saved)) {
             if (!saved.empty()) {
-                std::cout << "Loaded saved module states from '" << state_file_path() << "' (" << saved.size() << ")" << std::endl;
+                std::cout << "Loaded saved module states from '" << state_journal_.journal_path() << "' ("
+                          << saved.size() << ")" << std::endl;
             } else {
-                std::cout << "No saved module state to restore (" << state_file_path() << ")" << std::endl;
+                std::cout << "No saved module state to restore (" << state_journal_.journal_path() << ")" << std::endl;
             }
             restore_saved_states(saved);
         } else {
-            std::cerr << "Failed to load saved module states from '" << state_file_path() << "'" << std::endl;
+            std::cerr << "Failed to load saved module states from '" << state_journal_.journal_path() << "'" << std::endl;
         }
     } catch (const std::exception& e) {
         std::cerr << "State restore failed: " << e.what() << std::endl;
@@ -107,23 +150,40 @@ void HelixDaemon::shutdown() {
         std::cerr << "Failed to save module states: " << e.what() << std::endl;
     }
 
+    // Take modules down dependents first, so providers outlive the modules using their services
+    std::vector<std::string> order;
+    ResolutionResult resolution = dependency_resolver_->resolve_dependencies();
+    if (resolution.success) {
+        order.assign(resolution.load_order.rbegin(), resolution.load_order.rend());
+    }
+    std::set<std::string> ordered(order.begin(), order.end());
+    for (const auto& [name, info] : module_registry_) {
+        if (!ordered.count(name)) order.push_back(name);
+    }
+
     // Stop all running modules
-    for (auto& [name, info] : module_registry_) {
-        if (info.state == ModuleState::RUNNING) {
+    for (const auto& name : order) {
+        auto it = module_registry_.find(name);
+        if (it != module_registry_.end() && it->second.state == ModuleState::RUNNING) {
             std::cout << "Stopping module: " << name << std::endl;
             stop_module(name);
         }
     }
 
     // Disable all enabled modules
-    for (auto& [name, info] : module_registry_) {
-        if (info.state == ModuleState::INITIALIZED || info.state == ModuleState::STOPPED) {
+    for (const auto& name : order) {
+        auto it = module_registry_.find(name);
+        if (it == module_registry_.end()) continue;
+        const ModuleState state = it->second.state;
+        if (state == ModuleState::LOADED || state == ModuleState::INITIALIZED || state == ModuleState::STOPPED) {
             std::cout << "Disabling module: " << name << std::endl;
             disable_module(name);
         }
     }
 
+    ServiceRegistry::instance().set_dependency_check(nullptr);
     module_registry_.clear();
+    ++registry_generation_;
     dependency_resolver_->clear();
     initialized_ = false;
     
@@ -141,100 +201,329 @@ bool HelixDaemon::install_module(const std::string& package_path) {
     // 1) A .helx archive (tar.gz) produced by helxcompiler
     std::cout << "Installing module from: " << package_path << std::endl;
 
-    std::string source_dir = package_path;
-    ModuleManifest manifest;
+    std::string package_digest;
+    if (!hash_package(package_path, package_digest)) return false;
+    for (const auto& [name, info] : module_registry_) {
+        std::error_code hec;
+        if (info.package_digest == package_digest &&
+            std::filesystem::exists(info.install_path + "/" + info.manifest.binary_path, hec)) {
+            std::cout << "Module '" << name << "' v" << info.version
+                      << " is already installed from an identical package" << std::endl;
+            return true;
+        }
+    }
 
-    // Only accept .helx
-    if (std::filesystem::is_regular_file(package_path)) {
-        auto ext = std::filesystem::path(package_path).extension().string();
-        if (ext == ".helx") {
-            // Create temp dir
-            long suffix = 0;
-#ifdef __unix__
-            suffix = static_cast<long>(::getpid());
-#else
-            suffix = static_cast<long>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-#endif
-            std::string temp_dir = modules_directory_ + "/.tmp_install_" + std::to_string(suffix);
-            try { std::filesystem::create_directories(temp_dir); } catch (...) {}
-
-            // Extract archive using exec (avoid shell)
-            int rc = run_program({"tar", "-xzf", package_path, "-C", temp_dir});
-            if (rc != 0) {
-                std::cerr << "Failed to extract .helx package: exit code " << rc << std::endl;
-                set_last_error("Extract failed: tar exit code " + std::to_string(rc));
-                std::filesystem::remove_all(temp_dir);
-                return false;
-            }
-            source_dir = temp_dir;
+    StagedPackage staged;
+    if (!stage_package(package_path, package_digest, "Install", staged)) return false;
+    const std::string module_path = place_package(staged);
+    if (module_path.empty()) return false;
+
+    // Register module
+    const ModuleManifest& manifest = staged.manifest;
+    DaemonModuleInfo module_info;
+    module_info.name = manifest.name;
+    module_info.version = manifest.version;
+    module_info.install_path = module_path;
+    module_info.manifest = manifest;
+    module_info.state = ModuleState::INSTALLED;
+    module_info.package_digest = package_digest;
+
+    module_registry_[manifest.name] = module_info;
+    ++registry_generation_;
+    state_journal_.record(manifest.name, static_cast<uint8_t>(ModuleState::INSTALLED));
+    if (state_observer_) state_observer_(manifest.name, ModuleState::UNKNOWN, ModuleState::INSTALLED, "");
+    dependency_resolver_->add_module(manifest);
+    if (preload_) {
+        ModuleLoader::readahead_file(module_path + "/" + manifest.binary_path);
+    }
 
-            // Parse manifest from extracted temp
-            if (!load_module_manifest(source_dir, manifest)) {
-                std::cerr << "Failed to load manifest from extracted package" << std::endl;
-                set_last_error("Manifest parse failed");
-                std::filesystem::remove_all(temp_dir);
-                return false;
-            }
+    std::cout << "Successfully installed module: " << manifest.name << " v" << manifest.version << std::endl;
+    return true;
+}
 
-            // Enforce minimum core version requirement before installing
-            if (!manifest.minimum_core_version.empty()) {
-                const std::string core_version = std::string(HELIX_CORE_VERSION);
-                const std::string requirement = std::string(">=") + manifest.minimum_core_version;
-                if (!DependencyResolver::version_satisfies(core_version, requirement)) {
-                    std::cerr << "Install refused: module '" << manifest.name
-                              << "' requires Helix core >= " << manifest.minimum_core_version
-                              << ", but running core is " << core_version << std::endl;
-                    set_last_error("Core version " + std::string(HELIX_CORE_VERSION) +
-                                   " does not satisfy >=" + manifest.minimum_core_version);
-                    std::filesystem::remove_all(source_dir);
-                    return false;
-                }
+bool HelixDaemon::upgrade_module(const std::string& package_path) {
+    if (!initialized_) {
+        std::cerr << "Daemon not initialized" << std::endl;
+        set_last_error("Daemon not initialized");
+        return false;
+    }
+
+    std::cout << "Upgrading module from: " << package_path << std::endl;
+
+    std::string package_digest;
+    if (!hash_package(package_path, package_digest)) return false;
+    StagedPackage staged;
+    if (!stage_package(package_path, package_digest, "Upgrade", staged)) return false;
+    const ModuleManifest& manifest = staged.manifest;
+    auto discard_staged = [&]() {
+        std::error_code ec;
+        std::filesystem::remove_all(staged.directory, ec);
+        BlobStore(modules_directory_ + "/.store").collect_garbage();
+    };
+
+    auto it = module_registry_.find(manifest.name);
+    if (it == module_registry_.end()) {
+        std::cerr << "Module '" << manifest.name << "' is not installed; use install" << std::endl;
+        set_last_error("Not installed: " + manifest.name + " (use install)");
+        discard_staged();
+        return false;
+    }
+    DaemonModuleInfo& module_info = it->second;
+    if (module_info.package_digest == package_digest) {
+        std::cout << "Module '" << manifest.name << "' v" << module_info.version
+                  << " is already installed from an identical package" << std::endl;
+        discard_staged();
+        return true;
+    }
+    const ModuleState state = module_info.state;
+    if (state == ModuleState::ERROR || module_loader_->is_module_hung(manifest.name)) {
+        std::cerr << "Cannot upgrade '" << manifest.name << "' in its current state" << std::endl;
+        set_last_error("Upgrade refused: '" + manifest.name + "' is in state " + state_to_string(state));
+        discard_staged();
+        return false;
+    }
+
+    // Every installed dependent must accept the new version
+    std::string conflicts;
+    for (const auto& dependent : dependency_resolver_->get_dependents(manifest.name)) {
+        auto dep_it = module_registry_.find(dependent);
+        if (dep_it == module_registry_.end()) continue;
+        for (const auto& dep : dep_it->second.manifest.dependencies) {
+            if (dep.name == manifest.name && !DependencyResolver::version_satisfies(manifest.version, dep.version)) {
+                if (!conflicts.empty()) conflicts += ", ";
+                conflicts += dependent + " requires " + dep.version;
+            }
+        }
+    }
+    // An active module's new requirements must already be running
+    const bool active = state == ModuleState::INITIALIZED || state == ModuleState::RUNNING ||
+                        state == ModuleState::STOPPED;
+    if (active) {
+        for (const auto& dep : manifest.dependencies) {
+            auto dep_it = module_registry_.find(dep.name);
+            const bool usable = dep_it != module_registry_.end() && dep_it->second.state == ModuleState::RUNNING &&
+                                DependencyResolver::version_satisfies(dep_it->second.version, dep.version);
+            if (!usable && !dep.optional) {
+                if (!conflicts.empty()) conflicts += ", ";
+                conflicts += "needs running " + dep.name + (dep.version.empty() ? "" : " " + dep.version);
             }
+        }
+    }
+    if (!conflicts.empty()) {
+        std::cerr << "Cannot upgrade '" << manifest.name << "' to v" << manifest.version << ": " << conflicts
+                  << std::endl;
+        set_last_error("Upgrade refused: version conflicts: " + conflicts);
+        discard_staged();
+        return false;
+    }
 
-            // Enforce minimum API version requirement before installing
-            if (!manifest.minimum_api_version.empty()) {
-                const std::string api_version = std::string(HELIX_API_VERSION);
-                const std::string requirement = std::string(">=") + manifest.minimum_api_version;
-                if (!DependencyResolver::version_satisfies(api_version, requirement)) {
-                    std::cerr << "Install refused: module '" << manifest.name
-                              << "' requires Helix API >= " << manifest.minimum_api_version
-                              << ", but running API is " << api_version << std::endl;
-                    set_last_error("API version " + std::string(HELIX_API_VERSION) +
-                                   " does not satisfy >=" + manifest.minimum_api_version);
-                    std::filesystem::remove_all(source_dir);
-                    return false;
-                }
+    const ModuleManifest previous = module_info.manifest;
+    dependency_resolver_->remove_module(manifest.name);
+    dependency_resolver_->add_module(manifest);
+    auto revert_resolver = [&]() {
+        dependency_resolver_->remove_module(manifest.name);
+        dependency_resolver_->add_module(previous);
+    };
+
+    if (active) {
+        // The new build runs from the staged tree, which becomes the install by rename
+        std::string error;
+        const std::string binary_path = staged.directory + "/" + manifest.binary_path;
+        if (!module_loader_->upgrade_module(manifest.name, binary_path, manifest.entry_points, manifest.timeouts,
+                                            manifest.linkage, module_info.version, error)) {
+            std::cerr << "Upgrade of '" << manifest.name << "' failed, v" << module_info.version
+                      << " keeps running: " << error << std::endl;
+            set_last_error("Upgrade failed: " + error);
+            revert_resolver();
+            discard_staged();
+            return false;
+        }
+    } else if (state == ModuleState::LOADED) {
+        // Mapped but never initialized: nothing to hand off. Like the active path, the new
+        // build is mapped from the staged tree, so the old install stays intact until placed.
+        const std::string& name = manifest.name;
+        auto restore_previous = [&](const std::string& reason) {
+            const std::string old_binary = module_info.install_path + "/" + previous.binary_path;
+            if (module_loader_->load_module(old_binary, name, previous.entry_points, previous.timeouts,
+                                            previous.linkage)) {
+                update_module_state(name, ModuleState::LOADED);
+            } else {
+                std::cerr << "Could not reload v" << module_info.version << " of '" << name << "'" << std::endl;
+                update_module_state(name, ModuleState::ERROR,
+                                    reason + "; reloading v" + module_info.version + " failed");
             }
+            set_last_error(reason);
+            revert_resolver();
+        };
+
+        (void)module_loader_->unload_module(name);
+        update_module_state(name, ModuleState::INSTALLED);
+        const std::string staged_binary = staged.directory + "/" + manifest.binary_path;
+        if (!module_loader_->load_module(staged_binary, name, manifest.entry_points, manifest.timeouts,
+                                         manifest.linkage)) {
+            std::cerr << "Upgrade of '" << name << "' failed: cannot load v" << manifest.version << std::endl;
+            restore_previous("Upgrade failed: load failed: " + staged_binary);
+            discard_staged();
+            return false;
+        }
+        const std::string module_path = place_package(staged);
+        if (module_path.empty()) {
+            (void)module_loader_->unload_module(name);
+            restore_previous("Upgrade failed: " + last_error_);
+            return false;
+        }
+        module_info.install_path = module_path;
+        module_info.package_digest = package_digest;
+        const std::string from_version = module_info.version;
+        module_info.version = manifest.version;
+        module_info.manifest = manifest;
+        update_module_state(name, ModuleState::LOADED);
+        std::cout << "Successfully upgraded module: " << name << " v" << from_version << " -> v"
+                  << manifest.version << std::endl;
+        return true;
+    }
 
-            // Move extracted contents into final module install location (by name)
-            std::string module_path = extract_package(source_dir, manifest.name);
-            std::filesystem::remove_all(source_dir); // cleanup temp
+    const std::string module_path = place_package(staged);
+    if (module_path.empty()) {
+        if (!active) {
+            revert_resolver();
+            return false;
+        }
+        // The new code is already serving; leave the files of the old version in place
+        std::cerr << "Module '" << manifest.name << "' was upgraded in memory, but its files are still v"
+                  << module_info.version << std::endl;
+    } else {
+        module_info.install_path = module_path;
+        module_info.package_digest = package_digest;
+    }
+    const std::string from_version = module_info.version;
+    module_info.version = manifest.version;
+    module_info.manifest = manifest;
+    module_info.error_message.clear();
+    ++registry_generation_;
+
+    std::cout << "Successfully upgraded module: " << manifest.name << " v" << from_version << " -> v"
+              << manifest.version << std::endl;
+    return true;
+}
 
-            if (module_path.empty()) {
-                std::cerr << "Failed to install extracted package" << std::endl;
-                set_last_error("Install to modules dir failed");
-                return false;
-            }
+bool HelixDaemon::hash_package(const std::string& package_path, std::string& package_digest) {
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(package_path, ec) ||
+        std::filesystem::path(package_path).extension().string() != ".helx") {
+        std::cerr << "Only .helx packages are supported" << std::endl;
+        set_last_error("Unsupported package type (expected .helx)");
+        return false;
+    }
+    std::string hash_error;
+    if (!BlobStore::hash_file(package_path, package_digest, hash_error)) {
+        std::cerr << "Failed to read .helx package: " << hash_error << std::endl;
+        set_last_error("Read failed: " + hash_error);
+        return false;
+    }
+    return true;
+}
 
-            // Register module
-            DaemonModuleInfo module_info;
-            module_info.name = manifest.name;
-            module_info.version = manifest.version;
-            module_info.install_path = module_path;
-            module_info.manifest = manifest;
-            module_info.state = ModuleState::INSTALLED;
+bool HelixDaemon::stage_package(const std::string& package_path, const std::string& package_digest,
+                                const std::string& operation, StagedPackage& staged) {
+    // Create temp dir
+    long suffix = 0;
+#ifdef __unix__
+    suffix = static_cast<long>(::getpid());
+#else
+    suffix = static_cast<long>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+#endif
+    // Staged inside the modules directory so the final move is a same-filesystem rename
+    std::string temp_dir = modules_directory_ + "/.tmp_install_" + std::to_string(suffix);
+    std::error_code tec;
+    std::filesystem::remove_all(temp_dir, tec); // leftovers of an interrupted install
+    try { std::filesystem::create_directories(temp_dir); } catch (...) {}
+
+    const auto extract_started = std::chrono::steady_clock::now();
+    if (archive_support_available()) {
+        // Decompress straight into the staging directory, in-process
+        std::string extract_error;
+        if (!extract_tar_gz(package_path, temp_dir, extract_error)) {
+            std::cerr << "Failed to extract .helx package: " << extract_error << std::endl;
+            set_last_error("Extract failed: " + extract_error);
+            std::filesystem::remove_all(temp_dir, tec);
+            return false;
+        }
+    } else {
+        // Built without zlib: extract using exec (avoid shell)
+        int rc = run_program({"tar", "-xzf", package_path, "-C", temp_dir});
+        if (rc != 0) {
+            std::cerr << "Failed to extract .helx package: exit code " << rc << std::endl;
+            set_last_error("Extract failed: tar exit code " + std::to_string(rc));
+            std::filesystem::remove_all(temp_dir, tec);
+            return false;
+        }
+    }
+    static Histogram& extract_latency = Metrics::instance().histogram(
+        "helix_install_extract_seconds", {}, "Time to extract a .helx package into the staging directory");
+    extract_latency.record(std::chrono::steady_clock::now() - extract_started);
+
+    // Parse manifest from extracted temp
+    ModuleManifest& manifest = staged.manifest;
+    if (!load_module_manifest(temp_dir, manifest)) {
+        std::cerr << "Failed to load manifest from extracted package" << std::endl;
+        set_last_error("Manifest parse failed");
+        std::filesystem::remove_all(temp_dir, tec);
+        return false;
+    }
 
-            module_registry_[manifest.name] = module_info;
-            dependency_resolver_->add_module(manifest);
+    // Enforce minimum core version requirement before installing
+    if (!manifest.minimum_core_version.empty()) {
+        const std::string core_version = std::string(HELIX_CORE_VERSION);
+        const std::string requirement = std::string(">=") + manifest.minimum_core_version;
+        if (!DependencyResolver::version_satisfies(core_version, requirement)) {
+            std::cerr << operation << " refused: module '" << manifest.name
+                      << "' requires Helix core >= " << manifest.minimum_core_version
+                      << ", but running core is " << core_version << std::endl;
+            set_last_error("Core version " + std::string(HELIX_CORE_VERSION) +
+                           " does not satisfy >=" + manifest.minimum_core_version);
+            std::filesystem::remove_all(temp_dir, tec);
+            return false;
+        }
+    }
 
-            std::cout << "Successfully installed module: " << manifest.name << " v" << manifest.version << std::endl;
-            return true;
+    // Enforce minimum API version requirement before installing
+    if (!manifest.minimum_api_version.empty()) {
+        const std::string api_version = std::string(HELIX_API_VERSION);
+        const std::string requirement = std::string(">=") + manifest.minimum_api_version;
+        if (!DependencyResolver::version_satisfies(api_version, requirement)) {
+            std::cerr << operation << " refused: module '" << manifest.name
+                      << "' requires Helix API >= " << manifest.minimum_api_version
+                      << ", but running API is " << api_version << std::endl;
+            set_last_error("API version " + std::string(HELIX_API_VERSION) +
+                           " does not satisfy >=" + manifest.minimum_api_version);
+            std::filesystem::remove_all(temp_dir, tec);
+            return false;
         }
     }
 
-    std::cerr << "Install failed: only .helx packages are supported" << std::endl;
-    set_last_error("Unsupported package type (expected .helx)");
-    return false;
+    // Share identical files with other installs
+    deduplicate_staged_tree(temp_dir);
+    staged.directory = temp_dir;
+    staged.digest = package_digest;
+    return true;
+}
+
+std::string HelixDaemon::place_package(const StagedPackage& staged) {
+    // Rename the tree into place (by name)
+    std::error_code tec;
+    std::string module_path = extract_package(staged.directory, staged.manifest.name, staged.digest);
+    std::filesystem::remove_all(staged.directory, tec); // only left behind on failure
+
+    if (module_path.empty()) {
+        std::cerr << "Failed to install extracted package" << std::endl;
+        set_last_error("Install to modules dir failed");
+        BlobStore(modules_directory_ + "/.store").collect_garbage();
+        return std::string();
+    }
+    // An upgrade may have released the previous version's blobs
+    BlobStore(modules_directory_ + "/.store").collect_garbage();
+    return module_path;
 }
 
 bool HelixDaemon::uninstall_module(const std::string& module_name) {
@@ -278,10 +567,16 @@ bool HelixDaemon::uninstall_module(const std::string& module_name) {
         set_last_error("Filesystem remove failed");
         return false;
     }
+    BlobStore(modules_directory_ + "/.store").collect_garbage();
 
     // Remove from registry and dependency resolver
     dependency_resolver_->remove_module(module_name);
+    const ModuleState removed_state = it->second.state;
     module_registry_.erase(it);
+    ++registry_generation_;
+    state_journal_.record(module_name, static_cast<uint8_t>(ModuleState::UNKNOWN));
+    if (state_observer_) state_observer_(module_name, removed_state, ModuleState::UNKNOWN, "");
+    Metrics::instance().remove_gauges("helix_module_last_lifecycle_seconds", "module", module_name);
 
     std::cout << "Successfully uninstalled module: " << module_name << std::endl;
     return true;
@@ -301,7 +596,7 @@ bool HelixDaemon::enable_module(const std::string& module_name) {
     }
 
     auto& module_info = it->second;
-    if (module_info.state != ModuleState::INSTALLED) {
+    if (module_info.state != ModuleState::INSTALLED && module_info.state != ModuleState::LOADED) {
         std::cerr << "Module '" << module_name << "' is already enabled" << std::endl;
         set_last_error("Already enabled");
         return false;
@@ -315,21 +610,27 @@ bool HelixDaemon::enable_module(const std::string& module_name) {
         return false;
     }
 
-    // Load the module
-    std::string binary_path = module_info.install_path + "/" + module_info.manifest.binary_path;
-    if (!module_loader_->load_module(binary_path, module_name, module_info.manifest.entry_points)) {
-        // Leave module in INSTALLED state to allow retry/uninstall
-        update_module_state(module_name, ModuleState::INSTALLED, "Failed to load module binary");
-        set_last_error("Load failed: " + binary_path);
-        return false;
-    }
+    // Load the module unless `prepare` already mapped it
+    if (module_info.state == ModuleState::INSTALLED) {
+        std::string binary_path = module_info.install_path + "/" + module_info.manifest.binary_path;
+        if (!call_module([&] {
+                return module_loader_->load_module(binary_path, module_name, module_info.manifest.entry_points,
+                                                   module_info.manifest.timeouts, module_info.manifest.linkage);
+            })) {
+            // Leave module in INSTALLED state to allow retry/uninstall
+            update_module_state(module_name, ModuleState::INSTALLED, "Failed to load module binary");
+            set_last_error("Load failed: " + binary_path);
+            return false;
+        }
 
-    update_module_state(module_name, ModuleState::LOADED);
+        update_module_state(module_name, ModuleState::LOADED);
+    }
 
     // Initialize the module
-    if (!module_loader_->initialize_module(module_name)) {
+    if (!call_module([&] { return module_loader_->initialize_module(module_name); })) {
+        if (mark_if_hung(module_name, "Initialize")) return false;
         // Best-effort unload and reset state
-        (void)module_loader_->unload_module(module_name);
+        (void)call_module([&] { return module_loader_->unload_module(module_name); });
         update_module_state(module_name, ModuleState::INSTALLED, "Failed to initialize module");
         set_last_error("Initialize failed");
         return false;
@@ -340,6 +641,44 @@ bool HelixDaemon::enable_module(const std::string& module_name) {
     return true;
 }
 
+bool HelixDaemon::prepare_module(const std::string& module_name) {
+    if (!initialized_) {
+        std::cerr << "Daemon not initialized" << std::endl;
+        return false;
+    }
+
+    if (module_registry_.find(module_name) == module_registry_.end()) {
+        std::cerr << "Module '" << module_name << "' is not installed" << std::endl;
+        set_last_error("Not installed: " + module_name);
+        return false;
+    }
+
+    // Dependencies first: with RTLD_NOW a module only binds once its providers are mapped
+    auto result = dependency_resolver_->resolve_dependencies({module_name});
+    if (!result.success) {
+        set_last_error("Dependency resolution failed for '" + module_name + "'");
+        return false;
+    }
+
+    for (const auto& name : result.load_order) {
+        auto it = module_registry_.find(name);
+        if (it == module_registry_.end() || it->second.state != ModuleState::INSTALLED) continue;
+        const auto& manifest = it->second.manifest;
+        std::string binary_path = it->second.install_path + "/" + manifest.binary_path;
+        if (!call_module([&] {
+                return module_loader_->load_module(binary_path, name, manifest.entry_points, manifest.timeouts,
+                                                   manifest.linkage);
+            })) {
+            set_last_error("Load failed: " + binary_path);
+            return false;
+        }
+        update_module_state(name, ModuleState::LOADED);
+    }
+
+    std::cout << "Prepared module: " << module_name << std::endl;
+    return true;
+}
+
 bool HelixDaemon::disable_module(const std::string& module_name) {
     if (!initialized_) {
         std::cerr << "Daemon not initialized" << std::endl;
@@ -359,6 +698,24 @@ bool HelixDaemon::disable_module(const std::string& module_name) {
         return false;
     }
 
+    if (module_loader_->is_module_hung(module_name)) {
+        set_last_error("Busy: a timed-out lifecycle call of '" + module_name + "' is still running");
+        return false;
+    }
+
+    // Consumers hold direct pointers into this module's service tables
+    auto consumers = ServiceRegistry::instance().consumers_of(module_name);
+    if (!consumers.empty()) {
+        std::string users;
+        for (size_t i = 0; i < consumers.size(); ++i) {
+            if (i) users += ", ";
+            users += consumers[i];
+        }
+        std::cerr << "Cannot disable '" << module_name << "': its services are in use by " << users << std::endl;
+        set_last_error("Busy: services of '" + module_name + "' are in use by " + users);
+        return false;
+    }
+
     // Stop module if it's running
     if (module_info.state == ModuleState::RUNNING) {
         if (!stop_module(module_name)) {
@@ -367,8 +724,9 @@ bool HelixDaemon::disable_module(const std::string& module_name) {
     }
 
     // Unload the module if it was actually loaded; otherwise just reset state
-    if (module_info.state == ModuleState::LOADED || module_info.state == ModuleState::INITIALIZED || module_info.state == ModuleState::RUNNING || module_info.state == ModuleState::STOPPED) {
-        if (!module_loader_->unload_module(module_name)) {
+    if (module_info.state == ModuleState::LOADED || module_info.state == ModuleState::INITIALIZED || module_info.state == ModuleState::RUNNING || module_info.state == ModuleState::STOPPED ||
+        module_loader_->is_module_loaded(module_name)) {
+        if (!call_module([&] { return module_loader_->unload_module(module_name); })) {
             update_module_state(module_name, ModuleState::ERROR, "Failed to unload module");
             set_last_error("Unload failed");
             return false;
@@ -400,7 +758,8 @@ bool HelixDaemon::start_module(const std::string& module_name) {
         return false;
     }
 
-    if (!module_loader_->start_module(module_name)) {
+    if (!call_module([&] { return module_loader_->start_module(module_name); })) {
+        if (mark_if_hung(module_name, "Start")) return false;
         // Do not leave in ERROR; remain INITIALIZED to allow retry or stop/disable
         update_module_state(module_name, ModuleState::INITIALIZED, "Failed to start module");
         set_last_error("Start failed");
@@ -432,7 +791,8 @@ bool HelixDaemon::stop_module(const std::string& module_name) {
         return false;
     }
 
-    if (!module_loader_->stop_module(module_name)) {
+    if (!call_module([&] { return module_loader_->stop_module(module_name); })) {
+        if (mark_if_hung(module_name, "Stop")) return false;
         update_module_state(module_name, ModuleState::ERROR, "Failed to stop module");
         set_last_error("Stop failed");
         return false;
@@ -443,6 +803,90 @@ bool HelixDaemon::stop_module(const std::string& module_name) {
     return true;
 }
 
+std::vector<BatchResult> HelixDaemon::run_batch(const std::vector<BatchOperation>& ops) {
+    static const std::vector<std::string> phases = {"stop", "disable", "uninstall", "install", "enable", "start"};
+    std::vector<BatchResult> results;
+    results.reserve(ops.size());
+
+    for (const auto& op : ops) {
+        if (std::find(phases.begin(), phases.end(), op.action) == phases.end()) {
+            results.push_back({op.action, op.target, false, "unknown batch action"});
+        }
+    }
+
+    std::set<std::string> failed; // modules that failed to come up in this batch
+    for (const auto& phase : phases) {
+        std::vector<std::string> targets;
+        for (const auto& op : ops) {
+            if (op.action == phase && std::find(targets.begin(), targets.end(), op.target) == targets.end()) {
+                targets.push_back(op.target);
+            }
+        }
+        if (targets.empty()) continue;
+
+        std::vector<std::string> order = targets;
+        if (phase != "install") {
+            // Dependency order over the batch targets (the resolver may add modules; keep only targets)
+            auto res = dependency_resolver_->resolve_dependencies(targets);
+            if (!res.load_order.empty()) {
+                std::set<std::string> wanted(targets.begin(), targets.end());
+                order.clear();
+                for (const auto& name : res.load_order) {
+                    if (wanted.erase(name)) order.push_back(name);
+                }
+                for (const auto& name : targets) {
+                    if (wanted.count(name)) order.push_back(name);
+                }
+            }
+            if (phase == "stop" || phase == "disable" || phase == "uninstall") {
+                std::reverse(order.begin(), order.end());
+            }
+        }
+
+        for (const auto& target : order) {
+            if (phase == "enable" || phase == "start") {
+                std::string blocked;
+                if (const auto* info = get_module_info(target)) {
+                    for (const auto& dep : info->manifest.dependencies) {
+                        if (failed.count(dep.name)) { blocked = dep.name; break; }
+                    }
+                }
+                if (!blocked.empty()) {
+                    failed.insert(target);
+                    results.push_back({phase, target, false, "skipped: dependency '" + blocked + "' failed"});
+                    continue;
+                }
+            }
+
+            // Already in the requested state (e.g. started as a dependency of an earlier enable)
+            if (const auto* info = get_module_info(target)) {
+                ModuleState st = info->state;
+                bool satisfied = (phase == "enable" && (st == ModuleState::INITIALIZED || st == ModuleState::RUNNING ||
+                                                        st == ModuleState::STOPPED)) ||
+                                 (phase == "start" && st == ModuleState::RUNNING) ||
+                                 (phase == "stop" && st == ModuleState::STOPPED) ||
+                                 (phase == "disable" && st == ModuleState::INSTALLED);
+                if (satisfied) {
+                    results.push_back({phase, target, true, std::string()});
+                    continue;
+                }
+            }
+
+            bool ok = false;
+            if (phase == "install") ok = install_module(target);
+            else if (phase == "enable") ok = enable_module(target);
+            else if (phase == "start") ok = start_module(target);
+            else if (phase == "stop") ok = stop_module(target);
+            else if (phase == "disable") ok = disable_module(target);
+            else if (phase == "uninstall") ok = uninstall_module(target);
+
+            if (!ok && (phase == "enable" || phase == "start")) failed.insert(target);
+            results.push_back({phase, target, ok, ok ? std::string() : last_error_});
+        }
+    }
+    return results;
+}
+
 const DaemonModuleInfo* HelixDaemon::get_module_info(const std::string& module_name) const {
     auto it = module_registry_.find(module_name);
     return (it != module_registry_.end()) ? &it->second : nullptr;
@@ -498,25 +942,70 @@ std::string HelixDaemon::get_status() const {
 }
 
 bool HelixDaemon::scan_modules_directory() {
+    const std::string index_path = modules_directory_ + "/.helx_index";
+    if (!module_index_loaded_) {
+        module_index_.load(index_path); // a missing or stale-format index just means a full parse
+        module_index_loaded_ = true;
+    }
+
+    ModuleIndex next;
+    size_t parsed = 0;
+    std::unordered_set<std::string> seen;
     try {
         for (const auto& entry : std::filesystem::directory_iterator(modules_directory_)) {
             if (entry.is_directory()) {
+                const std::string dir = entry.path().string();
                 // Only consider modules that were installed from .helx (marker file)
-                if (!std::filesystem::exists(entry.path() / ".helx_installed")) {
+                if (::access((dir + "/.helx_installed").c_str(), F_OK) != 0) {
                     continue;
                 }
-                ModuleManifest manifest;
-                if (load_module_manifest(entry.path().string(), manifest)) {
+                ModuleIndexEntry current;
+                current.directory = entry.path().filename().string();
+                if (!ModuleIndex::stat_manifest(dir + "/manifest.json", current)) {
+                    continue;
+                }
+                bool changed = false;
+                if (const ModuleIndexEntry* cached = module_index_.find_current(current)) {
+                    current.manifest = cached->manifest;
+                    current.package_digest = cached->package_digest;
+                } else {
+                    if (!load_module_manifest(dir, current.manifest)) {
+                        continue;
+                    }
+                    current.package_digest = read_package_digest(dir);
+                    changed = true;
+                    ++parsed;
+                }
+
+                const ModuleManifest& manifest = current.manifest;
+                seen.insert(manifest.name);
+                auto it = module_registry_.find(manifest.name);
+                if (preload_ && (changed || it == module_registry_.end())) {
+                    ModuleLoader::readahead_file(dir + "/" + manifest.binary_path);
+                }
+                if (it == module_registry_.end()) {
                     DaemonModuleInfo module_info;
                     module_info.name = manifest.name;
                     module_info.version = manifest.version;
-                    module_info.install_path = entry.path().string();
+                    module_info.install_path = dir;
                     module_info.manifest = manifest;
                     module_info.state = ModuleState::INSTALLED;
+                    module_info.package_digest = current.package_digest;
 
                     module_registry_[manifest.name] = module_info;
+                    ++registry_generation_;
+                    dependency_resolver_->add_module(manifest);
+                } else if (changed || it->second.install_path != dir) {
+                    // Changed on disk: refresh the metadata but keep the runtime state
+                    it->second.version = manifest.version;
+                    it->second.install_path = dir;
+                    it->second.manifest = manifest;
+                    it->second.package_digest = current.package_digest;
+                    ++registry_generation_;
+                    dependency_resolver_->remove_module(manifest.name);
                     dependency_resolver_->add_module(manifest);
                 }
+                next.put(std::move(current));
             }
         }
     } catch (const std::exception& e) {
@@ -524,6 +1013,22 @@ bool HelixDaemon::scan_modules_directory() {
         return false;
     }
 
+    // Directories removed behind the daemon's back: forget modules that are not loaded
+    for (auto it = module_registry_.begin(); it != module_registry_.end();) {
+        if (!seen.count(it->first) && it->second.state == ModuleState::INSTALLED) {
+            dependency_resolver_->remove_module(it->first);
+            it = module_registry_.erase(it);
+            ++registry_generation_;
+        } else {
+            ++it;
+        }
+    }
+
+    const bool dirty = parsed > 0 || next.size() != module_index_.size();
+    module_index_ = std::move(next);
+    if (dirty && !module_index_.save(index_path)) {
+        std::cerr << "Warning: could not write module index " << index_path << std::endl;
+    }
     return true;
 }
 
@@ -540,16 +1045,58 @@ bool HelixDaemon::load_module_manifest(const std::string& module_path, ModuleMan
     return true;
 }
 
-std::string HelixDaemon::extract_package(const std::string& package_path, const std::string& module_name) {
-    // Simple implementation: assume package_path is already a directory
-    // In a real implementation, this would extract a .helx archive
+void HelixDaemon::deduplicate_staged_tree(const std::string& staged_dir) {
+    BlobStore store(modules_directory_ + "/.store");
+    size_t files = 0, shared = 0;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(staged_dir, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        bool linked = false;
+        std::string error;
+        if (!store.ingest(it->path().string(), linked, error)) {
+            std::cerr << "Blob store: " << error << std::endl;
+            continue;
+        }
+        ++files;
+        if (linked) ++shared;
+    }
+    if (files != shared) {
+        std::cerr << "Blob store: " << (files - shared) << " of " << files
+                  << " files kept as private copies" << std::endl;
+    }
+}
+
+std::string HelixDaemon::read_package_digest(const std::string& module_path) {
+    std::ifstream marker(module_path + "/.helx_installed");
+    std::string line;
+    const std::string key = "package_sha256=";
+    while (std::getline(marker, line)) {
+        if (line.rfind(key, 0) == 0) return line.substr(key.size());
+    }
+    return std::string();
+}
+
+std::string HelixDaemon::extract_package(const std::string& package_path, const std::string& module_name,
+                                         const std::string& package_digest) {
+    // package_path is the staged (already extracted) tree inside modules_directory_
     std::string destination = modules_directory_ + "/" + module_name;
-    
+
     try {
-        // If destination exists (reinstall/upgrade), verify it belongs to the same module
+        // Write install marker before the tree becomes visible under its final name
+        {
+            std::ofstream marker(package_path + "/.helx_installed");
+            marker << "installed_by=helxcompiler\n";
+            if (!package_digest.empty()) marker << "package_sha256=" << package_digest << "\n";
+            if (!marker) {
+                std::cerr << "Failed to write install marker in " << package_path << std::endl;
+                return std::string();
+            }
+        }
+
         std::error_code dec;
         if (std::filesystem::exists(destination, dec)) {
-            // Try to read existing manifest to confirm identity
+            // Reinstall/upgrade: verify the directory belongs to the same module
             ModuleManifest existing;
             bool ok = false;
             try { ok = load_module_manifest(destination, existing); } catch (...) { ok = false; }
@@ -558,22 +1105,34 @@ std::string HelixDaemon::extract_package(const std::string& package_path, const
                           << "' which belongs to '" << existing.name << "'" << std::endl;
                 return std::string();
             }
-            // Safe to remove: same module or unreadable; proceed
-            std::filesystem::remove_all(destination, dec);
-        }
-        if (package_path != destination) {
-            std::filesystem::copy(package_path, destination,
-                                  std::filesystem::copy_options::recursive);
+#if defined(__linux__) && defined(RENAME_EXCHANGE)
+            // Swap old and new trees atomically; the staging path then holds the old version
+            if (::renameat2(AT_FDCWD, package_path.c_str(), AT_FDCWD, destination.c_str(), RENAME_EXCHANGE) == 0) {
+                std::filesystem::remove_all(package_path, dec);
+                return destination;
+            }
+#endif
+            // No exchange support: move the old tree aside first
+            const std::string previous = package_path + ".previous";
+            std::filesystem::remove_all(previous, dec);
+            std::filesystem::rename(destination, previous);
+            std::filesystem::rename(package_path, destination, dec);
+            if (dec) {
+                // Put the old tree back so the installed version keeps its files
+                std::error_code rec;
+                std::filesystem::rename(previous, destination, rec);
+                std::cerr << "Failed to install package: " << dec.message() << std::endl;
+                return std::string();
+            }
+            std::filesystem::remove_all(previous, dec);
+            return destination;
         }
-        // Write install marker
-        std::ofstream marker(destination + "/.helx_installed");
-        marker << "installed_by=helxcompiler\n";
-        marker.close();
+        std::filesystem::rename(package_path, destination);
     } catch (const std::exception& e) {
-        std::cerr << "Failed to extract package: " << e.what() << std::endl;
+        std::cerr << "Failed to install package: " << e.what() << std::endl;
         return "";
     }
-    
+
     return destination;
 }
 
@@ -593,12 +1152,39 @@ bool HelixDaemon::remove_module_files(const std::string& module_name) {
     return true;
 }
 
+bool HelixDaemon::call_module(const std::function<bool()>& call) {
+    if (!module_call_wrapper_) return call();
+    bool ok = false;
+    module_call_wrapper_([&] { ok = call(); });
+    return ok;
+}
+
+bool HelixDaemon::mark_if_hung(const std::string& module_name, const std::string& operation) {
+    std::string err;
+    if (module_loader_->is_module_hung(module_name)) {
+        err = operation + " timed out; module stays in Error until the call returns";
+    } else {
+        const std::string reason = module_loader_->host_exit_reason(module_name);
+        if (reason.empty()) return false;
+        err = operation + " failed: host process " + reason + "; disable the module to clean up";
+    }
+    update_module_state(module_name, ModuleState::ERROR, err);
+    set_last_error(err);
+    return true;
+}
+
 void HelixDaemon::update_module_state(const std::string& module_name, ModuleState new_state, 
                                      const std::string& error_message) {
     auto it = module_registry_.find(module_name);
     if (it != module_registry_.end()) {
+        const ModuleState old_state = it->second.state;
         it->second.state = new_state;
         it->second.error_message = error_message;
+        ++registry_generation_;
+        if (old_state != new_state) {
+            state_journal_.record(module_name, static_cast<uint8_t>(new_state));
+            if (state_observer_) state_observer_(module_name, old_state, new_state, error_message);
+        }
     }
 }
 
@@ -629,6 +1215,13 @@ bool HelixDaemon::resolve_and_load_dependencies(const std::string& module_name)
                 if (i + 1 < result.missing_deps.size()) err << ", ";
             }
         }
+        if (!result.version_conflicts.empty()) {
+            err << "; version conflicts: ";
+            for (size_t i = 0; i < result.version_conflicts.size(); ++i) {
+                err << result.version_conflicts[i];
+                if (i + 1 < result.version_conflicts.size()) err << ", ";
+            }
+        }
         if (!result.circular_deps.empty()) {
             err << "; circular: ";
             for (size_t i = 0; i < result.circular_deps.size(); ++i) {
@@ -640,33 +1233,236 @@ bool HelixDaemon::resolve_and_load_dependencies(const std::string& module_name)
         return false;
     }
 
-    // Load dependencies in order (excluding the target module itself)
-    for (const auto& dep_name : result.load_order) {
-        if (dep_name == module_name) {
-            continue; // Skip the target module itself
+    // Bring dependencies up (excluding the target module itself); all of them must end up RUNNING
+    std::vector<std::vector<std::string>> layers;
+    std::unordered_set<std::string> to_start;
+    for (const auto& layer : result.load_layers) {
+        std::vector<std::string> deps;
+        for (const auto& dep_name : layer) {
+            if (dep_name == module_name) continue;
+            deps.push_back(dep_name);
+            to_start.insert(dep_name);
         }
-        
-        auto dep_it = module_registry_.find(dep_name);
-        if (dep_it != module_registry_.end() && dep_it->second.state == ModuleState::INSTALLED) {
-            if (!enable_module(dep_name)) {
-                set_last_error(std::string("Failed to enable dependency '") + dep_name + "': " + last_error_);
-                return false;
+        if (!deps.empty()) layers.push_back(std::move(deps));
+    }
+    if (!layers.empty() && !parallel_bring_up(layers, to_start)) {
+        set_last_error("Failed to enable dependency " + last_error_);
+        return false;
+    }
+
+    return true;
+}
+
+bool HelixDaemon::parallel_bring_up(const std::vector<std::vector<std::string>>& layers,
+                                    const std::unordered_set<std::string>& to_start) {
+    using clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](clock::time_point from, clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    struct Job {
+        std::string name;
+        std::string binary_path;
+        EntryPoints entry_points;
+        LifecycleTimeouts timeouts;
+        ModuleLinkage linkage;
+        ModuleState initial = ModuleState::INSTALLED;
+        bool start = false;
+        size_t pending_deps = 0;
+        std::vector<size_t> dependents;
+        bool runnable = true;         // false: skipped without touching the registry entry
+        // Filled in by the worker (error may be preset to skip the job)
+        bool ok = false;
+        ModuleState reached = ModuleState::INSTALLED;
+        std::string error;
+        double load_ms = 0, init_ms = 0, start_ms = 0;
+    };
+
+    std::vector<Job> jobs;
+    std::unordered_map<std::string, size_t> index;
+    for (const auto& layer : layers) {
+        for (const auto& name : layer) {
+            auto it = module_registry_.find(name);
+            if (it == module_registry_.end() || index.count(name)) continue;
+            ModuleState st = it->second.state;
+            if (st == ModuleState::RUNNING) continue; // already where any target wants it
+            Job job;
+            job.name = name;
+            job.binary_path = it->second.install_path + "/" + it->second.manifest.binary_path;
+            job.entry_points = it->second.manifest.entry_points;
+            job.timeouts = it->second.manifest.timeouts;
+            job.linkage = it->second.manifest.linkage;
+            job.initial = st;
+            job.reached = st;
+            if (st != ModuleState::INSTALLED && st != ModuleState::LOADED && st != ModuleState::INITIALIZED &&
+                st != ModuleState::STOPPED) {
+                job.runnable = false;
+                job.error = "cannot bring up from state " + state_to_string(st);
             }
+            index[name] = jobs.size();
+            jobs.push_back(std::move(job));
+        }
+    }
+    if (jobs.empty()) return true;
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        for (const auto& dep : dependency_resolver_->get_dependencies(jobs[i].name)) {
+            auto d = index.find(dep);
+            if (d == index.end()) continue; // not part of this bring-up (already RUNNING)
+            ++jobs[i].pending_deps;
+            jobs[d->second].dependents.push_back(i);
         }
-        // Ensure dependency is running (not just enabled), per requirement
-        dep_it = module_registry_.find(dep_name);
-        if (dep_it != module_registry_.end() && dep_it->second.state != ModuleState::RUNNING) {
-            // If it's initialized or stopped, start it
-            if (dep_it->second.state == ModuleState::INITIALIZED || dep_it->second.state == ModuleState::STOPPED) {
-                if (!start_module(dep_name)) {
-                    set_last_error(std::string("Failed to start dependency '") + dep_name + "': " + last_error_);
-                    return false;
+    }
+    for (auto& job : jobs) {
+        job.start = to_start.count(job.name) > 0 || !job.dependents.empty();
+    }
+
+    auto run_job = [&](Job& job) {
+        auto t0 = clock::now();
+        if (job.initial == ModuleState::INSTALLED || job.initial == ModuleState::LOADED) {
+            if (job.initial == ModuleState::INSTALLED &&
+                !module_loader_->load_module(job.binary_path, job.name, job.entry_points, job.timeouts, job.linkage)) {
+                job.error = "Load failed: " + job.binary_path;
+                return;
+            }
+            auto t1 = clock::now();
+            job.load_ms = elapsed_ms(t0, t1);
+            if (!module_loader_->initialize_module(job.name)) {
+                if (module_loader_->is_module_hung(job.name)) {
+                    job.reached = ModuleState::ERROR;
+                    job.error = "Initialize timed out";
+                    return;
                 }
+                (void)module_loader_->unload_module(job.name);
+                job.reached = ModuleState::INSTALLED;
+                job.error = "Initialize failed";
+                return;
+            }
+            job.reached = ModuleState::INITIALIZED;
+            t0 = clock::now();
+            job.init_ms = elapsed_ms(t1, t0);
+        }
+        if (job.start) {
+            if (!module_loader_->start_module(job.name)) {
+                const std::string lost = module_loader_->host_exit_reason(job.name);
+                if (module_loader_->is_module_hung(job.name) || !lost.empty()) job.reached = ModuleState::ERROR;
+                job.error = !lost.empty() ? "Start failed: host process " + lost
+                            : job.reached == ModuleState::ERROR ? "Start timed out" : "Start failed";
+                return;
             }
+            job.reached = ModuleState::RUNNING;
+            job.start_ms = elapsed_ms(t0, clock::now());
+        }
+        job.ok = true;
+    };
+
+    std::mutex mutex;
+    std::condition_variable work_cv, done_cv;
+    std::deque<size_t> ready, completed;
+    bool quit = false;
+    size_t unresolved = jobs.size();
+    size_t failures = 0;
+
+    // Jobs that already carry an error complete without running
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (jobs[i].pending_deps == 0) {
+            (jobs[i].error.empty() ? ready : completed).push_back(i);
         }
     }
 
-    return true;
+    size_t width = 0;
+    for (const auto& layer : layers) width = std::max(width, layer.size());
+    const size_t nthreads = std::min(bringup_workers_, std::min(width, jobs.size()));
+    auto t_begin = clock::now();
+    std::vector<std::thread> workers;
+    if (nthreads > 1) {
+        for (size_t t = 0; t < nthreads; ++t) {
+            workers.emplace_back([&]() {
+                std::unique_lock<std::mutex> lock(mutex);
+                for (;;) {
+                    work_cv.wait(lock, [&]() { return quit || !ready.empty(); });
+                    if (quit) return;
+                    size_t i = ready.front();
+                    ready.pop_front();
+                    lock.unlock();
+                    run_job(jobs[i]);
+                    lock.lock();
+                    completed.push_back(i);
+                    done_cv.notify_one();
+                }
+            });
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (unresolved > 0) {
+        if (workers.empty() && completed.empty()) {
+            // Serial mode: run the next ready job on this thread
+            if (ready.empty()) break; // cannot happen for acyclic layers
+            size_t i = ready.front();
+            ready.pop_front();
+            lock.unlock();
+            call_module([&] {
+                run_job(jobs[i]);
+                return true;
+            });
+            lock.lock();
+            completed.push_back(i);
+        }
+        if (completed.empty()) {
+            // Workers run module code; the registry is only updated below
+            call_module([&] {
+                done_cv.wait(lock, [&]() { return !completed.empty(); });
+                return true;
+            });
+        }
+        size_t i = completed.front();
+        completed.pop_front();
+        --unresolved;
+        Job& job = jobs[i];
+
+        // Registry updates stay on the calling thread
+        if (job.ok) {
+            update_module_state(job.name, job.reached);
+            std::cout << "Brought up '" << job.name << "' (" << state_to_string(job.reached) << ") in "
+                      << std::fixed << std::setprecision(1) << (job.load_ms + job.init_ms + job.start_ms)
+                      << " ms: load " << job.load_ms << " ms, init " << job.init_ms << " ms, start "
+                      << job.start_ms << " ms" << std::defaultfloat << std::endl;
+        } else {
+            ++failures;
+            if (job.runnable) update_module_state(job.name, job.reached, job.error);
+            std::cerr << "Bring-up failed for '" << job.name << "': " << job.error << std::endl;
+        }
+
+        for (size_t d : job.dependents) {
+            Job& dependent = jobs[d];
+            if (!job.ok && dependent.error.empty()) dependent.error = "skipped: dependency '" + job.name + "' failed";
+            if (--dependent.pending_deps == 0) {
+                (dependent.error.empty() ? ready : completed).push_back(d);
+            }
+        }
+        work_cv.notify_all();
+    }
+    quit = true;
+    lock.unlock();
+    work_cv.notify_all();
+    for (auto& w : workers) w.join();
+
+    std::cout << "Brought up " << (jobs.size() - failures) << "/" << jobs.size() << " modules in "
+              << std::fixed << std::setprecision(1) << elapsed_ms(t_begin, clock::now()) << std::defaultfloat
+              << " ms using " << std::max<size_t>(1, workers.size()) << " worker(s)" << std::endl;
+
+    if (failures == 0) return true;
+    for (const auto& layer : layers) {
+        for (const auto& name : layer) {
+            auto it = index.find(name);
+            if (it != index.end() && !jobs[it->second].ok) {
+                set_last_error("'" + name + "': " + jobs[it->second].error);
+                return false;
+            }
+        }
+    }
+    return false;
 }
 
 std::string HelixDaemon::state_to_string(ModuleState state) {
@@ -697,125 +1493,119 @@ std::string HelixDaemon::state_file_path() const {
     return modules_directory_ + "/.helix_state.json";
 }
 
-bool HelixDaemon::save_module_states() const {
-    // We persist only high-level states we can restore: Installed, Initialized, Running, Stopped
-    // Error/Loaded will be treated conservatively.
-    const std::string path = state_file_path();
-    std::ofstream ofs(path, std::ios::trunc);
-    if (!ofs.is_open()) {
-        std::cerr << "Could not open state file for writing: " << path << std::endl;
+bool HelixDaemon::save_module_states() {
+    // Every transition is already journaled; fold the journal into a snapshot and stop recording
+    if (!state_journal_.is_open()) return true;
+    if (!state_journal_.close()) {
+        std::cerr << "Could not write module state snapshot: " << state_journal_.snapshot_path() << std::endl;
+        return false;
+    }
+    std::cout << "Saved module states to '" << state_journal_.snapshot_path() << "'" << std::endl;
+    return true;
+}
+
+bool HelixDaemon::load_saved_module_states(std::unordered_map<std::string, ModuleState>& out_states) {
+    out_states.clear();
+    std::unordered_map<std::string, uint8_t> codes;
+    std::string error;
+    if (!state_journal_.open(modules_directory_, codes, error)) {
+        std::cerr << "State journal: " << error << std::endl;
         return false;
     }
+    for (const auto& [name, code] : codes) {
+        if (code <= static_cast<uint8_t>(ModuleState::ERROR)) out_states[name] = static_cast<ModuleState>(code);
+        // Forget modules that were removed from the modules directory behind our back
+        if (!module_registry_.count(name)) state_journal_.record(name, static_cast<uint8_t>(ModuleState::UNKNOWN));
+    }
 
-    ofs << "{\n  \"modules\": {\n";
-    size_t count = 0;
-    const size_t total = module_registry_.size();
-    for (const auto& kv : module_registry_) {
-        const auto& name = kv.first;
-        const auto& info = kv.second;
-        ofs << "    \"" << name << "\": { \"state\": \"" << state_to_string(info.state) << "\" }";
-        if (++count < total) ofs << ",";
-        ofs << "\n";
+    // Migrate the JSON file of earlier releases once; the journal is authoritative afterwards
+    const std::string legacy = state_file_path();
+    if (codes.empty() && ::access(legacy.c_str(), F_OK) == 0) {
+        if (!load_legacy_state_file(out_states)) return true;
+        for (const auto& [name, state] : out_states) codes[name] = static_cast<uint8_t>(state);
+        if (state_journal_.import(codes)) {
+            std::remove(legacy.c_str());
+            std::cout << "Migrated " << out_states.size() << " module state(s) from '" << legacy << "' to '"
+                      << state_journal_.snapshot_path() << "'" << std::endl;
+        }
     }
-    ofs << "  }\n}";
-    ofs.close();
-    std::cout << "Saved module states to '" << path << "'" << std::endl;
     return true;
 }
 
-bool HelixDaemon::load_saved_module_states(std::unordered_map<std::string, ModuleState>& out_states) const {
+bool HelixDaemon::load_legacy_state_file(std::unordered_map<std::string, ModuleState>& out_states) const {
     out_states.clear();
     const std::string path = state_file_path();
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
         // No state saved yet is not an error
         return true;
     }
-    std::stringstream buf; buf << ifs.rdbuf();
-    const std::string content = buf.str();
-    ifs.close();
-
-    // Extremely small and tolerant parser.
-    // We specifically scope to the top-level object at key "modules" and parse entries of the form:
-    //   "name": { "state": "Value" }
-    // This avoids bringing in a JSON dependency while ensuring we don't accidentally treat
-    // the top-level key "modules" itself as a module entry.
-    try {
-        // Locate the "modules" object block
-        const std::string modules_key = "\"modules\"";
-        size_t key_pos = content.find(modules_key);
-        if (key_pos == std::string::npos) {
-            // Be tolerant: treat as having nothing to restore
-            std::cerr << "State file '" << path << "' has no 'modules' key" << std::endl;
-            return true;
-        }
-
-        // Find the opening brace for the modules object after the key
-        size_t brace_start = content.find('{', key_pos + modules_key.size());
-        if (brace_start == std::string::npos) {
-            std::cerr << "State file '" << path << "': malformed 'modules' object" << std::endl;
-            return true;
-        }
-
-        // Find the matching closing brace by tracking nesting
-        size_t i = brace_start;
-        int depth = 0;
-        bool in_string = false;
-        for (; i < content.size(); ++i) {
-            char c = content[i];
-            if (c == '"') {
-                // Toggle in_string if not escaped
-                bool escaped = (i > 0 && content[i-1] == '\\');
-                if (!escaped) in_string = !in_string;
+    std::string content;
+    char buf[8192];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), file)) > 0) content.append(buf, n);
+    std::fclose(file);
+
+    // Tolerant single pass: { "modules": { "<name>": { "state": "<State>", ... }, ... }, ... }
+    // Unknown members and non-object entries are skipped; a malformed file restores nothing.
+    JsonScanner in(content);
+    std::string_view key, field;
+    std::string name, state_s;
+    bool found_modules = false;
+    size_t parsed = 0;
+    if (in.enter_object()) {
+        while (in.next_member(key)) {
+            if (key != "modules" || in.peek() != JsonScanner::Type::Object) {
+                in.skip_value();
+                continue;
             }
-            if (in_string) continue;
-            if (c == '{') {
-                ++depth;
-            } else if (c == '}') {
-                --depth;
-                if (depth == 0) {
-                    break; // 'i' is the matching closing brace
+            found_modules = true;
+            in.enter_object();
+            while (in.next_member(key)) {
+                name.assign(key.data(), key.size());
+                if (in.peek() != JsonScanner::Type::Object) {
+                    in.skip_value();
+                    continue;
+                }
+                in.enter_object();
+                state_s.clear();
+                while (in.next_member(field)) {
+                    if (field == "state" && in.peek() == JsonScanner::Type::String) in.read_string(state_s);
+                    else in.skip_value();
+                }
+                if (!state_s.empty()) {
+                    out_states[name] = state_from_string(state_s);
+                    ++parsed;
                 }
             }
         }
-
-        if (i >= content.size()) {
-            std::cerr << "State file '" << path << "': unterminated 'modules' object" << std::endl;
-            return true;
-        }
-
-        const size_t brace_end = i; // inclusive index of '}'
-        const std::string modules_block = content.substr(brace_start + 1, brace_end - brace_start - 1);
-
-        // Now parse immediate entries within the modules block
-        // Raw string for clarity; ECMAScript regex used by std::regex requires \} to match a literal '}'
-        std::regex entry_regex(R"regex("([^"]+)"\s*:\s*\{[^}]*"state"\s*:\s*"([^"]+)"[^}]*\})regex");
-        std::sregex_iterator it(modules_block.begin(), modules_block.end(), entry_regex);
-        std::sregex_iterator end;
-        size_t parsed = 0;
-        for (; it != end; ++it) {
-            const std::string name = (*it)[1].str();
-            const std::string state_s = (*it)[2].str();
-            if (name == "modules") {
-                // Defensive: skip any accidental capture of the container key
-                continue;
-            }
-            out_states[name] = state_from_string(state_s);
-            ++parsed;
-        }
-        if (parsed == 0) {
-            std::cerr << "State file '" << path << "' contained no module entries" << std::endl;
-        }
+    }
+    if (in.failed()) {
+        std::cerr << "State file '" << path << "' is malformed: " << in.error() << std::endl;
+        out_states.clear();
         return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to parse state file: " << e.what() << std::endl;
-        return false;
     }
+    if (!found_modules) {
+        // Be tolerant: treat as having nothing to restore
+        std::cerr << "State file '" << path << "' has no 'modules' key" << std::endl;
+    } else if (parsed == 0) {
+        std::cerr << "State file '" << path << "' contained no module entries" << std::endl;
+    }
+    return true;
 }
 
 void HelixDaemon::restore_saved_states(const std::unordered_map<std::string, ModuleState>& saved_states) {
     if (saved_states.empty()) return;
 
+    // Map modules that were only prepared; the bring-up below continues from Loaded
+    for (const auto& [name, desired_state] : saved_states) {
+        auto it = module_registry_.find(name);
+        if (desired_state == ModuleState::LOADED && it != module_registry_.end() &&
+            it->second.state == ModuleState::INSTALLED && !prepare_module(name)) {
+            std::cerr << "Restore: prepare failed for '" << name << "': " << last_error_ << std::endl;
+        }
+    }
+
     // First, enable modules that were at least enabled previously (Initialized/Running/Stopped)
     // Compute a global dependency-aware order.
     std::vector<std::string> to_enable_vec;
@@ -832,9 +1622,18 @@ void HelixDaemon::restore_saved_states(const std::unordered_map<std::string, Mod
 
     if (!to_enable_vec.empty()) {
         auto res = dependency_resolver_->resolve_dependencies(to_enable_vec);
-        if (!res.success) {
-            std::cerr << "Restore: dependency resolution reported issues; proceeding with simple order" << std::endl;
+        if (res.success) {
+            // Bring everything up in one parallel, dependency-ordered pass
+            std::unordered_set<std::string> to_start;
+            for (const auto& [name, desired_state] : saved_states) {
+                if (desired_state == ModuleState::RUNNING) to_start.insert(name);
+            }
+            if (!parallel_bring_up(res.load_layers, to_start)) {
+                std::cerr << "Restore: some modules failed to come up; first failure " << last_error_ << std::endl;
+            }
+            return;
         }
+        std::cerr << "Restore: dependency resolution reported issues; proceeding with simple order" << std::endl;
         const auto& order = res.load_order.empty() ? to_enable_vec : res.load_order;
         std::set<std::string> enable_set(to_enable_vec.begin(), to_enable_vec.end());
         for (const auto& name : order) {
@@ -0,0 +1,303 @@
+#include "event_hub.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <utility>
+
+namespace helix {
+
+namespace {
+
+void append_json_string(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back(ch);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+// Every event is one line; fold embedded line breaks
+std::string one_line(const char* s, size_t n) {
+    std::string out(s, n);
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r')) out.pop_back();
+    std::replace(out.begin(), out.end(), '\n', ' ');
+    std::replace(out.begin(), out.end(), '\r', ' ');
+    return out;
+}
+
+const char* level_name(int level) {
+    switch (level) {
+        case HELIX_LOG_DEBUG: return "DEBUG";
+        case HELIX_LOG_INFO: return "INFO";
+        case HELIX_LOG_WARN: return "WARN";
+        case HELIX_LOG_ERROR: return "ERROR";
+        default: return "LOG";
+    }
+}
+
+std::string dropped_line(uint64_t count, bool json) {
+    return json ? "{\"event\":\"dropped\",\"count\":" + std::to_string(count) + "}\n"
+                : "dropped " + std::to_string(count) + "\n";
+}
+
+} // namespace
+
+class EventHub::Subscription : public IpcServer::Stream {
+public:
+    Subscription(EventHub& hub, std::shared_ptr<Subscriber> sub) : hub_(hub), sub_(std::move(sub)) {}
+    ~Subscription() override { hub_.unsubscribe(sub_); }
+
+    void attach(std::function<void()> notify) override {
+        std::lock_guard<std::mutex> lock(hub_.mtx_);
+        sub_->notify = std::move(notify);
+        sub_->notified = true; // the server drains right after attaching
+    }
+
+    void drain(std::string& out) override { hub_.drain(*sub_, out); }
+
+private:
+    EventHub& hub_;
+    std::shared_ptr<Subscriber> sub_;
+};
+
+EventHub::EventHub(const HelixDaemon& daemon, size_t capacity)
+    : daemon_(daemon), capacity_(capacity ? capacity : 1) {}
+
+EventHub::~EventHub() {
+    {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        metrics_stop_ = true;
+    }
+    metrics_cv_.notify_all();
+    if (metrics_thread_.joinable()) metrics_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        subscribers_.clear();
+        subscribed_topics_ = 0;
+    }
+    update_log_sink();
+}
+
+bool EventHub::parse_command(const std::string& line, unsigned& topics, bool& json, std::string& error) {
+    std::istringstream in(line);
+    std::string word;
+    in >> word; // "subscribe"
+    topics = 0;
+    json = false;
+    while (in >> word) {
+        if (word == "states") topics |= kStates;
+        else if (word == "logs") topics |= kLogs;
+        else if (word == "metrics") topics |= kMetrics;
+        else if (word == "--json") json = true;
+        else {
+            error = "subscribe: unknown topic '" + word + "' (expected states, logs or metrics)";
+            return false;
+        }
+    }
+    if (topics == 0) topics = kStates;
+    return true;
+}
+
+std::shared_ptr<IpcServer::Stream> EventHub::subscribe(unsigned topics, bool json) {
+    auto sub = std::make_shared<Subscriber>();
+    sub->topics = topics;
+    sub->json = json;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (topics & kStates) {
+            // Start from the current states; names are sorted so the snapshot is stable
+            std::vector<std::string> names = daemon_.list_modules();
+            std::sort(names.begin(), names.end());
+            for (const auto& name : names) {
+                const DaemonModuleInfo* info = daemon_.get_module_info(name);
+                if (!info) continue;
+                auto event = std::make_shared<Event>();
+                const std::string state = HelixDaemon::state_to_string(info->state);
+                event->text = "state " + name + " " + state + "\n";
+                event->json = "{\"event\":\"state\",\"module\":";
+                append_json_string(event->json, name);
+                event->json += ",\"state\":";
+                append_json_string(event->json, state);
+                event->json += "}\n";
+                enqueue_locked(*sub, std::move(event));
+            }
+        }
+        subscribers_.push_back(sub);
+        subscribed_topics_ |= topics;
+    }
+    if (topics & kLogs) update_log_sink();
+    if (topics & kMetrics) {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        if (!metrics_thread_.joinable() && !metrics_stop_) metrics_thread_ = std::thread([this] { metrics_loop(); });
+    }
+    return std::make_shared<Subscription>(*this, std::move(sub));
+}
+
+void EventHub::publish_state(const std::string& module, ModuleState from, ModuleState to, const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!(subscribed_topics_ & kStates)) return;
+    }
+    auto event = std::make_shared<Event>();
+    const std::string from_name = HelixDaemon::state_to_string(from);
+    const std::string to_name = HelixDaemon::state_to_string(to);
+    event->text = "state " + module + " " + from_name + " " + to_name;
+    if (!error.empty()) event->text += ": " + one_line(error.data(), error.size());
+    event->text += "\n";
+    event->json = "{\"event\":\"state\",\"module\":";
+    append_json_string(event->json, module);
+    event->json += ",\"from\":";
+    append_json_string(event->json, from_name);
+    event->json += ",\"to\":";
+    append_json_string(event->json, to_name);
+    if (!error.empty()) {
+        event->json += ",\"error\":";
+        append_json_string(event->json, error);
+    }
+    event->json += "}\n";
+    std::vector<std::shared_ptr<const Event>> events;
+    events.push_back(std::move(event));
+    publish(kStates, std::move(events));
+}
+
+void EventHub::publish(unsigned topic, std::vector<std::shared_ptr<const Event>> events) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& sub : subscribers_) {
+        if (!(sub->topics & topic)) continue;
+        for (const auto& event : events) enqueue_locked(*sub, event);
+    }
+}
+
+void EventHub::enqueue_locked(Subscriber& sub, std::shared_ptr<const Event> event) {
+    if (sub.queue.size() >= capacity_) {
+        ++sub.pending_drops;
+        return;
+    }
+    sub.queue.push_back(Entry{std::move(event), sub.pending_drops});
+    sub.pending_drops = 0;
+    if (!sub.notified && sub.notify) {
+        sub.notified = true;
+        sub.notify();
+    }
+}
+
+void EventHub::drain(Subscriber& sub, std::string& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t n = 0; n < kDrainBatch && !sub.queue.empty(); ++n) {
+        Entry& entry = sub.queue.front();
+        if (entry.dropped_before) out += dropped_line(entry.dropped_before, sub.json);
+        out += sub.json ? entry.event->json : entry.event->text;
+        sub.queue.pop_front();
+    }
+    if (sub.queue.empty()) {
+        if (sub.pending_drops) {
+            out += dropped_line(sub.pending_drops, sub.json);
+            sub.pending_drops = 0;
+        }
+        sub.notified = false;
+    }
+}
+
+void EventHub::unsubscribe(const std::shared_ptr<Subscriber>& sub) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        subscribers_.erase(std::remove(subscribers_.begin(), subscribers_.end(), sub), subscribers_.end());
+        subscribed_topics_ = 0;
+        for (const auto& other : subscribers_) subscribed_topics_ |= other->topics;
+    }
+    if (sub->topics & kLogs) update_log_sink();
+}
+
+// Register the log sink while there are log subscribers and remove it after the last one
+void EventHub::update_log_sink() {
+    std::lock_guard<std::mutex> sink_lock(sink_mtx_);
+    bool wanted;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        wanted = (subscribed_topics_ & kLogs) != 0;
+    }
+    if (wanted == sink_registered_) return;
+    if (wanted) {
+        if (auto reg = helix_log_get_register_v2()) {
+            reg(&EventHub::on_log_records, this);
+            sink_registered_ = true;
+        }
+    } else if (auto unreg = helix_log_get_unregister_v2()) {
+        unreg(&EventHub::on_log_records, this);
+        sink_registered_ = false;
+    }
+}
+
+void EventHub::on_log_records(const HelixLogRecord* records, size_t count, void* user) {
+    auto* hub = static_cast<EventHub*>(user);
+    std::vector<std::shared_ptr<const Event>> events;
+    events.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const HelixLogRecord& rec = records[i];
+        const std::string module = rec.module ? rec.module : "(unknown)";
+        const std::string message = rec.message ? one_line(rec.message, rec.message_len) : std::string();
+        auto event = std::make_shared<Event>();
+        event->text = std::string("log ") + level_name(rec.level) + " " + module + " " + message + "\n";
+        event->json = "{\"event\":\"log\",\"level\":\"";
+        event->json += level_name(rec.level);
+        event->json += "\",\"module\":";
+        append_json_string(event->json, module);
+        event->json += ",\"message\":";
+        append_json_string(event->json, rec.message ? std::string(rec.message, rec.message_len) : std::string());
+        event->json += ",\"thread\":" + std::to_string(rec.thread_id) + ",\"ts_ns\":" + std::to_string(rec.timestamp_ns) + "}\n";
+        events.push_back(std::move(event));
+    }
+    hub->publish(kLogs, std::move(events));
+}
+
+void EventHub::metrics_loop() {
+    Metrics::Baseline baseline;
+    std::string text, json;
+    Metrics::instance().render_deltas(baseline, text, json); // deltas start now
+    std::unique_lock<std::mutex> lock(metrics_mtx_);
+    while (!metrics_cv_.wait_for(lock, std::chrono::milliseconds(kMetricsIntervalMs), [this] { return metrics_stop_; })) {
+        lock.unlock();
+        text.clear();
+        json.clear();
+        Metrics::instance().render_deltas(baseline, text, json);
+        bool wanted;
+        {
+            std::lock_guard<std::mutex> hub_lock(mtx_);
+            wanted = (subscribed_topics_ & kMetrics) != 0;
+        }
+        if (wanted && !text.empty()) {
+            // One event per histogram; the text and JSON renderings list them in the same order
+            std::vector<std::shared_ptr<const Event>> events;
+            size_t tp = 0, jp = 0;
+            while (tp < text.size() && jp < json.size()) {
+                const size_t tn = text.find('\n', tp), jn = json.find('\n', jp);
+                auto event = std::make_shared<Event>();
+                event->text = "metrics " + text.substr(tp, tn - tp + 1);
+                event->json = "{\"event\":\"metrics\"," + json.substr(jp + 1, jn - jp);
+                events.push_back(std::move(event));
+                tp = tn + 1;
+                jp = jn + 1;
+            }
+            publish(kMetrics, std::move(events));
+        }
+        lock.lock();
+    }
+}
+
+} // namespace helix
@@ -0,0 +1,105 @@
+#ifndef HELIX_EVENT_HUB_H
+#define HELIX_EVENT_HUB_H
+
+#include "helix/daemon.h"
+#include "helix/log.h"
+#include "helix/metrics.h"
+#include "ipc_server.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace helix {
+
+// Fan-out of daemon events to `subscribe` connections.
+//
+// Topics are module state changes (fed by HelixDaemon's state observer), log
+// records (the hub is a log sink while anyone subscribes to logs) and, once a
+// second, the latency histograms that recorded values (Metrics::render_deltas).
+// Each event is formatted once, as a text line and a JSON line, and queued to
+// every subscriber of its topic. A subscriber queues at most `capacity` events;
+// beyond that new events are dropped and counted, and the count is sent as a
+// "dropped <n>" line in the place the events went missing. Publishers never wait
+// for a client.
+//
+// Callers must hold off daemon mutations while calling subscribe() (the IPC
+// server's read lock does this), so the snapshot it starts with is consistent
+// with the changes that follow.
+class EventHub {
+public:
+    enum Topic : unsigned { kStates = 1u << 0, kLogs = 1u << 1, kMetrics = 1u << 2 };
+
+    static constexpr size_t kDefaultCapacity = 4096; // events queued per subscriber
+    static constexpr size_t kDrainBatch = 256;       // events per write to the connection
+    static constexpr int kMetricsIntervalMs = 1000;
+
+    explicit EventHub(const HelixDaemon& daemon, size_t capacity = kDefaultCapacity);
+    ~EventHub();
+
+    EventHub(const EventHub&) = delete;
+    EventHub& operator=(const EventHub&) = delete;
+
+    // "subscribe [states] [logs] [metrics] [--json]"; no topic means states.
+    static bool parse_command(const std::string& line, unsigned& topics, bool& json, std::string& error);
+
+    // New subscriber. A states subscription starts with one line per installed module.
+    std::shared_ptr<IpcServer::Stream> subscribe(unsigned topics, bool json);
+
+    // Hook for HelixDaemon::set_state_observer()
+    void publish_state(const std::string& module, ModuleState from, ModuleState to, const std::string& error);
+
+private:
+    struct Event {
+        std::string text;
+        std::string json;
+    };
+    struct Entry {
+        std::shared_ptr<const Event> event;
+        uint64_t dropped_before = 0; // events this subscriber lost just ahead of this one
+    };
+    struct Subscriber {
+        unsigned topics = 0;
+        bool json = false;
+        std::deque<Entry> queue;
+        uint64_t pending_drops = 0;  // lost since the last queued event
+        std::function<void()> notify;
+        bool notified = false;       // notify() was called and drain() has not emptied the queue
+    };
+    class Subscription;
+
+    void publish(unsigned topic, std::vector<std::shared_ptr<const Event>> events);
+    void enqueue_locked(Subscriber& sub, std::shared_ptr<const Event> event);
+    void drain(Subscriber& sub, std::string& out);
+    void unsubscribe(const std::shared_ptr<Subscriber>& sub);
+    void update_log_sink();
+    void metrics_loop();
+
+    static void on_log_records(const HelixLogRecord* records, size_t count, void* user);
+
+    const HelixDaemon& daemon_;
+    const size_t capacity_;
+
+    std::mutex mtx_; // subscribers and their queues
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+    unsigned subscribed_topics_ = 0;
+
+    // Registering or removing the log sink waits for running sink calls, which take
+    // mtx_, so it happens under this mutex instead
+    std::mutex sink_mtx_;
+    bool sink_registered_ = false;
+
+    std::mutex metrics_mtx_;
+    std::condition_variable metrics_cv_;
+    bool metrics_stop_ = false;
+    std::thread metrics_thread_;
+};
+
+} // namespace helix
+
+#endif // HELIX_EVENT_HUB_H
@@ -0,0 +1,230 @@
+// Wrappers around the libc calls that create and close file descriptors, so
+// ResourceAccounting can charge each descriptor to the module whose code opened it.
+// helixd exports its symbols (--export-dynamic), so these definitions take precedence
+// over libc's for the daemon and for every module it loads; each one forwards to the
+// next definition (libc's) found with dlsym(RTLD_NEXT).
+//
+// Only calls made while the thread is attributed to a module do any accounting;
+// the daemon's own calls check that and go straight to libc. close() still looks
+// up the owner, since the daemon may close a module's descriptor.
+//
+// Descriptors libc opens internally (getaddrinfo(), opendir(), ...) bypass the
+// wrappers and are not attributed. Under _FORTIFY_SOURCE, <fcntl.h> declares
+// open() and friends gnu_inline, so the definitions below are still the
+// out-of-line ones and the rest of the file keeps its checks.
+
+#include "helix/resource_accounting.h"
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+void* next_definition(std::atomic<void*>& cache, const char* name) {
+    void* fn = cache.load(std::memory_order_acquire);
+    if (!fn) {
+        fn = dlsym(RTLD_NEXT, name);
+        cache.store(fn, std::memory_order_release);
+    }
+    return fn;
+}
+
+#define HELIX_NEXT(name) \
+    ([]() { \
+        static std::atomic<void*> cache{nullptr}; \
+        return reinterpret_cast<decltype(&::name)>(next_definition(cache, #name)); \
+    }())
+
+// Whether the calling thread runs module code; everything else bypasses accounting
+bool in_module() {
+    return helix::ResourceAccounting::current() != 0;
+}
+
+int opened(int fd) {
+    if (fd >= 0) helix::ResourceAccounting::instance().fd_opened(fd);
+    return fd;
+}
+
+FILE* opened(FILE* file) {
+    if (file) helix::ResourceAccounting::instance().fd_opened(fileno(file));
+    return file;
+}
+
+mode_t mode_argument(int flags, va_list args) {
+    return (flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE ? static_cast<mode_t>(va_arg(args, int)) : 0;
+}
+
+} // namespace
+
+// Call libc directly unless module code is calling
+#define HELIX_FORWARD(name, ...) \
+    ([&]() { \
+        const auto next = HELIX_NEXT(name); \
+        return in_module() ? opened(next(__VA_ARGS__)) : next(__VA_ARGS__); \
+    }())
+
+extern "C" {
+
+int open(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    const mode_t mode = mode_argument(flags, args);
+    va_end(args);
+    return HELIX_FORWARD(open, path, flags, mode);
+}
+
+int open64(const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    const mode_t mode = mode_argument(flags, args);
+    va_end(args);
+    return HELIX_FORWARD(open64, path, flags, mode);
+}
+
+int openat(int dirfd, const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    const mode_t mode = mode_argument(flags, args);
+    va_end(args);
+    return HELIX_FORWARD(openat, dirfd, path, flags, mode);
+}
+
+int openat64(int dirfd, const char* path, int flags, ...) {
+    va_list args;
+    va_start(args, flags);
+    const mode_t mode = mode_argument(flags, args);
+    va_end(args);
+    return HELIX_FORWARD(openat64, dirfd, path, flags, mode);
+}
+
+// Called instead of open() by code built with _FORTIFY_SOURCE
+int __open_2(const char* path, int flags) {
+    return HELIX_FORWARD(open, path, flags, 0);
+}
+
+int __open64_2(const char* path, int flags) {
+    return HELIX_FORWARD(open64, path, flags, 0);
+}
+
+int __openat_2(int dirfd, const char* path, int flags) {
+    return HELIX_FORWARD(openat, dirfd, path, flags, 0);
+}
+
+int __openat64_2(int dirfd, const char* path, int flags) {
+    return HELIX_FORWARD(openat64, dirfd, path, flags, 0);
+}
+
+int creat(const char* path, mode_t mode) {
+    return HELIX_FORWARD(creat, path, mode);
+}
+
+FILE* fopen(const char* path, const char* mode) {
+    return HELIX_FORWARD(fopen, path, mode);
+}
+
+FILE* fopen64(const char* path, const char* mode) {
+    return HELIX_FORWARD(fopen64, path, mode);
+}
+
+int fclose(FILE* file) {
+    if (file) helix::ResourceAccounting::instance().fd_closed(fileno(file));
+    return HELIX_NEXT(fclose)(file);
+}
+
+int socket(int domain, int type, int protocol) {
+    return HELIX_FORWARD(socket, domain, type, protocol);
+}
+
+int socketpair(int domain, int type, int protocol, int fds[2]) {
+    const int rc = HELIX_NEXT(socketpair)(domain, type, protocol, fds);
+    if (rc == 0 && in_module()) {
+        opened(fds[0]);
+        opened(fds[1]);
+    }
+    return rc;
+}
+
+int accept(int fd, sockaddr* address, socklen_t* length) {
+    return HELIX_FORWARD(accept, fd, address, length);
+}
+
+int accept4(int fd, sockaddr* address, socklen_t* length, int flags) {
+    return HELIX_FORWARD(accept4, fd, address, length, flags);
+}
+
+int pipe(int fds[2]) {
+    const int rc = HELIX_NEXT(pipe)(fds);
+    if (rc == 0 && in_module()) {
+        opened(fds[0]);
+        opened(fds[1]);
+    }
+    return rc;
+}
+
+int pipe2(int fds[2], int flags) {
+    const int rc = HELIX_NEXT(pipe2)(fds, flags);
+    if (rc == 0 && in_module()) {
+        opened(fds[0]);
+        opened(fds[1]);
+    }
+    return rc;
+}
+
+int dup(int fd) {
+    return HELIX_FORWARD(dup, fd);
+}
+
+// These replace target, which may be a module's descriptor, so the daemon's calls
+// are recorded too: opened() releases whatever owned it before
+int dup2(int fd, int target) {
+    return opened(HELIX_NEXT(dup2)(fd, target));
+}
+
+int dup3(int fd, int target, int flags) {
+    return opened(HELIX_NEXT(dup3)(fd, target, flags));
+}
+
+int eventfd(unsigned int initial, int flags) {
+    return HELIX_FORWARD(eventfd, initial, flags);
+}
+
+int epoll_create(int size) {
+    return HELIX_FORWARD(epoll_create, size);
+}
+
+int epoll_create1(int flags) {
+    return HELIX_FORWARD(epoll_create1, flags);
+}
+
+int timerfd_create(int clock, int flags) {
+    return HELIX_FORWARD(timerfd_create, clock, flags);
+}
+
+int inotify_init() {
+    const auto next = HELIX_NEXT(inotify_init);
+    return in_module() ? opened(next()) : next();
+}
+
+int inotify_init1(int flags) {
+    return HELIX_FORWARD(inotify_init1, flags);
+}
+
+int memfd_create(const char* name, unsigned int flags) {
+    return HELIX_FORWARD(memfd_create, name, flags);
+}
+
+int close(int fd) {
+    helix::ResourceAccounting::instance().fd_closed(fd);
+    return HELIX_NEXT(close)(fd);
+}
+
+} // extern "C"
@@ -0,0 +1,196 @@
+// helix-modhost: runs one module in its own process for helixd ("isolation": "process").
+//
+// helixd starts it with the four HostChannel descriptors on fds 3-6:
+//   helix-modhost --module <path.so> --name <module> --entry-points <init> <start> <stop> <destroy>
+//                 [--log-level N] [--bind-now]
+// The module is opened, its entry points are resolved and the outcome is reported
+// with a kReady message; then each kCall runs one entry point and is answered with
+// a kReply. The process exits on kExit or when helixd goes away.
+//
+// The program exports the log registry entry points modules look up with
+// dlsym(RTLD_DEFAULT), so helix_log() and the HELIX_LOGF macros in a hosted module
+// forward records to the daemon over the channel, and helix/memory.h arenas and pools
+// work as they do in helixd. It also exports the message bus (helix/bus.h): topics are
+// the daemon's memfds, requested over the channel's socket and mapped here, so messages
+// cross the process boundary through shared memory alone. Services cannot cross it and
+// fail with a message (see ModuleHost).
+#include "helix/host_channel.h"
+#include "helix/log.h"
+#include "helix/message_bus.h"
+#include "helix/module_host.h"
+#include "helix/module_memory.h"
+#include "helix/service_registry.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <dlfcn.h>
+#include <unistd.h>
+
+namespace {
+
+helix::HostChannel g_channel;
+bool g_attached = false;
+std::atomic<int> g_min_level{HELIX_LOG_INFO};
+
+using InitFn = int (*)();
+using DestroyFn = void (*)();
+
+void forward_log(const char* module, int level, const char* message, size_t length) {
+    if (!g_attached || level < g_min_level.load(std::memory_order_relaxed)) return;
+    helix::HostChannel::Message record;
+    record.type = helix::HostChannel::kLog;
+    record.op = static_cast<uint16_t>(level);
+    record.payload.reserve(std::strlen(module) + 1 + length);
+    record.payload.append(module).push_back('\0');
+    record.payload.append(message, length);
+    (void)g_channel.send(record, 0); // never block the module on a slow daemon; overflow is counted
+}
+
+// The daemon owns every topic; ask it for the ring's memfd
+int open_topic(const std::string& name, uint32_t slot_size, uint32_t capacity, std::string& error) {
+    if (name.size() > helix::HostChannel::kMaxPayload) {
+        error = "topic name is too long";
+        return -1;
+    }
+    helix::HostChannel::Message request;
+    request.type = helix::HostChannel::kOpenTopic;
+    request.value = static_cast<int64_t>(static_cast<uint64_t>(slot_size) << 32 | capacity);
+    request.payload = name;
+    helix::HostChannel::Message answer;
+    int fd = -1;
+    if (!g_channel.request(request, answer, fd)) {
+        error = "helixd did not answer";
+        return -1;
+    }
+    if (answer.value != 0 || fd < 0) {
+        if (fd >= 0) ::close(fd);
+        error = answer.payload.empty() ? "helixd sent no ring" : answer.payload;
+        return -1;
+    }
+    return fd;
+}
+
+void report_ready(const std::string& error) {
+    helix::HostChannel::Message ready;
+    ready.type = helix::HostChannel::kReady;
+    ready.value = error.empty() ? 0 : -1;
+    ready.payload = error;
+    (void)g_channel.send(ready, 1000);
+}
+
+int usage() {
+    std::cerr << "Usage: helix-modhost --module <path.so> --name <module> "
+                 "--entry-points <init> <start> <stop> <destroy> [--log-level N] [--bind-now]\n"
+                 "Started by helixd for modules with \"isolation\": \"process\"; not meant to be run by hand."
+              << std::endl;
+    return 2;
+}
+
+} // namespace
+
+extern "C" {
+
+void helix_log_dispatch(const char* module, int level, const char* message) {
+    forward_log(module ? module : "(unknown)", level, message ? message : "", message ? std::strlen(message) : 0);
+}
+
+void helix_log_dispatch_n(const char* module, int level, const char* message, size_t length) {
+    forward_log(module ? module : "(unknown)", level, message ? message : "", message ? length : 0);
+}
+
+const void* helix_log_min_level_ref() {
+    return &g_min_level;
+}
+
+int helix_log_min_level_get() {
+    return g_min_level.load(std::memory_order_relaxed);
+}
+
+} // extern "C"
+
+int main(int argc, char* argv[]) {
+    std::string module_path;
+    std::string module_name;
+    helix::EntryPoints entry_points;
+    bool bind_now = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--module" && i + 1 < argc) {
+            module_path = argv[++i];
+        } else if (arg == "--name" && i + 1 < argc) {
+            module_name = argv[++i];
+        } else if (arg == "--entry-points" && i + 4 < argc) {
+            entry_points.init = argv[++i];
+            entry_points.start = argv[++i];
+            entry_points.stop = argv[++i];
+            entry_points.destroy = argv[++i];
+        } else if (arg == "--log-level" && i + 1 < argc) {
+            g_min_level.store(std::atoi(argv[++i]), std::memory_order_relaxed);
+        } else if (arg == "--bind-now") {
+            bind_now = true;
+        } else {
+            return usage();
+        }
+    }
+    if (module_path.empty() || module_name.empty()) return usage();
+
+    std::string error;
+    if (!g_channel.attach(helix::HostChannel::kHostMemoryFd, helix::HostChannel::kHostInboxFd,
+                          helix::HostChannel::kHostOutboxFd, helix::HostChannel::kHostRequestFd, error)) {
+        std::cerr << "helix-modhost: " << error << std::endl;
+        return 1;
+    }
+    g_attached = true;
+    helix::MessageBus::instance().set_topic_source(&open_topic);
+    helix::ServiceRegistry::instance().set_unavailable(
+        "modules with \"isolation\": \"process\" cannot provide or use services");
+
+    void* handle = dlopen(module_path.c_str(), (bind_now ? RTLD_NOW : RTLD_LAZY) | RTLD_LOCAL);
+    if (!handle) {
+        const char* reason = dlerror();
+        report_ready(std::string("cannot open ") + module_path + ": " + (reason ? reason : "unknown error"));
+        return 1;
+    }
+    auto init = reinterpret_cast<InitFn>(dlsym(handle, entry_points.init.c_str()));
+    auto start = reinterpret_cast<InitFn>(dlsym(handle, entry_points.start.c_str()));
+    auto stop = reinterpret_cast<InitFn>(dlsym(handle, entry_points.stop.c_str()));
+    auto destroy = reinterpret_cast<DestroyFn>(dlsym(handle, entry_points.destroy.c_str()));
+    if (!init || !start || !stop || !destroy) {
+        report_ready("module " + module_name + " is missing an entry point (" + entry_points.init + ", " +
+                     entry_points.start + ", " + entry_points.stop + ", " + entry_points.destroy + ")");
+        return 1;
+    }
+    report_ready(std::string());
+
+    helix::HostChannel::Message message;
+    for (;;) {
+        if (!g_channel.receive(message, 1000)) {
+            if (getppid() == 1) break; // helixd is gone and PR_SET_PDEATHSIG did not fire
+            continue;
+        }
+        if (message.type == helix::HostChannel::kExit) break;
+        if (message.type != helix::HostChannel::kCall) continue;
+
+        helix::HostChannel::Message reply;
+        reply.type = helix::HostChannel::kReply;
+        reply.op = message.op;
+        reply.id = message.id;
+        switch (message.op) {
+            case helix::ModuleHost::kInit: reply.value = init(); break;
+            case helix::ModuleHost::kStart: reply.value = start(); break;
+            case helix::ModuleHost::kStop: reply.value = stop(); break;
+            case helix::ModuleHost::kDestroy:
+                destroy();
+                helix::ModuleMemory::instance().release(0); // everything in this process was the module's
+                break;
+            case helix::ModuleHost::kPing: break;
+            default: reply.value = -1; break;
+        }
+        (void)g_channel.send(reply);
+    }
+    // The daemon has already called destroy if it wanted to; module threads may still run, so skip dlclose
+    std::cout.flush();
+    _exit(0);
+}
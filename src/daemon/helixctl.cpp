@@ -1,9 +1,16 @@
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <poll.h>
 #include <unistd.h>
 #include <cerrno>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <thread>
 #include <sstream>
 #include <string>
 #include <filesystem>
@@ -21,6 +28,26 @@ static void print_usage(const char* prog) {
               << "       " << prog << " install-service [--service-name helixd] [--modules-dir PATH] [--socket PATH] [--exec /path/to/helixd]\n\n"
               << "Commands:\n"
               << "  <command>            Send a single control command (status, list, info <name>, install <file.helx>, ...)\n"
+              << "  batch [-f FILE] [--ordered]\n"
+              << "                       Pipeline commands (one per line, from FILE or stdin) over one connection;\n"
+              << "                       --ordered applies lifecycle commands in one dependency-ordered daemon batch\n"
+              << "  <enable|start|stop|disable> <name> --async\n"
+              << "                       Queue the operation and print its job id without waiting\n"
+              << "  wait <job> [--timeout SEC]\n"
+              << "                       Block until a queued job finishes; exits 1 if it failed or is still running\n"
+              << "  upgrade <file.helx>  Replace an installed module with a newer package without stopping it\n"
+              << "  jobs                 List queued, running and recently finished lifecycle jobs\n"
+              << "  topics [--json]      Show message bus topics with their depth, published and drop counters\n"
+              << "  metrics [--json | prometheus]\n"
+              << "                       Show latency histograms (lifecycle, resolver, install, IPC, log dispatch)\n"
+              << "  top [--interval SEC] [--count N] [--json]\n"
+              << "                       Show CPU, threads, descriptors and heap use of helixd and each loaded module;\n"
+              << "                       CPU% is measured over SEC (default 1); N > 1 refreshes, 0 runs until interrupted\n"
+              << "  watch [states] [logs] [metrics] [--json]\n"
+              << "                       Print module state changes (and log records, metric deltas) as they happen,\n"
+              << "                       starting with the current state of every module; runs until interrupted\n"
+              << "  logs -f [--module NAME] [--json]\n"
+              << "                       Follow the daemon's log records\n"
               << "  install-service      Install and enable a systemd service for helixd (requires root)\n"
               << "  uninstall-service    Stop/disable and remove the helixd systemd service/socket (requires root)\n\n"
               << "Options:\n"
@@ -28,15 +55,21 @@ static void print_usage(const char* prog) {
               << "  --no-color           Disable ANSI colors in output\n"
               << "  --version            Query daemon and print Helix core and API versions\n";
 }
-static bool send_command(const std::string& socket_path, const std::string& command, std::string& response) {
+static int connect_control_socket(const std::string& socket_path, std::string& error) {
     int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
-    if (fd < 0) { response = std::string("socket: ") + std::strerror(errno); return false; }
+    if (fd < 0) { error = std::string("socket: ") + std::strerror(errno); return -1; }
     sockaddr_un addr{}; addr.sun_family = AF_UNIX;
     std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path.c_str());
     if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
-        response = std::string("connect: ") + std::strerror(errno) + " (" + socket_path + ")";
-        ::close(fd); return false;
+        error = std::string("connect: ") + std::strerror(errno) + " (" + socket_path + ")";
+        ::close(fd); return -1;
     }
+    return fd;
+}
+
+static bool send_command(const std::string& socket_path, const std::string& command, std::string& response) {
+    int fd = connect_control_socket(socket_path, response);
+    if (fd < 0) return false;
     std::string wire = command; if (wire.empty() || wire.back()!='\n') wire.push_back('\n');
     if (::write(fd, wire.data(), wire.size()) < 0) { response = std::string("write: ") + std::strerror(errno); ::close(fd); return false; }
     char buf[1024]; ssize_t n; response.clear();
@@ -45,6 +78,324 @@ static bool send_command(const std::string& socket_path, const std::string& comm
     return true;
 }
 
+// Turns "install|upgrade <relative path>" into an absolute path; the daemon may have a different CWD.
+static std::string normalize_command(const std::string& line) {
+    const bool upgrade = line.rfind("upgrade ", 0) == 0;
+    if (line.rfind("install ", 0) != 0 && !upgrade) return line;
+    std::string path = line.substr(8);
+    while (!path.empty() && path.front() == ' ') path.erase(0, 1);
+    std::error_code ec;
+    fs::path abs = fs::absolute(fs::path(path), ec);
+    return (upgrade ? "upgrade " : "install ") + (ec ? path : abs.string());
+}
+
+// Sends all commands over one session connection, tagged "@<n>", without waiting for
+// replies in between, and collects the responses by tag. Writes and reads are
+// interleaved with poll() so large replies cannot deadlock against unsent commands.
+static bool send_pipelined(const std::string& socket_path, const std::vector<std::string>& commands,
+                           std::vector<std::string>& responses, std::string& error) {
+    int fd = connect_control_socket(socket_path, error);
+    if (fd < 0) return false;
+    std::string wire = "session\n";
+    for (size_t k = 0; k < commands.size(); ++k) wire += "@" + std::to_string(k + 1) + " " + commands[k] + "\n";
+    wire += "quit\n";
+
+    responses.assign(commands.size(), std::string());
+    std::vector<bool> seen(commands.size(), false);
+    size_t received = 0, written = 0;
+    std::string in, frame;
+    bool got_eof = false;
+    while (!got_eof) {
+        pollfd pfd{fd, static_cast<short>(POLLIN | (written < wire.size() ? POLLOUT : 0)), 0};
+        if (::poll(&pfd, 1, 30000) <= 0) { error = "timed out waiting for the daemon"; break; }
+        if ((pfd.revents & POLLOUT) && written < wire.size()) {
+            ssize_t n = ::send(fd, wire.data() + written, wire.size() - written, MSG_NOSIGNAL);
+            if (n < 0 && errno != EINTR && errno != EAGAIN) { error = std::string("write: ") + std::strerror(errno); break; }
+            if (n > 0) written += static_cast<size_t>(n);
+        }
+        if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            char buf[4096];
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { got_eof = true; }
+            else in.append(buf, buf + n);
+        }
+        size_t pos;
+        while ((pos = in.find('\n')) != std::string::npos) {
+            std::string line = in.substr(0, pos);
+            in.erase(0, pos + 1);
+            if (line == "." || line.rfind(". ", 0) == 0) {
+                // End of a response frame; untagged frames answer "session" and "quit"
+                if (line.size() > 2) {
+                    char* end = nullptr;
+                    unsigned long tag = std::strtoul(line.c_str() + 2, &end, 10);
+                    if (end && *end == '\0' && tag >= 1 && tag <= commands.size() && !seen[tag - 1]) {
+                        responses[tag - 1] = frame;
+                        seen[tag - 1] = true;
+                        ++received;
+                    }
+                }
+                frame.clear();
+                continue;
+            }
+            if (!line.empty() && line[0] == '.') line.erase(0, 1);
+            frame += line + "\n";
+        }
+    }
+    ::close(fd);
+    if (received < commands.size()) {
+        if (error.empty()) {
+            error = "connection closed after " + std::to_string(received) + " of " +
+                    std::to_string(commands.size()) + " responses";
+        }
+        return false;
+    }
+    return true;
+}
+
+// helixctl batch: one command per line; blank lines and lines starting with '#' are skipped.
+// With ordered=true the lifecycle commands are sent as a single daemon-side "batch" request,
+// which the daemon applies in dependency order.
+static int run_batch_file(const std::string& socket_path, std::istream& input, bool ordered, bool no_color) {
+    std::vector<std::string> commands;
+    std::string line;
+    while (std::getline(input, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+        size_t p = 0; while (p < line.size() && (line[p] == ' ' || line[p] == '\t')) ++p;
+        line.erase(0, p);
+        if (line.empty() || line[0] == '#') continue;
+        commands.push_back(normalize_command(line));
+    }
+    if (commands.empty()) { std::cerr << "batch: no commands" << std::endl; return 2; }
+
+    if (ordered) {
+        static const char* lifecycle[] = {"install ", "enable ", "start ", "stop ", "disable ", "uninstall "};
+        std::string joined = "batch ";
+        for (size_t k = 0; k < commands.size(); ++k) {
+            bool ok = false;
+            for (const char* verb : lifecycle) ok = ok || commands[k].rfind(verb, 0) == 0;
+            if (!ok || commands[k].find(';') != std::string::npos) {
+                std::cerr << "batch --ordered: not a lifecycle command: " << commands[k] << std::endl;
+                return 2;
+            }
+            if (k) joined += "; ";
+            joined += commands[k];
+        }
+        commands.assign(1, joined);
+    }
+
+    std::vector<std::string> responses;
+    std::string error;
+    if (!send_pipelined(socket_path, commands, responses, error)) { std::cerr << error << std::endl; return 1; }
+
+    auto color = [&](const std::string& s, const char* code){ return no_color ? s : (std::string("\033[") + code + "m" + s + "\033[0m"); };
+    bool failed = false;
+    for (size_t k = 0; k < commands.size(); ++k) {
+        const std::string& resp = responses[k];
+        if (!ordered) std::cout << color("[" + std::to_string(k + 1) + "] " + commands[k], "1") << "\n";
+        std::istringstream iss(resp);
+        std::string out;
+        while (std::getline(iss, out)) {
+            bool err = out.rfind("ERR", 0) == 0;
+            failed = failed || err;
+            if (out.empty()) continue;
+            std::cout << (ordered ? "" : "  ") << (err ? color(out, "31") : out) << "\n";
+        }
+    }
+    return failed ? 1 : 0;
+}
+
+// One line of a "top" reply: "<name> key=value ..."
+struct TopRow {
+    std::string name;
+    std::map<std::string, std::string> fields;
+
+    double number(const std::string& key) const {
+        auto it = fields.find(key);
+        return it == fields.end() ? 0.0 : std::strtod(it->second.c_str(), nullptr);
+    }
+    std::string text(const std::string& key, const std::string& fallback = "-") const {
+        auto it = fields.find(key);
+        return it == fields.end() ? fallback : it->second;
+    }
+};
+
+static std::vector<TopRow> parse_top(const std::string& resp) {
+    std::vector<TopRow> rows;
+    std::istringstream iss(resp);
+    std::string line;
+    while (std::getline(iss, line)) {
+        std::istringstream words(line);
+        TopRow row;
+        if (!(words >> row.name)) continue;
+        std::string word;
+        while (words >> word) {
+            auto eq = word.find('=');
+            if (eq != std::string::npos) row.fields[word.substr(0, eq)] = word.substr(eq + 1);
+        }
+        rows.push_back(std::move(row));
+    }
+    return rows;
+}
+
+static std::string human_bytes(double bytes) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    size_t u = 0;
+    while (bytes >= 1024 && u + 1 < sizeof(units) / sizeof(units[0])) { bytes /= 1024; ++u; }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(u ? 1 : 0) << bytes << " " << units[u];
+    return os.str();
+}
+
+// helixctl top: two samples `interval` apart give CPU%; the table is sorted by it
+static int run_top(const std::string& socket_path, double interval, long count, bool no_color) {
+    auto bold = [&](const std::string& s){ return no_color ? s : "\033[1m" + s + "\033[0m"; };
+    std::string resp;
+    if (!send_command(socket_path, "top", resp)) { std::cerr << resp << std::endl; return 1; }
+    if (resp.rfind("ERR", 0) == 0) { std::cerr << resp; return 1; }
+    std::vector<TopRow> before = parse_top(resp);
+    auto sampled_at = std::chrono::steady_clock::now();
+
+    for (long round = 0; count == 0 || round < count; ++round) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+        if (!send_command(socket_path, "top", resp)) { std::cerr << resp << std::endl; return 1; }
+        if (resp.rfind("ERR", 0) == 0) { std::cerr << resp; return 1; }
+        std::vector<TopRow> after = parse_top(resp);
+        const auto now = std::chrono::steady_clock::now();
+        const double wall = std::chrono::duration<double>(now - sampled_at).count();
+        auto cpu_percent = [&](const TopRow& row) {
+            for (const auto& old : before) {
+                if (old.name == row.name) {
+                    const double used = row.number("cpu_seconds") - old.number("cpu_seconds");
+                    return wall > 0 && used > 0 ? 100.0 * used / wall : 0.0;
+                }
+            }
+            return 0.0;
+        };
+
+        if (round) std::cout << "\n";
+        std::vector<std::pair<double, const TopRow*>> modules;
+        for (const auto& row : after) {
+            if (row.name == "process") {
+                std::cout << bold("helixd") << "  cpu " << std::fixed << std::setprecision(1) << cpu_percent(row)
+                          << "%  rss " << human_bytes(row.number("rss_bytes")) << "  threads " << row.text("threads")
+                          << "  fds " << row.text("fds") << "\n";
+            } else {
+                modules.emplace_back(cpu_percent(row), &row);
+            }
+        }
+        std::stable_sort(modules.begin(), modules.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        std::cout << bold("MODULE                STATE        CPU%    CPU_S  THREADS  FDS  HEAP") << "\n";
+        for (const auto& [cpu, row] : modules) {
+            std::string heap = row->fields.count("alloc_live_bytes") ? human_bytes(row->number("alloc_live_bytes")) : "-";
+            if (row->fields.count("host_pid")) heap = human_bytes(row->number("rss_bytes")) + " rss (pid " + row->text("host_pid") + ")";
+            std::cout << std::left << std::setw(21) << row->name << " " << std::setw(11) << row->text("state") << std::right
+                      << std::fixed << std::setprecision(1) << std::setw(6) << cpu << std::setprecision(2)
+                      << std::setw(9) << row->number("cpu_seconds") << std::setw(9) << row->text("threads")
+                      << std::setw(5) << row->text("fds") << "  " << heap << "\n";
+        }
+        if (modules.empty()) std::cout << "(no loaded modules)\n";
+        std::cout.flush();
+        before = std::move(after);
+        sampled_at = now;
+    }
+    return 0;
+}
+
+// helixctl watch / logs -f: one "subscribe" connection, printed line by line until the daemon closes it.
+// The first line is the daemon's reply; every later line is one event (see "subscribe" in docs/USAGE.md).
+static int run_subscription(const std::string& socket_path, const std::string& command, bool raw,
+                            const std::string& module_filter, bool no_color) {
+    auto color = [&](const std::string& s, const char* code){ return no_color ? s : (std::string("\033[") + code + "m" + s + "\033[0m"); };
+    auto state_color = [&](const std::string& st) {
+        return st == "Running" ? color(st, "32") : (st == "Error" ? color(st, "31") : color(st, "33"));
+    };
+    std::string error;
+    int fd = connect_control_socket(socket_path, error);
+    if (fd < 0) { std::cerr << error << std::endl; return 1; }
+    const std::string wire = command + "\n";
+    if (::write(fd, wire.data(), wire.size()) < 0) {
+        std::cerr << "write: " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return 1;
+    }
+
+    auto clock = [] {
+        std::time_t now = std::time(nullptr);
+        char buf[16];
+        std::strftime(buf, sizeof(buf), "%H:%M:%S", std::localtime(&now));
+        return std::string(buf);
+    };
+    auto print = [&](const std::string& line) {
+        std::istringstream iss(line);
+        std::string kind, a, b, c;
+        iss >> kind;
+        if (kind == "log") {
+            iss >> a >> b; // level, module
+            if (!module_filter.empty() && b != module_filter) return;
+            std::string message;
+            std::getline(iss, message);
+            if (!message.empty() && message[0] == ' ') message.erase(0, 1);
+            if (raw) { std::cout << line << "\n"; return; }
+            const char* code = a == "ERROR" ? "31" : (a == "WARN" ? "33" : "2");
+            std::cout << clock() << " " << color(a, code) << " " << color(b, "1") << " " << message << "\n";
+        } else if (raw) {
+            std::cout << line << "\n";
+        } else if (kind == "state") {
+            iss >> a >> b; // module, state (snapshot) or previous state
+            std::string rest;
+            std::getline(iss, rest);
+            if (rest.empty()) {
+                std::cout << color(a, "1") << " [" << state_color(b) << "]\n";
+                return;
+            }
+            std::istringstream tail(rest);
+            tail >> c; // new state, possibly followed by ": error"
+            std::string reason;
+            std::getline(tail, reason);
+            if (!c.empty() && c.back() == ':') c.pop_back();
+            std::cout << clock() << " " << color(a, "1") << " " << b << " -> " << state_color(c) << reason << "\n";
+        } else if (kind == "metrics") {
+            std::cout << clock() << " " << line.substr(8) << "\n";
+        } else if (kind == "dropped") {
+            iss >> a;
+            std::cout << color("(" + a + " events dropped: this client fell behind)", "33") << "\n";
+        } else {
+            std::cout << line << "\n";
+        }
+    };
+
+    std::string pending;
+    bool replied = false;
+    char buf[4096];
+    ssize_t n;
+    while ((n = ::read(fd, buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+        if (n < 0) continue;
+        pending.append(buf, static_cast<size_t>(n));
+        size_t start = 0, nl;
+        while ((nl = pending.find('\n', start)) != std::string::npos) {
+            const std::string line = pending.substr(start, nl - start);
+            start = nl + 1;
+            if (!replied) {
+                replied = true;
+                if (line.rfind("OK", 0) != 0) {
+                    std::cerr << line << std::endl;
+                    ::close(fd);
+                    return 1;
+                }
+                continue;
+            }
+            print(line);
+        }
+        pending.erase(0, start);
+        std::cout.flush();
+    }
+    ::close(fd);
+    if (!replied) { std::cerr << "subscribe: connection closed without a reply" << std::endl; return 1; }
+    return 0;
+}
+
 static std::string detect_default_socket() {
     const char* env = std::getenv("HELIX_SOCKET");
     if (env && *env) return std::string(env);
@@ -279,15 +630,103 @@ int main(int argc, char* argv[]) {
         return uninstall_service(service_name);
     }
 
+    if (sub == "batch") {
+        std::string file;
+        bool ordered = false;
+        while (i < argc) {
+            std::string a = argv[i++];
+            if ((a == "-f" || a == "--file") && i < argc) file = argv[i++];
+            else if (a == "--ordered") ordered = true;
+            else { std::cerr << "Unknown option for batch: " << a << std::endl; return 2; }
+        }
+        if (file.empty() || file == "-") return run_batch_file(socket_path, std::cin, ordered, no_color);
+        std::ifstream ifs(file);
+        if (!ifs) { std::cerr << "batch: cannot open " << file << std::endl; return 1; }
+        return run_batch_file(socket_path, ifs, ordered, no_color);
+    }
+
+    if (sub == "wait") {
+        std::string job, timeout = "0";
+        while (i < argc) {
+            std::string a = argv[i++];
+            if (a == "--timeout" && i < argc) timeout = argv[i++];
+            else if (job.empty()) job = a;
+            else { std::cerr << "Unknown option for wait: " << a << std::endl; return 2; }
+        }
+        if (job.empty()) { std::cerr << "wait: missing job id" << std::endl; return 2; }
+        // The daemon bounds each wait; without --timeout keep asking until the job finishes
+        const bool unbounded = timeout == "0";
+        const std::string still = "ERR wait: job " + job + " still ";
+        std::string resp;
+        do {
+            if (!send_command(socket_path, "wait " + job + " " + timeout, resp)) { std::cerr << resp << std::endl; return 1; }
+        } while (unbounded && resp.rfind(still, 0) == 0);
+        std::cout << resp;
+        if (!resp.empty() && resp.back() != '\n') std::cout << "\n";
+        return resp.rfind("OK", 0) == 0 ? 0 : 1;
+    }
+
+    if (sub == "top") {
+        double interval = 1.0;
+        long count = 1;
+        bool json = false;
+        while (i < argc) {
+            std::string a = argv[i++];
+            if (a == "--interval" && i < argc) interval = std::strtod(argv[i++], nullptr);
+            else if (a == "--count" && i < argc) count = std::strtol(argv[i++], nullptr, 10);
+            else if (a == "--json") json = true;
+            else { std::cerr << "Unknown option for top: " << a << std::endl; return 2; }
+        }
+        if (interval <= 0 || count < 0) { std::cerr << "top: --interval must be positive and --count at least 0" << std::endl; return 2; }
+        if (json) {
+            std::string resp;
+            if (!send_command(socket_path, "top --json", resp)) { std::cerr << resp << std::endl; return 1; }
+            std::cout << resp;
+            return resp.rfind("ERR", 0) == 0 ? 1 : 0;
+        }
+        return run_top(socket_path, interval, count, no_color);
+    }
+
+    if (sub == "watch") {
+        std::string command = "subscribe";
+        bool json = false;
+        while (i < argc) {
+            std::string a = argv[i++];
+            if (a == "states" || a == "logs" || a == "metrics") command += " " + a;
+            else if (a == "--json") json = true;
+            else { std::cerr << "Unknown option for watch: " << a << std::endl; return 2; }
+        }
+        if (json) command += " --json";
+        return run_subscription(socket_path, command, json, std::string(), no_color);
+    }
+
+    if (sub == "logs") {
+        // The daemon keeps no log history, so logs only ever follows; -f is accepted for familiarity
+        std::string module;
+        bool json = false;
+        while (i < argc) {
+            std::string a = argv[i++];
+            if (a == "-f" || a == "--follow") continue;
+            else if (a == "--module" && i < argc) module = argv[i++];
+            else if (a == "--json") json = true;
+            else { std::cerr << "Unknown option for logs: " << a << std::endl; return 2; }
+        }
+        if (json && !module.empty()) {
+            std::cerr << "logs: --module filters text output; filter JSON records with your JSON tool" << std::endl;
+            return 2;
+        }
+        return run_subscription(socket_path, json ? "subscribe logs --json" : "subscribe logs", json, module, no_color);
+    }
+
     // Default behavior: send command to daemon
-    // Special-case: normalize install path to absolute (daemon may have different CWD)
+    // Special-case: normalize install/upgrade paths to absolute (daemon may have different CWD)
     std::string cmd;
     {
         int start = i - 1; // include 'sub' as first token
         for (int j = start; j < argc; ++j) {
             if (j > start) cmd.push_back(' ');
             std::string token = argv[j];
-            if (j == start && token == "install" && (j + 1) < argc) {
+            if (j == start && (token == "install" || token == "upgrade") && (j + 1) < argc) {
                 cmd += token;
                 cmd.push_back(' ');
                 fs::path p(argv[j+1]);
@@ -311,6 +750,9 @@ int main(int argc, char* argv[]) {
     auto yellow = [&](const std::string& s){ return color(s, "33"); };
     auto red = [&](const std::string& s){ return color(s, "31"); };
 
+    // JSON-lines replies (list/info --json) are meant for tools; pass them through untouched
+    if (cmd.find(" --json\n") != std::string::npos) { std::cout << resp; return 0; }
+
     if (sub == "list") {
         // format: name state
         std::istringstream iss(resp);
@@ -346,6 +788,39 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    if (sub == "jobs") {
+        // <id> <action> <target> <state> ...; highlight the state word
+        std::istringstream iss(resp);
+        std::string line; bool any = false;
+        while (std::getline(iss, line)) {
+            if (line.empty()) continue;
+            any = true;
+            for (const char* st : {" succeeded", " failed", " cancelled", " running", " queued"}) {
+                auto pos = line.find(st);
+                if (pos == std::string::npos) continue;
+                std::string word = std::string(st).substr(1);
+                std::string colored = word == "succeeded" ? green(word) : (word == "running" || word == "queued" ? yellow(word) : red(word));
+                line = line.substr(0, pos + 1) + colored + line.substr(pos + 1 + word.size());
+                break;
+            }
+            std::cout << line << "\n";
+        }
+        if (!any) std::cout << "(no jobs)\n";
+        return 0;
+    }
+
+    if (sub == "metrics") {
+        if (resp.empty()) std::cout << "(no metrics)\n";
+        else std::cout << resp;
+        return resp.rfind("ERR", 0) == 0 ? 1 : 0;
+    }
+
+    if (sub == "topics") {
+        if (resp.empty()) std::cout << "(no topics)\n";
+        else std::cout << resp;
+        return resp.rfind("ERR", 0) == 0 ? 1 : 0;
+    }
+
     // Default: print as-is (may include ERR ...)
     std::cout << resp;
     return 0;
@@ -1,23 +1,358 @@
 #include "ipc_server.h"
+#include "helix/metrics.h"
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <cerrno>
+#include <cctype>
 #include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace fs = std::filesystem;
 namespace helix {
 
-IpcServer::IpcServer(std::string socket_path) : socket_path_(std::move(socket_path)) {}
+namespace {
 
-IpcServer::~IpcServer() { stop(); }
+using Clock = std::chrono::steady_clock;
+
+bool set_nonblocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void wake(int fd) {
+    if (fd < 0) return;
+    uint64_t one = 1;
+    ssize_t rc = ::write(fd, &one, sizeof(one));
+    (void)rc; // counter saturation only means a wakeup is already pending
+}
+
+// Session-mode framing: dot-stuff lines starting with '.', then terminate with ".\n",
+// or ". <tag>\n" when the request carried a tag.
+std::string frame_response(const std::string& response, const std::string& tag = std::string()) {
+    std::string out;
+    out.reserve(response.size() + 4);
+    bool line_start = true;
+    for (char c : response) {
+        if (line_start && c == '.') out.push_back('.');
+        out.push_back(c);
+        line_start = (c == '\n');
+    }
+    if (!line_start) out.push_back('\n');
+    out += tag.empty() ? std::string(".\n") : (". " + tag + "\n");
+    return out;
+}
+
+// Splits an optional "@<tag> " request prefix off a session command line.
+// Tags are 1-32 characters of [A-Za-z0-9_-]; anything else is left as part of the command.
+std::string take_tag(std::string& line) {
+    if (line.size() < 3 || line[0] != '@') return std::string();
+    size_t end = 1;
+    while (end < line.size() && end <= 32 &&
+           (std::isalnum(static_cast<unsigned char>(line[end])) || line[end] == '_' || line[end] == '-')) ++end;
+    if (end == 1 || end >= line.size() || line[end] != ' ') return std::string();
+    std::string tag = line.substr(1, end - 1);
+    line.erase(0, end + 1);
+    return tag;
+}
+
+// Latency histogram for a command's verb. Every distinct verb becomes a label, so
+// after kMaxVerbs of them (or for anything that is not a plain word) "other" is used.
+Histogram& request_histogram(const std::string& line) {
+    constexpr size_t kMaxVerbs = 48;
+    static std::mutex mutex;
+    static std::unordered_set<std::string> verbs;
+    thread_local std::unordered_map<std::string, Histogram*> cache;
+
+    size_t p = 0;
+    while (p < line.size() && line[p] == ' ') ++p;
+    size_t end = p;
+    while (end < line.size() && (std::islower(static_cast<unsigned char>(line[end])) || line[end] == '-')) ++end;
+    std::string verb = line.substr(p, end - p);
+    if (verb.empty() || (end < line.size() && line[end] != ' ' && line[end] != '\r')) verb = "other";
+
+    auto it = cache.find(verb);
+    if (it != cache.end()) return *it->second;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!verbs.count(verb) && verbs.size() >= kMaxVerbs) verb = "other";
+        else verbs.insert(verb);
+    }
+    Histogram& h = Metrics::instance().histogram("helix_ipc_request_seconds", {{"command", verb}},
+                                                 "Control command latency, including the wait for the state lock");
+    cache.emplace(verb, &h);
+    return h;
+}
+
+// How the reply to a request is written back.
+enum class ReplyMode {
+    OneShot,  // raw text, connection closes afterwards
+    Session,  // dot-terminated text frame
+    Framed,   // 8-byte header (length, request id) followed by the payload
+};
+
+struct Request {
+    std::string line;
+    std::string tag;        // session tag ("@tag cmd")
+    uint32_t id = 0;        // framed request id
+    ReplyMode mode = ReplyMode::OneShot;
+    bool switch_to_framed = false; // the "framed" handshake; answered inline
+    bool stream = false;    // goes to the stream opener instead of the handler
+};
+
+// A queued piece of output. Payloads are shared, so cached replies are sent as-is.
+struct OutChunk {
+    IpcServer::Payload data;
+    size_t off = 0;
+};
+
+void put_be32(char* p, uint32_t v) {
+    p[0] = static_cast<char>(v >> 24);
+    p[1] = static_cast<char>(v >> 16);
+    p[2] = static_cast<char>(v >> 8);
+    p[3] = static_cast<char>(v);
+}
+
+uint32_t get_be32(const char* p) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 24) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(p[2])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(p[3]));
+}
+
+IpcServer::Payload make_payload(std::string s) {
+    return std::make_shared<const std::string>(std::move(s));
+}
+
+struct Connection {
+    int fd = -1;
+    uint64_t id = 0;
+    std::string in;
+    std::deque<OutChunk> out;
+    std::deque<Request> pending;       // requests waiting for the previous command
+    bool busy = false;                 // a command from this connection is on a worker
+    bool session = false;              // persistent, framed responses
+    bool framed = false;               // input is parsed as length-prefixed frames
+    bool one_shot_done = false;        // one-shot mode: command received, ignore further input
+    bool read_closed = false;          // peer shut down its write side
+    bool close_after_write = false;
+    std::shared_ptr<IpcServer::Stream> stream; // set once a stream command succeeded
+    uint32_t events = EPOLLIN | EPOLLRDHUP; // currently registered epoll interest
+    Clock::time_point last_activity;
+    Clock::time_point last_write_progress;
+
+    bool has_output() const { return !out.empty(); }
+
+    void queue(IpcServer::Payload data) {
+        if (out.empty()) last_write_progress = Clock::now();
+        if (data && !data->empty()) out.push_back(OutChunk{std::move(data), 0});
+    }
+
+    // Encodes a reply for the request's mode. Framed replies keep the payload by
+    // reference: the header goes out as its own chunk and both leave in one writev().
+    void queue_reply(const Request& req, IpcServer::Payload payload) {
+        static const IpcServer::Payload empty = make_payload(std::string());
+        if (!payload) payload = empty;
+        switch (req.mode) {
+            case ReplyMode::Framed: {
+                std::string header(8, '\0');
+                put_be32(&header[0], static_cast<uint32_t>(payload->size()));
+                put_be32(&header[4], req.id);
+                queue(make_payload(std::move(header)));
+                queue(std::move(payload));
+                break;
+            }
+            case ReplyMode::Session:
+                queue(make_payload(frame_response(*payload, req.tag)));
+                break;
+            case ReplyMode::OneShot:
+                if (!payload->empty() && payload->back() == '\n') queue(std::move(payload));
+                else queue(make_payload(*payload + "\n"));
+                break;
+        }
+    }
+};
+
+struct Job {
+    uint64_t conn_id;
+    Request req;
+    Clock::time_point submitted{};
+};
+
+struct Completion {
+    uint64_t conn_id;
+    IpcServer::Payload response;
+    Request req;
+    std::shared_ptr<IpcServer::Stream> stream;
+};
+
+// Streams with output waiting; notify() may run on any thread
+struct StreamWakeups {
+    int wake_fd = -1;
+    std::mutex mtx;
+    std::vector<uint64_t> conn_ids;
+
+    void notify(uint64_t conn_id) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            conn_ids.push_back(conn_id);
+        }
+        wake(wake_fd);
+    }
+
+    std::vector<uint64_t> take() {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<uint64_t> out;
+        out.swap(conn_ids);
+        return out;
+    }
+};
+
+// Runs commands off the event loop. Read-only commands share the state lock; all
+// other commands hold it exclusively, so lifecycle mutations never overlap.
+// Commands classified as unlocked take no lock at all.
+class WorkerPool {
+public:
+    WorkerPool(size_t count, const IpcServer::SharedHandler& handler, const IpcServer::Classifier& read_only,
+               const IpcServer::Classifier& unlocked, const IpcServer::StreamOpener& open_stream,
+               StateLock& state_lock, int wake_fd)
+        : handler_(handler), read_only_(read_only), unlocked_(unlocked), open_stream_(open_stream), wake_fd_(wake_fd),
+          state_lock_(state_lock) {
+        if (count == 0) count = 1;
+        for (size_t i = 0; i < count; ++i) threads_.emplace_back([this]{ run(); });
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    void submit(Job job) {
+        job.submitted = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    std::vector<Completion> take_completions() {
+        std::lock_guard<std::mutex> lock(done_mtx_);
+        std::vector<Completion> out;
+        out.swap(done_);
+        return out;
+    }
+
+private:
+    IpcServer::Payload execute(const std::string& line) {
+        if (!handler_) return make_payload("ERR no handler\n");
+        ScopedTimer timer(request_histogram(line));
+        try {
+            if (unlocked_ && unlocked_(line)) {
+                return handler_(line);
+            }
+            if (read_only_ && read_only_(line)) {
+                std::shared_lock<std::shared_mutex> lock(state_lock_.state);
+                return handler_(line);
+            }
+            MutationLock lock(state_lock_);
+            return handler_(line);
+        } catch (...) {
+            return make_payload("ERR exception\n");
+        }
+    }
+
+    // Opening a stream reads handler state (e.g. a snapshot to start from), so it takes the read lock
+    std::shared_ptr<IpcServer::Stream> execute_stream(const std::string& line, IpcServer::Payload& reply) {
+        ScopedTimer timer(request_histogram(line));
+        try {
+            std::shared_lock<std::shared_mutex> lock(state_lock_.state);
+            return open_stream_(line, reply);
+        } catch (...) {
+            reply = make_payload("ERR exception\n");
+            return nullptr;
+        }
+    }
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cv_.wait(lock, [this]{ return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            static Histogram& queue_wait = Metrics::instance().histogram(
+                "helix_ipc_queue_wait_seconds", {}, "Time a control command waits for a free worker");
+            queue_wait.record(Clock::now() - job.submitted);
+            IpcServer::Payload response;
+            std::shared_ptr<IpcServer::Stream> stream;
+            if (job.req.stream) stream = execute_stream(job.req.line, response);
+            else response = execute(job.req.line);
+            {
+                std::lock_guard<std::mutex> lock(done_mtx_);
+                done_.push_back(Completion{job.conn_id, std::move(response), std::move(job.req), std::move(stream)});
+            }
+            wake(wake_fd_);
+        }
+    }
+
+    const IpcServer::SharedHandler& handler_;
+    const IpcServer::Classifier& read_only_;
+    const IpcServer::Classifier& unlocked_;
+    const IpcServer::StreamOpener& open_stream_;
+    int wake_fd_;
+    StateLock& state_lock_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    bool stopping_ = false;
+    std::mutex done_mtx_;
+    std::vector<Completion> done_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace
+
+IpcServer::IpcServer(std::string socket_path) : IpcServer(std::move(socket_path), Options{}) {}
+
+IpcServer::IpcServer(std::string socket_path, Options options)
+    : socket_path_(std::move(socket_path)), options_(options) {}
+
+IpcServer::~IpcServer() {
+    stop();
+    close_listener();
+}
 
 void IpcServer::stop() {
     running_.store(false);
+    wake(wake_fd_.load());
+}
+
+void IpcServer::close_listener() {
     if (listen_fd_ >= 0) {
         close(listen_fd_);
         listen_fd_ = -1;
@@ -26,9 +361,10 @@ void IpcServer::stop() {
     if (created_socket_ && !socket_path_.empty() && fs::exists(socket_path_)) {
         fs::remove(socket_path_);
     }
+    created_socket_ = false;
 }
 
-bool IpcServer::serve(Handler handler) {
+bool IpcServer::open_listener() {
     // Ensure parent directory exists
     try {
         auto dir = fs::path(socket_path_).parent_path();
@@ -58,7 +394,7 @@ bool IpcServer::serve(Handler handler) {
             fs::remove(socket_path_);
         }
 
-        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
         if (listen_fd_ < 0) {
             std::cerr << "IPC: socket() failed: " << std::strerror(errno) << std::endl;
             return false;
@@ -69,56 +405,405 @@ bool IpcServer::serve(Handler handler) {
         std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path_.c_str());
         if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
             std::cerr << "IPC: bind() failed: " << std::strerror(errno) << std::endl;
-            stop();
+            close_listener();
             return false;
         }
+        created_socket_ = true;
 
         // Relax permissions to allow non-root clients by default (0666)
         if (::chmod(socket_path_.c_str(), 0666) < 0) {
             std::cerr << "IPC: chmod(" << socket_path_ << ") failed: " << std::strerror(errno) << std::endl;
         }
 
-        if (::listen(listen_fd_, 4) < 0) {
+        if (::listen(listen_fd_, options_.backlog > 0 ? options_.backlog : SOMAXCONN) < 0) {
             std::cerr << "IPC: listen() failed: " << std::strerror(errno) << std::endl;
-            stop();
+            close_listener();
             return false;
         }
-        created_socket_ = true;
     }
 
+    if (!set_nonblocking(listen_fd_)) {
+        std::cerr << "IPC: failed to make listening socket non-blocking: " << std::strerror(errno) << std::endl;
+        close_listener();
+        return false;
+    }
+    return true;
+}
+
+bool IpcServer::serve(Handler handler) {
+    if (!handler) return serve(SharedHandler());
+    return serve(SharedHandler([handler = std::move(handler)](const std::string& line) {
+        return make_payload(handler(line));
+    }));
+}
+
+bool IpcServer::serve(SharedHandler handler) {
+    if (!open_listener()) return false;
+
+    int ep = ::epoll_create1(EPOLL_CLOEXEC);
+    int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ep < 0 || efd < 0) {
+        std::cerr << "IPC: epoll/eventfd setup failed: " << std::strerror(errno) << std::endl;
+        if (ep >= 0) close(ep);
+        if (efd >= 0) close(efd);
+        close_listener();
+        return false;
+    }
+    wake_fd_.store(efd);
+
+    // Tags 0 and 1 identify the listener and the wakeup fd; connections use ids >= 2.
+    constexpr uint64_t kListenTag = 0;
+    constexpr uint64_t kWakeTag = 1;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kListenTag;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = kWakeTag;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, efd, &ev);
+
+    StreamWakeups stream_wakeups; // outlives every connection's stream
+    stream_wakeups.wake_fd = efd;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> conns;
+    uint64_t next_id = 2;
+    bool ok = true;
+
     running_.store(true);
-    while (running_.load()) {
-        int client_fd = ::accept(listen_fd_, nullptr, nullptr);
-        if (client_fd < 0) {
-            if (errno == EINTR) continue;
-            if (!running_.load()) break;
-            std::cerr << "IPC: accept() failed: " << std::strerror(errno) << std::endl;
-            break;
-        }
+    {
+        WorkerPool pool(options_.workers, handler, read_only_, unlocked_, open_stream_, state_lock_, efd);
 
-        // Read a single line command
-        std::string input;
-        char buf[1024];
-        ssize_t n;
-        while ((n = ::read(client_fd, buf, sizeof(buf))) > 0) {
-            input.append(buf, buf + n);
-            if (input.find('\n') != std::string::npos) break;
-        }
-        if (!input.empty() && input.back() == '\n') input.pop_back();
+        // Poll for input until the peer's EOF (it would fire continuously afterwards)
+        // and for output only while a response is pending.
+        auto update_interest = [&](Connection& c) {
+            uint32_t want = (c.read_closed ? 0u : (EPOLLIN | EPOLLRDHUP)) |
+                            (c.has_output() ? EPOLLOUT : 0u);
+            if (want == c.events) return;
+            epoll_event cev{};
+            cev.events = want;
+            cev.data.u64 = c.id;
+            ::epoll_ctl(ep, EPOLL_CTL_MOD, c.fd, &cev);
+            c.events = want;
+        };
 
-        std::string response;
-        try {
-            response = handler ? handler(input) : std::string("ERR no handler\n");
-        } catch (...) {
-            response = "ERR exception\n";
+        auto close_conn = [&](uint64_t id) {
+            auto it = conns.find(id);
+            if (it == conns.end()) return;
+            ::epoll_ctl(ep, EPOLL_CTL_DEL, it->second->fd, nullptr);
+            ::close(it->second->fd);
+            conns.erase(it);
+        };
+
+        // Flush as much output as the socket takes, pulling more from a stream whenever
+        // the queue runs dry. Returns false if the connection was closed.
+        auto flush = [&](Connection& c) -> bool {
+            constexpr size_t kMaxIov = 32;
+            struct iovec iov[kMaxIov];
+            for (;;) {
+                if (!c.has_output()) {
+                    if (!c.stream) break;
+                    std::string chunk;
+                    c.stream->drain(chunk);
+                    if (chunk.empty()) break;
+                    c.queue(make_payload(std::move(chunk)));
+                }
+                size_t cnt = 0;
+                for (auto it = c.out.begin(); it != c.out.end() && cnt < kMaxIov; ++it, ++cnt) {
+                    iov[cnt].iov_base = const_cast<char*>(it->data->data() + it->off);
+                    iov[cnt].iov_len = it->data->size() - it->off;
+                }
+                msghdr msg{};
+                msg.msg_iov = iov;
+                msg.msg_iovlen = cnt;
+                ssize_t n = ::sendmsg(c.fd, &msg, MSG_NOSIGNAL);
+                if (n > 0) {
+                    size_t left = static_cast<size_t>(n);
+                    while (left > 0) {
+                        OutChunk& front = c.out.front();
+                        size_t avail = front.data->size() - front.off;
+                        if (left < avail) { front.off += left; break; }
+                        left -= avail;
+                        c.out.pop_front();
+                    }
+                    c.last_write_progress = Clock::now();
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                close_conn(c.id);
+                return false;
+            }
+            if (!c.has_output()) {
+                if ((c.close_after_write || c.read_closed) && !c.busy && c.pending.empty()) {
+                    close_conn(c.id);
+                    return false;
+                }
+            }
+            update_interest(c);
+            return true;
+        };
+
+        static const Payload ok_reply = make_payload("OK\n");
+
+        auto dispatch_next = [&](Connection& c) {
+            if (c.stream) {
+                c.pending.clear();
+                return;
+            }
+            while (!c.busy && !c.pending.empty()) {
+                Request req = std::move(c.pending.front());
+                c.pending.pop_front();
+                if (req.switch_to_framed) {
+                    // Handshake reply is plain text; everything after it is framed
+                    c.queue(ok_reply);
+                    continue;
+                }
+                if (req.mode != ReplyMode::OneShot) {
+                    std::string cmd = req.line;
+                    while (!cmd.empty() && (cmd.back() == ' ' || cmd.back() == '\r')) cmd.pop_back();
+                    if (cmd == "quit") {
+                        c.queue_reply(req, ok_reply);
+                        c.close_after_write = true;
+                        c.pending.clear();
+                        return;
+                    }
+                    if (cmd == "session") { c.queue_reply(req, ok_reply); continue; }
+                }
+                if (open_stream_ && is_stream_ && is_stream_(req.line)) {
+                    if (req.mode == ReplyMode::Framed) {
+                        c.queue_reply(req, make_payload("ERR streams are not available on framed connections\n"));
+                        continue;
+                    }
+                    req.stream = true;
+                }
+                c.busy = true;
+                pool.submit(Job{c.id, std::move(req)});
+            }
+        };
+
+        auto reject_oversized = [&](Connection& c, const Request& req) {
+            c.pending.clear();
+            c.in.clear();
+            c.queue_reply(req, make_payload("ERR command too long\n"));
+            c.close_after_write = true;
+        };
+
+        // Split complete lines (or frames, after the "framed" handshake) out of the
+        // input buffer and queue them.
+        auto consume_input = [&](Connection& c) -> bool {
+            size_t start = 0;
+            for (;;) {
+                if (c.framed) {
+                    if (c.in.size() - start < 8) break;
+                    uint32_t len = get_be32(c.in.data() + start);
+                    Request req;
+                    req.id = get_be32(c.in.data() + start + 4);
+                    req.mode = ReplyMode::Framed;
+                    if (len > options_.max_line) { reject_oversized(c, req); return false; }
+                    if (c.in.size() - start - 8 < len) break;
+                    req.line.assign(c.in, start + 8, len);
+                    start += 8 + len;
+                    c.pending.push_back(std::move(req));
+                    continue;
+                }
+                size_t nl = c.in.find('\n', start);
+                if (nl == std::string::npos) break;
+                Request req;
+                req.line = c.in.substr(start, nl - start);
+                start = nl + 1;
+                std::string cmd = req.line;
+                while (!cmd.empty() && (cmd.back() == ' ' || cmd.back() == '\r')) cmd.pop_back();
+                if (!c.session) {
+                    if (c.one_shot_done) continue;
+                    if (cmd == "session") {
+                        c.session = true;
+                        c.queue(make_payload(frame_response("OK\n")));
+                        continue;
+                    }
+                }
+                if (cmd == "framed") {
+                    c.session = true;
+                    c.framed = true;
+                    req.switch_to_framed = true;
+                    c.pending.push_back(std::move(req));
+                    continue;
+                }
+                if (c.session) {
+                    req.mode = ReplyMode::Session;
+                    req.tag = take_tag(req.line);
+                } else {
+                    c.one_shot_done = true;
+                    c.close_after_write = true;
+                }
+                c.pending.push_back(std::move(req));
+            }
+            c.in.erase(0, start);
+            if (!c.framed && c.in.size() > options_.max_line) {
+                Request req;
+                req.mode = c.session ? ReplyMode::Session : ReplyMode::OneShot;
+                reject_oversized(c, req);
+                return false;
+            }
+            return true;
+        };
+
+        auto handle_readable = [&](Connection& c) -> bool {
+            char buf[4096];
+            for (;;) {
+                ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    c.last_activity = Clock::now();
+                    if (!c.close_after_write && !c.stream) c.in.append(buf, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n == 0) { c.read_closed = true; break; }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                close_conn(c.id);
+                return false;
+            }
+            if (consume_input(c) && c.read_closed && !c.in.empty() && !c.session && !c.one_shot_done) {
+                // One-shot client wrote a command without a trailing newline and closed its side
+                Request req;
+                req.line = std::move(c.in);
+                c.pending.push_back(std::move(req));
+                c.in.clear();
+                c.one_shot_done = true;
+                c.close_after_write = true;
+            }
+            dispatch_next(c);
+            return flush(c);
+        };
+
+        auto accept_clients = [&] {
+            for (;;) {
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                        std::cerr << "IPC: accept() failed: " << std::strerror(errno) << std::endl;
+                    }
+                    return;
+                }
+                if (conns.size() >= options_.max_clients) {
+                    static const char busy[] = "ERR too many clients\n";
+                    ssize_t rc = ::send(fd, busy, sizeof(busy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+                    (void)rc;
+                    ::close(fd);
+                    continue;
+                }
+                auto c = std::make_unique<Connection>();
+                c->fd = fd;
+                c->id = next_id++;
+                c->last_activity = c->last_write_progress = Clock::now();
+                epoll_event cev{};
+                cev.events = EPOLLIN | EPOLLRDHUP;
+                cev.data.u64 = c->id;
+                if (::epoll_ctl(ep, EPOLL_CTL_ADD, fd, &cev) < 0) {
+                    ::close(fd);
+                    continue;
+                }
+                conns.emplace(c->id, std::move(c));
+            }
+        };
+
+        auto handle_completions = [&] {
+            uint64_t drained;
+            while (::read(efd, &drained, sizeof(drained)) > 0) {}
+            for (auto& done : pool.take_completions()) {
+                auto it = conns.find(done.conn_id);
+                if (it == conns.end()) continue; // client went away while the command ran
+                Connection& c = *it->second;
+                c.busy = false;
+                c.last_activity = Clock::now();
+                c.queue_reply(done.req, std::move(done.response));
+                if (done.stream) {
+                    // The connection now only carries stream output
+                    c.stream = std::move(done.stream);
+                    c.pending.clear();
+                    c.one_shot_done = true;
+                    c.close_after_write = false;
+                    const uint64_t conn_id = c.id;
+                    c.stream->attach([&stream_wakeups, conn_id] { stream_wakeups.notify(conn_id); });
+                }
+                dispatch_next(c);
+                flush(c);
+            }
+            for (uint64_t id : stream_wakeups.take()) {
+                auto it = conns.find(id);
+                if (it == conns.end() || it->second->has_output()) continue; // drained once the socket takes more
+                flush(*it->second);
+            }
+        };
+
+        auto expire_clients = [&] {
+            const auto now = Clock::now();
+            std::vector<uint64_t> expired;
+            for (auto& [id, c] : conns) {
+                if (c->busy || c->stream) continue;
+                bool writing = c->has_output();
+                if (writing && options_.write_timeout_ms > 0 &&
+                    now - c->last_write_progress > std::chrono::milliseconds(options_.write_timeout_ms)) {
+                    expired.push_back(id);
+                } else if (!writing && c->pending.empty() && options_.idle_timeout_ms > 0 &&
+                           now - c->last_activity > std::chrono::milliseconds(options_.idle_timeout_ms)) {
+                    expired.push_back(id);
+                }
+            }
+            for (uint64_t id : expired) close_conn(id);
+        };
+
+        epoll_event events[64];
+        auto last_sweep = Clock::now();
+        while (running_.load()) {
+            int n = ::epoll_wait(ep, events, 64, 500);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "IPC: epoll_wait() failed: " << std::strerror(errno) << std::endl;
+                ok = false;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                const uint64_t tag = events[i].data.u64;
+                if (tag == kListenTag) { accept_clients(); continue; }
+                if (tag == kWakeTag) { handle_completions(); continue; }
+                auto it = conns.find(tag);
+                if (it == conns.end()) continue;
+                Connection& c = *it->second;
+                const uint32_t e = events[i].events;
+                if ((e & EPOLLERR) || ((e & EPOLLHUP) && !(e & EPOLLIN))) {
+                    // Keep the connection while a command runs so the worker result has a home;
+                    // the send in flush() will fail and close it then.
+                    if (!c.busy) {
+                        close_conn(tag);
+                    } else {
+                        c.read_closed = true;
+                        c.pending.clear();
+                        update_interest(c);
+                    }
+                    continue;
+                }
+                if (e & (EPOLLIN | EPOLLRDHUP)) {
+                    if (!handle_readable(c)) continue;
+                }
+                if (e & EPOLLOUT) flush(c);
+            }
+            auto now = Clock::now();
+            if (now - last_sweep >= std::chrono::milliseconds(250)) {
+                expire_clients();
+                last_sweep = now;
+            }
         }
-        if (!response.empty() && response.back() != '\n') response.push_back('\n');
-        ::write(client_fd, response.data(), response.size());
-        ::close(client_fd);
+        if (stop_hook_) stop_hook_();
+        // WorkerPool destructor finishes queued commands before connections are closed
     }
 
-    stop();
-    return true;
+    for (auto& [id, c] : conns) ::close(c->fd);
+    conns.clear();
+    wake_fd_.store(-1);
+    ::close(efd);
+    ::close(ep);
+    running_.store(false);
+    close_listener();
+    return ok;
 }
 
 } // namespace helix
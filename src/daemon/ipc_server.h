@@ -2,29 +2,126 @@
 #define HELIX_IPC_SERVER_H
 
 #include <atomic>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <shared_mutex>
 #include <string>
 
+#include "state_lock.h"
+
 namespace helix {
 
+// Event-driven control socket server.
+//
+// Connections start in one-shot mode (one command, one response, close), which is
+// what plain `helixctl` and scripts using socat/nc expect. A client that sends
+// `session` first keeps the connection open and may send any number of
+// newline-delimited commands; each response is then terminated by a line holding
+// a single '.', and response lines that begin with '.' are sent with an extra '.'.
+// A session command may be prefixed with "@<tag> "; its response then ends with
+// ". <tag>" instead of "." so pipelining clients can match replies to requests.
+//
+// Sending `framed` (first, or inside a session) switches the connection to binary
+// framing after a plain "OK\n": every request and reply is an 8-byte header
+// (payload length and request id, both big-endian uint32) followed by the payload.
+// Replies echo the request id and are written with a single writev().
+//
+// Commands run on a small worker pool. Commands the classifier reports as read-only
+// run concurrently under the shared state lock; all others take a MutationLock, so
+// they are serialized against each other and against reads except while the
+// handler runs module code (see StateLock).
+// Commands the unlocked classifier accepts bypass the state lock entirely.
+// Commands from one connection are always handled in order.
+//
+// A command the stream classifier accepts (see set_stream_opener) turns its
+// connection into a stream: after the reply, the server writes whatever the
+// returned Stream produces until either side closes the connection. Input after
+// that command is ignored, and streams are exempt from the idle and write timeouts.
 class IpcServer {
 public:
     using Handler = std::function<std::string(const std::string&)>;
+    // Shared payloads let handlers return cached, preserialized replies without a copy.
+    using Payload = std::shared_ptr<const std::string>;
+    using SharedHandler = std::function<Payload(const std::string&)>;
+    using Classifier = std::function<bool(const std::string&)>;
+
+    // Output pushed to a connection after its command's reply.
+    class Stream {
+    public:
+        virtual ~Stream() = default;
+        // Called once on the server thread with a function that schedules drain();
+        // call it from any thread whenever output becomes available.
+        virtual void attach(std::function<void()> notify) = 0;
+        // Append pending output to out. Called on the server thread whenever the
+        // connection has nothing left to write; keep each call's output small.
+        virtual void drain(std::string& out) = 0;
+    };
+    // Runs on a worker under the read lock. Returns the stream, or nullptr with the
+    // error in reply; on success reply is sent first.
+    using StreamOpener = std::function<std::shared_ptr<Stream>(const std::string& line, Payload& reply)>;
+
+    struct Options {
+        int backlog = 128;                 // listen() backlog
+        size_t workers = 4;                // command worker threads
+        int idle_timeout_ms = 30000;       // close connections idle this long (0 = never)
+        int write_timeout_ms = 5000;       // close clients that stop reading responses
+        size_t max_line = 64 * 1024;       // longest accepted command line
+        size_t max_clients = 1024;         // further connections are refused
+    };
 
     explicit IpcServer(std::string socket_path);
+    IpcServer(std::string socket_path, Options options);
     ~IpcServer();
 
+    // Commands for which the classifier returns true may run concurrently.
+    // Without a classifier every command is serialized.
+    void set_read_only_classifier(Classifier classifier) { read_only_ = std::move(classifier); }
+
+    // Commands for which this classifier returns true run without the state lock;
+    // they must not touch handler state that other commands mutate (e.g. blocking waits).
+    void set_unlocked_classifier(Classifier classifier) { unlocked_ = std::move(classifier); }
+
+    // Commands for which the classifier returns true are passed to the opener instead
+    // of the handler. Streams are plain text; framed connections get an error.
+    void set_stream_opener(Classifier is_stream, StreamOpener opener) {
+        is_stream_ = std::move(is_stream);
+        open_stream_ = std::move(opener);
+    }
+
+    // Called on the serving thread once the event loop ends, before the worker pool
+    // finishes queued commands and joins; use it to release handlers that block.
+    void set_stop_hook(std::function<void()> hook) { stop_hook_ = std::move(hook); }
+
+    // The lock serializing handler calls. Code outside the server that mutates the
+    // same state must hold a MutationLock on it.
+    StateLock& state_lock() { return state_lock_; }
+
     // Start listening and handling connections in the current thread.
     // Returns true on clean shutdown, false on fatal error.
     bool serve(Handler handler);
+    bool serve(SharedHandler handler);
 
+    // Safe to call from any thread; serve() returns shortly after.
     void stop();
 
     const std::string& socket_path() const { return socket_path_; }
+    const Options& options() const { return options_; }
 
 private:
+    bool open_listener();
+    void close_listener();
+
     std::string socket_path_;
+    Options options_;
+    Classifier read_only_;
+    Classifier unlocked_;
+    Classifier is_stream_;
+    StreamOpener open_stream_;
+    std::function<void()> stop_hook_;
+    StateLock state_lock_;
     std::atomic<bool> running_{false};
+    std::atomic<int> wake_fd_{-1};
     int listen_fd_{-1};
     bool created_socket_{false};
 };
@@ -0,0 +1,147 @@
+#include "lifecycle_jobs.h"
+#include <chrono>
+
+namespace helix {
+
+LifecycleJobs::LifecycleJobs(StateLock& state_lock, size_t keep_finished)
+    : state_lock_(state_lock), keep_finished_(keep_finished), executor_([this] { run(); }) {}
+
+LifecycleJobs::~LifecycleJobs() {
+    stop();
+}
+
+uint64_t LifecycleJobs::submit(const std::string& action, const std::string& target, Operation op) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Entry entry;
+    entry.job.id = next_id_++;
+    entry.job.action = action;
+    entry.job.target = target;
+    entry.op = std::move(op);
+    if (stopping_) {
+        entry.job.state = State::Cancelled;
+        entry.job.error = "daemon shutting down";
+    }
+    entries_.push_back(std::move(entry));
+
+    // Forget the oldest finished jobs beyond the retention limit
+    size_t finished = 0;
+    for (const auto& e : entries_) {
+        if (e.job.state != State::Queued && e.job.state != State::Running) ++finished;
+    }
+    while (finished > keep_finished_ && !entries_.empty() &&
+           entries_.front().job.state != State::Queued && entries_.front().job.state != State::Running) {
+        entries_.pop_front();
+        --finished;
+    }
+
+    work_cv_.notify_one();
+    return entries_.back().job.id;
+}
+
+bool LifecycleJobs::wait(uint64_t id, int timeout_ms, Job& out) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto finished = [&]() {
+        Entry* e = find_locked(id);
+        return stopping_ || !e || (e->job.state != State::Queued && e->job.state != State::Running);
+    };
+    if (timeout_ms <= 0) timeout_ms = kDefaultWaitMs;
+    if (timeout_ms > kMaxWaitMs) timeout_ms = kMaxWaitMs;
+    done_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), finished);
+    Entry* e = find_locked(id);
+    if (!e) return false;
+    if (stopping_ && (e->job.state == State::Queued || e->job.state == State::Running)) return false;
+    out = e->job;
+    return true;
+}
+
+std::vector<LifecycleJobs::Job> LifecycleJobs::list() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<Job> out;
+    out.reserve(entries_.size());
+    for (const auto& e : entries_) out.push_back(e.job);
+    return out;
+}
+
+void LifecycleJobs::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopping_ && !executor_.joinable()) return;
+        stopping_ = true;
+        for (auto& e : entries_) {
+            if (e.job.state == State::Queued) {
+                e.job.state = State::Cancelled;
+                e.job.error = "daemon shutting down";
+            }
+        }
+    }
+    work_cv_.notify_all();
+    done_cv_.notify_all();
+    if (executor_.joinable()) executor_.join();
+}
+
+bool LifecycleJobs::stopping() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stopping_;
+}
+
+const char* LifecycleJobs::state_name(State state) {
+    switch (state) {
+        case State::Queued: return "queued";
+        case State::Running: return "running";
+        case State::Succeeded: return "succeeded";
+        case State::Failed: return "failed";
+        case State::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+void LifecycleJobs::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+        Entry* next = nullptr;
+        work_cv_.wait(lock, [&]() {
+            for (auto& e : entries_) {
+                if (e.job.state == State::Queued) { next = &e; break; }
+            }
+            return stopping_ || next;
+        });
+        if (!next) return; // stopping with nothing queued
+
+        const uint64_t id = next->job.id;
+        Operation op = std::move(next->op);
+        next->job.state = State::Running;
+        lock.unlock();
+
+        std::string error;
+        bool ok = false;
+        const auto t0 = std::chrono::steady_clock::now();
+        try {
+            MutationLock state(state_lock_);
+            ok = op(error);
+        } catch (const std::exception& e) {
+            error = std::string("exception: ") + e.what();
+        } catch (...) {
+            error = "exception";
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        lock.lock();
+        // submit() never trims running jobs, so the entry is still present
+        if (Entry* e = find_locked(id)) {
+            e->job.state = ok ? State::Succeeded : State::Failed;
+            e->job.error = ok ? std::string() : error;
+            e->job.elapsed_ms = ms;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+LifecycleJobs::Entry* LifecycleJobs::find_locked(uint64_t id) {
+    // Ids are dense and ascending, so the position is id minus the first id
+    if (entries_.empty() || id < entries_.front().job.id) return nullptr;
+    const uint64_t pos = id - entries_.front().job.id;
+    if (pos >= entries_.size()) return nullptr;
+    return &entries_[pos];
+}
+
+} // namespace helix
@@ -0,0 +1,86 @@
+#ifndef HELIX_LIFECYCLE_JOBS_H
+#define HELIX_LIFECYCLE_JOBS_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "state_lock.h"
+
+namespace helix {
+
+// Queue of lifecycle operations (`enable --async` and friends) run by one executor
+// thread. Each job holds a MutationLock while it runs, exactly like a synchronous
+// mutation from the control socket, so jobs and direct commands never overlap; queries
+// still run while the job is inside module code (see StateLock). Clients get the job id immediately and poll with `jobs` or block in `wait`;
+// both only touch the job table and must not be called under the state lock.
+class LifecycleJobs {
+public:
+    enum class State { Queued, Running, Succeeded, Failed, Cancelled };
+
+    struct Job {
+        uint64_t id = 0;
+        std::string action;
+        std::string target;
+        State state = State::Queued;
+        std::string error;     // failure reason when state is Failed/Cancelled
+        double elapsed_ms = 0; // run time once finished
+    };
+
+    // Runs the operation; returns false and fills error on failure.
+    using Operation = std::function<bool(std::string& error)>;
+
+    explicit LifecycleJobs(StateLock& state_lock, size_t keep_finished = 256);
+    ~LifecycleJobs();
+
+    // Queue an operation; returns its job id.
+    uint64_t submit(const std::string& action, const std::string& target, Operation op);
+
+    // A waiter occupies an IPC worker, so every wait is bounded: timeout_ms <= 0 means
+    // kDefaultWaitMs and longer timeouts are capped at kMaxWaitMs.
+    static constexpr int kDefaultWaitMs = 30 * 1000;
+    static constexpr int kMaxWaitMs = 5 * 60 * 1000;
+
+    // Wait until the job finishes or the timeout passes. Returns false for unknown (or
+    // already forgotten) ids and when stop() interrupts the wait; otherwise out holds
+    // the latest snapshot.
+    bool wait(uint64_t id, int timeout_ms, Job& out);
+
+    // Snapshot of queued, running and recently finished jobs in id order.
+    std::vector<Job> list() const;
+
+    // Cancel queued jobs, release every waiter and stop after the running one completes.
+    void stop();
+
+    bool stopping() const;
+
+    static const char* state_name(State state);
+
+private:
+    struct Entry {
+        Job job;
+        Operation op;
+    };
+
+    void run();
+    Entry* find_locked(uint64_t id);
+
+    StateLock& state_lock_;
+    const size_t keep_finished_;
+    mutable std::mutex mtx_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Entry> entries_; // ascending ids; finished ones are trimmed from the front
+    uint64_t next_id_ = 1;
+    bool stopping_ = false;
+    std::thread executor_;
+};
+
+} // namespace helix
+
+#endif // HELIX_LIFECYCLE_JOBS_H
@@ -1,23 +1,36 @@
 #include <vector>
 #include <mutex>
 #include <algorithm>
-#include <deque>
 #include <atomic>
-#include <tuple>
 #include <string>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <unordered_map>
 // Centralized logging registry with bounded pre-sink queue, stats, and level filtering.
 // Environment variables influence behavior:
 // - HELIX_LOG_QUEUE_CAP: capacity of pre-sink queue (default 256)
 // - HELIX_LOG_MIN_LEVEL: 0=DEBUG,1=INFO,2=WARN,3=ERROR (default 1)
+// - HELIX_LOG_ASYNC: 1 to enable async mode (producers enqueue, a dispatcher thread calls sinks)
+// - HELIX_LOG_RING_CAP: async ring capacity in records, rounded up to a power of two (default 1024)
+//
+// Records are fixed-size binary structs (interned module id, level, monotonic timestamp,
+// thread id, message). In async mode each producer thread stages records in its own
+// single-producer buffer; the shared lock-free ring only absorbs overflow. Sinks either
+// take HelixLogRecord batches (v2) or the original (module, level, message) triple (v1).
 #include <cstdlib>
 #include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #include "helix/log.h"
+#include "helix/metrics.h"
 
 using LogSink = void (*)(const char*, int, const char*);
 
-static std::mutex g_log_mtx;
-static std::vector<LogSink> g_sinks;
-static std::deque<std::tuple<std::string,int,std::string>> g_queue; // pre-sink backlog while no sinks
+static std::mutex g_log_mtx; // serializes sink list writers and guards g_queue
 
 static std::atomic<int> g_min_level{1}; // default INFO
 static std::atomic<uint64_t> g_dispatched{0};
@@ -26,6 +39,642 @@ static std::atomic<uint64_t> g_dropped_overflow{0};
 static std::atomic<uint64_t> g_dropped_filtered{0};
 static size_t g_queue_cap = 256;
 
+namespace {
+
+// Packed record used by the pre-sink queue, the shared async ring and the per-thread
+// staging buffers. Longer messages are truncated.
+struct LogRecord {
+    static constexpr size_t kMessageMax = 472;
+    uint64_t timestamp_ns;
+    uint64_t thread_id;
+    uint32_t module_id;
+    int32_t  level;
+    uint32_t message_len;
+    char     message[kMessageMax];
+};
+
+// --- Module name interning ---
+// Ids index a fixed table of leaked, immutable names; id 0 means "(unknown)".
+constexpr size_t kMaxModuleIds = 4096;
+std::atomic<const char*> g_module_names[kMaxModuleIds];
+std::mutex g_intern_mtx;
+std::unordered_map<std::string, uint32_t> g_module_ids; // guarded by g_intern_mtx
+
+struct InternCacheEntry {
+    const char* key;
+    uint32_t id;
+};
+thread_local InternCacheEntry t_intern_cache[16];
+
+const char* module_name_for(uint32_t id) {
+    const char* name = id < kMaxModuleIds ? g_module_names[id].load(std::memory_order_acquire) : nullptr;
+    return name ? name : "(unknown)";
+}
+
+// Module names are usually string literals, so a per-thread cache keyed by pointer
+// (confirmed with strcmp) avoids the intern lock on the hot path.
+uint32_t intern_module(const char* name) {
+    auto& slot = t_intern_cache[(reinterpret_cast<uintptr_t>(name) >> 3) & 15];
+    if (slot.key == name && slot.id != 0 && std::strcmp(module_name_for(slot.id), name) == 0) {
+        return slot.id;
+    }
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_intern_mtx);
+        auto it = g_module_ids.find(name);
+        if (it != g_module_ids.end()) {
+            id = it->second;
+        } else if (g_module_ids.size() + 1 < kMaxModuleIds) {
+            id = static_cast<uint32_t>(g_module_ids.size() + 1);
+            size_t len = std::strlen(name);
+            char* copy = new char[len + 1];
+            std::memcpy(copy, name, len + 1);
+            g_module_names[id].store(copy, std::memory_order_release);
+            g_module_ids.emplace(std::string(name, len), id);
+        }
+    }
+    if (id != 0) slot = InternCacheEntry{name, id};
+    return id;
+}
+
+uint64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+thread_local uint64_t t_thread_id = 0;
+
+uint64_t current_thread_id() {
+    if (t_thread_id == 0) t_thread_id = static_cast<uint64_t>(::syscall(SYS_gettid));
+    return t_thread_id;
+}
+
+void fill_record(LogRecord& rec, uint32_t module_id, int level, uint64_t ts, uint64_t tid,
+                 const char* msg, size_t len) {
+    if (len > LogRecord::kMessageMax - 1) len = LogRecord::kMessageMax - 1;
+    rec.timestamp_ns = ts;
+    rec.thread_id = tid;
+    rec.module_id = module_id;
+    rec.level = level;
+    rec.message_len = static_cast<uint32_t>(len);
+    std::memcpy(rec.message, msg, len);
+    rec.message[len] = '\0';
+}
+
+HelixLogRecord view_of(const LogRecord& rec) {
+    return HelixLogRecord{rec.timestamp_ns, rec.thread_id, rec.module_id, rec.level,
+                          module_name_for(rec.module_id), rec.message, rec.message_len};
+}
+
+// Bounded pre-sink backlog. Grows on demand up to the configured capacity and then
+// stays allocated; records are stored inline, so queueing does not allocate per message.
+class PreSinkQueue {
+public:
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    bool push(const LogRecord& rec, size_t cap) {
+        if (count_ >= cap) return false;
+        if (count_ == buf_.size()) grow(cap);
+        buf_[(head_ + count_) % buf_.size()] = rec;
+        ++count_;
+        return true;
+    }
+
+    const LogRecord& front() const { return buf_[head_]; }
+
+    void pop() {
+        head_ = (head_ + 1) % buf_.size();
+        --count_;
+    }
+
+private:
+    void grow(size_t cap) {
+        size_t next = std::min(cap, std::max<size_t>(16, buf_.size() * 2));
+        std::vector<LogRecord> bigger(next);
+        for (size_t i = 0; i < count_; ++i) bigger[i] = buf_[(head_ + i) % buf_.size()];
+        buf_.swap(bigger);
+        head_ = 0;
+    }
+
+    std::vector<LogRecord> buf_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
+class StagingBuffer;
+
+// Bounded lock-free multi-producer ring (Vyukov-style per-slot sequence numbers).
+// Only the dispatcher thread consumes; it reads records in place and releases them
+// after the sinks return, so draining does not copy. Each slot remembers the staging
+// buffer of the thread that overflowed into it (nullptr if it had none).
+class LogRing {
+public:
+    explicit LogRing(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        mask_ = cap - 1;
+        slots_.reset(new Slot[cap]);
+        for (size_t i = 0; i < cap; ++i) slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    size_t size() const {
+        size_t head = enqueue_pos_.load(std::memory_order_relaxed);
+        size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+        return head >= tail ? head - tail : 0;
+    }
+
+    uint64_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+    bool try_push(StagingBuffer* owner, uint32_t module_id, int level, uint64_t ts, uint64_t tid,
+                  const char* msg, size_t len) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->owner = owner;
+        fill_record(slot->rec, module_id, level, ts, tid, msg, len);
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        size_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+        uint64_t depth = tail <= pos + 1 ? std::min<uint64_t>(pos + 1 - tail, mask_ + 1) : 0;
+        uint64_t hw = high_water_.load(std::memory_order_relaxed);
+        while (depth > hw && !high_water_.compare_exchange_weak(hw, depth, std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    // Single consumer: exposes up to max published records in order without removing them.
+    size_t peek(const LogRecord** out, StagingBuffer** owners, size_t max) const {
+        size_t n = 0;
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (n < max) {
+            const Slot* slot = &slots_[(pos + n) & mask_];
+            if (slot->seq.load(std::memory_order_acquire) != pos + n + 1) break;
+            out[n] = &slot->rec;
+            owners[n] = slot->owner;
+            ++n;
+        }
+        return n;
+    }
+
+    // Single consumer: hands the first n peeked slots back to producers.
+    void release(size_t n) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < n; ++i, ++pos) {
+            slots_[pos & mask_].seq.store(pos + mask_ + 1, std::memory_order_release);
+        }
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        StagingBuffer* owner;
+        LogRecord rec;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<uint64_t> high_water_{0};
+};
+
+// Per-thread single-producer/single-consumer staging buffer. The owning thread appends
+// without atomic read-modify-write operations; the dispatcher drains it in place.
+//
+// To keep a thread's records in order, once it overflows into the shared ring it keeps
+// writing there until the dispatcher has delivered all of those records (ring_pending
+// drops to zero). The dispatcher drains the buffer before delivering any ring record
+// of the same thread, so everything staged is older than what sits in the ring.
+class StagingBuffer {
+public:
+    static constexpr size_t kSlots = 128;
+
+    explicit StagingBuffer(uint64_t tid) : thread_id(tid) {}
+
+    bool try_push(uint32_t module_id, int level, uint64_t ts, uint64_t tid, const char* msg, size_t len) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= kSlots) return false;
+        fill_record(slots_[head % kSlots], module_id, level, ts, tid, msg, len);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+    }
+
+    size_t peek(const LogRecord** out, size_t max) const {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t n = std::min(max, head_.load(std::memory_order_acquire) - tail);
+        for (size_t i = 0; i < n; ++i) out[i] = &slots_[(tail + i) % kSlots];
+        return n;
+    }
+
+    void release(size_t n) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    const uint64_t thread_id;                // producer's kernel thread id
+    std::atomic<bool> orphaned{false};       // owning thread exited; dispatcher frees once drained
+    std::atomic<uint32_t> ring_pending{0};   // this thread's records still in the shared ring
+
+private:
+    LogRecord slots_[kSlots];
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// One registered sink. v1 sinks are adapted by calling them once per record.
+struct SinkEntry {
+    LogSink v1;
+    HelixLogSinkV2Fn v2;
+    void* user;
+};
+
+bool same_sink(const SinkEntry& a, const SinkEntry& b) {
+    return a.v1 == b.v1 && a.v2 == b.v2 && a.user == b.user;
+}
+
+// Immutable sink snapshot. Writers build a new list under g_log_mtx and publish it;
+// dispatch reads the current pointer without copying or locking.
+struct SinkList {
+    std::vector<SinkEntry> sinks;
+};
+
+// Per-thread reader state, on its own cache line so dispatching threads never write
+// a line another thread writes. Slots are recycled when their thread exits, never freed.
+struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> seq{0};    // odd while the owning thread is inside a read section
+    std::atomic<bool> in_use{true};
+};
+
+// Read-side section for the published sink list. Old lists are reclaimed once every
+// thread that was inside a section when the new list was published has left it.
+class SinkReadGuard {
+public:
+    SinkReadGuard();
+    ~SinkReadGuard();
+    SinkReadGuard(const SinkReadGuard&) = delete;
+    SinkReadGuard& operator=(const SinkReadGuard&) = delete;
+    const SinkList* list() const { return list_; }
+private:
+    ReaderSlot* slot_; // nullptr when nested, or counted in g_exiting_readers
+    bool exiting_;
+    const SinkList* list_;
+};
+
+} // namespace
+
+static PreSinkQueue g_queue; // pre-sink backlog while no sinks (guarded by g_log_mtx)
+
+static std::atomic<const SinkList*> g_sink_list{nullptr}; // nullptr when no sinks are registered
+static std::vector<const SinkList*> g_retired; // lists that could not be reclaimed yet (guarded by g_log_mtx)
+static thread_local int t_read_depth = 0;
+
+// Every reader slot handed out so far; wait_for_readers() scans them
+static std::mutex g_reader_mtx;
+static std::vector<ReaderSlot*> g_reader_slots;
+// Readers on threads whose slot was already released (logging from thread_local destructors)
+static std::atomic<uint64_t> g_exiting_readers{0};
+
+// Trivially destructible for the same reason as t_staging below
+static ReaderSlot* const kReaderExited = reinterpret_cast<ReaderSlot*>(uintptr_t{1});
+static thread_local ReaderSlot* t_reader_slot = nullptr;
+
+namespace {
+struct ReaderSlotReleaser {
+    ~ReaderSlotReleaser() {
+        if (t_reader_slot && t_reader_slot != kReaderExited) t_reader_slot->in_use.store(false);
+        t_reader_slot = kReaderExited;
+    }
+};
+thread_local ReaderSlotReleaser t_reader_slot_releaser;
+} // namespace
+
+// The calling thread's slot, claimed on first use; nullptr once the thread is exiting
+static ReaderSlot* thread_reader_slot() {
+    if (t_reader_slot) return t_reader_slot == kReaderExited ? nullptr : t_reader_slot;
+    (void)&t_reader_slot_releaser; // odr-use so the releaser is constructed for this thread
+    std::lock_guard<std::mutex> lock(g_reader_mtx);
+    for (ReaderSlot* slot : g_reader_slots) {
+        bool free = false;
+        if (slot->in_use.compare_exchange_strong(free, true)) {
+            t_reader_slot = slot;
+            return slot;
+        }
+    }
+    auto* slot = new (std::nothrow) ReaderSlot;
+    if (!slot) return nullptr;
+    g_reader_slots.push_back(slot);
+    t_reader_slot = slot;
+    return slot;
+}
+
+// Only the owning thread writes its slot: entering makes seq odd, leaving even again.
+// Both the seq store and the list load are seq_cst, as are the writer's exchange and
+// scan, so either the writer sees this reader inside or the reader sees the new list.
+SinkReadGuard::SinkReadGuard() : slot_(nullptr), exiting_(false) {
+    if (t_read_depth++ == 0) {
+        slot_ = thread_reader_slot();
+        if (slot_) {
+            slot_->seq.store(slot_->seq.load(std::memory_order_relaxed) + 1);
+        } else {
+            g_exiting_readers.fetch_add(1);
+            exiting_ = true;
+        }
+    }
+    list_ = g_sink_list.load();
+}
+
+SinkReadGuard::~SinkReadGuard() {
+    if (slot_) slot_->seq.store(slot_->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    if (exiting_) g_exiting_readers.fetch_sub(1);
+    --t_read_depth;
+}
+
+static void backoff(int spins) {
+    if (spins < 64) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+// Wait until no reader can still hold a list published before this call.
+// Returns false when called from inside a read-side section (e.g. a sink
+// unregistering itself), where waiting would deadlock. Caller holds g_log_mtx.
+static bool wait_for_readers() {
+    if (t_read_depth > 0) return false;
+    // Threads inside a section now; ones entering later already load the new list
+    std::vector<std::pair<ReaderSlot*, uint64_t>> inside;
+    {
+        std::lock_guard<std::mutex> lock(g_reader_mtx);
+        for (ReaderSlot* slot : g_reader_slots) {
+            const uint64_t seq = slot->seq.load();
+            if (seq & 1) inside.emplace_back(slot, seq);
+        }
+    }
+    for (const auto& [slot, seq] : inside) {
+        for (int spins = 0; slot->seq.load(std::memory_order_acquire) == seq; ++spins) backoff(spins);
+    }
+    for (int spins = 0; g_exiting_readers.load() != 0; ++spins) backoff(spins);
+    return true;
+}
+
+// Publish a new sink list and reclaim the previous one. Caller holds g_log_mtx.
+static void publish_sinks(std::vector<SinkEntry> sinks) {
+    const SinkList* next = sinks.empty() ? nullptr : new SinkList{std::move(sinks)};
+    const SinkList* prev = g_sink_list.exchange(next);
+    if (!prev) return;
+    if (wait_for_readers()) {
+        delete prev;
+        for (auto* r : g_retired) delete r;
+        g_retired.clear();
+    } else {
+        g_retired.push_back(prev);
+    }
+}
+
+static std::vector<SinkEntry> current_sinks_locked() {
+    const SinkList* cur = g_sink_list.load();
+    return cur ? cur->sinks : std::vector<SinkEntry>{};
+}
+
+// Hand a batch of already-filtered records to every sink.
+static void deliver(const SinkList& list, const HelixLogRecord* recs, size_t n) {
+    if (n == 0) return;
+    static helix::Histogram& latency = helix::Metrics::instance().histogram(
+        "helix_log_dispatch_seconds", {}, "Time to hand one batch of log records to every sink");
+    helix::ScopedTimer timer(latency);
+    for (const auto& e : list.sinks) {
+        if (e.v2) {
+            e.v2(recs, n, e.user);
+        } else {
+            for (size_t i = 0; i < n; ++i) e.v1(recs[i].module, recs[i].level, recs[i].message);
+        }
+    }
+    g_dispatched += n;
+}
+
+// Filter records against the current level and deliver the survivors in batches.
+static void filter_and_deliver(const SinkList& list, const LogRecord* const* recs, size_t n) {
+    constexpr size_t kBatch = 64;
+    HelixLogRecord views[kBatch];
+    const int min_level = g_min_level.load();
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (recs[i]->level < min_level) { g_dropped++; g_dropped_filtered++; continue; }
+        views[kept++] = view_of(*recs[i]);
+        if (kept == kBatch) { deliver(list, views, kept); kept = 0; }
+    }
+    deliver(list, views, kept);
+}
+
+// Queue a record while no sink is registered. If a sink appeared in the meantime
+// (writers publish under g_log_mtx), deliver directly instead. Caller holds g_log_mtx.
+static void enqueue_or_deliver_locked(const LogRecord& rec) {
+    if (const SinkList* cur = g_sink_list.load()) {
+        const LogRecord* p = &rec;
+        filter_and_deliver(*cur, &p, 1);
+        return;
+    }
+    if (!g_queue.push(rec, g_queue_cap)) {
+        g_dropped++; g_dropped_overflow++;
+    }
+}
+
+// Deliver queued records to the current sinks in batches. Caller holds g_log_mtx.
+static void flush_queue_locked() {
+    const SinkList* cur = g_sink_list.load();
+    if (!cur) return;
+    constexpr size_t kBatch = 64;
+    LogRecord batch[kBatch];
+    const LogRecord* ptrs[kBatch];
+    while (!g_queue.empty()) {
+        size_t n = 0;
+        while (n < kBatch && !g_queue.empty()) {
+            batch[n] = g_queue.front();
+            ptrs[n] = &batch[n];
+            g_queue.pop();
+            ++n;
+        }
+        filter_and_deliver(*cur, ptrs, n);
+    }
+}
+
+static size_t g_ring_cap = 1024;
+static std::atomic<uint64_t> g_ring_dropped_overflow{0};
+static std::unique_ptr<LogRing> g_ring;
+static std::atomic<bool> g_async_running{false};
+static std::atomic<bool> g_async_stop{false};
+static std::atomic<bool> g_dispatcher_idle{false};
+static std::mutex g_wake_mtx;
+static std::condition_variable g_wake_cv;
+
+// Registered staging buffers; only the dispatcher removes entries.
+static std::mutex g_staging_mtx;
+static std::vector<StagingBuffer*> g_staging;
+static std::atomic<uint64_t> g_staging_gen{0};
+
+// The pointer is trivially destructible so it stays usable while other thread_local
+// destructors run; the releaser below only flags the buffer for the dispatcher.
+static StagingBuffer* const kStagingDisabled = reinterpret_cast<StagingBuffer*>(uintptr_t{1});
+static thread_local StagingBuffer* t_staging = nullptr;
+
+namespace {
+struct StagingReleaser {
+    ~StagingReleaser() {
+        if (t_staging && t_staging != kStagingDisabled) t_staging->orphaned.store(true);
+        t_staging = kStagingDisabled;
+    }
+};
+thread_local StagingReleaser t_staging_releaser;
+} // namespace
+
+static StagingBuffer* thread_staging() {
+    if (t_staging) return t_staging == kStagingDisabled ? nullptr : t_staging;
+    (void)&t_staging_releaser; // odr-use so the releaser is constructed for this thread
+    auto* buf = new (std::nothrow) StagingBuffer(current_thread_id());
+    if (!buf) { t_staging = kStagingDisabled; return nullptr; }
+    {
+        std::lock_guard<std::mutex> lock(g_staging_mtx);
+        g_staging.push_back(buf);
+        g_staging_gen++;
+    }
+    t_staging = buf;
+    return buf;
+}
+
+// Hand records taken from the ring or a staging buffer to the sinks, or queue them
+// while no sink is registered.
+static void deliver_or_queue(const LogRecord* const* recs, size_t n) {
+    {
+        SinkReadGuard guard;
+        if (const SinkList* list = guard.list()) {
+            filter_and_deliver(*list, recs, n);
+            return;
+        }
+    }
+    std::lock_guard<std::mutex> lock(g_log_mtx);
+    for (size_t i = 0; i < n; ++i) enqueue_or_deliver_locked(*recs[i]);
+}
+
+// Drain up to one batch from a staging buffer. Returns records taken.
+static size_t drain_staging(StagingBuffer& buf) {
+    constexpr size_t kBatch = 64;
+    const LogRecord* recs[kBatch];
+    size_t n = buf.peek(recs, kBatch);
+    if (n == 0) return 0;
+    deliver_or_queue(recs, n);
+    buf.release(n);
+    return n;
+}
+
+static void refresh_buffers(std::vector<StagingBuffer*>& buffers, uint64_t& seen_gen) {
+    if (g_staging_gen.load() == seen_gen) return;
+    std::lock_guard<std::mutex> lock(g_staging_mtx);
+    buffers = g_staging;
+    seen_gen = g_staging_gen.load();
+}
+
+// Drain up to one batch from the shared ring. Records a thread staged before it
+// overflowed are delivered first, so each thread's records reach the sinks in order.
+static size_t drain_ring(std::vector<StagingBuffer*>& buffers, uint64_t& seen_gen) {
+    constexpr size_t kBatch = 64;
+    const LogRecord* recs[kBatch];
+    StagingBuffer* owners[kBatch];
+    size_t n = g_ring->peek(recs, owners, kBatch);
+    if (n == 0) return 0;
+    // A buffer registered after our snapshot may hold records older than these
+    refresh_buffers(buffers, seen_gen);
+    uint64_t flushed_tid = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t tid = recs[i]->thread_id;
+        if (tid == flushed_tid) continue;
+        for (auto* b : buffers) {
+            if (b->thread_id == tid) while (drain_staging(*b) > 0) {}
+        }
+        flushed_tid = tid;
+    }
+    deliver_or_queue(recs, n);
+    g_ring->release(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (owners[i]) owners[i]->ring_pending.fetch_sub(1, std::memory_order_release);
+    }
+    return n;
+}
+
+static void dispatcher_main() {
+    std::vector<StagingBuffer*> buffers;
+    uint64_t seen_gen = ~uint64_t{0};
+    for (;;) {
+        refresh_buffers(buffers, seen_gen);
+
+        size_t n = drain_ring(buffers, seen_gen);
+        bool reap = false;
+        for (auto* b : buffers) {
+            n += drain_staging(*b);
+            if (b->orphaned.load() && b->size() == 0 && b->ring_pending.load() == 0) reap = true;
+        }
+        if (reap) {
+            // Orphaned buffers get no new records, so empty ones can be freed once no
+            // ring slot still points at them
+            std::lock_guard<std::mutex> lock(g_staging_mtx);
+            auto live = [](StagingBuffer* b) {
+                return !(b->orphaned.load() && b->size() == 0 && b->ring_pending.load() == 0);
+            };
+            auto dead = std::stable_partition(g_staging.begin(), g_staging.end(), live);
+            for (auto it = dead; it != g_staging.end(); ++it) delete *it;
+            g_staging.erase(dead, g_staging.end());
+            buffers = g_staging;
+            seen_gen = ++g_staging_gen;
+        }
+        if (n > 0) continue;
+        if (g_async_stop.load()) break;
+
+        // Announce idleness, then re-check so a producer that missed the flag is still seen.
+        g_dispatcher_idle.store(true);
+        {
+            std::unique_lock<std::mutex> lock(g_wake_mtx);
+            bool pending = g_ring->size() != 0 || g_staging_gen.load() != seen_gen;
+            for (auto* b : buffers) pending = pending || b->size() != 0;
+            if (!pending && !g_async_stop.load()) {
+                g_wake_cv.wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+        g_dispatcher_idle.store(false);
+    }
+}
+
+namespace {
+// Owns the dispatcher thread; drains and joins it on process exit.
+struct AsyncDispatcher {
+    std::thread thread;
+    ~AsyncDispatcher() {
+        if (!thread.joinable()) return;
+        g_async_running.store(false);
+        g_async_stop.store(true);
+        { std::lock_guard<std::mutex> lock(g_wake_mtx); }
+        g_wake_cv.notify_one();
+        thread.join();
+    }
+};
+} // namespace
+
+static AsyncDispatcher g_dispatcher;
+
 static void init_from_env_once() {
     static std::once_flag once;
     std::call_once(once, []{
@@ -37,58 +686,123 @@ static void init_from_env_once() {
             long v = std::strtol(lvl, nullptr, 10);
             if (v >= 0 && v <= 3) g_min_level.store(static_cast<int>(v));
         }
+        if (const char* rcap = std::getenv("HELIX_LOG_RING_CAP")) {
+            long v = std::strtol(rcap, nullptr, 10);
+            if (v > 0) g_ring_cap = static_cast<size_t>(v);
+        }
+        const char* async = std::getenv("HELIX_LOG_ASYNC");
+        if (async && std::strtol(async, nullptr, 10) > 0) {
+            g_ring = std::make_unique<LogRing>(g_ring_cap);
+            g_ring_cap = g_ring->capacity();
+            try {
+                g_dispatcher.thread = std::thread(dispatcher_main);
+                g_async_running.store(true);
+            } catch (const std::exception&) {
+                // Could not spawn the dispatcher; stay synchronous
+            }
+        }
     });
 }
 
-extern "C" void helix_log_register_sink(LogSink sink) {
-    if (!sink) return;
+static void add_sink(const SinkEntry& entry) {
     std::lock_guard<std::mutex> lock(g_log_mtx);
-    if (std::find(g_sinks.begin(), g_sinks.end(), sink) == g_sinks.end()) {
-        g_sinks.push_back(sink);
+    auto sinks = current_sinks_locked();
+    auto it = std::find_if(sinks.begin(), sinks.end(), [&](const SinkEntry& e) { return same_sink(e, entry); });
+    if (it == sinks.end()) {
+        sinks.push_back(entry);
+        publish_sinks(std::move(sinks));
     }
     // On first sink registration, flush any queued messages
-    if (!g_queue.empty()) {
-        auto sinks_copy = g_sinks; // vector copy
-        while (!g_queue.empty()) {
-            auto [mod, lvl, msg] = std::move(g_queue.front());
-            g_queue.pop_front();
-            if (lvl < g_min_level.load()) { g_dropped_filtered++; continue; }
-            for (auto& s : sinks_copy) s(mod.c_str(), lvl, msg.c_str());
-            g_dispatched++;
-        }
-    }
+    flush_queue_locked();
+}
+
+// Publishing waits for in-flight dispatches, so the sink is never called after this returns
+// (unless the sink unregisters itself from inside a dispatch).
+static void remove_sink(const SinkEntry& entry) {
+    std::lock_guard<std::mutex> lock(g_log_mtx);
+    auto sinks = current_sinks_locked();
+    auto it = std::remove_if(sinks.begin(), sinks.end(), [&](const SinkEntry& e) { return same_sink(e, entry); });
+    if (it == sinks.end()) return;
+    sinks.erase(it, sinks.end());
+    publish_sinks(std::move(sinks));
+}
+
+extern "C" void helix_log_register_sink(LogSink sink) {
+    if (!sink) return;
+    add_sink(SinkEntry{sink, nullptr, nullptr});
 }
 
 extern "C" void helix_log_unregister_sink(LogSink sink) {
     if (!sink) return;
-    std::lock_guard<std::mutex> lock(g_log_mtx);
-    g_sinks.erase(std::remove(g_sinks.begin(), g_sinks.end(), sink), g_sinks.end());
+    remove_sink(SinkEntry{sink, nullptr, nullptr});
 }
 
-extern "C" void helix_log_dispatch(const char* module_name, int level, const char* message) {
+extern "C" void helix_log_register_sink_v2(HelixLogSinkV2Fn sink, void* user) {
+    if (!sink) return;
+    add_sink(SinkEntry{nullptr, sink, user});
+}
+
+extern "C" void helix_log_unregister_sink_v2(HelixLogSinkV2Fn sink, void* user) {
+    if (!sink) return;
+    remove_sink(SinkEntry{nullptr, sink, user});
+}
+
+// 'message' must be NUL-terminated at message[len]; the length only spares a strlen.
+extern "C" void helix_log_dispatch_n(const char* module_name, int level, const char* message, size_t len) {
     init_from_env_once();
     const char* mod = module_name ? module_name : "(unknown)";
-    const char* msg = message ? message : "";
+    if (!message) { message = ""; len = 0; }
+    const uint32_t module_id = intern_module(mod);
+    const uint64_t ts = now_ns();
+    const uint64_t tid = current_thread_id();
+
+    if (g_async_running.load(std::memory_order_relaxed)) {
+        StagingBuffer* staging = thread_staging();
+        // Stay on the ring while earlier overflow is undelivered, or this record would overtake it
+        bool ok = staging && staging->ring_pending.load(std::memory_order_acquire) == 0 &&
+                  staging->try_push(module_id, level, ts, tid, message, len);
+        if (!ok) {
+            if (staging) staging->ring_pending.fetch_add(1, std::memory_order_relaxed);
+            ok = g_ring->try_push(staging, module_id, level, ts, tid, message, len);
+            if (!ok && staging) staging->ring_pending.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (!ok) {
+            g_dropped++; g_ring_dropped_overflow++;
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (g_dispatcher_idle.load(std::memory_order_relaxed)) {
+            { std::lock_guard<std::mutex> lock(g_wake_mtx); }
+            g_wake_cv.notify_one();
+        }
+        return;
+    }
 
-    std::vector<LogSink> sinks_copy;
     {
-        std::lock_guard<std::mutex> lock(g_log_mtx);
-        sinks_copy = g_sinks;
-        if (sinks_copy.empty()) {
-            // Buffer until a sink becomes available
-            if (g_queue.size() >= g_queue_cap) {
-                g_dropped++; g_dropped_overflow++;
-                return;
-            }
-            g_queue.emplace_back(std::string(mod), level, std::string(msg));
+        SinkReadGuard guard;
+        if (const SinkList* list = guard.list()) {
+            // Have at least one sink; filter and dispatch directly without copying the message
+            if (level < g_min_level.load()) { g_dropped++; g_dropped_filtered++; return; }
+            HelixLogRecord rec{ts, tid, module_id, level, module_name_for(module_id), message, len};
+            deliver(*list, &rec, 1);
             return;
         }
     }
 
-    // Have at least one sink; filter and dispatch directly
-    if (level < g_min_level.load()) { g_dropped++; g_dropped_filtered++; return; }
-    for (auto& s : sinks_copy) s(mod, level, msg);
-    g_dispatched++;
+    // Buffer until a sink becomes available
+    LogRecord rec;
+    fill_record(rec, module_id, level, ts, tid, message, len);
+    std::lock_guard<std::mutex> lock(g_log_mtx);
+    enqueue_or_deliver_locked(rec);
+}
+
+extern "C" void helix_log_dispatch(const char* module_name, int level, const char* message) {
+    const char* msg = message ? message : "";
+    helix_log_dispatch_n(module_name, level, msg, std::strlen(msg));
+}
+
+extern "C" const char* helix_log_module_name(uint32_t module_id) {
+    return module_name_for(module_id);
 }
 
 extern "C" void helix_log_stats_get(struct HelixLogStats* out) {
@@ -101,10 +815,37 @@ extern "C" void helix_log_stats_get(struct HelixLogStats* out) {
     out->dropped_filtered = g_dropped_filtered.load();
     out->queued = g_queue.size();
     out->queue_capacity = g_queue_cap;
-    out->sinks = g_sinks.size();
+    const SinkList* cur = g_sink_list.load();
+    out->sinks = cur ? cur->sinks.size() : 0;
     out->min_level = g_min_level.load();
 }
 
+// Callers built against an older header pass a smaller struct_size; copy only what fits.
+extern "C" void helix_log_stats_get_v2(struct HelixLogStatsV2* out) {
+    if (!out || out->struct_size < sizeof(uint32_t)) return;
+    init_from_env_once();
+    HelixLogStatsV2 full{};
+    {
+        std::lock_guard<std::mutex> lock(g_log_mtx);
+        full.dispatched = g_dispatched.load();
+        full.dropped = g_dropped.load();
+        full.dropped_overflow = g_dropped_overflow.load();
+        full.dropped_filtered = g_dropped_filtered.load();
+        full.queued = g_queue.size();
+        full.queue_capacity = g_queue_cap;
+        const SinkList* cur = g_sink_list.load();
+        full.sinks = cur ? cur->sinks.size() : 0;
+        full.min_level = g_min_level.load();
+        full.ring_capacity = g_ring ? g_ring->capacity() : 0;
+        full.ring_high_water = g_ring ? g_ring->high_water() : 0;
+        full.ring_dropped_overflow = g_ring_dropped_overflow.load();
+    }
+    const size_t n = std::min<size_t>(out->struct_size, sizeof(full));
+    const uint32_t caller_size = out->struct_size;
+    std::memcpy(out, &full, n);
+    out->struct_size = caller_size;
+}
+
 extern "C" void helix_log_min_level_set(int level) {
     if (level < 0) level = 0; if (level > 3) level = 3;
     g_min_level.store(level);
@@ -113,3 +854,10 @@ extern "C" void helix_log_min_level_set(int level) {
 extern "C" int helix_log_min_level_get() {
     return g_min_level.load();
 }
+
+// Exposes the live level so modules can filter before formatting (see HELIX_LOGF in helix/log.h).
+// Returned as const void* to keep a C-compatible signature; it points to a std::atomic<int>.
+extern "C" const void* helix_log_min_level_ref() {
+    init_from_env_once();
+    return &g_min_level;
+}
@@ -1,14 +1,31 @@
 #include "helix/daemon.h"
 #include "helix/version.h"
+#include "helix/metrics.h"
 #include "ipc_server.h"
+#include "response_cache.h"
+#include "event_hub.h"
+#include "lifecycle_jobs.h"
+#include "module_watcher.h"
+#include "metrics_endpoint.h"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <csignal>
 #include <memory>
 #include <string>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
 
 std::unique_ptr<helix::HelixDaemon> g_daemon;
+std::atomic<helix::IpcServer*> g_server{nullptr};
 
 void signal_handler(int signal) {
+    // In service mode let serve() return so main can drain lifecycle jobs first
+    if (helix::IpcServer* server = g_server.load()) {
+        server->stop();
+        return;
+    }
     std::cout << "\nReceived signal " << signal << ", shutting down..." << std::endl;
     if (g_daemon) {
         g_daemon->shutdown();
@@ -34,6 +51,17 @@ int main(int argc, char* argv[]) {
                   << "  --modules-dir <path>  Modules directory (defaults to ./modules)\n\n"
                   << "  --socket <path>       Unix socket path for control (default: /tmp/helixd.sock)\n"
                   << "  --foreground          Stay in foreground (do not daemonize)\n"
+                  << "  --ipc-backlog <n>     Control socket listen backlog (default: 128)\n"
+                  << "  --ipc-workers <n>     Threads serving control commands (default: 4)\n"
+                  << "  --ipc-idle-timeout <sec>  Close idle control connections after <sec> (default: 30, 0 = never)\n"
+                  << "  --bringup-workers <n> Threads bringing modules up in parallel (default: CPUs, max 8)\n"
+                  << "  --lifecycle-timeout <sec>  Limit for module init/start/stop calls (default: 30, 0 = none)\n"
+                  << "  --watch-modules       Rescan the modules directory when entries appear or vanish (inotify)\n"
+                  << "  --preload             Read module binaries into the page cache at install/scan and prefault them on load\n"
+                  << "  --bind-now            Resolve module symbols when loading (RTLD_NOW) instead of on first call\n"
+                  << "  --module-host <path>  Host program for \"isolation\": \"process\" modules (default: helix-modhost)\n"
+                  << "  --metrics-port <n>    Serve Prometheus metrics over HTTP at /metrics on this port (default: off)\n"
+                  << "  --metrics-address <ip>  Address for --metrics-port (default: 127.0.0.1)\n"
                   << "  --interactive         Run interactive CLI (legacy mode) on stdin/stdout\n\n"
                   << "If both --modules-dir and a positional modules_dir are provided,\n"
                   << "the explicit --modules-dir takes precedence." << std::endl;
@@ -52,6 +80,29 @@ int main(int argc, char* argv[]) {
     std::string socket_path = "/tmp/helixd.sock";
     bool interactive = false;
     bool foreground = false;
+    bool watch_modules = false;
+    bool preload = false;
+    bool bind_now = false;
+    std::string module_host;
+    helix::IpcServer::Options ipc_options;
+    long bringup_workers = 0; // 0 = daemon default
+    long lifecycle_timeout = -1; // -1 = daemon default
+    long metrics_port = 0; // 0 = no HTTP endpoint
+    std::string metrics_address = "127.0.0.1";
+    auto parse_int_arg = [&](int& i, const std::string& opt, long min_value, long& out) -> bool {
+        if (i + 1 >= argc) {
+            std::cerr << RED << "Error: " << opt << " requires a value" << RESET << std::endl;
+            return false;
+        }
+        char* end = nullptr;
+        long v = std::strtol(argv[++i], &end, 10);
+        if (!end || *end != '\0' || v < min_value) {
+            std::cerr << RED << "Error: invalid value for " << opt << ": " << argv[i] << RESET << std::endl;
+            return false;
+        }
+        out = v;
+        return true;
+    };
     // Minimal argument parsing
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -73,8 +124,34 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) { socket_path = argv[++i]; } else { std::cerr << RED << "Error: --socket requires <path>" << RESET << std::endl; return 2; }
         } else if (arg == "--interactive") {
             interactive = true;
+        } else if (arg == "--watch-modules") {
+            watch_modules = true;
+        } else if (arg == "--preload") {
+            preload = true;
+        } else if (arg == "--bind-now") {
+            bind_now = true;
+        } else if (arg == "--module-host") {
+            if (i + 1 < argc) { module_host = argv[++i]; } else { std::cerr << RED << "Error: --module-host requires <path>" << RESET << std::endl; return 2; }
         } else if (arg == "--foreground") {
             foreground = true;
+        } else if (arg == "--ipc-backlog" || arg == "--ipc-workers" || arg == "--ipc-idle-timeout") {
+            long v = 0;
+            if (!parse_int_arg(i, arg, arg == "--ipc-idle-timeout" ? 0 : 1, v)) return 2;
+            if (arg == "--ipc-backlog") ipc_options.backlog = static_cast<int>(v);
+            else if (arg == "--ipc-workers") ipc_options.workers = static_cast<size_t>(v);
+            else ipc_options.idle_timeout_ms = static_cast<int>(v * 1000);
+        } else if (arg == "--bringup-workers") {
+            if (!parse_int_arg(i, arg, 1, bringup_workers)) return 2;
+        } else if (arg == "--lifecycle-timeout") {
+            if (!parse_int_arg(i, arg, 0, lifecycle_timeout)) return 2;
+        } else if (arg == "--metrics-port") {
+            if (!parse_int_arg(i, arg, 1, metrics_port)) return 2;
+            if (metrics_port > 65535) {
+                std::cerr << RED << "Error: invalid value for --metrics-port: " << metrics_port << RESET << std::endl;
+                return 2;
+            }
+        } else if (arg == "--metrics-address") {
+            if (i + 1 < argc) { metrics_address = argv[++i]; } else { std::cerr << RED << "Error: --metrics-address requires <ip>" << RESET << std::endl; return 2; }
         } else if (!arg.empty() && arg[0] == '-') {
             std::cerr << RED << "Unknown option: " << arg << RESET << std::endl;
             print_usage();
@@ -93,6 +170,11 @@ int main(int argc, char* argv[]) {
 
     // Create daemon instance
     g_daemon = std::make_unique<helix::HelixDaemon>();
+    if (bringup_workers > 0) g_daemon->set_bringup_workers(static_cast<size_t>(bringup_workers));
+    if (lifecycle_timeout >= 0) g_daemon->set_lifecycle_timeout_ms(static_cast<unsigned>(lifecycle_timeout * 1000));
+    g_daemon->set_preload(preload);
+    g_daemon->set_bind_now(bind_now);
+    if (!module_host.empty()) g_daemon->set_module_host(module_host);
 
     // Initialize daemon
     if (!g_daemon->initialize(modules_dir)) {
@@ -107,8 +189,27 @@ int main(int argc, char* argv[]) {
     // Launch mode: interactive CLI or IPC server
     if (!interactive) {
         std::cout << YELLOW << "Running in service mode. Control socket: " << socket_path << RESET << std::endl;
+        // Feeds `subscribe` connections; declared first so it outlives their streams
+        helix::EventHub events(*g_daemon);
+        g_daemon->set_state_observer([&events](const std::string& module, helix::ModuleState from,
+                                               helix::ModuleState to, const std::string& error) {
+            events.publish_state(module, from, to, error);
+        });
+        helix::IpcServer server(socket_path, ipc_options);
+        // `<action> <name> --async` queues the operation; jobs take the server's state lock themselves
+        helix::LifecycleJobs jobs(server.state_lock());
+        // Picks up directories added or removed outside the control socket; runs under the same lock
+        helix::ModuleWatcher watcher(modules_dir, server.state_lock(), [] { g_daemon->refresh_modules(); });
+        // Mutations release the state lock while module code runs, so queries keep being answered
+        g_daemon->set_module_call_wrapper([&server](const std::function<void()>& call) {
+            server.state_lock().without_state(call);
+        });
+        if (watch_modules) watcher.start();
+        // Reads only the metrics registry, so it needs no state lock
+        helix::MetricsEndpoint metrics_endpoint;
+        if (metrics_port > 0) metrics_endpoint.start(metrics_address, static_cast<int>(metrics_port));
         // Command dispatcher for control requests
-        auto handler = [&](const std::string& line) -> std::string {
+        auto text_handler = [&](const std::string& line) -> std::string {
             std::string cmd = line;
             auto trim = [](std::string& s){ while(!s.empty() && (s.back()=='\r' || s.back()==' ')) s.pop_back(); size_t p=0; while(p<s.size() && s[p]==' ') ++p; s.erase(0,p); };
             trim(cmd);
@@ -124,43 +225,191 @@ int main(int argc, char* argv[]) {
                 if (out.empty()) out = "ERR version unavailable\n";
                 return out;
             }
-            if (cmd == "list") {
-                std::string out;
-                for (auto& name : g_daemon->list_modules()) {
-                    const auto* info = g_daemon->get_module_info(name);
-                    std::string state = info ? helix::HelixDaemon::state_to_string(info->state) : std::string("Unknown");
-                    out += name + " " + state + "\n";
-                }
-                if (out.empty()) out = "\n"; // send at least a newline to indicate success
-                return out;
-            }
-            if (cmd.rfind("info ",0)==0) {
-                auto name = cmd.substr(5);
-                const auto* info = g_daemon->get_module_info(name);
-                if (!info) return "ERR not installed";
-                std::string out;
-                out += "name=" + info->name + "\n";
-                out += "version=" + info->version + "\n";
-                out += "state=" + helix::HelixDaemon::state_to_string(info->state) + "\n";
-                out += "description=" + info->manifest.description + "\n";
-                out += "author=" + info->manifest.author + "\n";
-                out += "license=" + info->manifest.license + "\n";
-                out += "binary_path=" + info->manifest.binary_path + "\n";
-                if (!info->manifest.minimum_core_version.empty()) out += "minimum_core_version=" + info->manifest.minimum_core_version + "\n";
-                if (!info->manifest.minimum_api_version.empty()) out += "minimum_api_version=" + info->manifest.minimum_api_version + "\n";
-                return out;
-            }
+            if (cmd == "refresh") return g_daemon->refresh_modules() ? "OK" : "ERR refresh: scanning the modules directory failed";
             if (cmd.rfind("install ",0)==0) return g_daemon->install_module(cmd.substr(8)) ? "OK" : (std::string("ERR install: ") + g_daemon->last_error());
+            if (cmd.rfind("upgrade ",0)==0) return g_daemon->upgrade_module(cmd.substr(8)) ? "OK" : (std::string("ERR upgrade: ") + g_daemon->last_error());
+            if (cmd.rfind("prepare ",0)==0) return g_daemon->prepare_module(cmd.substr(8)) ? "OK" : (std::string("ERR prepare: ") + g_daemon->last_error());
             if (cmd.rfind("enable ",0)==0) return g_daemon->enable_module(cmd.substr(7)) ? "OK" : (std::string("ERR enable: ") + g_daemon->last_error());
             if (cmd.rfind("start ",0)==0) return g_daemon->start_module(cmd.substr(6)) ? "OK" : (std::string("ERR start: ") + g_daemon->last_error());
             if (cmd.rfind("stop ",0)==0) return g_daemon->stop_module(cmd.substr(5)) ? "OK" : (std::string("ERR stop: ") + g_daemon->last_error());
             if (cmd.rfind("disable ",0)==0) return g_daemon->disable_module(cmd.substr(8)) ? "OK" : (std::string("ERR disable: ") + g_daemon->last_error());
             if (cmd.rfind("uninstall ",0)==0) return g_daemon->uninstall_module(cmd.substr(10)) ? "OK" : (std::string("ERR uninstall: ") + g_daemon->last_error());
+            if (cmd.rfind("batch ",0)==0) {
+                // batch <action> <target>; <action> <target>; ...
+                std::vector<helix::BatchOperation> ops;
+                std::stringstream ss(cmd.substr(6));
+                std::string item;
+                while (std::getline(ss, item, ';')) {
+                    trim(item);
+                    if (item.empty()) continue;
+                    auto sp = item.find(' ');
+                    if (sp == std::string::npos) return "ERR batch: missing target in '" + item + "'";
+                    std::string target = item.substr(sp + 1);
+                    trim(target);
+                    ops.push_back({item.substr(0, sp), target});
+                }
+                if (ops.empty()) return "ERR batch: no operations";
+                std::string out;
+                for (const auto& r : g_daemon->run_batch(ops)) {
+                    out += (r.success ? "OK " : "ERR ") + r.action + " " + r.target;
+                    if (!r.success) out += ": " + r.error;
+                    out += "\n";
+                }
+                return out;
+            }
             return std::string("ERR unknown command: ") + cmd;
         };
 
-        helix::IpcServer server(socket_path);
+        // list/info replies come preserialized from the cache (also as JSON lines with --json)
+        helix::ResponseCache replies(*g_daemon);
+        auto handler = [&](const std::string& line) -> helix::IpcServer::Payload {
+            std::string cmd = line;
+            while (!cmd.empty() && (cmd.back() == '\r' || cmd.back() == ' ')) cmd.pop_back();
+            size_t p = 0;
+            while (p < cmd.size() && cmd[p] == ' ') ++p;
+            cmd.erase(0, p);
+            const std::string async_flag = " --async";
+            if (cmd.size() > async_flag.size() && cmd.compare(cmd.size() - async_flag.size(), async_flag.size(), async_flag) == 0) {
+                cmd.erase(cmd.size() - async_flag.size());
+                auto sp = cmd.find(' ');
+                const std::string action = cmd.substr(0, sp);
+                if (sp == std::string::npos || (action != "enable" && action != "start" && action != "stop" && action != "disable")) {
+                    return std::make_shared<const std::string>("ERR --async applies to enable, start, stop and disable");
+                }
+                const std::string target = cmd.substr(sp + 1);
+                uint64_t id = jobs.submit(action, target, [action, target](std::string& error) {
+                    bool ok = false;
+                    if (action == "enable") ok = g_daemon->enable_module(target);
+                    else if (action == "start") ok = g_daemon->start_module(target);
+                    else if (action == "stop") ok = g_daemon->stop_module(target);
+                    else ok = g_daemon->disable_module(target);
+                    if (!ok) error = g_daemon->last_error();
+                    return ok;
+                });
+                return std::make_shared<const std::string>("OK job " + std::to_string(id));
+            }
+            if (cmd == "jobs") {
+                // <id> <action> <target> <state> [<ms>ms] [: error]
+                std::string out;
+                for (const auto& job : jobs.list()) {
+                    out += std::to_string(job.id) + " " + job.action + " " + job.target + " " +
+                           helix::LifecycleJobs::state_name(job.state);
+                    if (job.state == helix::LifecycleJobs::State::Succeeded || job.state == helix::LifecycleJobs::State::Failed) {
+                        out += " " + std::to_string(static_cast<long long>(job.elapsed_ms)) + "ms";
+                    }
+                    if (!job.error.empty()) out += ": " + job.error;
+                    out += "\n";
+                }
+                return std::make_shared<const std::string>(out);
+            }
+            if (cmd.rfind("wait ", 0) == 0) {
+                // wait <id> [timeout_sec]
+                std::stringstream ss(cmd.substr(5));
+                unsigned long long id = 0;
+                long timeout_sec = 0;
+                if (!(ss >> id)) return std::make_shared<const std::string>("ERR wait: expected a job id");
+                if (!(ss >> timeout_sec) || timeout_sec < 0) timeout_sec = 0; // 0 = default timeout
+                // LifecycleJobs::wait caps the timeout; clamp here so the conversion cannot overflow
+                timeout_sec = std::min<long>(timeout_sec, helix::LifecycleJobs::kMaxWaitMs / 1000);
+                helix::LifecycleJobs::Job job;
+                if (!jobs.wait(id, static_cast<int>(timeout_sec * 1000), job)) {
+                    if (jobs.stopping()) return std::make_shared<const std::string>("ERR wait: daemon shutting down");
+                    return std::make_shared<const std::string>("ERR wait: unknown job " + std::to_string(id));
+                }
+                switch (job.state) {
+                    case helix::LifecycleJobs::State::Succeeded:
+                        return std::make_shared<const std::string>("OK");
+                    case helix::LifecycleJobs::State::Failed:
+                    case helix::LifecycleJobs::State::Cancelled:
+                        return std::make_shared<const std::string>("ERR " + job.action + ": " + job.error);
+                    default:
+                        return std::make_shared<const std::string>("ERR wait: job " + std::to_string(id) + " still " +
+                                                                   helix::LifecycleJobs::state_name(job.state));
+                }
+            }
+            bool json = false;
+            const std::string json_flag = " --json";
+            if (cmd.size() > json_flag.size() && cmd.compare(cmd.size() - json_flag.size(), json_flag.size(), json_flag) == 0) {
+                json = true;
+                cmd.erase(cmd.size() - json_flag.size());
+            }
+            if (cmd == "list") return replies.list(json);
+            if (cmd == "topics") return helix::ResponseCache::topics(json);
+            if (cmd == "top") return replies.top(json);
+            if (cmd == "metrics") {
+                const auto& metrics = helix::Metrics::instance();
+                return std::make_shared<const std::string>(json ? metrics.render_json() : metrics.render_text());
+            }
+            if (cmd == "metrics prometheus") {
+                return std::make_shared<const std::string>(helix::Metrics::instance().render_prometheus());
+            }
+            if (cmd.rfind("info ",0)==0) {
+                if (auto reply = replies.info(cmd.substr(5), json)) return reply;
+                return std::make_shared<const std::string>("ERR not installed");
+            }
+            return std::make_shared<const std::string>(text_handler(line));
+        };
+
+        // Queries may run concurrently; anything else changes module state and is serialized
+        auto is_read_only = [](const std::string& line) {
+            std::string cmd = line;
+            size_t p = 0;
+            while (p < cmd.size() && cmd[p] == ' ') ++p;
+            cmd.erase(0, p);
+            std::string verb = cmd.substr(0, cmd.find(' '));
+            while (!verb.empty() && verb.back() == '\r') verb.pop_back();
+            return verb == "status" || verb == "version" || verb == "list" || verb == "info" ||
+                   verb == "top";
+        };
+        // Job bookkeeping and bus counters never touch daemon state, so they must not wait behind a running job
+        auto is_unlocked = [](const std::string& line) {
+            std::string cmd = line;
+            while (!cmd.empty() && (cmd.back() == '\r' || cmd.back() == ' ')) cmd.pop_back();
+            size_t p = 0;
+            while (p < cmd.size() && cmd[p] == ' ') ++p;
+            cmd.erase(0, p);
+            const std::string async_flag = " --async";
+            if (cmd.size() > async_flag.size() && cmd.compare(cmd.size() - async_flag.size(), async_flag.size(), async_flag) == 0) return true;
+            std::string verb = cmd.substr(0, cmd.find(' '));
+            return verb == "jobs" || verb == "wait" || verb == "topics" || verb == "metrics";
+        };
+
+        // `subscribe [states] [logs] [metrics] [--json]` keeps the connection open and streams events
+        auto is_subscribe = [](const std::string& line) {
+            std::stringstream ss(line);
+            std::string verb;
+            ss >> verb;
+            return verb == "subscribe";
+        };
+        auto open_subscription = [&events](const std::string& line,
+                                           helix::IpcServer::Payload& reply) -> std::shared_ptr<helix::IpcServer::Stream> {
+            unsigned topics = 0;
+            bool json = false;
+            std::string error;
+            if (!helix::EventHub::parse_command(line, topics, json, error)) {
+                reply = std::make_shared<const std::string>("ERR " + error);
+                return nullptr;
+            }
+            std::string ok = "OK subscribed";
+            if (topics & helix::EventHub::kStates) ok += " states";
+            if (topics & helix::EventHub::kLogs) ok += " logs";
+            if (topics & helix::EventHub::kMetrics) ok += " metrics";
+            reply = std::make_shared<const std::string>(ok + "\n");
+            return events.subscribe(topics, json);
+        };
+
+        server.set_read_only_classifier(is_read_only);
+        server.set_unlocked_classifier(is_unlocked);
+        server.set_stream_opener(is_subscribe, open_subscription);
+        // Release blocked `wait` commands before the worker pool joins
+        server.set_stop_hook([&jobs] { jobs.stop(); });
+        g_server.store(&server);
         server.serve(handler);
+        g_server.store(nullptr);
+        metrics_endpoint.stop();
+        watcher.stop();
+        jobs.stop();
+        g_daemon->set_module_call_wrapper(nullptr);
 
         // After serve returns, proceed to shutdown
         std::cout << YELLOW << "Shutting down Helix daemon..." << RESET << std::endl;
@@ -200,6 +449,13 @@ int main(int argc, char* argv[]) {
             } else {
                 std::cout << RED << "Failed to install module" << RESET << std::endl;
             }
+        } else if (command.find("upgrade ") == 0) {
+            std::string package_path = command.substr(8);
+            if (g_daemon->upgrade_module(package_path)) {
+                std::cout << GREEN << "Module upgraded successfully" << RESET << std::endl;
+            } else {
+                std::cout << RED << "Failed to upgrade module: " << g_daemon->last_error() << RESET << std::endl;
+            }
         } else if (command.find("info ") == 0) {
             std::string module_name = command.substr(5);
             const auto* info = g_daemon->get_module_info(module_name);
@@ -224,6 +480,13 @@ int main(int argc, char* argv[]) {
             } else {
                 std::cout << RED << "Failed to enable module" << RESET << std::endl;
             }
+        } else if (command.find("prepare ") == 0) {
+            std::string module_name = command.substr(8);
+            if (g_daemon->prepare_module(module_name)) {
+                std::cout << GREEN << "Module prepared successfully" << RESET << std::endl;
+            } else {
+                std::cout << RED << "Failed to prepare module" << RESET << std::endl;
+            }
         } else if (command.find("start ") == 0) {
             std::string module_name = command.substr(6);
             if (g_daemon->start_module(module_name)) {
@@ -252,17 +515,25 @@ int main(int argc, char* argv[]) {
             } else {
                 std::cout << RED << "Failed to uninstall module" << RESET << std::endl;
             }
+        } else if (command == "metrics") {
+            std::cout << helix::Metrics::instance().render_text();
+        } else if (command == "top") {
+            std::cout << *helix::ResponseCache(*g_daemon).top(false);
         } else if (command == "help") {
             std::cout << BOLD << "Available commands:" << RESET << std::endl;
             std::cout << "  status          - Show daemon status" << std::endl;
             std::cout << "  list            - List all modules" << std::endl;
             std::cout << "  info <name>     - Show module info (name, version, author, description)" << std::endl;
             std::cout << "  install <file.helx>  - Install module from a .helx package" << std::endl;
+            std::cout << "  upgrade <file.helx>  - Replace an installed module in place, without stopping it" << std::endl;
+            std::cout << "  prepare <name>  - Load a module and its dependencies without initializing" << std::endl;
             std::cout << "  enable <name>   - Enable a module" << std::endl;
             std::cout << "  start <name>    - Start a module" << std::endl;
             std::cout << "  stop <name>     - Stop a running module" << std::endl;
             std::cout << "  disable <name>  - Disable (unload) a module" << std::endl;
             std::cout << "  uninstall <name>- Uninstall a module" << std::endl;
+            std::cout << "  metrics         - Show lifecycle, resolver, install, IPC and log latencies" << std::endl;
+            std::cout << "  top             - Show CPU, threads, descriptors and heap use per module" << std::endl;
             std::cout << "  quit/exit       - Shutdown daemon" << std::endl;
         } else if (!command.empty()) {
             std::cout << RED << "Unknown command: " << command << RESET << std::endl;
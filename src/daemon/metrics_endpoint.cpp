@@ -0,0 +1,133 @@
+#include "metrics_endpoint.h"
+#include "helix/metrics.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace helix {
+
+namespace {
+
+constexpr int kReadTimeoutMs = 2000;
+constexpr size_t kMaxRequest = 8192;
+
+void send_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = ::send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        off += static_cast<size_t>(n);
+    }
+}
+
+std::string http_reply(const char* status, const char* content_type, const std::string& body) {
+    return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + content_type +
+           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+MetricsEndpoint::~MetricsEndpoint() { stop(); }
+
+bool MetricsEndpoint::start(const std::string& address, int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Metrics endpoint disabled: invalid address " << address << std::endl;
+        return false;
+    }
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "Metrics endpoint disabled: socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int one = 1;
+    (void)::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd_, 16) < 0) {
+        std::cerr << "Metrics endpoint disabled: cannot listen on " << address << ":" << port << ": "
+                  << std::strerror(errno) << std::endl;
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "Metrics endpoint disabled: eventfd: " << std::strerror(errno) << std::endl;
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    std::cout << "Serving Prometheus metrics on http://" << address << ":" << port << "/metrics" << std::endl;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void MetricsEndpoint::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        (void)::write(wake_fd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    listen_fd_ = wake_fd_ = -1;
+}
+
+void MetricsEndpoint::run() {
+    for (;;) {
+        pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve_client(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsEndpoint::serve_client(int fd) {
+    // Read the request head; the body of a GET is empty
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos) {
+        pollfd p{fd, POLLIN, 0};
+        if (::poll(&p, 1, kReadTimeoutMs) <= 0) return;
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        request.append(buf, static_cast<size_t>(n));
+        if (request.size() > kMaxRequest) {
+            send_all(fd, http_reply("431 Request Header Fields Too Large", "text/plain", "request too large\n"));
+            return;
+        }
+    }
+    const std::string line = request.substr(0, request.find_first_of("\r\n"));
+    const size_t sp1 = line.find(' ');
+    const size_t sp2 = sp1 == std::string::npos ? std::string::npos : line.find(' ', sp1 + 1);
+    const std::string method = line.substr(0, sp1);
+    std::string path = sp1 == std::string::npos ? std::string() : line.substr(sp1 + 1, sp2 - sp1 - 1);
+    path = path.substr(0, path.find('?'));
+    if (method != "GET" && method != "HEAD") {
+        send_all(fd, http_reply("405 Method Not Allowed", "text/plain", "only GET is supported\n"));
+    } else if (path != "/metrics") {
+        send_all(fd, http_reply("404 Not Found", "text/plain", "try /metrics\n"));
+    } else {
+        std::string reply = http_reply("200 OK", "text/plain; version=0.0.4", Metrics::instance().render_prometheus());
+        if (method == "HEAD") reply.erase(reply.find("\r\n\r\n") + 4);
+        send_all(fd, reply);
+    }
+}
+
+} // namespace helix
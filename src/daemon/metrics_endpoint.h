@@ -0,0 +1,36 @@
+#ifndef HELIX_METRICS_ENDPOINT_H
+#define HELIX_METRICS_ENDPOINT_H
+
+#include <string>
+#include <thread>
+
+namespace helix {
+
+// Minimal HTTP listener for Prometheus scrapes. `GET /metrics` returns
+// Metrics::render_prometheus(); every other path gets a 404. Requests are served
+// one at a time on a single thread and the connection is closed after each reply,
+// so a stuck client can hold up the next scrape by at most the read timeout.
+// Only metrics are read, never daemon state, so no lock is taken.
+class MetricsEndpoint {
+public:
+    MetricsEndpoint() = default;
+    ~MetricsEndpoint();
+
+    // Listen on address:port (IPv4, e.g. "127.0.0.1"); returns false with a message on stderr.
+    bool start(const std::string& address, int port);
+
+    // Stop the listener thread; safe to call more than once.
+    void stop();
+
+private:
+    void run();
+    void serve_client(int fd);
+
+    int listen_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread thread_;
+};
+
+} // namespace helix
+
+#endif // HELIX_METRICS_ENDPOINT_H
@@ -0,0 +1,95 @@
+#include "module_watcher.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace helix {
+
+ModuleWatcher::ModuleWatcher(std::string directory, StateLock& state_lock, std::function<void()> on_change,
+                             int settle_ms)
+    : directory_(std::move(directory)), state_lock_(state_lock), on_change_(std::move(on_change)),
+      settle_ms_(settle_ms) {}
+
+ModuleWatcher::~ModuleWatcher() { stop(); }
+
+bool ModuleWatcher::start() {
+#ifdef __linux__
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        std::cerr << "Module watcher disabled: inotify_init1: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    if (::inotify_add_watch(inotify_fd_, directory_.c_str(), mask) < 0) {
+        std::cerr << "Module watcher disabled: cannot watch " << directory_ << ": " << std::strerror(errno) << std::endl;
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "Module watcher disabled: eventfd: " << std::strerror(errno) << std::endl;
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    thread_ = std::thread([this] { run(); });
+    return true;
+#else
+    std::cerr << "Module watcher disabled: inotify is not available on this platform" << std::endl;
+    return false;
+#endif
+}
+
+void ModuleWatcher::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        (void)::write(wake_fd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (inotify_fd_ >= 0) ::close(inotify_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    inotify_fd_ = wake_fd_ = -1;
+}
+
+void ModuleWatcher::run() {
+#ifdef __linux__
+    bool pending = false;
+    alignas(struct inotify_event) char buf[4096];
+    for (;;) {
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        // While changes are pending, wait only for the burst to go quiet
+        int rc = ::poll(fds, 2, pending ? settle_ms_ : -1);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Module watcher stopped: poll: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents) return;
+        if (rc == 0) {
+            pending = false;
+            MutationLock lock(state_lock_);
+            on_change_();
+            continue;
+        }
+        ssize_t n;
+        while ((n = ::read(inotify_fd_, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                if ((ev->mask & IN_Q_OVERFLOW) || (ev->len > 0 && ev->name[0] != '.')) pending = true;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+    }
+#endif
+}
+
+} // namespace helix
@@ -0,0 +1,44 @@
+#ifndef HELIX_MODULE_WATCHER_H
+#define HELIX_MODULE_WATCHER_H
+
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "state_lock.h"
+
+namespace helix {
+
+// Watches the top level of the modules directory with inotify and, once a burst of
+// changes has been quiet for settle_ms, runs the callback holding a MutationLock on
+// the daemon state. Names starting with '.' (staging trees, the blob store, the scan
+// index) are ignored, so the daemon's own bookkeeping never triggers a rescan.
+// Module directories should appear by rename, as `install` does; a tree being copied
+// in place is only picked up if its marker exists when the burst settles.
+class ModuleWatcher {
+public:
+    ModuleWatcher(std::string directory, StateLock& state_lock, std::function<void()> on_change,
+                  int settle_ms = 200);
+    ~ModuleWatcher();
+
+    // Begin watching; returns false (with a message on stderr) if inotify is unavailable.
+    bool start();
+
+    // Stop the watcher thread; safe to call more than once.
+    void stop();
+
+private:
+    void run();
+
+    const std::string directory_;
+    StateLock& state_lock_;
+    const std::function<void()> on_change_;
+    const int settle_ms_;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread thread_;
+};
+
+} // namespace helix
+
+#endif // HELIX_MODULE_WATCHER_H
@@ -0,0 +1,258 @@
+#include "response_cache.h"
+#include "helix/message_bus.h"
+#include "helix/resource_accounting.h"
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace helix {
+
+namespace {
+
+void append_json_string(std::string& out, const std::string& s) {
+    out.push_back('"');
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out.push_back(ch);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+void append_json_field(std::string& out, const char* key, const std::string& value, bool first = false) {
+    if (!first) out.push_back(',');
+    out.push_back('"');
+    out += key;
+    out += "\":";
+    append_json_string(out, value);
+}
+
+std::string info_text(const DaemonModuleInfo& info) {
+    std::string out;
+    out.reserve(256);
+    out += "name=" + info.name + "\n";
+    out += "version=" + info.version + "\n";
+    out += "state=" + HelixDaemon::state_to_string(info.state) + "\n";
+    out += "description=" + info.manifest.description + "\n";
+    out += "author=" + info.manifest.author + "\n";
+    out += "license=" + info.manifest.license + "\n";
+    out += "binary_path=" + info.manifest.binary_path + "\n";
+    if (!info.manifest.minimum_core_version.empty()) out += "minimum_core_version=" + info.manifest.minimum_core_version + "\n";
+    if (!info.manifest.minimum_api_version.empty()) out += "minimum_api_version=" + info.manifest.minimum_api_version + "\n";
+    out += std::string("isolation=") + (info.manifest.linkage.process ? "process" : info.manifest.linkage.global ? "global" : "local") + "\n";
+    if (!info.manifest.linkage.exports.empty()) {
+        out += "exports=";
+        for (size_t i = 0; i < info.manifest.linkage.exports.size(); ++i) {
+            if (i) out.push_back(',');
+            out += info.manifest.linkage.exports[i];
+        }
+        out += "\n";
+    }
+    if (!info.manifest.build_profile.empty()) out += "build_profile=" + info.manifest.build_profile + "\n";
+    if (!info.package_digest.empty()) out += "package_sha256=" + info.package_digest + "\n";
+    if (!info.error_message.empty()) out += "error=" + info.error_message + "\n";
+    return out;
+}
+
+std::string info_json(const DaemonModuleInfo& info) {
+    std::string out;
+    out.reserve(384);
+    out.push_back('{');
+    append_json_field(out, "name", info.name, true);
+    append_json_field(out, "version", info.version);
+    append_json_field(out, "state", HelixDaemon::state_to_string(info.state));
+    append_json_field(out, "description", info.manifest.description);
+    append_json_field(out, "author", info.manifest.author);
+    append_json_field(out, "license", info.manifest.license);
+    append_json_field(out, "binary_path", info.manifest.binary_path);
+    append_json_field(out, "install_path", info.install_path);
+    append_json_field(out, "minimum_core_version", info.manifest.minimum_core_version);
+    append_json_field(out, "minimum_api_version", info.manifest.minimum_api_version);
+    append_json_field(out, "package_sha256", info.package_digest);
+    append_json_field(out, "isolation", info.manifest.linkage.process ? "process" : info.manifest.linkage.global ? "global" : "local");
+    append_json_field(out, "build_profile", info.manifest.build_profile);
+    append_json_field(out, "error", info.error_message);
+    out += ",\"dependencies\":[";
+    bool first = true;
+    for (const auto& dep : info.manifest.dependencies) {
+        if (!first) out.push_back(',');
+        first = false;
+        out.push_back('{');
+        append_json_field(out, "name", dep.name, true);
+        append_json_field(out, "version", dep.version);
+        out += dep.optional ? ",\"optional\":true}" : ",\"optional\":false}";
+    }
+    out += "],\"exports\":[";
+    for (size_t i = 0; i < info.manifest.linkage.exports.size(); ++i) {
+        if (i) out.push_back(',');
+        append_json_string(out, info.manifest.linkage.exports[i]);
+    }
+    out += "]}\n";
+    return out;
+}
+
+bool is_loaded(ModuleState state) {
+    return state == ModuleState::LOADED || state == ModuleState::INITIALIZED || state == ModuleState::RUNNING ||
+           state == ModuleState::STOPPED;
+}
+
+std::string cpu_seconds(uint64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6f", static_cast<double>(ns) / 1e9);
+    return buf;
+}
+
+// Resource counters of a loaded module as key=value lines, or JSON fields without braces
+std::string resources(const ResourceAccounting::Usage& u, bool json) {
+    std::vector<std::pair<const char*, std::string>> fields = {
+        {"threads", std::to_string(u.threads)},
+        {"threads_started", std::to_string(u.threads_started)},
+        {"cpu_seconds", cpu_seconds(u.cpu_ns)},
+        {"fds", std::to_string(u.fds)},
+    };
+    if (u.arena_bytes) fields.emplace_back("arena_bytes", std::to_string(u.arena_bytes));
+    if (u.host_pid) {
+        fields.emplace_back("host_pid", std::to_string(u.host_pid));
+        fields.emplace_back("rss_bytes", std::to_string(u.rss_bytes));
+    }
+    if (u.allocations_tracked) {
+        fields.emplace_back("alloc_live_bytes", std::to_string(u.live_bytes()));
+        fields.emplace_back("alloc_total_bytes", std::to_string(u.bytes_allocated));
+        fields.emplace_back("allocations", std::to_string(u.allocations));
+        fields.emplace_back("frees", std::to_string(u.frees));
+    }
+    std::string out;
+    for (const auto& [key, value] : fields) {
+        if (json) {
+            if (!out.empty()) out.push_back(',');
+            out += std::string("\"") + key + "\":" + value;
+        } else {
+            out += std::string(key) + "=" + value + "\n";
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+void ResponseCache::sync_generation_locked() {
+    uint64_t gen = daemon_.registry_generation();
+    if (gen == generation_) return;
+    generation_ = gen;
+    list_text_.reset();
+    list_json_.reset();
+    info_.clear();
+}
+
+ResponseCache::Payload ResponseCache::list(bool json) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    sync_generation_locked();
+    Payload& slot = json ? list_json_ : list_text_;
+    if (slot) return slot;
+
+    std::string out;
+    for (const auto& name : daemon_.list_modules()) {
+        const auto* info = daemon_.get_module_info(name);
+        std::string state = info ? HelixDaemon::state_to_string(info->state) : std::string("Unknown");
+        if (json) {
+            out.push_back('{');
+            append_json_field(out, "name", name, true);
+            append_json_field(out, "version", info ? info->version : std::string());
+            append_json_field(out, "state", state);
+            out += "}\n";
+        } else {
+            out += name + " " + state + "\n";
+        }
+    }
+    if (out.empty() && !json) out = "\n"; // send at least a newline to indicate success
+    slot = std::make_shared<const std::string>(std::move(out));
+    return slot;
+}
+
+ResponseCache::Payload ResponseCache::info(const std::string& name, bool json) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    sync_generation_locked();
+    const auto* info = daemon_.get_module_info(name);
+    if (!info) return nullptr;
+    InfoEntry& entry = info_[name];
+    Payload& slot = json ? entry.json : entry.text;
+    if (!slot) slot = std::make_shared<const std::string>(json ? info_json(*info) : info_text(*info));
+    if (!is_loaded(info->state)) return slot;
+
+    // Resource counters move on their own; append them to the cached part on every call
+    const auto usage = ResourceAccounting::instance().usage(name);
+    std::string out = *slot;
+    if (json) {
+        out.erase(out.size() - 2); // "}\n"
+        out += ",\"resources\":{" + resources(usage, true) + "}}\n";
+    } else {
+        out += resources(usage, false);
+    }
+    return std::make_shared<const std::string>(std::move(out));
+}
+
+ResponseCache::Payload ResponseCache::top(bool json) {
+    const auto process = ResourceAccounting::process_usage();
+    std::string out;
+    if (json) {
+        out += "{\"process\":true,\"rss_bytes\":" + std::to_string(process.rss_bytes) +
+               ",\"cpu_seconds\":" + cpu_seconds(process.cpu_ns) + ",\"threads\":" + std::to_string(process.threads) +
+               ",\"fds\":" + std::to_string(process.fds) + "}\n";
+    } else {
+        out += "process rss_bytes=" + std::to_string(process.rss_bytes) + " cpu_seconds=" + cpu_seconds(process.cpu_ns) +
+               " threads=" + std::to_string(process.threads) + " fds=" + std::to_string(process.fds) + "\n";
+    }
+    for (const auto& name : daemon_.list_modules()) {
+        const auto* info = daemon_.get_module_info(name);
+        if (!info || !is_loaded(info->state)) continue;
+        const auto usage = ResourceAccounting::instance().usage(name);
+        if (json) {
+            out.push_back('{');
+            append_json_field(out, "name", name, true);
+            append_json_field(out, "state", HelixDaemon::state_to_string(info->state));
+            out += "," + resources(usage, true) + "}\n";
+        } else {
+            std::string fields = resources(usage, false);
+            for (char& c : fields) {
+                if (c == '\n') c = ' ';
+            }
+            fields.pop_back();
+            out += name + " state=" + HelixDaemon::state_to_string(info->state) + " " + fields + "\n";
+        }
+    }
+    return std::make_shared<const std::string>(std::move(out));
+}
+
+ResponseCache::Payload ResponseCache::topics(bool json) {
+    std::string out;
+    for (const auto& t : MessageBus::instance().stats()) {
+        if (json) {
+            out.push_back('{');
+            append_json_field(out, "name", t.name, true);
+            out += ",\"slot_size\":" + std::to_string(t.slot_size) + ",\"capacity\":" + std::to_string(t.capacity) +
+                   ",\"depth\":" + std::to_string(t.depth) + ",\"published\":" + std::to_string(t.published) +
+                   ",\"dropped\":" + std::to_string(t.dropped) + ",\"subscribers\":" + std::to_string(t.subscribers) +
+                   "}\n";
+        } else {
+            out += t.name + " slot_size=" + std::to_string(t.slot_size) + " capacity=" + std::to_string(t.capacity) +
+                   " depth=" + std::to_string(t.depth) + " published=" + std::to_string(t.published) +
+                   " dropped=" + std::to_string(t.dropped) + " subscribers=" + std::to_string(t.subscribers) + "\n";
+        }
+    }
+    return std::make_shared<const std::string>(std::move(out));
+}
+
+} // namespace helix
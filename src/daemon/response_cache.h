@@ -0,0 +1,58 @@
+#ifndef HELIX_RESPONSE_CACHE_H
+#define HELIX_RESPONSE_CACHE_H
+
+#include "helix/daemon.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace helix {
+
+// Serialized replies for the query commands (`list`, `info`), in text and JSON-lines
+// form. Each reply is built once per registry generation and handed out as a shared
+// buffer, so repeated polls neither re-stringify module data nor copy the result.
+//
+// Callers must hold off daemon mutations while calling in (the IPC server's read
+// lock does this); the cache's own mutex only orders concurrent readers.
+class ResponseCache {
+public:
+    using Payload = std::shared_ptr<const std::string>;
+
+    explicit ResponseCache(const HelixDaemon& daemon) : daemon_(daemon) {}
+
+    // "name state" lines, or one {"name","version","state"} object per line for json.
+    Payload list(bool json);
+
+    // key=value lines, or a single JSON object line. nullptr if the module is not installed.
+    // Loaded modules also get their resource counters, which are read fresh on every call.
+    Payload info(const std::string& name, bool json);
+
+    // Process RSS, CPU, threads and descriptors, then one line per loaded module with its
+    // resource counters ("name state=... key=value ..." or a JSON object). Built fresh.
+    Payload top(bool json);
+
+    // Message bus counters, one topic per line ("name key=value ..." or a JSON object).
+    // Always built fresh: the counters move without a registry change.
+    static Payload topics(bool json);
+
+private:
+    struct InfoEntry {
+        Payload text;
+        Payload json;
+    };
+
+    void sync_generation_locked();
+
+    const HelixDaemon& daemon_;
+    std::mutex mtx_;
+    uint64_t generation_ = UINT64_MAX;
+    Payload list_text_;
+    Payload list_json_;
+    std::unordered_map<std::string, InfoEntry> info_;
+};
+
+} // namespace helix
+
+#endif // HELIX_RESPONSE_CACHE_H
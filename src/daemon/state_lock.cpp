@@ -0,0 +1,37 @@
+#include "state_lock.h"
+
+namespace helix {
+
+namespace {
+
+// Innermost MutationLock held by this thread
+thread_local MutationLock* t_mutation = nullptr;
+
+} // namespace
+
+MutationLock::MutationLock(StateLock& lock)
+    : lock_(lock), mutation_(lock.mutation), state_(lock.state), previous_(t_mutation) {
+    t_mutation = this;
+}
+
+MutationLock::~MutationLock() {
+    t_mutation = previous_;
+}
+
+void StateLock::without_state(const std::function<void()>& call) {
+    MutationLock* held = t_mutation;
+    if (!held || &held->lock_ != this || !held->state_.owns_lock()) {
+        call();
+        return;
+    }
+    held->state_.unlock();
+    try {
+        call();
+    } catch (...) {
+        held->state_.lock();
+        throw;
+    }
+    held->state_.lock();
+}
+
+} // namespace helix
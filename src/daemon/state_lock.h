@@ -0,0 +1,44 @@
+#ifndef HELIX_STATE_LOCK_H
+#define HELIX_STATE_LOCK_H
+
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+
+namespace helix {
+
+// The daemon state lock. Queries hold `state` shared. Mutations (control commands,
+// lifecycle jobs, the module watcher) take a MutationLock, which serializes them on
+// `mutation` for their whole run and holds `state` exclusively, except while they
+// run module code: HelixDaemon calls entry points through without_state(), so a
+// module's slow init or start does not hold up `list`, `info` or `subscribe`.
+// No other mutation can start meanwhile, so the mutating thread's view of the
+// registry stays valid across the call.
+struct StateLock {
+    std::mutex mutation;
+    std::shared_mutex state;
+
+    // Runs call with `state` released if this thread holds a MutationLock on this
+    // lock, else runs it as is.
+    void without_state(const std::function<void()>& call);
+};
+
+class MutationLock {
+public:
+    explicit MutationLock(StateLock& lock);
+    ~MutationLock();
+    MutationLock(const MutationLock&) = delete;
+    MutationLock& operator=(const MutationLock&) = delete;
+
+private:
+    StateLock& lock_;
+    std::unique_lock<std::mutex> mutation_;
+    std::unique_lock<std::shared_mutex> state_;
+    MutationLock* previous_;
+
+    friend struct StateLock;
+};
+
+} // namespace helix
+
+#endif // HELIX_STATE_LOCK_H
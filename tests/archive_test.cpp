@@ -0,0 +1,153 @@
+// extract_tar_gz() is what every install trusts to keep a package inside its
+// directory. Archives written by write_tar_gz() must come back byte for byte, and
+// hand-made archives whose members try to leave the destination must be refused
+// without anything being written outside it.
+#include "helix/archive.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what.c_str());
+        ++failures;
+    }
+}
+
+std::string read_file(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_file(const fs::path& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary) << data;
+}
+
+// One raw ustar member: a 512-byte header followed by data padded to whole blocks
+std::string member(const std::string& name, char type, const std::string& data,
+                   const std::string& link = std::string()) {
+    std::string hdr(512, '\0');
+    std::memcpy(&hdr[0], name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(&hdr[100], 8, "%07o", 0644);
+    std::snprintf(&hdr[108], 8, "%07o", 0);
+    std::snprintf(&hdr[116], 8, "%07o", 0);
+    std::snprintf(&hdr[124], 12, "%011lo", static_cast<unsigned long>(data.size()));
+    std::snprintf(&hdr[136], 12, "%011o", 0);
+    hdr[156] = type;
+    std::memcpy(&hdr[157], link.data(), std::min<size_t>(link.size(), 100));
+    std::memcpy(&hdr[257], "ustar\0" "00", 8);
+    std::memset(&hdr[148], ' ', 8);
+    unsigned sum = 0;
+    for (unsigned char c : hdr) sum += c;
+    std::snprintf(&hdr[148], 8, "%06o", sum);
+    hdr[155] = ' ';
+    std::string padded = data;
+    padded.resize((data.size() + 511) / 512 * 512, '\0');
+    return hdr + padded;
+}
+
+std::string pax_record(const std::string& key, const std::string& value) {
+    const std::string body = " " + key + "=" + value + "\n";
+    size_t len = body.size() + 1;
+    while (std::to_string(len).size() + body.size() != len) ++len;
+    return std::to_string(len) + body;
+}
+
+void write_gz(const fs::path& path, const std::string& tar) {
+    gzFile gz = gzopen(path.c_str(), "wb");
+    const std::string whole = tar + std::string(1024, '\0');
+    gzwrite(gz, whole.data(), static_cast<unsigned>(whole.size()));
+    gzclose(gz);
+}
+
+// Extraction of tar must fail and leave nothing behind outside dest
+void expect_rejected(const fs::path& root, const std::string& label, const std::string& tar) {
+    const fs::path archive = root / "evil.helx";
+    const fs::path dest = root / "sandbox" / "dest";
+    fs::remove_all(root / "sandbox");
+    fs::remove(root / "x");
+    fs::remove(root / "sandbox-x");
+    fs::create_directories(dest);
+    write_gz(archive, tar);
+
+    std::string error;
+    expect(!helix::extract_tar_gz(archive.string(), dest.string(), error), label + ": extraction succeeded");
+    expect(!error.empty(), label + ": no error reported");
+    expect(!fs::exists(root / "x") && !fs::exists(root / "sandbox" / "x") && !fs::exists(root / "sandbox-x"),
+           label + ": wrote outside the destination");
+    expect(!fs::is_symlink(dest / "link"), label + ": created a symlink");
+}
+
+} // namespace
+
+int main() {
+    if (!helix::archive_support_available()) {
+        std::printf("archive support not built; skipping\n");
+        return 0;
+    }
+    char templ[] = "/tmp/helix-archive-test-XXXXXX";
+    if (!::mkdtemp(templ)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const fs::path root = templ;
+    std::string error;
+
+    // Round trip, including a name long enough to need the ustar prefix field
+    const fs::path src = root / "src";
+    const std::string long_dir = std::string(60, 'd') + "/" + std::string(60, 'e');
+    fs::create_directories(src / long_dir);
+    write_file(src / "manifest.json", "{\"name\": \"m\"}\n");
+    std::string blob(200000, '\0');
+    for (size_t i = 0; i < blob.size(); ++i) blob[i] = static_cast<char>(i * 131 + 7);
+    write_file(src / long_dir / "lib.so", blob);
+    ::chmod((src / long_dir / "lib.so").c_str(), 0755);
+
+    const std::vector<helix::ArchiveMember> members = {
+        {"manifest.json", (src / "manifest.json").string()},
+        {long_dir + "/lib.so", (src / long_dir / "lib.so").string()},
+    };
+    const fs::path archive = root / "good.helx";
+    expect(helix::write_tar_gz(archive.string(), members, error), "write_tar_gz: " + error);
+    const fs::path out = root / "out";
+    expect(helix::extract_tar_gz(archive.string(), out.string(), error), "extract_tar_gz: " + error);
+    expect(read_file(out / "manifest.json") == read_file(src / "manifest.json"), "manifest.json differs");
+    expect(read_file(out / long_dir / "lib.so") == blob, "lib.so differs");
+    struct stat st{};
+    expect(::stat((out / long_dir / "lib.so").c_str(), &st) == 0 && (st.st_mode & 0777) == 0755,
+           "lib.so lost its mode");
+
+    // The writer refuses the same names the reader does
+    expect(!helix::write_tar_gz((root / "bad.helx").string(), {{"../x", (src / "manifest.json").string()}}, error),
+           "write_tar_gz accepted ../x");
+
+    // Hostile members
+    expect_rejected(root, "../x", member("../x", '0', "escaped\n"));
+    expect_rejected(root, "absolute path", member((root / "sandbox-x").string(), '0', "escaped\n"));
+    expect_rejected(root, "a/../../x", member("a/../../x", '0', "escaped\n"));
+    expect_rejected(root, "symlink", member("link", '2', "", "/etc") + member("link/passwd", '0', "escaped\n"));
+    expect_rejected(root, "hard link", member("link", '1', "", "/etc/passwd"));
+    expect_rejected(root, "pax path", member("PaxHeader/ok", 'x', pax_record("path", "../x")) +
+                                          member("ok", '0', "escaped\n"));
+    expect_rejected(root, "GNU long name", member("././@LongLink", 'L', std::string("../x") + '\0') +
+                                               member("ok", '0', "escaped\n"));
+
+    fs::remove_all(root);
+    if (failures) return 1;
+    std::printf("archive round trip and hostile members ok\n");
+    return 0;
+}
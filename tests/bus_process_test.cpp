@@ -0,0 +1,87 @@
+// A second process maps a topic through a TopicSource, as helix-modhost does, and
+// publishes into the daemon's ring. It then exits holding an open loan and a
+// subscription; release_process() must cancel the loan, so subscribers can read
+// past it, and free the cursor, so producers are not held back by it.
+#include "helix/bus.h"
+#include "helix/message_bus.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern "C" const HelixBusApi* helix_bus_api();
+
+namespace {
+
+int fail(const char* what) {
+    std::fprintf(stderr, "%s\n", what);
+    return 1;
+}
+
+uint32_t subscribers(const std::string& topic) {
+    for (const auto& s : helix::MessageBus::instance().stats()) {
+        if (s.name == topic) return s.subscribers;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main() {
+    const HelixBusApi* api = helix_bus_api();
+    auto& bus = helix::MessageBus::instance();
+    std::string error;
+    const int fd = bus.share("shared", 16, 8, error);
+    if (fd < 0) return fail(error.c_str());
+    HelixBusTopic* topic = bus.topic("shared", 16, 0, error);
+    HelixBusSubscriber* sub = api->subscribe(topic);
+    if (!sub) return fail("cannot subscribe");
+
+    const pid_t child = fork();
+    if (child == 0) {
+        // A fresh bus: the inherited singleton already holds the daemon's view of the topic
+        helix::MessageBus host;
+        host.set_topic_source([fd](const std::string&, uint32_t, uint32_t, std::string&) { return dup(fd); });
+        std::string host_error;
+        HelixBusTopic* mapped = host.topic("shared", 16, 0, host_error);
+        if (!mapped) _exit(2);
+        for (int i = 1; i <= 3; ++i) {
+            if (api->publish(mapped, &i, sizeof(i)) != 0) _exit(3);
+        }
+        if (!api->loan(mapped, sizeof(int)) || !api->subscribe(mapped)) _exit(4);
+        _exit(0); // dies with the loan open and the subscription held
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return fail("child could not use the shared topic");
+    if (subscribers("shared") != 2) return fail("child subscription is not visible");
+
+    HelixBusMessage batch[8];
+    size_t n = api->poll(sub, batch, 8);
+    if (n != 3) return fail("messages from the other process did not arrive");
+    for (size_t i = 0; i < n; ++i) {
+        int value;
+        std::memcpy(&value, batch[i].data, sizeof(value));
+        if (value != static_cast<int>(i) + 1) return fail("messages arrived out of order");
+    }
+
+    const int after = 4;
+    if (api->publish(topic, &after, sizeof(after)) != 0) return fail("publish failed");
+    if (api->poll(sub, batch, 8) != 0) return fail("read past an open loan");
+
+    bus.release_process(child);
+    if (subscribers("shared") != 1) return fail("the exited process still subscribes");
+    n = api->poll(sub, batch, 8);
+    int value = 0;
+    if (n == 1) std::memcpy(&value, batch[0].data, sizeof(value));
+    if (value != after) return fail("the exited process's loan still blocks the ring");
+
+    // With only our cursor left, a full ring's worth of messages fits again
+    for (int i = 0; i < 8; ++i) {
+        api->poll(sub, batch, 8);
+        if (api->publish(topic, &i, sizeof(i)) != 0) return fail("ring stays full after release");
+    }
+    std::printf("cross-process publish, loan cancel and cursor release ok\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Many add/remove/resolve cycles on one DependencyResolver. Rows are rewritten in
+// place, moved when they grow and compacted now and then; after every change the
+// resolution must match what the current manifests say.
+#include "helix/dependency_resolver.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using helix::DependencyResolver;
+using helix::ModuleManifest;
+using helix::ResolutionResult;
+
+namespace {
+
+constexpr size_t kModules = 200;
+constexpr int kCycles = 5000;
+
+std::string name_of(size_t i) { return "mod" + std::to_string(i); }
+
+// Dependencies only point at lower indices, so the graph never has a cycle. Allowing
+// more of them as the test goes on keeps rows outgrowing their slots.
+ModuleManifest make_manifest(size_t i, size_t max_deps, std::mt19937& rng) {
+    ModuleManifest manifest;
+    manifest.name = name_of(i);
+    manifest.version = "1.0.0";
+    if (i == 0) return manifest;
+    std::uniform_int_distribution<size_t> count(0, max_deps), target(0, i - 1);
+    const size_t deps = count(rng);
+    for (size_t d = 0; d < deps; ++d) {
+        manifest.dependencies.push_back({name_of(target(rng)), ">=1.0.0", false});
+    }
+    return manifest;
+}
+
+bool check(DependencyResolver& resolver, const std::vector<ModuleManifest>& manifests,
+           const std::vector<bool>& present, int cycle) {
+    bool complete = true;
+    size_t count = 0;
+    for (size_t i = 0; i < kModules; ++i) {
+        if (!present[i]) continue;
+        ++count;
+        for (const auto& dep : manifests[i].dependencies) {
+            if (!present[std::stoul(dep.name.substr(3))]) complete = false;
+        }
+    }
+    ResolutionResult result = resolver.resolve_dependencies();
+    if (result.success != complete) {
+        std::fprintf(stderr, "cycle %d: success %d, expected %d\n", cycle, result.success, complete);
+        return false;
+    }
+    if (!complete) return true;
+    if (result.load_order.size() != count) {
+        std::fprintf(stderr, "cycle %d: %zu modules ordered, %zu present\n", cycle, result.load_order.size(), count);
+        return false;
+    }
+    std::unordered_map<std::string, size_t> position;
+    for (size_t p = 0; p < result.load_order.size(); ++p) position[result.load_order[p]] = p;
+    for (size_t i = 0; i < kModules; ++i) {
+        if (!present[i]) continue;
+        for (const auto& dep : manifests[i].dependencies) {
+            if (position.at(dep.name) >= position.at(manifests[i].name)) {
+                std::fprintf(stderr, "cycle %d: %s ordered before its dependency %s\n", cycle,
+                             manifests[i].name.c_str(), dep.name.c_str());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(12345);
+    DependencyResolver resolver;
+    std::vector<ModuleManifest> manifests(kModules);
+    std::vector<bool> present(kModules, false);
+    for (size_t i = 0; i < kModules; ++i) {
+        manifests[i] = make_manifest(i, 2, rng);
+        resolver.add_module(manifests[i]);
+        present[i] = true;
+    }
+    if (!check(resolver, manifests, present, 0)) return 1;
+
+    std::uniform_int_distribution<size_t> pick(0, kModules - 1);
+    for (int cycle = 1; cycle <= kCycles; ++cycle) {
+        const size_t i = pick(rng);
+        if (present[i]) {
+            resolver.remove_module(manifests[i].name);
+            present[i] = false;
+        } else {
+            // A re-added module usually declares a different number of dependencies
+            manifests[i] = make_manifest(i, 2 + static_cast<size_t>(cycle) * 48 / kCycles, rng);
+            resolver.add_module(manifests[i]);
+            present[i] = true;
+        }
+        if (!check(resolver, manifests, present, cycle)) return 1;
+    }
+    std::printf("%d add/remove/resolve cycles on %zu modules\n", kCycles, kModules);
+    return 0;
+}
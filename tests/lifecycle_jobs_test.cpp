@@ -0,0 +1,58 @@
+// LifecycleJobs::stop() releases clients blocked in wait() while a job is still running,
+// so shutdown does not wait for the job queue on behalf of IPC workers.
+#include "lifecycle_jobs.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <thread>
+
+int main() {
+    helix::StateLock state_lock;
+    helix::LifecycleJobs jobs(state_lock);
+
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> running{false};
+    const uint64_t id = jobs.submit("start", "slow", [&](std::string&) {
+        running.store(true);
+        released.wait();
+        return true;
+    });
+    while (!running.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // A finite timeout still returns the running snapshot
+    helix::LifecycleJobs::Job job;
+    if (!jobs.wait(id, 10, job) || job.state != helix::LifecycleJobs::State::Running) {
+        std::fprintf(stderr, "bounded wait did not report the running job\n");
+        return 1;
+    }
+
+    // No timeout means the default bound, which is far longer than this test
+    auto waiter = std::async(std::launch::async, [&] {
+        helix::LifecycleJobs::Job out;
+        return jobs.wait(id, 0, out);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto stopper = std::async(std::launch::async, [&] { jobs.stop(); });
+
+    if (waiter.wait_for(std::chrono::seconds(5)) != std::future_status::ready) {
+        std::fprintf(stderr, "stop() did not release the waiter\n");
+        release.set_value();
+        return 1;
+    }
+    if (waiter.get()) {
+        std::fprintf(stderr, "interrupted wait reported success\n");
+        release.set_value();
+        return 1;
+    }
+    if (!jobs.stopping()) {
+        std::fprintf(stderr, "stopping() is false after stop()\n");
+        release.set_value();
+        return 1;
+    }
+    release.set_value();
+    stopper.get();
+    std::printf("waiter released on stop\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Async log dispatch keeps each producer's records in order when its staging buffer
+// overflows into the shared ring. The sink stalls the dispatcher until every producer
+// has overflowed, then checks that sequence numbers only ever increase per producer.
+#include "helix/log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" void helix_log_dispatch_n(const char* module_name, int level, const char* message, size_t len);
+extern "C" void helix_log_register_sink_v2(HelixLogSinkV2Fn sink, void* user);
+extern "C" void helix_log_stats_get_v2(struct HelixLogStatsV2* out);
+
+namespace {
+
+constexpr int kProducers = 4;
+constexpr int kPerPhase = 300; // more than a staging buffer holds
+
+std::mutex g_gate_mtx;
+std::condition_variable g_gate_cv;
+bool g_gate_open = false;
+
+long g_last_seq[kProducers];
+std::atomic<int> g_failures{0};
+
+void ordered_sink(const HelixLogRecord* recs, size_t n, void*) {
+    {
+        std::unique_lock<std::mutex> lock(g_gate_mtx);
+        g_gate_cv.wait(lock, [] { return g_gate_open; });
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int producer = 0;
+        long seq = 0;
+        if (std::sscanf(recs[i].message, "p%d %ld", &producer, &seq) != 2 || producer < 0 || producer >= kProducers) {
+            std::fprintf(stderr, "unexpected record '%s'\n", recs[i].message);
+            g_failures++;
+            continue;
+        }
+        if (seq <= g_last_seq[producer]) {
+            std::fprintf(stderr, "producer %d: record %ld delivered after %ld\n", producer, seq, g_last_seq[producer]);
+            g_failures++;
+        }
+        g_last_seq[producer] = seq;
+    }
+}
+
+void log_range(int producer, long from, long to) {
+    char buf[64];
+    for (long seq = from; seq < to; ++seq) {
+        int len = std::snprintf(buf, sizeof(buf), "p%d %ld", producer, seq);
+        helix_log_dispatch_n("order-test", HELIX_LOG_INFO, buf, static_cast<size_t>(len));
+    }
+}
+
+} // namespace
+
+int main() {
+    setenv("HELIX_LOG_ASYNC", "1", 1);
+    setenv("HELIX_LOG_RING_CAP", "4096", 1);
+    for (auto& s : g_last_seq) s = -1;
+    helix_log_register_sink_v2(&ordered_sink, nullptr);
+
+    // Phase one fills every staging buffer and spills into the ring while the sink is
+    // stalled; phase two keeps logging while the backlog drains.
+    std::atomic<int> filled{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([p, &filled] {
+            log_range(p, 0, kPerPhase);
+            filled++;
+            log_range(p, kPerPhase, 2 * kPerPhase);
+        });
+    }
+    while (filled.load() < kProducers) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    {
+        std::lock_guard<std::mutex> lock(g_gate_mtx);
+        g_gate_open = true;
+    }
+    g_gate_cv.notify_all();
+    for (auto& t : producers) t.join();
+
+    const uint64_t total = uint64_t{kProducers} * 2 * kPerPhase;
+    HelixLogStatsV2 stats{};
+    for (int i = 0; i < 5000; ++i) {
+        stats = HelixLogStatsV2{};
+        stats.struct_size = sizeof(stats);
+        helix_log_stats_get_v2(&stats);
+        if (stats.dispatched + stats.dropped >= total) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (stats.dispatched + stats.dropped < total) {
+        std::fprintf(stderr, "only %llu of %llu records accounted for\n",
+                     static_cast<unsigned long long>(stats.dispatched + stats.dropped),
+                     static_cast<unsigned long long>(total));
+        return 1;
+    }
+    if (stats.ring_high_water == 0) {
+        std::fprintf(stderr, "staging buffers never overflowed into the ring\n");
+        return 1;
+    }
+    if (g_failures.load() != 0) return 1;
+    std::printf("%llu records in order (%llu dropped, ring high water %llu)\n",
+                static_cast<unsigned long long>(stats.dispatched),
+                static_cast<unsigned long long>(stats.dropped),
+                static_cast<unsigned long long>(stats.ring_high_water));
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Unregistering a sink must wait for every dispatch that may still call it, with
+// producers on long-lived and short-lived threads (whose reader slots are recycled).
+// Each registration's state is marked dead right after unregister returns; a sink
+// call that sees a dead state means a reader was not waited for.
+#include "helix/log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" void helix_log_dispatch_n(const char* module_name, int level, const char* message, size_t len);
+extern "C" void helix_log_register_sink_v2(HelixLogSinkV2Fn sink, void* user);
+extern "C" void helix_log_unregister_sink_v2(HelixLogSinkV2Fn sink, void* user);
+
+namespace {
+
+constexpr int kProducers = 4;
+constexpr int kRegistrations = 300;
+
+struct SinkState {
+    std::atomic<bool> alive{true};
+};
+
+std::atomic<long> g_calls{0};
+std::atomic<int> g_failures{0};
+
+void checking_sink(const HelixLogRecord*, size_t, void* user) {
+    if (!static_cast<SinkState*>(user)->alive.load()) g_failures++;
+    // Stay inside the read section long enough for unregister to overlap it
+    for (volatile int i = 0; i < 200; ++i) {}
+    g_calls++;
+}
+
+void produce(const std::atomic<bool>& stop) {
+    while (!stop.load(std::memory_order_relaxed)) helix_log_dispatch_n("reclaim-test", HELIX_LOG_INFO, "x", 1);
+}
+
+} // namespace
+
+int main() {
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) producers.emplace_back(produce, std::cref(stop));
+
+    // Short-lived producers exit and hand their reader slots to the next ones
+    std::atomic<bool> churn_stop{false};
+    std::thread churn([&] {
+        while (!churn_stop.load()) {
+            std::thread([] {
+                for (int i = 0; i < 100; ++i) helix_log_dispatch_n("reclaim-test", HELIX_LOG_INFO, "y", 1);
+            }).join();
+        }
+    });
+
+    std::vector<std::unique_ptr<SinkState>> states; // kept, so a late call reads a dead flag, not freed memory
+    states.reserve(kRegistrations);
+    for (int i = 0; i < kRegistrations; ++i) {
+        states.push_back(std::make_unique<SinkState>());
+        SinkState* state = states.back().get();
+        helix_log_register_sink_v2(&checking_sink, state);
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+        helix_log_unregister_sink_v2(&checking_sink, state);
+        state->alive.store(false);
+    }
+
+    churn_stop = true;
+    churn.join();
+    stop = true;
+    for (auto& t : producers) t.join();
+
+    if (g_calls.load() == 0) {
+        std::fprintf(stderr, "sink was never called\n");
+        return 1;
+    }
+    if (g_failures.load()) {
+        std::fprintf(stderr, "%d sink calls after unregister returned\n", g_failures.load());
+        return 1;
+    }
+    std::printf("%d registrations, %ld sink calls, none after unregister\n", kRegistrations, g_calls.load());
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Consumers calling through a service while its provider is upgraded over and over
+// must always see one complete table: every function of a table they load returns
+// the same generation tag.
+#include "helix/service.h"
+#include "helix/service_registry.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct WideV1 {
+    int (*f[16])();
+};
+
+template <int Tag>
+int tag() { return Tag; }
+
+template <int Tag>
+WideV1 make_table() {
+    WideV1 table;
+    for (auto& fn : table.f) fn = &tag<Tag>;
+    return table;
+}
+
+} // namespace
+
+int main() {
+    auto& registry = helix::ServiceRegistry::instance();
+    const std::string provider = "provider";
+    const uint32_t version = HELIX_SERVICE_VERSION(1, 0);
+    const WideV1 tables[2] = {make_table<1>(), make_table<2>()};
+    std::string error;
+
+    if (!registry.register_service(provider, "wide", version, &tables[0], sizeof(WideV1), error)) {
+        std::fprintf(stderr, "register: %s\n", error.c_str());
+        return 1;
+    }
+    const auto* slot = registry.resolve("consumer", "wide", version, sizeof(WideV1), error);
+    if (!slot) {
+        std::fprintf(stderr, "resolve: %s\n", error.c_str());
+        return 1;
+    }
+    HelixService<WideV1> service(slot);
+
+    std::atomic<bool> done{false};
+    std::atomic<long> calls{0};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&] {
+            long n = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                const WideV1* table = service.get();
+                const int first = table->f[0]();
+                for (auto fn : table->f) {
+                    if (fn() != first) { torn++; break; }
+                }
+                ++n;
+            }
+            calls += n;
+        });
+    }
+
+    constexpr int kUpgrades = 20000;
+    for (int i = 1; i <= kUpgrades; ++i) {
+        const uint64_t instance = static_cast<uint64_t>(i);
+        registry.begin_replacement(provider, instance);
+        {
+            helix::ServiceRegistry::CallerScope scope(provider, instance);
+            if (!registry.register_service(provider, "wide", version, &tables[i & 1], sizeof(WideV1), error) ||
+                !registry.commit_replacement(provider, error)) {
+                std::fprintf(stderr, "upgrade %d: %s\n", i, error.c_str());
+                done = true;
+                for (auto& t : readers) t.join();
+                return 1;
+            }
+        }
+    }
+    done = true;
+    for (auto& t : readers) t.join();
+    registry.withdraw("consumer");
+    registry.withdraw(provider);
+
+    if (torn.load() != 0) {
+        std::fprintf(stderr, "%d calls saw a mix of old and new functions\n", torn.load());
+        return 1;
+    }
+    std::printf("%d upgrades, %ld consistent calls\n", kUpgrades, calls.load());
+    return 0;
+}
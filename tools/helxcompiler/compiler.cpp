@@ -10,11 +10,20 @@ using nlohmann::json;
 #endif
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include "helix/archive.h"
+#include "helix/blob_store.h"
+#include "helix/json_scanner.h"
 #include "helix/manifest.h"
 #include "helix/version.h"
 
@@ -181,6 +190,8 @@ std::vector<std::string> HelixCompiler::find_source_files(const std::string& dir
     } catch (const std::exception& e) {
         set_error(std::string("Error scanning directory: ") + e.what());
     }
+    // Directory order varies; a fixed order keeps link order and builds reproducible
+    std::sort(source_files.begin(), source_files.end());
     return source_files;
 }
 
@@ -213,37 +224,494 @@ bool HelixCompiler::extract_module_metadata(const std::vector<std::string>& sour
     return !module_name.empty() && !module_version.empty();
 }
 
+std::vector<std::string> HelixCompiler::codegen_flags(const CompileConfig& config) {
+    std::vector<std::string> flags;
+    flags.push_back(config.optimization_level.empty() ? std::string("-O2") : config.optimization_level);
+    if (config.debug_info) flags.push_back("-g");
+    flags.push_back("-fPIC");
+    if (!config.march.empty()) flags.push_back("-march=" + config.march);
+    if (config.lto) flags.push_back("-flto=auto");
+    if (!config.pgo_generate_dir.empty()) {
+        flags.push_back("-fprofile-generate=" + std::filesystem::absolute(config.pgo_generate_dir).string());
+        flags.push_back("-fprofile-update=atomic"); // modules are multithreaded
+    }
+    if (!config.pgo_use_dir.empty()) {
+        flags.push_back("-fprofile-use=" + std::filesystem::absolute(config.pgo_use_dir).string());
+        flags.push_back("-fprofile-correction");
+        flags.push_back("-Wno-missing-profile");
+    }
+    if (config.hidden_visibility) {
+        flags.push_back("-fvisibility=hidden");
+        flags.push_back("-fvisibility-inlines-hidden");
+    }
+    if (config.no_plt) flags.push_back("-fno-plt");
+    if (config.gc_sections) {
+        flags.push_back("-ffunction-sections");
+        flags.push_back("-fdata-sections");
+    }
+    if (config.hardening) {
+        flags.push_back("-fstack-protector-strong");
+        flags.push_back("-fstack-clash-protection");
+        flags.push_back("-D_FORTIFY_SOURCE=2");
+    }
+    return flags;
+}
+
+std::vector<std::string> HelixCompiler::link_flags(const CompileConfig& config) {
+    std::vector<std::string> flags;
+    if (config.gc_sections) {
+        flags.push_back("-Wl,--gc-sections");
+        flags.push_back("-Wl,-O1");
+        flags.push_back("-Wl,--as-needed");
+    }
+    // Without a PLT, calls go through the GOT, which is resolved and sealed at load
+    if (config.no_plt || config.hardening) {
+        flags.push_back("-Wl,-z,relro");
+        flags.push_back("-Wl,-z,now");
+    }
+    if (config.strip) flags.push_back("-s");
+    return flags;
+}
+
+bool HelixCompiler::apply_profile(const std::string& name, CompileConfig& config, bool keep_optimization,
+                                  std::string& error) {
+    if (name != "release" && name != "size" && name != "pgo-gen" && name != "pgo-use") {
+        error = "unknown profile '" + name + "' (expected release, size, pgo-gen or pgo-use)";
+        return false;
+    }
+    config.profile = name;
+    config.hidden_visibility = true;
+    config.no_plt = true;
+    config.gc_sections = true;
+    config.hardening = true;
+    config.lto = true;
+    if (!keep_optimization) config.optimization_level = name == "size" ? "-Os" : "-O2";
+    if (name == "size") config.strip = true;
+
+    const std::string default_dir = "helx-pgo/" + (config.module_name.empty() ? std::string("module") : config.module_name);
+    if (name == "pgo-gen") {
+        if (!config.pgo_use_dir.empty()) {
+            error = "profile pgo-gen cannot be combined with --pgo-use";
+            return false;
+        }
+        if (config.pgo_generate_dir.empty()) config.pgo_generate_dir = default_dir;
+    } else if (name == "pgo-use") {
+        if (!config.pgo_generate_dir.empty()) {
+            error = "profile pgo-use cannot be combined with --pgo-generate";
+            return false;
+        }
+        if (config.pgo_use_dir.empty()) config.pgo_use_dir = default_dir;
+    }
+    return true;
+}
+
+std::string HelixCompiler::resolve_cache_dir(const CompileConfig& config) {
+    if (!config.use_cache) return std::string();
+    if (!config.cache_dir.empty()) return config.cache_dir;
+    if (const char* env = std::getenv("HELXCOMPILER_CACHE")) {
+        if (*env) return env;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg) return std::string(xdg) + "/helxcompiler";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        if (*home) return std::string(home) + "/.cache/helxcompiler";
+    }
+    return std::string();
+}
+
+namespace {
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    out.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Prerequisites listed in a make rule written by -MD ("obj: src hdr ...", continued
+// across lines with a trailing backslash), with escaped spaces restored
+std::vector<std::string> parse_depfile(const std::string& text) {
+    std::vector<std::string> deps;
+    size_t i = text.find(": ");
+    if (i == std::string::npos) return deps;
+    i += 2;
+    std::string current;
+    for (; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '\\' && i + 1 < text.size() && (text[i + 1] == '\n' || text[i + 1] == '\r')) {
+            ++i;
+            continue;
+        }
+        if (c == '\\' && i + 1 < text.size() && text[i + 1] == ' ') {
+            current.push_back(' ');
+            ++i;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (!current.empty()) deps.push_back(std::move(current));
+            current.clear();
+            if (c == '\n') break; // one rule only
+            continue;
+        }
+        current.push_back(c);
+    }
+    if (!current.empty()) deps.push_back(std::move(current));
+    return deps;
+}
+
+// One recorded header of a cache entry: contents hash plus the stat data that lets
+// an unchanged file skip rehashing
+struct DepRecord {
+    std::string digest;
+    long long size = 0;
+    long long mtime_ns = 0;
+    std::string path;
+};
+
+// "entry_points" and "exports" of the manifest in a source directory
+void read_manifest_symbols(const std::string& source_dir, EntryPoints& entry_points,
+                           std::vector<std::string>& exports) {
+    std::string text;
+    if (!read_file((std::filesystem::path(source_dir) / "manifest.json").string(), text)) return;
+    JsonScanner in(text);
+    std::string_view key;
+    if (!in.enter_object()) return;
+    while (in.next_member(key)) {
+        if (key == "entry_points" && in.peek() == JsonScanner::Type::Object) {
+            in.enter_object();
+            while (in.next_member(key)) {
+                std::string* slot = key == "init" ? &entry_points.init
+                                  : key == "start" ? &entry_points.start
+                                  : key == "stop" ? &entry_points.stop
+                                  : key == "destroy" ? &entry_points.destroy : nullptr;
+                if (slot && in.peek() == JsonScanner::Type::String) in.read_string(*slot);
+                else in.skip_value();
+            }
+        } else if (key == "exports" && in.peek() == JsonScanner::Type::Array) {
+            in.enter_array();
+            while (in.next_element()) {
+                std::string symbol;
+                if (in.peek() == JsonScanner::Type::String && in.read_string(symbol)) exports.push_back(symbol);
+                else in.skip_value();
+            }
+        } else {
+            in.skip_value();
+        }
+    }
+}
+
+bool stat_file(const std::string& path, long long& size, long long& mtime_ns) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) return false;
+    size = static_cast<long long>(st.st_size);
+    mtime_ns = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool deps_unchanged(const std::string& deps_path) {
+    std::ifstream in(deps_path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        DepRecord rec;
+        if (!(fields >> rec.digest >> rec.size >> rec.mtime_ns)) return false;
+        std::getline(fields >> std::ws, rec.path);
+        long long size = 0, mtime_ns = 0;
+        if (!stat_file(rec.path, size, mtime_ns)) return false;
+        if (size == rec.size && mtime_ns == rec.mtime_ns) continue;
+        std::string digest, error;
+        if (size != rec.size || !BlobStore::hash_file(rec.path, digest, error) || digest != rec.digest) return false;
+    }
+    return true;
+}
+
+// Write to a private name, then rename, so concurrent builds never see partial entries
+bool publish_file(const std::string& from, const std::string& to) {
+    const std::string tmp = to + ".tmp" + std::to_string(static_cast<long>(::getpid())) + "-" +
+                            std::to_string(static_cast<unsigned long>(std::hash<std::string>{}(from)));
+    std::error_code ec;
+    std::filesystem::copy_file(from, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+    if (ec || std::rename(tmp.c_str(), to.c_str()) != 0) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<std::string> HelixCompiler::entry_point_symbols(const CompileConfig& config) {
+    EntryPoints manifest_eps;
+    std::vector<std::string> exports;
+    read_manifest_symbols(config.source_directory, manifest_eps, exports);
+    auto pick = [](const std::string& cli, const std::string& manifest, const char* fallback) {
+        return !cli.empty() ? cli : (!manifest.empty() ? manifest : std::string(fallback));
+    };
+    return {pick(config.ep_init, manifest_eps.init, "helix_module_init"),
+            pick(config.ep_start, manifest_eps.start, "helix_module_start"),
+            pick(config.ep_stop, manifest_eps.stop, "helix_module_stop"),
+            pick(config.ep_destroy, manifest_eps.destroy, "helix_module_destroy")};
+}
+
+bool HelixCompiler::check_exported_symbols(const CompileConfig& config, const std::string& so_file) {
+    std::string listing;
+    if (run_program_capture({"nm", "-D", "--defined-only", so_file}, listing) != 0) {
+        if (config.verbose) std::cout << "nm not available; exported symbols not checked" << std::endl;
+        return true;
+    }
+    std::unordered_set<std::string> defined;
+    std::istringstream lines(listing);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const size_t space = line.find_last_of(' ');
+        std::string name = space == std::string::npos ? line : line.substr(space + 1);
+        const size_t at = name.find('@');
+        if (at != std::string::npos) name.resize(at);
+        defined.insert(name);
+    }
+
+    EntryPoints unused;
+    std::vector<std::string> exports;
+    read_manifest_symbols(config.source_directory, unused, exports);
+    std::vector<std::string> required = entry_point_symbols(config);
+    required.insert(required.end(), exports.begin(), exports.end());
+    std::string missing;
+    for (const auto& symbol : required) {
+        if (defined.count(symbol)) continue;
+        if (!missing.empty()) missing += ", ";
+        missing += symbol;
+    }
+    if (!missing.empty()) {
+        set_error("Not exported from the built library: " + missing +
+                  " (with hidden visibility, mark exported symbols HELIX_EXPORT from helix/exports.h)");
+        return false;
+    }
+    return true;
+}
+
+bool HelixCompiler::compile_object(const std::vector<std::string>& flags, const std::string& cache_dir,
+                                   const std::string& key_base, const std::string& source,
+                                   const std::string& object, std::string& result, std::string& output,
+                                   bool& cached) {
+    cached = false;
+    std::string entry;
+    if (!cache_dir.empty()) {
+        std::string contents_digest, error;
+        if (BlobStore::hash_file(source, contents_digest, error)) {
+            const std::string key_text = key_base + "\nsource " + source + " " + contents_digest;
+            const std::string key = BlobStore::hash_bytes(key_text.data(), key_text.size());
+            entry = cache_dir + "/" + key.substr(0, 2) + "/" + key;
+            if (std::filesystem::exists(entry + ".o") && deps_unchanged(entry + ".deps")) {
+                result = entry + ".o";
+                cached = true;
+                return true;
+            }
+        }
+    }
+
+    std::vector<std::string> args;
+    args.push_back("g++");
+    args.insert(args.end(), flags.begin(), flags.end());
+    args.insert(args.end(), {"-MD", "-MF", object + ".d", "-c", source, "-o", object});
+    if (run_program_capture(args, output) != 0) return false;
+    result = object;
+    if (entry.empty()) return true;
+
+    // Record the headers, then publish the object last: it marks the entry complete
+    std::string depfile;
+    if (!read_file(object + ".d", depfile)) return true;
+    auto deps = parse_depfile(depfile);
+    std::ostringstream records;
+    for (size_t i = 1; i < deps.size(); ++i) { // [0] is the source, already in the key
+        DepRecord rec;
+        std::string error;
+        rec.path = std::filesystem::absolute(deps[i]).lexically_normal().string();
+        if (!stat_file(rec.path, rec.size, rec.mtime_ns) || !BlobStore::hash_file(rec.path, rec.digest, error)) {
+            return true; // vanished mid-build; do not cache
+        }
+        records << rec.digest << ' ' << rec.size << ' ' << rec.mtime_ns << ' ' << rec.path << '\n';
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(entry).parent_path(), ec);
+    const std::string deps_tmp = object + ".deps";
+    {
+        std::ofstream out(deps_tmp);
+        out << records.str();
+        if (!out) return true;
+    }
+    if (publish_file(deps_tmp, entry + ".deps")) publish_file(object, entry + ".o");
+    return true;
+}
+
 bool HelixCompiler::compile_shared_library(const CompileConfig& config,
                                          const std::vector<std::string>& source_files,
                                          const std::string& output_so) {
-    std::vector<std::string> args;
-    args.push_back("g++");
-    args.push_back(std::string("-std=") + (config.cxx_standard.empty() ? "c++17" : config.cxx_standard));
-    args.push_back(config.optimization_level.empty() ? std::string("-O2") : config.optimization_level);
-    if (config.debug_info) args.push_back("-g");
-    args.push_back("-shared");
-    args.push_back("-fPIC");
+    const std::vector<std::string> codegen = codegen_flags(config);
+    std::vector<std::string> flags;
+    flags.push_back(std::string("-std=") + (config.cxx_standard.empty() ? "c++17" : config.cxx_standard));
+    flags.insert(flags.end(), codegen.begin(), codegen.end());
 
     std::string base = source_files.empty() ? std::filesystem::current_path().string()
                                             : std::filesystem::path(source_files.front()).parent_path().string();
     std::string helixInclude = detect_helix_include(base);
     if (!helixInclude.empty()) {
-        args.push_back(std::string("-I") + helixInclude);
+        flags.push_back(std::string("-I") + helixInclude);
     }
-    for (const auto& inc : config.include_paths) args.push_back(std::string("-I") + inc);
+    for (const auto& inc : config.include_paths) flags.push_back(std::string("-I") + inc);
 
     if (!config.module_name.empty()) {
-        args.push_back(std::string("-DHELIX_MODULE_NAME=\"") + config.module_name + "\"");
+        flags.push_back(std::string("-DHELIX_MODULE_NAME=\"") + config.module_name + "\"");
     }
     if (!config.module_version.empty()) {
-        args.push_back(std::string("-DHELIX_MODULE_VERSION=\"") + config.module_version + "\"");
+        flags.push_back(std::string("-DHELIX_MODULE_VERSION=\"") + config.module_version + "\"");
+    }
+    std::string cache_dir = resolve_cache_dir(config);
+
+    if (config.hidden_visibility) {
+        // Declared before any module code, so the definitions inherit default visibility
+        // even where a module writes its entry points by hand
+        const auto eps = entry_point_symbols(config);
+        std::string header = "// Generated by helxcompiler for -fvisibility=hidden builds\n"
+                             "struct HelixHandoff;\n"
+                             "#define HELIX_EP_ __attribute__((visibility(\"default\")))\n"
+                             "extern \"C\" {\n";
+        header += "HELIX_EP_ int " + eps[0] + "();\n";
+        header += "HELIX_EP_ int " + eps[1] + "();\n";
+        header += "HELIX_EP_ int " + eps[2] + "();\n";
+        header += "HELIX_EP_ void " + eps[3] + "();\n";
+        header += "HELIX_EP_ int helix_module_handoff(const HelixHandoff*);\n";
+        for (const char* accessor : {"name", "version", "description", "author", "dependencies"}) {
+            header += std::string("HELIX_EP_ const char* helix_module_get_") + accessor + "();\n";
+        }
+        header += "}\n#undef HELIX_EP_\n";
+
+        // Named by content inside the cache so the flag (part of the cache key) is stable
+        const std::string digest = BlobStore::hash_bytes(header.data(), header.size());
+        const std::string dir = cache_dir.empty() ? std::filesystem::path(output_so).parent_path().string()
+                                                  : cache_dir + "/include";
+        const std::string path = dir + "/entry-points-" + digest.substr(0, 16) + ".h";
+        std::error_code hec;
+        std::filesystem::create_directories(dir, hec);
+        if (!std::filesystem::exists(path, hec)) {
+            const std::string tmp = path + ".tmp" + std::to_string(static_cast<long>(::getpid()));
+            std::ofstream out(tmp);
+            out << header;
+            out.close();
+            if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) {
+                set_error("Failed to write " + path);
+                return false;
+            }
+        }
+        flags.push_back("-include");
+        flags.push_back(path);
+    }
+
+    // Objects are written under the build directory; with -fprofile-generate/-use the
+    // object path names the profile, so it must be the same in the generate and use builds
+    const bool pgo = !config.pgo_generate_dir.empty() || !config.pgo_use_dir.empty();
+    std::string object_dir = std::filesystem::path(output_so).parent_path().string() + "/obj";
+    if (pgo) {
+        object_dir = std::filesystem::absolute(config.pgo_generate_dir.empty() ? config.pgo_use_dir
+                                                                               : config.pgo_generate_dir)
+                         .string() + "/obj";
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(object_dir, ec);
+
+    std::string key_base;
+    if (!cache_dir.empty()) {
+        std::string version;
+        if (run_program_capture({"g++", "-dumpfullversion", "-dumpmachine"}, version) != 0) {
+            cache_dir.clear(); // cannot identify the compiler: build uncached
+        } else {
+            key_base = "helxcompiler-object-1\ncompiler " + version + "\nflags";
+            for (const auto& f : flags) key_base += " " + f;
+            if (config.debug_info) key_base += "\ncwd " + std::filesystem::current_path().string();
+            if (pgo) key_base += "\nobjects " + object_dir;
+            if (!config.pgo_use_dir.empty()) {
+                // Profiles are inputs too
+                std::vector<std::string> profiles;
+                for (auto it = std::filesystem::recursive_directory_iterator(config.pgo_use_dir, ec);
+                     !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+                    if (it->path().extension() == ".gcda") profiles.push_back(it->path().string());
+                }
+                std::sort(profiles.begin(), profiles.end());
+                for (const auto& profile : profiles) {
+                    std::string digest, error;
+                    BlobStore::hash_file(profile, digest, error);
+                    key_base += "\nprofile " + profile + " " + digest;
+                }
+            }
+        }
     }
 
-    for (const auto& src : source_files) args.push_back(src);
+    std::vector<std::string> objects(source_files.size());
+    std::vector<std::string> outputs(source_files.size());
+    std::vector<char> ok(source_files.size(), 0);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> reused{0};
+    std::atomic<bool> failed{false};
+    std::mutex print_mutex;
+    auto worker = [&]() {
+        for (size_t i; !failed && (i = next.fetch_add(1)) < source_files.size();) {
+            const std::string& source = source_files[i];
+            std::string object;
+            if (pgo) {
+                std::error_code wec; // per worker: ec above is shared
+                std::string rel = std::filesystem::relative(source, config.source_directory, wec).string();
+                if (rel.empty() || rel.rfind("..", 0) == 0) rel = std::filesystem::path(source).filename().string();
+                object = object_dir + "/" + rel + ".o";
+                std::filesystem::create_directories(std::filesystem::path(object).parent_path(), wec);
+            } else {
+                object = object_dir + "/" + std::to_string(i) + "-" +
+                         std::filesystem::path(source).filename().string() + ".o";
+            }
+            bool cached = false;
+            ok[i] = compile_object(flags, cache_dir, key_base, source, object, objects[i], outputs[i], cached);
+            if (!ok[i]) failed = true;
+            if (cached) ++reused;
+            if (config.verbose) {
+                std::lock_guard<std::mutex> lock(print_mutex);
+                std::cout << (cached ? "Cached:   " : "Compiled: ") << source << std::endl;
+            }
+        }
+    };
+
+    unsigned jobs = config.jobs ? config.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = static_cast<unsigned>(std::min<size_t>(jobs, source_files.size()));
+    if (config.verbose) {
+        std::ostringstream oss; for (const auto& a : flags) { oss << a << ' '; }
+        std::cout << "Compiling " << source_files.size() << " translation unit(s) with " << jobs
+                  << " job(s): g++ " << oss.str() << std::endl;
+        if (!cache_dir.empty()) std::cout << "Object cache: " << cache_dir << std::endl;
+    }
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < jobs; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+
+    for (size_t i = 0; i < source_files.size(); ++i) {
+        if (!ok[i] && !outputs[i].empty()) {
+            set_error(std::string("Compilation failed: ") + outputs[i]);
+            return false;
+        }
+    }
+    if (failed) {
+        set_error("Compilation failed");
+        return false;
+    }
 
+    std::vector<std::string> args;
+    args.push_back("g++");
+    args.insert(args.end(), codegen.begin(), codegen.end());
+    args.push_back("-shared");
+    const std::vector<std::string> linking = link_flags(config);
+    args.insert(args.end(), linking.begin(), linking.end());
+    args.insert(args.end(), objects.begin(), objects.end());
     for (const auto& libp : config.library_paths) args.push_back(std::string("-L") + libp);
     for (const auto& lib : config.libraries) args.push_back(std::string("-l") + lib);
-
     args.push_back("-pthread");
     args.push_back("-ldl");
     args.push_back("-o");
@@ -252,15 +720,17 @@ bool HelixCompiler::compile_shared_library(const CompileConfig& config,
     if (config.verbose) {
         std::ostringstream oss; for (const auto& a : args) { oss << a << ' '; }
         std::cout << "Running: " << oss.str() << std::endl;
+        std::cout << "Reused " << reused.load() << " of " << source_files.size() << " object(s) from the cache"
+                  << std::endl;
     }
 
     std::string output;
     int rc = run_program_capture(args, output);
     if (rc != 0) {
-        set_error(std::string("Compilation failed: ") + output);
+        set_error(std::string("Link failed: ") + output);
         return false;
     }
-    return true;
+    return !config.hidden_visibility || check_exported_symbols(config, output_so);
 }
 
 bool HelixCompiler::generate_manifest(const CompileConfig& config, const std::string& manifest_path) {
@@ -329,6 +799,8 @@ bool HelixCompiler::generate_manifest(const CompileConfig& config, const std::st
     std::string homepage = get_field("homepage");
     std::string repository = get_field("repository");
     std::string tags = get_array("tags");
+    std::string isolation = get_field("isolation");
+    std::string exports = get_array("exports");
     std::string config_obj = get_object("config");
 
     if (minimum_core_version.empty()) {
@@ -358,34 +830,37 @@ bool HelixCompiler::generate_manifest(const CompileConfig& config, const std::st
     if (ep_stop.empty()) ep_stop = "helix_module_stop";
     if (ep_destroy.empty()) ep_destroy = "helix_module_destroy";
 
+    // Members are joined at the end so the object never carries a trailing comma
+    std::vector<std::string> members;
+    auto field = [](const char* key, const std::string& value) { return std::string("\"") + key + "\": \"" + value + "\""; };
+    members.push_back(field("name", name));
+    members.push_back(field("version", version));
+    if (!description.empty()) members.push_back(field("description", description));
+    if (!author.empty()) members.push_back(field("author", author));
+    if (!license.empty()) members.push_back(field("license", license));
+    members.push_back(field("binary_path", "lib" + name + ".so"));
+    members.push_back(field("minimum_core_version", minimum_core_version));
+    members.push_back(field("minimum_api_version", minimum_api_version));
+    members.push_back("\"entry_points\": {\n"
+                      "    " + field("init", ep_init) + ",\n"
+                      "    " + field("start", ep_start) + ",\n"
+                      "    " + field("stop", ep_stop) + ",\n"
+                      "    " + field("destroy", ep_destroy) + "\n"
+                      "  }");
+    std::string timeouts = get_object("timeouts");
+    if (!timeouts.empty()) members.push_back("\"timeouts\": {" + timeouts + "}");
+    members.push_back("\"dependencies\": [" + get_array("dependencies") + "]");
+    if (!tags.empty()) members.push_back("\"tags\": [" + tags + "]");
+    if (!isolation.empty()) members.push_back(field("isolation", isolation));
+    if (!exports.empty()) members.push_back("\"exports\": [" + exports + "]");
+    if (!config_obj.empty()) members.push_back("\"config\": {" + config_obj + "}");
+    if (!config.profile.empty()) members.push_back(field("build_profile", config.profile));
+    if (!homepage.empty()) members.push_back(field("homepage", homepage));
+    if (!repository.empty()) members.push_back(field("repository", repository));
+
     manifest << "{\n";
-    manifest << "  \"name\": \"" << name << "\",\n";
-    manifest << "  \"version\": \"" << version << "\",\n";
-    if (!description.empty()) manifest << "  \"description\": \"" << description << "\",\n";
-    if (!author.empty()) manifest << "  \"author\": \"" << author << "\",\n";
-    if (!license.empty()) manifest << "  \"license\": \"" << license << "\",\n";
-    manifest << "  \"binary_path\": \"lib" << name << ".so\",\n";
-    manifest << "  \"minimum_core_version\": \"" << minimum_core_version << "\",\n";
-    manifest << "  \"minimum_api_version\": \"" << minimum_api_version << "\",\n";
-    manifest << "  \"entry_points\": {\n";
-    manifest << "    \"init\": \"" << ep_init << "\",\n";
-    manifest << "    \"start\": \"" << ep_start << "\",\n";
-    manifest << "    \"stop\": \"" << ep_stop << "\",\n";
-    manifest << "    \"destroy\": \"" << ep_destroy << "\"\n";
-    manifest << "  },\n";
-    std::string deps = get_array("dependencies");
-    manifest << "  \"dependencies\": [";
-    if (!deps.empty()) manifest << deps;
-    manifest << "],\n";
-    if (!tags.empty()) {
-        manifest << "  \"tags\": [" << tags << "],\n";
-    }
-    if (!config_obj.empty()) {
-        manifest << "  \"config\": {" << config_obj << "},\n";
-    }
-    if (!homepage.empty()) manifest << "  \"homepage\": \"" << homepage << "\",\n";
-    if (!repository.empty()) manifest << "  \"repository\": \"" << repository << "\"\n";
-    if (homepage.empty() && repository.empty()) {
+    for (size_t i = 0; i < members.size(); ++i) {
+        manifest << "  " << members[i] << (i + 1 < members.size() ? ",\n" : "\n");
     }
     manifest << "}\n";
 
@@ -415,6 +890,16 @@ bool HelixCompiler::create_helx_package(const std::string& so_file,
     const std::string so_name = std::filesystem::path(so_file).filename().string();
     const std::string mf_name = std::filesystem::path(manifest_file).filename().string();
 
+    if (helix::archive_support_available()) {
+        std::string error;
+        if (!helix::write_tar_gz(output_helx, {{so_name, so_file}, {mf_name, manifest_file}}, error)) {
+            set_error("Failed to create .helx package: " + error);
+            return false;
+        }
+        return true;
+    }
+
+    // Built without zlib: fall back to the tar program
     std::vector<std::string> args = {
         "tar", "-czf", output_helx,
         "-C", parent,
@@ -495,11 +980,15 @@ void HelixCompiler::set_error(const std::string& error) {
 }
 
 std::string HelixCompiler::detect_helix_include(const std::string& from_dir) const {
+    auto cached = helix_include_cache_.find(from_dir);
+    if (cached != helix_include_cache_.end()) return cached->second;
+    std::string& found = helix_include_cache_[from_dir];
+
     if (const char* env = std::getenv("HELIX_ROOT")) {
         std::filesystem::path p(env);
         auto inc = p / "include";
         if (std::filesystem::exists(inc / "helix" / "module.h")) {
-            return inc.string();
+            return found = inc.string();
         }
     }
 
@@ -507,14 +996,14 @@ std::string HelixCompiler::detect_helix_include(const std::string& from_dir) con
     for (int i = 0; i < 6; ++i) {
         std::filesystem::path inc = cur / "include";
         if (std::filesystem::exists(inc / "helix" / "module.h")) {
-            return inc.string();
+            return found = inc.string();
         }
         if (cur.has_parent_path()) cur = cur.parent_path(); else break;
     }
 
     std::filesystem::path cwd = std::filesystem::current_path();
     if (std::filesystem::exists(cwd / "../../include/helix/module.h")) {
-        return (cwd / "../../include").string();
+        return found = (cwd / "../../include").string();
     }
 
     return std::string();
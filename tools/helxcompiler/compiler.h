@@ -2,6 +2,7 @@
 #define HELIX_COMPILER_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -27,6 +28,21 @@ struct CompileConfig {
     std::string ep_start;           ///< Symbol for start
     std::string ep_stop;            ///< Symbol for stop
     std::string ep_destroy;         ///< Symbol for destroy
+    // Build parallelism, caching and code generation
+    unsigned jobs = 0;              ///< Parallel compile jobs (0: one per CPU)
+    std::string cache_dir;          ///< Object cache directory (empty: $HELXCOMPILER_CACHE or ~/.cache/helxcompiler)
+    bool use_cache = true;          ///< Reuse objects of unchanged translation units
+    bool lto = false;               ///< Link-time optimization (-flto=auto)
+    std::string march;              ///< Target CPU for -march= (empty: compiler default)
+    std::string pgo_generate_dir;   ///< Instrument for profiling; profiles are written here
+    std::string pgo_use_dir;        ///< Optimize with the profiles found here
+    // Set by apply_profile(); can also be enabled one by one
+    std::string profile;            ///< Named build profile, recorded in the manifest (empty: none)
+    bool hidden_visibility = false; ///< -fvisibility=hidden; entry points stay exported
+    bool no_plt = false;            ///< -fno-plt calls, bound at load time
+    bool gc_sections = false;       ///< One section per function/object, unreferenced ones dropped at link
+    bool hardening = false;         ///< Stack protector, _FORTIFY_SOURCE and full RELRO
+    bool strip = false;             ///< Strip the symbol table from the .so
 };
 
 /**
@@ -52,6 +68,21 @@ public:
      */
     bool detect_module_config(const std::string& source_dir, CompileConfig& config);
 
+    /**
+     * @brief Apply a named build profile to a configuration
+     *
+     * - release: hidden visibility, -fno-plt, section GC, LTO and hardening
+     * - size: release at -Os, stripped
+     * - pgo-gen: release, instrumented to write profiles (to config.pgo_generate_dir,
+     *   default helx-pgo/<module name>)
+     * - pgo-use: release, optimized with those profiles (config.pgo_use_dir, same default)
+     *
+     * The optimization level is only changed when keep_optimization is false.
+     * @return false for an unknown profile name (error says which names exist)
+     */
+    static bool apply_profile(const std::string& name, CompileConfig& config, bool keep_optimization,
+                              std::string& error);
+
     /**
      * @brief Validate manifest.json in a source directory (no build)
      */
@@ -85,6 +116,10 @@ private:
 
     /**
      * @brief Compile source files to shared library
+     *
+     * Each translation unit is compiled to its own object on a pool of
+     * config.jobs workers, then the objects are linked. Objects are looked up in
+     * the object cache first (see compile_object()).
      * @param config Compilation configuration
      * @param source_files List of source files
      * @param output_so Output shared library path
@@ -94,6 +129,42 @@ private:
                                const std::vector<std::string>& source_files,
                                const std::string& output_so);
 
+    /**
+     * @brief Compile one translation unit, or reuse its cached object
+     *
+     * Cache entries are keyed by the compiler version, the flags, the source path
+     * and the source contents. Each entry also records the headers the compiler
+     * reported through -MD with their hashes; it is reused only while all of them
+     * are unchanged.
+     * @param key_base Hash input shared by every unit of this build (empty: no cache)
+     * @param object Where to write the object when it is compiled
+     * @param result Receives the object to link (object, or the cached copy)
+     * @param output Compiler diagnostics on failure
+     * @param cached Set to true when the cached object was reused
+     */
+    bool compile_object(const std::vector<std::string>& flags, const std::string& cache_dir,
+                        const std::string& key_base, const std::string& source, const std::string& object,
+                        std::string& result, std::string& output, bool& cached);
+
+    /// Code generation flags used both to compile and to link
+    static std::vector<std::string> codegen_flags(const CompileConfig& config);
+
+    /// Flags used only to link
+    static std::vector<std::string> link_flags(const CompileConfig& config);
+
+    /// Entry point symbols: config overrides, then the source manifest, then the defaults
+    static std::vector<std::string> entry_point_symbols(const CompileConfig& config);
+
+    /**
+     * @brief Check that the linked library still exports its entry points and the
+     *        manifest's "exports" (hidden visibility can drop unmarked ones)
+     * @return false if one is missing; skipped (true) when nm is not available
+     */
+    bool check_exported_symbols(const CompileConfig& config, const std::string& so_file);
+
+    /// The object cache directory for config, or empty when caching is off
+    static std::string resolve_cache_dir(const CompileConfig& config);
+
     /**
      * @brief Generate manifest.json from module metadata
      * @param config Compilation configuration
@@ -133,6 +204,8 @@ private:
      * @return Detected Helix include path
      */
     std::string detect_helix_include(const std::string& from_dir) const;
+
+    mutable std::unordered_map<std::string, std::string> helix_include_cache_; ///< detect_helix_include() results
 };
 
 } // namespace helix
@@ -1,4 +1,5 @@
 #include "compiler.h"
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -17,16 +18,31 @@ void print_usage(const char* program_name) {
     std::cout << "  -O, --optimize <level>  Optimization level (default: -O2)\n";
     std::cout << "  -g, --debug             Include debug information\n";
     std::cout << "  -v, --verbose           Verbose output\n";
+    std::cout << "  -j, --jobs <n>          Compile up to n translation units at once (default: one per CPU)\n";
+    std::cout << "  --cache-dir <dir>       Object cache (default: $HELXCOMPILER_CACHE or ~/.cache/helxcompiler)\n";
+    std::cout << "  --no-cache              Rebuild every object and do not update the cache\n";
+    std::cout << "  --profile <name>        Build profile: release, size, pgo-gen or pgo-use (see below)\n";
+    std::cout << "  --lto                   Link-time optimization\n";
+    std::cout << "  --march <cpu>           Generate code for a CPU (e.g. x86-64-v3, native)\n";
+    std::cout << "  --pgo-generate <dir>    Instrument for profiling; running the module writes profiles to dir\n";
+    std::cout << "  --pgo-use <dir>         Optimize with the profiles in dir\n";
     std::cout << "  --ep-init <symbol>      Custom init entry point symbol\n";
     std::cout << "  --ep-start <symbol>     Custom start entry point symbol\n";
     std::cout << "  --ep-stop <symbol>      Custom stop entry point symbol\n";
     std::cout << "  --ep-destroy <symbol>   Custom destroy entry point symbol\n";
     std::cout << "  --validate              Validate manifest.json only (no build)\n";
     std::cout << "  -h, --help              Show this help message\n\n";
+    std::cout << "Profiles:\n";
+    std::cout << "  release                 -O2, LTO, hidden visibility, -fno-plt, section GC, hardening\n";
+    std::cout << "  size                    release at -Os, stripped\n";
+    std::cout << "  pgo-gen                 release, instrumented; profiles go to --pgo-generate (default helx-pgo/<name>)\n";
+    std::cout << "  pgo-use                 release, optimized with profiles from --pgo-use (default helx-pgo/<name>)\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << program_name << " my_module_src/\n";
     std::cout << "  " << program_name << " -o my_module.helx -v src/\n";
     std::cout << "  " << program_name << " --std c++20 -O3 -g module_dir/\n";
+    std::cout << "  " << program_name << " -j 8 -O3 --lto --march x86-64-v3 module_dir/\n";
+    std::cout << "  " << program_name << " --profile=release module_dir/\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -41,6 +57,8 @@ int main(int argc, char* argv[]) {
     config.debug_info = false;
     config.verbose = false;
     bool validate_only = false;
+    bool optimization_set = false;
+    std::string profile;
 
     std::string source_directory;
 
@@ -106,6 +124,7 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
             config.optimization_level = "-O" + std::string(argv[i]);
+            optimization_set = true;
         }
         else if (arg == "-g" || arg == "--debug") {
             config.debug_info = true;
@@ -129,6 +148,49 @@ int main(int argc, char* argv[]) {
             if (++i >= argc) { std::cerr << "Error: --ep-destroy requires a symbol" << std::endl; return 1; }
             config.ep_destroy = argv[i];
         }
+        else if (arg == "-j" || arg == "--jobs") {
+            if (++i >= argc) {
+                std::cerr << "Error: " << arg << " requires an argument" << std::endl;
+                return 1;
+            }
+            char* end = nullptr;
+            const unsigned long jobs = std::strtoul(argv[i], &end, 10);
+            if (!end || *end != '\0' || jobs == 0 || jobs > 1024) {
+                std::cerr << "Error: " << arg << " expects a job count between 1 and 1024" << std::endl;
+                return 1;
+            }
+            config.jobs = static_cast<unsigned>(jobs);
+        }
+        else if (arg == "--cache-dir") {
+            if (++i >= argc) { std::cerr << "Error: --cache-dir requires a directory" << std::endl; return 1; }
+            config.cache_dir = argv[i];
+        }
+        else if (arg == "--no-cache") {
+            config.use_cache = false;
+        }
+        else if (arg == "--profile" || arg.rfind("--profile=", 0) == 0) {
+            if (arg == "--profile") {
+                if (++i >= argc) { std::cerr << "Error: --profile requires a name" << std::endl; return 1; }
+                profile = argv[i];
+            } else {
+                profile = arg.substr(10);
+            }
+        }
+        else if (arg == "--lto") {
+            config.lto = true;
+        }
+        else if (arg == "--march") {
+            if (++i >= argc) { std::cerr << "Error: --march requires a CPU name" << std::endl; return 1; }
+            config.march = argv[i];
+        }
+        else if (arg == "--pgo-generate") {
+            if (++i >= argc) { std::cerr << "Error: --pgo-generate requires a directory" << std::endl; return 1; }
+            config.pgo_generate_dir = argv[i];
+        }
+        else if (arg == "--pgo-use") {
+            if (++i >= argc) { std::cerr << "Error: --pgo-use requires a directory" << std::endl; return 1; }
+            config.pgo_use_dir = argv[i];
+        }
         else if (arg == "--validate") {
             validate_only = true;
         }
@@ -145,6 +207,11 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!config.pgo_generate_dir.empty() && !config.pgo_use_dir.empty()) {
+        std::cerr << "Error: --pgo-generate and --pgo-use are mutually exclusive" << std::endl;
+        return 1;
+    }
+
     if (source_directory.empty()) {
         std::cerr << "Error: No source directory specified" << std::endl;
         print_usage(argv[0]);
@@ -168,6 +235,15 @@ int main(int argc, char* argv[]) {
 
     config.source_directory = source_directory;
 
+    // After detection: the PGO profiles default to a directory named after the module
+    if (!profile.empty()) {
+        std::string error;
+        if (!helix::HelixCompiler::apply_profile(profile, config, optimization_set, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
     if (validate_only) {
         if (compiler.validate_manifest_in_dir(config)) {
             std::cout << "Manifest validation: OK" << std::endl;
@@ -192,6 +268,11 @@ int main(int argc, char* argv[]) {
         std::cout << "C++ standard: " << config.cxx_standard << std::endl;
         std::cout << "Optimization: " << config.optimization_level << std::endl;
         std::cout << "Debug info: " << (config.debug_info ? "yes" : "no") << std::endl;
+        if (!config.profile.empty()) std::cout << "Profile: " << config.profile << std::endl;
+        if (config.lto) std::cout << "LTO: yes" << std::endl;
+        if (!config.march.empty()) std::cout << "Target CPU: " << config.march << std::endl;
+        if (!config.pgo_generate_dir.empty()) std::cout << "PGO: instrument, profiles in " << config.pgo_generate_dir << std::endl;
+        if (!config.pgo_use_dir.empty()) std::cout << "PGO: use profiles in " << config.pgo_use_dir << std::endl;
         std::cout << std::endl;
     }
 